@@ -0,0 +1,191 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_ASSOCIATION_H_
+#define TACHYON_ASSOCIATION_H_
+
+#include <string>
+#include <vector>
+
+#include "genotypes.h"
+#include "header_footer.h"
+#include "variant_container.h"
+
+namespace tachyon {
+
+// Per-sample values are padded to a multiple of this number of doubles.
+#define YON_ASSOC_LANES 4
+
+/**<
+ * Regression model of the phenotype.
+ *    LINEAR)   Quantitative phenotype with normally distributed errors.
+ *    LOGISTIC) Binary phenotype coded as 0 (control) and 1 (case).
+ */
+enum TACHYON_ASSOC_MODEL {
+	YON_ASSOC_LINEAR,
+	YON_ASSOC_LOGISTIC
+};
+
+struct yon_assoc_settings {
+public:
+	yon_assoc_settings() : model(YON_ASSOC_LINEAR), min_mac(1), n_threads(1) {}
+
+public:
+	TACHYON_ASSOC_MODEL model;
+	uint32_t min_mac; // records with a smaller minor allele count are not tested
+	uint32_t n_threads;
+	std::string phenotype; // phenotype column or the first column if empty
+};
+
+/**<
+ * Summary statistics of a record. The effect size is the one-step
+ * estimate of the score test and the test statistic is chi-squared
+ * distributed with one degree of freedom under the null.
+ */
+struct yon_assoc_result {
+public:
+	yon_assoc_result() : rid(0), pos(0), n(0), af(0), beta(0), se(0), chisq(0), p(1) {}
+
+public:
+	uint32_t    rid;
+	int64_t     pos;
+	std::string name, ref, alt;
+	uint32_t    n; // number of included samples with observed genotypes
+	float       af; // alternative allele frequency over n samples
+	double      beta, se, chisq, p;
+};
+
+/**<
+ * Thread-local memory for testing the records of a block. The null model
+ * vectors are moved into the permutation of every block such that they
+ * can be combined with the run-length encoded genotypes in order.
+ */
+struct yon_assoc_workspace {
+public:
+	yon_assoc_workspace() : permuted(false), n_tested(0), n_skipped(0), rows(nullptr) {}
+
+public:
+	bool permuted; // rows_permuted is valid for ordering
+	uint64_t n_tested, n_skipped; // number of records tested and skipped in the last block
+	std::vector<uint32_t> ordering; // permutation of rows_permuted
+	std::vector<double>   rows_permuted;
+	const double*         rows; // rows in the permutation of the current block
+	std::vector<uint8_t>  classes; // dosage class of every run
+	std::vector<uint32_t> class_counts;
+	std::vector<double>   sums; // sums of rows per dosage class
+	std::vector<yon_assoc_result> results; // results of the last block
+};
+
+/**<
+ * Genome-wide association tests of the alternative allele dosage with a
+ * quantitative (linear) or binary (logistic) phenotype adjusting for
+ * covariates. The null model including an intercept and the covariates
+ * is fitted once and every record is evaluated with a score test:
+ *
+ *    U = g'(y - mu)
+ *    V = g'Wg - g'WX(X'WX)^-1 X'Wg
+ *
+ * where W is the identity (linear) or the variance mu(1-mu) (logistic).
+ * The projection onto the covariates is precomputed as an orthonormal
+ * basis Q of W^(1/2)X such that V only requires the dot products of g
+ * with the columns of W^(1/2)Q. All per-sample vectors are stored
+ * together as rows of a samples x stride matrix:
+ *    [included, y - mu, W, W^(1/2)Q_1, ..., W^(1/2)Q_k]
+ *
+ * Dosages are never expanded: the rows of all samples in a run of
+ * identical genotypes are summed per dosage class, and the class with the
+ * most samples (the reference class for rare variants) is derived from
+ * the totals over all samples. Missing genotypes are imputed with the
+ * mean dosage. Any non-reference allele is counted such that
+ * multi-allelic records are collapsed to bi-allelic.
+ *
+ * Samples are only included if they have a phenotype and all covariates.
+ */
+class Association {
+public:
+	typedef Association self_type;
+
+public:
+	Association();
+	~Association() = default;
+
+	/**<
+	 * Read the phenotypes and covariates and fit the null model.
+	 * Phenotype and covariate files are tab-delimited with a header line
+	 * naming the columns and one line per sample with the sample name in
+	 * the first column. Missing values are NA or '.'.
+	 * @param header     Src header of the archive.
+	 * @param phenotypes Src phenotype file.
+	 * @param covariates Src covariate file or an empty string.
+	 * @param settings   Src settings.
+	 * @return           Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Open(const yon_vnt_hdr_t& header,
+	          const std::string& phenotypes,
+	          const std::string& covariates,
+	          const yon_assoc_settings& settings);
+
+	/**<
+	 * Test every record in a container. Results are stored in the
+	 * workspace in the order of the container. This function may be
+	 * invoked concurrently with distinct workspaces.
+	 * @param vc Src container of variants with evaluated genotypes.
+	 * @param ws Dst workspace.
+	 * @return   Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Evaluate(yon1_vc_t& vc, yon_assoc_workspace& ws) const;
+
+	inline uint32_t GetNumberIncluded(void) const { return(this->n_included); }
+	inline uint32_t GetNumberCovariates(void) const { return(this->covariate_names.size()); }
+	inline const std::string& GetPhenotypeName(void) const { return(this->phenotype_name); }
+	inline const yon_assoc_settings& GetSettings(void) const { return(this->settings); }
+
+private:
+	// Fit the null models and populate the rows.
+	bool FitLinear(const std::vector<uint32_t>& included, const std::vector<double>& y, std::vector<double>& x, uint32_t n_cols);
+	bool FitLogistic(const std::vector<uint32_t>& included, const std::vector<double>& y, std::vector<double>& x, uint32_t n_cols);
+
+	// Store the residuals, weights, and weighted orthonormal basis q of
+	// the included samples as rows.
+	void SetRows(const std::vector<uint32_t>& included, const std::vector<double>& r, const std::vector<double>& w, const std::vector<double>& q);
+
+	// Move the rows into the permutation of a record.
+	void SetPermutation(const yon_gt_ppa* ppa, yon_assoc_workspace& ws) const;
+
+	// Test a record and return FALSE if it cannot be tested.
+	bool Test(const yon_gt& gt, yon_assoc_workspace& ws, yon_assoc_result& result) const;
+
+private:
+	yon_assoc_settings settings;
+	uint32_t n_samples, n_included;
+	uint32_t rank; // number of linearly independent columns of the design matrix
+	uint32_t stride;
+	double   scale; // residual variance (linear) or 1 (logistic)
+	std::string phenotype_name;
+	std::vector<std::string> covariate_names;
+	std::vector<double> rows; // n_samples x stride in sample order
+	std::vector<double> totals; // column sums of rows
+};
+
+}
+
+#endif /* TACHYON_ASSOCIATION_H_ */
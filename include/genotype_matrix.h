@@ -0,0 +1,208 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_GENOTYPE_MATRIX_H_
+#define TACHYON_GENOTYPE_MATRIX_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "genotypes.h"
+#include "memory_arena.h"
+#include "variant_container.h"
+
+namespace tachyon {
+
+// Values used in dense genotype matrices.
+#define YON_GT_MATRIX_MISSING -1 // missing allele or genotype
+#define YON_GT_MATRIX_EOV     -2 // allele beyond the ploidy of a sample
+
+// Total length of a .npy preamble (magic, version, and header) in bytes.
+// This has to be a multiple of 64 and leaves room for any shape.
+const uint32_t YON_NPY_HEADER_LENGTH = 128;
+
+/**<
+ * Layouts of dense genotype matrices. All layouts store one int8_t per
+ * cell.
+ *    DOSAGE)       Number of non-reference alleles per sample or -1 if
+ *                  any allele is missing.
+ *    HAPLOTYPE)    Allele index (0 for reference) per sample and ploidy
+ *                  with -1 for missing and -2 for alleles beyond the
+ *                  ploidy of a record. Alleles of a sample are adjacent.
+ *    MISSING_MASK) 1 if any allele of a sample is missing or 0 otherwise.
+ */
+enum TACHYON_GT_MATRIX_LAYOUT {
+	YON_GT_MATRIX_DOSAGE,
+	YON_GT_MATRIX_HAPLOTYPE,
+	YON_GT_MATRIX_MISSING_MASK
+};
+
+struct yon_gt_matrix_settings {
+public:
+	yon_gt_matrix_settings() : layout(YON_GT_MATRIX_DOSAGE), transpose(false), ploidy(2) {}
+
+	/**<
+	 * Number of columns per variant given the total number of samples.
+	 * @param n_samples Total number of samples in the archive.
+	 * @return          Returns the number of columns.
+	 */
+	inline uint32_t GetNumberColumns(const uint32_t n_samples) const {
+		const uint32_t n_s = this->samples.size() ? this->samples.size() : n_samples;
+		return(this->layout == YON_GT_MATRIX_HAPLOTYPE ? n_s * this->ploidy : n_s);
+	}
+
+public:
+	TACHYON_GT_MATRIX_LAYOUT layout;
+	bool transpose; // store matrices as columns x variants
+	uint8_t ploidy; // number of alleles per sample in the haplotype layout
+	std::vector<uint32_t> samples; // subset of samples in output order or empty for all
+};
+
+/**<
+ * Dense genotype matrix of a block of variants. By default the matrix is
+ * stored in row-major order with one row per variant. If transposed is
+ * set the matrix is stored with one row per column (sample or haplotype)
+ * instead.
+ *
+ * Memory is either provided by the caller with SetBuffer(), served from
+ * an arena provided with SetArena(), or allocated and owned by this
+ * object.
+ */
+struct yon_gt_matrix {
+public:
+	yon_gt_matrix();
+	yon_gt_matrix(const yon_gt_matrix& other) = delete;
+	yon_gt_matrix& operator=(const yon_gt_matrix& other) = delete;
+	~yon_gt_matrix();
+
+	/**<
+	 * Use caller-provided memory for all subsequent matrices. The memory
+	 * is not owned and must remain valid for the lifetime of the matrix.
+	 * @param buffer   Dst memory.
+	 * @param capacity Number of int8_t elements available in buffer.
+	 */
+	void SetBuffer(int8_t* buffer, const uint64_t capacity);
+
+	/**<
+	 * Serve all subsequent matrices from an arena. The memory is released
+	 * when the arena is reset.
+	 * @param arena Src arena that is not owned.
+	 */
+	void SetArena(yon_arena* arena);
+
+	/**<
+	 * Reserve memory for a matrix of the given dimensions.
+	 * @param n_rows Number of variants.
+	 * @param n_cols Number of columns per variant.
+	 * @return       Returns TRUE upon success or FALSE if caller-provided memory is insufficient.
+	 */
+	bool Allocate(const uint32_t n_rows, const uint32_t n_cols);
+
+	/**<
+	 * Fill the matrix with the genotypes of every variant in a container.
+	 * Variants without genotypes are stored as missing. Genotypes are
+	 * expanded into the original sample order in tiles of records. The
+	 * workspace has to be allocated for the number of samples.
+	 * @param vc       Src container of variants.
+	 * @param settings Src settings describing the layout.
+	 * @param tiles    Src/Dst reusable tiled expansion workspace.
+	 * @return         Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Fill(yon1_vc_t& vc, const yon_gt_matrix_settings& settings, yon_gt_tiled_exp& tiles);
+
+	inline int8_t& at(const uint32_t row, const uint32_t col) {
+		return(this->transposed ? this->data[(uint64_t)col * this->n_rows + row] : this->data[(uint64_t)row * this->n_cols + col]);
+	}
+	inline const int8_t& at(const uint32_t row, const uint32_t col) const {
+		return(this->transposed ? this->data[(uint64_t)col * this->n_rows + row] : this->data[(uint64_t)row * this->n_cols + col]);
+	}
+	inline uint64_t size(void) const { return((uint64_t)this->n_rows * this->n_cols); }
+
+private:
+	// Convert an expanded row of genotypes into a matrix row.
+	void FillRow(const uint32_t row, const uint8_t* alleles, const uint8_t m, const uint32_t n_samples, const yon_gt_matrix_settings& settings);
+
+	// Store a row of missing values for variants without genotypes.
+	void FillMissing(const uint32_t row, const yon_gt_matrix_settings& settings);
+
+public:
+	uint32_t block_id; // sequential block number
+	uint32_t n_rows, n_cols; // number of variants and columns per variant
+	bool transposed;
+	bool owned; // data is allocated by this object
+	uint64_t n_capacity; // number of int8_t elements available
+	int8_t* data;
+	yon_arena* arena; // not owned
+	std::vector<uint32_t> rid; // contig identifier of each variant
+	std::vector<int64_t> pos; // position of each variant
+};
+
+/**<
+ * Writer of dense genotype matrices as a NumPy .npy file of int8 values.
+ * Matrices are appended as variants and the shape is written in the
+ * header when the file is closed. Transposed output (columns x variants)
+ * is stored in Fortran order such that matrices can still be appended
+ * without buffering. The file can be memory-mapped with numpy.load(...,
+ * mmap_mode='r') or read by any other .npy reader.
+ */
+struct yon_npy_writer {
+public:
+	yon_npy_writer();
+	~yon_npy_writer();
+
+	/**<
+	 * Open a file for writing and reserve space for the header.
+	 * @param path      Dst file path.
+	 * @param n_cols    Number of columns per variant.
+	 * @param transpose If TRUE then the stored shape is (columns, variants).
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool open(const std::string& path, const uint32_t n_cols, const bool transpose);
+
+	/**<
+	 * Append a matrix that is not transposed.
+	 * @param matrix Src matrix.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Add(const yon_gt_matrix& matrix);
+
+	/**<
+	 * Write the final header and close the file.
+	 * @return Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool close(void);
+
+private:
+	// Construct a header of exactly YON_NPY_HEADER_LENGTH bytes.
+	std::string BuildHeader(void) const;
+
+public:
+	bool transpose;
+	uint32_t n_cols;
+	uint64_t n_rows;
+	std::ofstream stream;
+};
+
+}
+
+#endif /* TACHYON_GENOTYPE_MATRIX_H_ */
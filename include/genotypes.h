@@ -31,6 +31,7 @@ DEALINGS IN THE SOFTWARE.
 #include "buffer.h"
 #include "support_vcf.h"
 #include "header_footer.h"
+#include "memory_arena.h"
 
 namespace tachyon {
 
@@ -51,7 +52,9 @@ namespace tachyon {
 #define YON_GT_DIPLOID_BCF_PHASE(PRIMITIVE)          ((PRIMITIVE) & 1)
 #define YON_GT_BCF1(ALLELE) (((((ALLELE) >> 1) - 1) << 1) | ((ALLELE) & 1))
 #define YON_GT_RCD_ALLELE_UNPACK(ALLELE) ((ALLELE) >> 1)
+#define YON_GT_RCD_ALLELE_PACK(ALLELE)   ((ALLELE) << 1)
 #define YON_GT_RCD_PHASE(ALLELE) ((ALLELE) & 1)
+#define YON_GT_SPARSE_PHASE(ALLELE, PHASE) ((ALLELE) > YON_GT_RCD_EOV ? ((ALLELE) | (PHASE)) : (ALLELE))
 
 // 0:  Nothing evaluated
 // 1:  rcds
@@ -59,18 +62,74 @@ namespace tachyon {
 // 4:  d_bcf_ppa
 // 8:  d_exp
 // 16: d_occ
+// 32: soa
 #define YON_GT_UN_NONE       0 // nothing
 #define YON_GT_UN_RCDS       1 // basic rcds
 #define YON_GT_UN_BCF        2 // convert into bcf-style
 #define YON_GT_UN_BCF_PPA    4  // convert into bcf-style in-order
 #define YON_GT_UN_EXPAND     8 // expand rcds into entries
 #define YON_GT_UN_OCC       16 // calculate rcds for each factor
+#define YON_GT_UN_SOA       32 // structure-of-arrays diploid runs
 #define YON_GT_UN_ALL       (YON_GT_UN_EXPAND|YON_GT_UN_OCC) // everything
 
+// Default dimensions of a tile in cache-blocked genotype expansion.
+#define YON_GT_TILE_RECORDS  8
+#define YON_GT_TILE_SAMPLES  4096
+
 // 0 for missing and 1 for sentinel node. Note that the
 // sentinel node never occurs in this encoding type.
 const uint8_t YON_GT_RLE_RECODE[3] = {2, 3, 0};
 
+/**<
+ * Unsigned variable-length integers (7 bits per byte with the high bit
+ * flagging continuation) used by the sparse carrier-list encoding
+ * (YON_GT_SPARSE). Each carrier is stored as the gap to the previous
+ * carrier in permuted order followed by one yon_gt_rcd allele without
+ * phase per ploidy. The haplotype PBWT encoding (YON_GT_PBWT) stores its
+ * run lengths in the same way.
+ */
+static inline uint32_t SparseGenotypeVarintEncode(uint32_t value, uint8_t* out) {
+	uint32_t n = 0;
+	while (value > 127) {
+		out[n++] = (value & 127) | 128;
+		value >>= 7;
+	}
+	out[n++] = value;
+	return(n);
+}
+
+static inline uint32_t SparseGenotypeVarintDecode(const uint8_t* data, uint64_t& offset) {
+	uint32_t value = 0;
+	for (uint32_t shift = 0; ; shift += 7) {
+		const uint8_t b = data[offset++];
+		value |= (uint32_t)(b & 127) << shift;
+		if ((b & 128) == 0) break;
+	}
+	return(value);
+}
+
+static inline uint32_t SparseGenotypeVarintLength(uint32_t value) {
+	uint32_t n = 1;
+	while (value > 127) { value >>= 7; ++n; }
+	return(n);
+}
+
+/**<
+ * Compute the number of bytes occupied by a sparse carrier-list record.
+ * @param data       Src pointer to the record.
+ * @param n_carriers Number of carriers in the record.
+ * @param n_ploidy   Base ploidy of the record.
+ * @return           Returns the number of bytes.
+ */
+static inline uint64_t SparseGenotypeLength(const uint8_t* data, const uint32_t n_carriers, const uint8_t n_ploidy) {
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < n_carriers; ++i) {
+		SparseGenotypeVarintDecode(data, offset);
+		offset += n_ploidy;
+	}
+	return(offset);
+}
+
 // Vcf:INFO names for fields annotated when triggering
 // annotation of genotypes.
 const std::vector< std::string > YON_GT_ANNOTATE_FIELDS = {"NM","NPM","AN","HWE_P","AC","AF","AC_P","FS_A","F_PIC","HET","MULTI_ALLELIC"};
@@ -114,6 +173,28 @@ public:
 	 */
 	void reset(void);
 
+	/**<
+	 * Encode this permutation relative to a reference permutation. Every
+	 * sample is replaced by its position in the reference and these
+	 * positions are stored as zigzag varint encoded differences to the
+	 * preceding position. If this permutation was derived from the
+	 * reference by a stable sort then the positions form a few increasing
+	 * runs and most differences are stored in a single byte. The encoded
+	 * bytes are packed into the words of delta preceded by their number
+	 * such that delta.n_s is the number of words rather than samples.
+	 * @param reference Src reference permutation.
+	 * @param delta     Dst encoded permutation.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool ToDelta(const yon_gt_ppa& reference, yon_gt_ppa& delta) const;
+
+	/**<
+	 * Decode a permutation encoded with ToDelta() in-place.
+	 * @param reference Src reference permutation used for encoding.
+	 * @return          Returns TRUE if the result is a permutation of the reference or FALSE otherwise.
+	 */
+	bool ApplyDelta(const yon_gt_ppa& reference);
+
 	friend yon_buffer_t& operator>>(yon_buffer_t& buffer, yon_gt_ppa& ppa);
 	friend yon_buffer_t& operator<<(yon_buffer_t& buffer, const yon_gt_ppa& ppa);
 
@@ -201,6 +282,41 @@ public:
 	uint8_t* allele; // contains phase at first bit
 };
 
+/**<
+ * Structure-of-arrays decoding of diploid run-length encoded genotypes
+ * (M1 and M2). Run lengths and the two alleles are stored in separate
+ * contiguous arrays with the alleles encoded as in yon_gt_rcd, that is
+ * (ALLELE << 1 | phasing). Memory is either owned by the parent yon_gt
+ * or served from its arena.
+ */
+struct yon_gt_soa {
+public:
+	yon_gt_soa() : n(0), run_length(nullptr), allele0(nullptr), allele1(nullptr) {}
+
+public:
+	uint32_t  n; // number of runs
+	uint32_t* run_length;
+	uint8_t*  allele0;
+	uint8_t*  allele1;
+};
+
+/**<
+ * Unpack n diploid run-length encoded genotypes into a structure of
+ * arrays. The unpacking is branchless over the input words and is
+ * dispatched at run-time to the widest vector instruction set supported
+ * by the processor with a fallback to the build target.
+ * @param data         Src packed genotypes.
+ * @param p            Src number of bytes per packed genotype.
+ * @param n            Src number of packed genotypes.
+ * @param shift        Src number of bits per allele.
+ * @param add          Src number of bits reserved for phasing (0 or 1).
+ * @param global_phase Src phasing used if add is 0.
+ * @param recode       Src if TRUE then alleles are biallelic M1 codes and are recoded.
+ * @param soa          Dst arrays with room for at least n runs.
+ * @return             Returns the total run length.
+ */
+uint64_t UnpackDiploidRuns(const uint8_t* data, const uint8_t p, const uint32_t n, const uint8_t shift, const uint8_t add, const uint8_t global_phase, const bool recode, yon_gt_soa& soa);
+
 // Forward declare.
 struct yon_gt_summary;
 
@@ -240,6 +356,7 @@ public:
 	*     M1) Diploid bi-allelic and no EOV
 	*     M2) Diploid any allele count, missingness, and EOV
 	*     M4) Nploid any
+	*     M8) Sparse carrier list of any ploidy
 	*
 	* @return Returns TRUE upon success or FALSE otherwise
 	*/
@@ -247,10 +364,29 @@ public:
 	bool EvaluateRecordsM1();
 	bool EvaluateRecordsM2();
 	bool EvaluateRecordsM4();
-	template <class T> bool EvaluateRecordsM1_();
-	template <class T> bool EvaluateRecordsM2_();
+
+	/**<
+	 * Decode a sparse carrier list into records. Samples between carriers
+	 * are homozygous for the reference allele and are collapsed into a
+	 * single record such that the number of records, and therefore the
+	 * cost of any downstream summary or Occ partition, is proportional
+	 * to the number of carriers rather than the number of samples.
+	 * Adjacent carriers sharing the same alleles are merged.
+	 * @return Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool EvaluateRecordsM8();
+	bool EvaluateRecordsDiploid();
 	template <class T> bool EvaluateRecordsM4_();
 
+	/**<
+	 * Decode diploid run-length encoded genotypes (M1 and M2) into the
+	 * structure-of-arrays representation (soa). This is invoked when
+	 * evaluating rcds for these methods but may also be called directly
+	 * by consumers that stream over run lengths and alleles.
+	 * @return Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool EvaluateSoa(void);
+
 	/**<
 	 * Wrapper for expanding (possibly) run-length encoded rcds structures
 	 * into a vector of length N where each entry corresponds to a single
@@ -282,6 +418,22 @@ public:
 	*/
 	bcf1_t* UpdateHtslibGenotypes(bcf1_t* rec, bcf_hdr_t* hdr);
 
+	/**<
+	 * Allocate n yon_gt_rcd objects with allele memory reserved for the
+	 * base ploidy of this object. If an arena is attached then both the
+	 * records and their alleles are served from one contiguous slab of
+	 * arena memory; otherwise they are heap-allocated and owned by the
+	 * records themselves.
+	 * @param n_records Number of records to allocate.
+	 * @return          Returns a pointer to the first record.
+	 */
+	yon_gt_rcd* AllocateRecords(const uint32_t n_records) const;
+
+private:
+	// Release all lazy-evaluated record data. Record data served
+	// from an arena is released collectively when it is reset.
+	void ReleaseRecords(void);
+
 public:
 	uint16_t eval_cont;
 	uint8_t  add : 7,
@@ -289,112 +441,30 @@ public:
 	uint8_t  shift;
 	uint8_t  p, m, method; // bytes per entry, base ploidy, base method
 	uint32_t n_s, n_i, n_o;     // number samples, number of entries
+	uint32_t n_c; // number of carriers (sparse encoding only)
 	uint8_t  n_allele;
 	yon_gt_ppa* ppa; // pointer to ppa
 	const uint8_t* data; // pointer to data
 	yon_gt_rcd* d_exp; // lazy evaluated from ppa/normal to internal offset (length = n_samples). This can be very expensive if evaluated internally for every record.
 	yon_gt_rcd* rcds; // lazy interpreted internal records
+	yon_gt_soa soa; // lazy decoded diploid runs (M1 and M2 only)
 	uint32_t* n_i_occ;
 	yon_gt_rcd** d_occ; // lazy evaluation of occ table
+	yon_arena* arena; // not owned: memory arena serving rcds and d_occ (if any)
 	bool dirty;
 };
 
-template <class T>
-bool yon_gt::EvaluateRecordsM1_() {
-	// Prevent double evaluation.
-	if (this->eval_cont & YON_GT_UN_RCDS)
-		return true;
-
-	if (this->rcds != nullptr) delete [] this->rcds;
-	assert(this->m == 2);
-	assert(this->n_allele == 2);
-
-	// Allocate memory for new records.
-	this->rcds = new yon_gt_rcd[this->n_i];
-
-	// Reinterpret byte stream into the appropriate actual
-	// primitive type.
-	const T* r_data = reinterpret_cast<const T*>(this->data);
-
-	// Keep track of the cumulative number of genotypes observed
-	// as a means of asserting correctness.
-	uint64_t n_total = 0;
-
-	// Iterate over the internal run-length encoded genotypes
-	// and populate the rcds structure.
-	for (uint32_t i = 0; i < this->n_i; ++i) {
-		uint8_t phasing = 0;
-		if (add) phasing = r_data[i] & 1;
-		else    phasing = this->global_phase;
-
-		this->rcds[i].run_length = YON_GT_RLE_LENGTH(r_data[i], shift, add);
-		this->rcds[i].allele = new uint8_t[2];
-		this->rcds[i].allele[0] = YON_GT_RLE_ALLELE_B(r_data[i], shift, add);
-		this->rcds[i].allele[1] = YON_GT_RLE_ALLELE_A(r_data[i], shift, add);
-		// Store an allele encoded as (ALLELE << 1 | phasing).
-		this->rcds[i].allele[0] = (YON_GT_RLE_RECODE[this->rcds[i].allele[0]] << 1) | phasing;
-		this->rcds[i].allele[1] = (YON_GT_RLE_RECODE[this->rcds[i].allele[1]] << 1) | phasing;
-		n_total += this->rcds[i].run_length;
-	}
-	assert(n_total == this->n_s);
-	this->eval_cont |= YON_GT_UN_RCDS;
-
-	return true;
-}
-
-template <class T>
-bool yon_gt::EvaluateRecordsM2_() {
-	// Prevent double evaluation.
-	if (this->eval_cont & YON_GT_UN_RCDS)
-		return true;
-
-	if (this->rcds != nullptr) delete [] this->rcds;
-	assert(this->m == 2);
-
-	// Allocate memory for new records.
-	this->rcds = new yon_gt_rcd[this->n_i];
-
-	// Reinterpret byte stream into the appropriate actual
-	// primitive type.
-	const T* r_data = reinterpret_cast<const T*>(this->data);
-
-	// Keep track of the cumulative number of genotypes observed
-	// as a means of asserting correctness.
-	uint64_t n_total = 0;
-
-	// Iterate over the internal run-length encoded genotypes
-	// and populate the rcds structure.
-	for (uint32_t i = 0; i < this->n_i; ++i) {
-		uint8_t phasing = 0;
-		if (add) phasing = r_data[i] & 1;
-		else    phasing = this->global_phase;
-
-		this->rcds[i].run_length = YON_GT_RLE_LENGTH(r_data[i], shift, add);
-		this->rcds[i].allele = new uint8_t[2];
-		this->rcds[i].allele[0] = YON_GT_RLE_ALLELE_B(r_data[i], shift, add);
-		this->rcds[i].allele[1] = YON_GT_RLE_ALLELE_A(r_data[i], shift, add);
-		// Store an allele encoded as (ALLELE << 1 | phasing).
-		this->rcds[i].allele[0] = (this->rcds[i].allele[0] << 1) | phasing;
-		this->rcds[i].allele[1] = (this->rcds[i].allele[1] << 1) | phasing;
-		n_total += this->rcds[i].run_length;
-	}
-	assert(n_total == this->n_s);
-	this->eval_cont |= YON_GT_UN_RCDS;
-
-	return true;
-}
-
 template <class T>
 bool yon_gt::EvaluateRecordsM4_() {
 	// Prevent double evaluation.
 	if (this->eval_cont & YON_GT_UN_RCDS)
 		return true;
 
-	if (this->rcds != nullptr) delete [] this->rcds;
+	if (this->rcds != nullptr && this->arena == nullptr) delete [] this->rcds;
 	assert(this->m != 2);
 
 	// Allocate memory for new records.
-	this->rcds = new yon_gt_rcd[this->n_i];
+	this->rcds = this->AllocateRecords(this->n_i);
 
 	// Keep track of the cumulative number of genotypes observed
 	// as a means of asserting correctness.
@@ -408,7 +478,6 @@ bool yon_gt::EvaluateRecordsM4_() {
 		b_offset += sizeof(T);
 
 		this->rcds[i].run_length = *run_length;
-		this->rcds[i].allele = new uint8_t[this->m];
 		for (uint32_t j = 0; j < this->m; ++j, ++b_offset)
 			this->rcds[i].allele[j] = this->data[b_offset];
 
@@ -420,6 +489,96 @@ bool yon_gt::EvaluateRecordsM4_() {
 	return true;
 }
 
+/**<
+ * Cache-blocked expansion of genotypes into the original sample order.
+ * Expanding records one at a time through the permutation array scatters
+ * every record over an n_samples-sized array and is bound by cache misses
+ * for large sample sizes. Records sharing a permutation are instead
+ * expanded a tile of records at a time: each record is first expanded in
+ * permuted order with sequential writes into its scratch row and the
+ * tile is then un-permuted a range of samples at a time by gathering
+ * through the inverse permutation. A range of the inverse permutation is
+ * reused by all records of the tile and all writes are sequential. No
+ * memory is allocated per sample or per record.
+ *
+ * Expanded genotypes are stored as rows of n_samples * m bytes where m is
+ * the base ploidy of the record. Alleles are encoded as in yon_gt_rcd.
+ * A single set of records is returned by GetRecords() and is only
+ * rewritten if the row or its ploidy changes.
+ */
+struct yon_gt_tiled_exp {
+public:
+	yon_gt_tiled_exp(void);
+	yon_gt_tiled_exp(const yon_gt_tiled_exp& other) = delete;
+	yon_gt_tiled_exp& operator=(const yon_gt_tiled_exp& other) = delete;
+	~yon_gt_tiled_exp(void);
+
+	/**<
+	 * Allocate memory for a new number of samples. All previous data is
+	 * deleted without consideration.
+	 * @param n_samples      Number of samples.
+	 * @param n_tile_records Maximum number of records in a tile.
+	 * @param n_tile_samples Number of samples un-permuted at a time.
+	 */
+	void Allocate(const uint32_t n_samples,
+	              const uint32_t n_tile_records = YON_GT_TILE_RECORDS,
+	              const uint32_t n_tile_samples = YON_GT_TILE_SAMPLES);
+
+	/**<
+	 * Invalidate the cached inverse permutation. This has to be called
+	 * whenever the contents of a permutation array passed to Expand()
+	 * may have changed, such as when a new block is loaded.
+	 */
+	void ResetPermutation(void);
+
+	/**<
+	 * Expand a tile of records. All records must share the same
+	 * permutation array (or have none). Records that are nullptr are
+	 * skipped and their rows are left unset.
+	 * @param gts       Src array of genotype containers.
+	 * @param n_records Number of records; at most n_tile_records.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Expand(yon_gt* const* gts, const uint32_t n_records);
+
+	/**<
+	 * Retrieve the expanded genotypes of a record in the current tile as
+	 * yon_gt_rcd records with a run length of one. These records point
+	 * into the expanded row and are valid until the next call to Expand()
+	 * or GetRecords() and must not be modified.
+	 * @param record Record offset in the current tile.
+	 * @return       Returns a pointer to n_samples records.
+	 */
+	yon_gt_rcd* GetRecords(const uint32_t record);
+
+	inline const uint8_t* GetRow(const uint32_t record) const { return(&this->rows[record * this->b_row]); }
+	inline uint32_t size(void) const { return(this->n_r); }
+	inline uint32_t capacity(void) const { return(this->n_tile_r); }
+
+private:
+	// Build the inverse of a permutation array.
+	void SetPermutation(const yon_gt_ppa* ppa);
+
+	// Expand the runs of a record into dst in stored order.
+	bool ExpandRuns(yon_gt* gt, uint8_t* dst) const;
+
+public:
+	uint32_t n_s; // number of samples
+	uint32_t n_tile_r; // maximum number of records in a tile
+	uint32_t n_tile_s; // number of samples un-permuted at a time
+	uint32_t n_r; // number of records in the current tile
+	uint8_t  m_row; // ploidy the rows are allocated for
+	uint64_t b_row; // bytes per row
+	const yon_gt_ppa* ppa; // not owned: permutation the inverse was built from
+	uint32_t* inverse; // inverse permutation: original sample -> stored offset
+	uint8_t* ploidy; // base ploidy of each record in the current tile
+	uint8_t* scratch; // records in stored order
+	uint8_t* rows; // records in original sample order
+	uint32_t view_r; // row the view was built for
+	uint8_t  view_m; // ploidy the view was built for or 0
+	yon_gt_rcd* view; // n_samples records pointing into a row
+};
+
 /****************************
 *  Genotype summary statistics
 ****************************/
@@ -440,6 +599,9 @@ bool yon_gt::EvaluateRecordsM4_() {
  * This object should be considered internal. Manipulation of this object
  * without modifying all othe related genotype objects could result in
  * significant discord.
+ *
+ * If the object was constructed in an arena then it and its arrays are
+ * owned by that arena: see yon_gt_summary::ReleaseEvaluation().
  */
 struct yon_gt_summary_rcd {
 public:
@@ -463,38 +625,29 @@ public:
 	float hwe_p;// hardy-weinberg p
 	float f_pic;
 	float heterozygosity;
+	bool is_arena; // this object and its arrays are served from an arena
 };
 
+// Maximum number of cells (n_alleles ^ ploidy) in a dense genotype
+// count tensor. Summaries with more possible genotypes fall back to
+// a sparse table of observed genotypes.
+#define YON_GT_SUMMARY_DENSE_MAX 4096
+
 /**<
- * Primary object used in the genotype trie in yon_gt_summary below. This object is built
- * using information about the number of alleles. However this information
- * is not explicitly stored here (it is stored in the parent container).
- * Because of this it is not possible to invoke the copy ctor or copy assign
- * operator (use Clone() instead). It also prevents the use of this object
- * in direct arithmetic use cases.
+ * Genotype summary of a record. Allele counts, allele counts per
+ * chromosome, and the counts of every observed genotype are stored
+ * in a single contiguous buffer. Genotypes are counted in a flat
+ * tensor with n_alleles ^ ploidy cells indexed by the packed allele
+ * tuple (the first allele in the most significant position) such
+ * that the diploid genotype a/b is stored at a * n_alleles + b. If
+ * the tensor would exceed YON_GT_SUMMARY_DENSE_MAX cells then the
+ * observed genotypes are stored in an open-addressing hash table
+ * instead.
+ *
+ * Memory is retained between calls to Setup() and is only allocated
+ * if the required size grows. If an arena is attached then memory is
+ * served from that arena and released collectively when it is reset.
  */
-struct yon_gt_summary_obj {
-public:
-	yon_gt_summary_obj();
-	yon_gt_summary_obj(const yon_gt_summary_obj& other) = delete;
-	yon_gt_summary_obj& operator=(const yon_gt_summary_obj& other) = delete;
-	yon_gt_summary_obj(yon_gt_summary_obj&& other) noexcept;
-	yon_gt_summary_obj& operator=(yon_gt_summary_obj&& other) noexcept;
-	~yon_gt_summary_obj();
-
-	// Clone helper ctor.
-	yon_gt_summary_obj(const uint8_t n_alleles, const uint64_t cnt, yon_gt_summary_obj* c);
-
-	yon_gt_summary_obj Clone(const uint8_t n_alleles) { return(yon_gt_summary_obj(n_alleles, n_cnt, children)); }
-
-	inline yon_gt_summary_obj& operator[](const uint32_t pos) { return(this->children[pos]); }
-	inline const yon_gt_summary_obj& operator[](const uint32_t pos) const{ return(this->children[pos]); }
-
-public:
-	uint64_t n_cnt;
-	yon_gt_summary_obj* children;
-};
-
 struct yon_gt_summary {
 public:
 	yon_gt_summary(void);
@@ -505,26 +658,89 @@ public:
 	yon_gt_summary& operator=(const yon_gt_summary& other);
 	~yon_gt_summary();
 
+	/**<
+	 * Prepare the summary for a record with the given base ploidy and
+	 * number of alleles. All counts are reset to zero and previously
+	 * allocated memory is reused if it is sufficiently large.
+	 * @param base_ploidy Base ploidy of the record.
+	 * @param n_als       Number of alleles excluding the missing and sentinel symbols.
+	 */
 	void Setup(const uint8_t base_ploidy, const uint8_t n_als);
 
 	/**<
-	 * Iteratively add layers to the complete trie in order to represent
-	 * a possible ploidy-dimensional matrix at the leafs. The memory
-	 * cost of the trie is O(n_alleles ^ ploidy) and allows the prefix
-	 * lookup of any partial genotype.
-	 *children
-	 * @param target
-	 * @param depth
-	 * @return
+	 * Serve all subsequent memory from an arena rather than the heap.
+	 * Memory served from an arena is never freed by this object.
+	 * @param arena Src arena that is not owned or nullptr to use the heap.
 	 */
-	bool AddGenotypeLayer(yon_gt_summary_obj* target, uint8_t depth);
+	inline void SetArena(yon_arena* arena) { this->arena = arena; }
 
 	yon_gt_summary& operator+=(const yon_gt& gt);
 	yon_gt_summary& Add(const yon_gt& gt, const uint32_t n_i, const yon_gt_rcd* rcds);
 
+	/**<
+	 * Add the counts of another summary with the same base ploidy and
+	 * number of alleles. Dense summaries are added element-wise over
+	 * their contiguous buffers.
+	 * @param other Src summary.
+	 * @return      Returns a reference to this object.
+	 */
+	yon_gt_summary& operator+=(const yon_gt_summary& other);
+
+	/**<
+	 * Add the genotypes of a record directly from its encoded data without
+	 * evaluating any yon_gt_rcd records. Diploid run-length encodings (M1
+	 * and M2) are tallied per packed genotype with every run weighted by
+	 * its length and the tallies are then folded into the allele counts
+	 * and the genotype tensor. Sparse carrier lists (M8) only visit their
+	 * carriers. The cost is therefore O(runs) rather than O(samples).
+	 * The encoding is validated before any counts are added such that
+	 * the summary is unchanged if FALSE is returned.
+	 * @param gt Src genotype container.
+	 * @return   Returns TRUE upon success or FALSE if the encoding is not supported.
+	 */
+	bool AddEncoded(const yon_gt& gt);
+	template <class T> bool AddEncodedDiploid_(const yon_gt& gt);
+	bool AddEncodedSparse(const yon_gt& gt);
+
+	/**<
+	 * Add a count to a genotype. Alleles are unpacked allele codes
+	 * (YON_GT_RCD_ALLELE_UNPACK) and must be smaller than n_alleles.
+	 * Allele counts are not updated.
+	 * @param alleles Src tuple of n_ploidy alleles.
+	 * @param count   Number of observations.
+	 */
+	inline void AddGenotype(const uint8_t* alleles, const uint64_t count) {
+		if (this->n_cells) this->genotypes[this->GetGenotypeIndex(alleles)] += count;
+		else this->AddSparse(alleles, count);
+	}
+
+	/**<
+	 * Returns the number of observations of a genotype.
+	 * @param alleles Src tuple of n_ploidy unpacked allele codes.
+	 * @return        Returns the number of observations.
+	 */
+	uint64_t GetGenotypeCount(const uint8_t* alleles) const;
+
+	// Number of observations of the diploid genotype a/b.
+	inline uint64_t GetGenotypeCount(const uint8_t a, const uint8_t b) const {
+		assert(this->n_ploidy == 2);
+		if (this->n_cells) return(this->genotypes[(uint32_t)a * this->n_alleles + b]);
+		const uint8_t alleles[2] = {a, b};
+		return(this->GetGenotypeCount(alleles));
+	}
+
+	// Position of a genotype in the dense tensor.
+	inline uint32_t GetGenotypeIndex(const uint8_t* alleles) const {
+		uint32_t index = 0;
+		for (uint32_t i = 0; i < this->n_ploidy; ++i) index = index * this->n_alleles + alleles[i];
+		return(index);
+	}
+
 	// Accessors to internal data.
 	inline uint32_t* GetAlleleCountsRaw(void) { return(this->alleles); }
 	inline const uint32_t* GetAlleleCountsRaw(void) const{ return(this->alleles); }
+	inline uint32_t GetAlleleStrandCount(const uint32_t chromosome, const uint32_t allele) const { return(this->alleles_strand[chromosome * this->n_alleles + allele]); }
+	inline bool IsDense(void) const { return(this->n_cells != 0); }
 
 	/**<
 	 * Calculates and returns a vector of alelle counts.
@@ -548,17 +764,11 @@ public:
 	std::vector< std::vector<uint64_t> > GetAlleleStrandCounts(void) const;
 
 	/**<
-	 * Traverse the genotypic trie and return the
-	 * @param data
-	 * @param target
-	 * @param depth
-	 * @return
+	 * Returns a record for every genotype with its number of observations
+	 * stored as the run length. Alleles are stored packed and unphased.
+	 * @param drop_empty Predicate for skipping genotypes that were never observed (dense only).
+	 * @return           Returns a vector of genotype records.
 	 */
-	bool GetGenotype(std::vector<uint64_t>& data,
-	                 yon_gt_summary_obj* target,
-	                 uint8_t depth) const;
-
-	// Todo: unfinished.
 	std::vector<yon_gt_rcd> GetGenotypeCounts(bool drop_empty = true) const;
 
 	/**<
@@ -578,34 +788,129 @@ public:
 
 	/**<
 	 * Lazy evaluates the current data in this object into easy-to-use
-	 * elements of the yon_gt_summary_rcd structure.
-	 * @return Returns TRUE upon success or FALSE otherwise.
+	 * elements of the yon_gt_summary_rcd structure. The arrays of a
+	 * previous evaluation are reused if their sizes match. If an arena
+	 * is attached then the record and its arrays are served from it such
+	 * that nothing is allocated on the heap per record. Hypothesis
+	 * tests (Hardy-Weinberg and strand bias) can be skipped if they are
+	 * computed in batch elsewhere: the Hardy-Weinberg P-value is then -1.
+	 * @param hypothesis_tests Predicate for computing hypothesis tests.
+	 * @return                 Returns TRUE upon success or FALSE otherwise.
 	 */
-	bool LazyEvaluate(void);
+	bool LazyEvaluate(const bool hypothesis_tests = true);
+
+private:
+	// Add a count to a genotype in the sparse table.
+	void AddSparse(const uint8_t* alleles, const uint64_t count);
+
+	// Position of a genotype in the sparse table.
+	uint32_t FindSparse(const uint8_t* alleles) const;
+
+	// Release memory that is owned by this object.
+	void Release(void);
+
+	// Release a lazy evaluated record. Records constructed in an arena
+	// are only destructed.
+	static void ReleaseEvaluation(yon_gt_summary_rcd* d);
 
 public:
 	uint8_t    n_ploidy; // base ploidy at site
 	uint8_t    n_alleles; // number of alleles
+	bool       is_arena; // buffer is served from the arena
+	uint32_t   n_cells; // number of cells in the dense tensor or 0 if sparse
+	uint64_t   m_buffer; // capacity of the buffer in 64-bit words
+	uint64_t*  buffer; // genotypes, alleles, and alleles_strand in one allocation
+	uint64_t*  genotypes; // dense genotype count tensor (if dense)
 	uint32_t*  alleles; // allele counts
-	uint32_t** alleles_strand; // allelic counts per chromosome
-	yon_gt_summary_obj* gt; // complete genotypic trie with branch-size n_alleles
+	uint32_t*  alleles_strand; // allelic counts per chromosome: [chromosome * n_alleles + allele]
+	std::vector<uint32_t> sparse_table; // open-addressing table of entry + 1 (or 0 if empty)
+	std::vector<uint8_t>  sparse_alleles; // n_ploidy alleles per sparse entry
+	std::vector<uint64_t> sparse_counts; // count per sparse entry
 	yon_gt_summary_rcd* d; // lazy evaluated record
+	yon_gt_summary_rcd* d_unused; // previous evaluation retained for reuse
+	yon_arena* arena; // not owned: memory arena serving the buffer (if any)
 };
 
+template <class T>
+bool yon_gt_summary::AddEncodedDiploid_(const yon_gt& gt) {
+	const T* r_data = reinterpret_cast<const T*>(gt.data);
+	const uint32_t n_symbols = 1 << (2*gt.shift);
+	const uint32_t mask      = (1 << gt.shift) - 1;
+
+	// Tally run lengths per packed genotype ignoring phase. The
+	// packed genotype stores the first allele in its upper bits.
+	uint64_t  counts_local[256];
+	std::vector<uint64_t> counts_heap;
+	uint64_t* counts = counts_local;
+	if (n_symbols > 256) {
+		counts_heap.resize(n_symbols, 0);
+		counts = counts_heap.data();
+	} else memset(counts, 0, sizeof(uint64_t)*n_symbols);
+
+	for (uint32_t i = 0; i < gt.n_i; ++i)
+		counts[(r_data[i] >> gt.add) & (n_symbols - 1)] += YON_GT_RLE_LENGTH(r_data[i], gt.shift, gt.add);
+
+	// Validate every observed genotype before adding any counts such
+	// that the summary is left untouched if the encoding is rejected.
+	for (uint32_t s = 0; s < n_symbols; ++s) {
+		if (counts[s] == 0) continue;
+
+		uint32_t a = s >> gt.shift;
+		uint32_t b = s & mask;
+		if (gt.method == 1) {
+			if (a > 2 || b > 2) return false;
+			a = YON_GT_RLE_RECODE[a];
+			b = YON_GT_RLE_RECODE[b];
+		}
+		if (a >= this->n_alleles || b >= this->n_alleles) return false;
+	}
+
+	for (uint32_t s = 0; s < n_symbols; ++s) {
+		if (counts[s] == 0) continue;
+
+		uint32_t a = s >> gt.shift;
+		uint32_t b = s & mask;
+		if (gt.method == 1) {
+			a = YON_GT_RLE_RECODE[a];
+			b = YON_GT_RLE_RECODE[b];
+		}
+
+		const uint8_t genotype[2] = {(uint8_t)a, (uint8_t)b};
+		this->AddGenotype(genotype, counts[s]);
+		this->alleles[a] += counts[s];
+		this->alleles[b] += counts[s];
+		this->alleles_strand[a] += counts[s];
+		this->alleles_strand[this->n_alleles + b] += counts[s];
+	}
+	return true;
+}
+
 /****************************
 *  Occ functionality
 ****************************/
 
+// Cumulative sums of groupings are padded to a multiple of this many
+// 32-bit lanes per row.
+#define YON_OCC_LANES 16
+
 /**<
  * Structure for using the partial-sum algortihms with constrained run-length
  * encoded genotypes. Allows for O(1)-time partitions into one or more groupings.
+ *
+ * Cumulative sums are stored in a single row-major buffer with one row
+ * per sample offset in the permutation order of the current block and
+ * one column per grouping. The number of members of every grouping in
+ * a run spanning the sample offsets [from, to) is then the element-wise
+ * difference of two rows. Rows are built with vectorized row additions.
+ * If the permutation changes between blocks then only the rows between
+ * the first and the last sample offset that moved are rebuilt.
  */
 struct yon_occ {
 public:
 	typedef std::unordered_map<std::string, uint32_t> map_type;
 
 public:
-	yon_occ() = default;
+	yon_occ();
 	~yon_occ() = default;
 
 	/**<
@@ -621,12 +926,23 @@ public:
 	/**<
 	 * Construct an Occ table from the pre-loaded matrix of sample->groupings.
 	 * The BuildTable() and BuildTable(yon_gt_ppa*) function requires that
-	 * ReadTable() has been run and successfully completed.
+	 * ReadTable() has been run and successfully completed. The table is
+	 * retained if it was previously built in the same permutation and
+	 * otherwise only the rows spanning the moved samples are rebuilt.
 	 * @return Returns TRUE upon success or FALSE otherwise.
 	 */
 	bool BuildTable(void);
 	bool BuildTable(const yon_gt_ppa* ppa_p);
 
+	/**<
+	 * Cumulative number of members of every grouping preceding a sample
+	 * offset in the current permutation.
+	 * @param offset Src sample offset in [0, n_samples].
+	 * @return       Returns a pointer to a row of n_groups counts.
+	 */
+	inline const uint32_t* GetRow(const uint32_t offset) const { return(&this->occ[(uint64_t)offset * this->stride]); }
+	inline uint32_t size(void) const { return(this->n_groups); }
+
 public:
 	// Map from group name to row offset in the table.
 	map_type map;
@@ -635,16 +951,20 @@ public:
 	// Total cumulative sums for each row.
 	std::vector<uint32_t> cum_sums;
 
-	// A matrix with proportions samples times groupings
-	// rows corresponds to the cumulative sum of a grouping
-	// over the samples. The table corresponds to the set
-	// membership (presence or absence) and the occ table
-	// corresponds to the cumsum at any given sample offset.
-	std::vector< std::vector<uint32_t> > table;
-	std::vector< std::vector<uint32_t> > occ;
-	// Transpose of occ table for data locality lookups when
-	// using constrained run-length encoded objects.
-	std::vector< std::vector<uint32_t> > vocc;
+	uint32_t n_groups; // number of groupings
+	uint32_t n_samples; // number of samples
+	uint32_t stride; // number of lanes per row (n_groups padded to YON_OCC_LANES)
+	bool built; // occ has been built
+	bool permuted; // occ has been built in the permutation of a ppa
+	// Set membership (presence or absence) with one row per sample in
+	// the original sample order.
+	std::vector<uint8_t> table;
+	// Cumulative sums with n_samples + 1 rows in the permutation order
+	// of the current block.
+	std::vector<uint32_t> occ;
+	// Permutation the cumulative sums were built in (identity if the
+	// block has no permutation).
+	std::vector<uint32_t> ordering;
 };
 
 /****************************
@@ -794,6 +1114,33 @@ static yon_gt* GetGenotypeNploid(
 	return(x);
 }
 
+static yon_gt* GetGenotypeSparse(
+	const char* data,
+	const uint32_t n_carriers,
+	const uint32_t n_samples,
+	const uint16_t n_als,
+	const uint8_t  n_ploidy,
+	const uint16_t controller,
+	yon_gt_ppa* ppa)
+{
+	yon_gt* x = new yon_gt;
+	const yon_vnt_cnt* cont = reinterpret_cast<const yon_vnt_cnt*>(&controller);
+	x->shift = 0;
+	x->add   = 0;
+	x->global_phase = cont->gt_phase_uniform;
+	x->data = reinterpret_cast<const uint8_t*>(data);
+	x->n_i = 0;
+	x->n_c = n_carriers;
+	x->method = 8;
+	x->m = n_ploidy;
+	x->p = sizeof(uint8_t);
+	x->n_s = n_samples;
+	x->n_allele = n_als;
+	x->ppa = ppa;
+
+	return(x);
+}
+
 }
 
 #endif
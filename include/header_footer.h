@@ -65,6 +65,16 @@ public:
 	bool BuildReverseMaps(void);
 	bool BuildMaps(void);
 
+	/**<
+	 * Checks if the data encoded using another header can be interpreted
+	 * using this header without translation. This requires that the samples,
+	 * contigs, and Info, Format, and Filter field dictionaries are identical
+	 * and in the same order as their array offsets are stored in the blocks.
+	 * @param other Src header to compare against.
+	 * @return      Returns TRUE if compatible or FALSE otherwise.
+	 */
+	bool IsCompatible(const self_type& other) const;
+
 	/**<
 	 * Recodes the internal IDX field for contig info, INFO, FORMAT, and FILTER
 	 * from any range to the range [0, 1, ..., n-1] as desired in Tachyon.
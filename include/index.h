@@ -107,6 +107,22 @@ public:
 	                  const uint32_t yon_block_id);
 
 	self_type& operator+=(const entry_type& entry);
+
+	/**<
+	 * Append the index of another archive whose blocks have been copied,
+	 * byte-for-byte, to the end of the archive described by this index. The
+	 * linear and meta entries of the other index are shifted by the provided
+	 * block and byte offsets and its quad-tree bins are remapped to the new
+	 * block identifiers. Both indices must have been set up with the same
+	 * contigs. The appended blocks must keep the archive sorted: contigs
+	 * cannot be interleaved and positions within a contig must not decrease.
+	 * @param other             Src index of the copied archive.
+	 * @param block_offset      Identifier of the first appended block in this archive.
+	 * @param byte_offset_delta Difference between the destination and source byte offsets.
+	 * @return                  Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Append(const self_type& other, const uint32_t block_offset, const int64_t byte_offset_delta);
+
 	entry_type& operator[](const uint32_t block_id);
 	const entry_type& operator[](const uint32_t block_id) const;
 
@@ -0,0 +1,223 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_LINKAGE_DISEQUILIBRIUM_H_
+#define TACHYON_LINKAGE_DISEQUILIBRIUM_H_
+
+#include <deque>
+#include <vector>
+
+#include "genotypes.h"
+#include "variant_container.h"
+#include "algorithm/parallel/fork_join.h"
+
+namespace tachyon {
+
+// Number of records per side of a tile of pairs computed by one worker.
+#define YON_LD_TILE_RECORDS 64
+
+/**<
+ * Linkage disequilibrium statistics.
+ *    HAPLOTYPE) Haplotype r-squared and D' computed from allele counts
+ *               over haplotypes. Genotypes are assumed to be phased.
+ *    GENOTYPE)  Squared Pearson correlation of alternative allele
+ *               dosages. Phasing is not used and D' is not defined.
+ */
+enum TACHYON_LD_MODE {
+	YON_LD_HAPLOTYPE,
+	YON_LD_GENOTYPE
+};
+
+struct yon_ld_settings {
+public:
+	yon_ld_settings() : mode(YON_LD_HAPLOTYPE), window_bp(1000000), window_records(0), min_r2(0.2), n_threads(1) {}
+
+public:
+	TACHYON_LD_MODE mode;
+	int64_t  window_bp; // maximum distance between pairs or 0 for unlimited
+	uint32_t window_records; // maximum number of records between pairs or 0 for unlimited
+	double   min_r2; // pairs with a smaller r-squared are not reported
+	uint32_t n_threads;
+};
+
+/**<
+ * Statistics of a pair of records. Records are identified by their
+ * sequential number in the order they were added and a always precedes
+ * b. Statistics are NaN if either record is monomorphic over the
+ * jointly observed haplotypes or samples.
+ */
+struct yon_ld_pair {
+public:
+	yon_ld_pair() : a(0), b(0), rid_a(0), rid_b(0), pos_a(0), pos_b(0), n(0), r2(0), d_prime(0) {}
+
+public:
+	uint64_t a, b;
+	uint32_t rid_a, rid_b;
+	int64_t  pos_a, pos_b;
+	uint32_t n; // number of jointly observed haplotypes (or samples)
+	float    r2, d_prime;
+};
+
+// Record used in the computation of linkage disequilibrium.
+struct yon_ld_record {
+public:
+	yon_ld_record() : id(0), rid(0), pos(0) {}
+	yon_ld_record(const uint64_t id, const uint32_t rid, const int64_t pos) : id(id), rid(rid), pos(pos) {}
+
+public:
+	uint64_t id; // sequential record number
+	uint32_t rid;
+	int64_t  pos;
+};
+
+/**<
+ * Bit-packed diploid genotypes of a record with one bit per haplotype.
+ * Haplotypes 2*i and 2*i+1 are the alleles of the sample stored at
+ * position i of the permutation the bitmap is stored in. Any allele
+ * other than the reference counts as alternative such that
+ * multi-allelic records are collapsed to bi-allelic.
+ */
+struct yon_ld_bitmap {
+public:
+	yon_ld_bitmap() : id(0), rid(0), pos(0), n_pad(0), n_alt(0), n_valid(0), n_hom(0) {}
+
+	/**<
+	 * Construct the bitmaps of a diploid record. Run-length encoded
+	 * genotypes set ranges of bits at a time without expanding them.
+	 * In the genotype mode a sample is only observed if both alleles
+	 * are observed.
+	 * @param gt   Src genotypes.
+	 * @param mode Src statistics the bitmaps are used for.
+	 * @return     Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Build(yon_gt& gt, const TACHYON_LD_MODE mode);
+
+	/**<
+	 * Move all bitmaps into another permutation.
+	 * @param from    Src ordering of the bitmaps or nullptr if unpermuted.
+	 * @param inverse Src inverse of the destination ordering or nullptr if unpermuted.
+	 * @param mode    Src statistics the bitmaps are used for.
+	 * @param scratch Src/Dst scratch memory.
+	 */
+	void Permute(const uint32_t* from, const uint32_t* inverse, const TACHYON_LD_MODE mode, std::vector<uint64_t>& scratch);
+
+	inline bool IsComplete(void) const { return(this->n_valid == this->valid.size() * 64 - this->n_pad); }
+
+public:
+	uint64_t id; // sequential record number
+	uint32_t rid;
+	int64_t  pos;
+	uint32_t n_pad; // unused bits in the last word
+	uint32_t n_alt, n_valid, n_hom; // number of alternative, observed, and homozygous alternative (genotype mode) bits
+	std::vector<uint64_t> alt; // alternative alleles
+	std::vector<uint64_t> valid; // observed alleles
+	std::vector<uint64_t> swap; // alt with the alleles of every sample swapped (genotype mode)
+	std::vector<uint64_t> hom; // first allele of homozygous alternative samples (genotype mode)
+};
+
+/**<
+ * Linkage disequilibrium engine over bit-packed haplotypes. Records are
+ * added a block at a time and every record is compared to all preceding
+ * records within a sliding window on the same contig. Bitmaps are built
+ * directly from the run-length encoded genotypes in the permutation
+ * order of their block, and the records retained in the window are
+ * moved into the permutation of each new block. Counts are computed with
+ * popcounts dispatched at run-time to the widest instruction set
+ * supported by the processor and tiles of pairs are computed in
+ * parallel.
+ *
+ * Only diploid records are supported: other records are skipped.
+ */
+class LinkageDisequilibrium {
+public:
+	typedef LinkageDisequilibrium self_type;
+
+public:
+	LinkageDisequilibrium();
+	~LinkageDisequilibrium();
+	LinkageDisequilibrium(const self_type& other) = delete;
+	LinkageDisequilibrium& operator=(const self_type& other) = delete;
+
+	/**<
+	 * Prepare the engine for a new set of records. All previous data is
+	 * deleted without consideration.
+	 * @param n_samples Number of samples.
+	 * @param settings  Src settings.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Open(const uint32_t n_samples, const yon_ld_settings& settings);
+
+	/**<
+	 * Add the records of a block and compute the statistics of all new
+	 * pairs. Records have to be added in sorted order. Pairs are stored
+	 * ordered by b and then a and replace the pairs of the previous call.
+	 * @param vc Src container of variants.
+	 * @return   Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Add(yon1_vc_t& vc);
+
+	inline const std::vector<yon_ld_pair>& GetPairs(void) const { return(this->pairs); }
+	inline const std::vector<yon_ld_record>& GetRecords(void) const { return(this->records); } // records of the previous call that were not skipped
+	inline uint64_t GetNumberRecords(void) const { return(this->n_records); }
+	inline uint64_t GetNumberSkipped(void) const { return(this->n_skipped); }
+
+private:
+	// Move the window into the permutation of a new block.
+	void SetPermutation(const yon_gt_ppa* ppa);
+
+	// Compute the statistics of one pair of records.
+	bool Compute(const yon_ld_bitmap& a, const yon_ld_bitmap& b, yon_ld_pair& pair) const;
+
+	// Compute all pairs in tile t.
+	void ComputeTile(const uint32_t t, std::vector<yon_ld_pair>& out) const;
+
+	// Retrieve an unused bitmap.
+	yon_ld_bitmap* AcquireBitmap(void);
+
+private:
+	// Tile of pairs: new records [b_from, b_to) against the window
+	// records [a_from, a_to).
+	struct yon_ld_tile {
+		uint32_t b_from, b_to, a_from, a_to;
+	};
+
+	uint32_t n_s;
+	uint64_t n_records; // number of records added
+	uint64_t n_skipped; // number of records without diploid genotypes
+	yon_ld_settings settings;
+	bool permuted; // the window is stored in a permutation
+	std::vector<uint32_t> ordering; // permutation of the window
+	std::vector<uint32_t> inverse;
+	std::vector<uint64_t> scratch;
+	std::deque<yon_ld_bitmap*> window; // retained and new records in order
+	std::vector<uint32_t> lower; // first window record paired with each record
+	std::vector<yon_ld_bitmap*> unused;
+	std::vector<yon_ld_tile> tiles;
+	std::vector< std::vector<yon_ld_pair> > tile_pairs;
+	std::vector<yon_ld_pair> pairs;
+	std::vector<yon_ld_record> records;
+	algorithm::ForkJoinPool pool;
+};
+
+}
+
+#endif /* TACHYON_LINKAGE_DISEQUILIBRIUM_H_ */
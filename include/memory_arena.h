@@ -0,0 +1,212 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_MEMORY_ARENA_H_
+#define TACHYON_MEMORY_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <new>
+#include <vector>
+
+namespace tachyon {
+
+// Default size of each memory chunk allocated by yon_arena.
+const std::size_t YON_ARENA_CHUNK_SIZE = 1 << 20; // 1 MB
+
+/**<
+ * Monotonic (bump-pointer) memory arena. Memory is handed out linearly
+ * from large chunks and is never returned individually: all allocations
+ * are released collectively by reset() or when the arena is destroyed.
+ *
+ * This is used for the many small, short-lived objects that are created
+ * for every record in a block (allele strings, genotype run records) and
+ * that all die together when the block is cleared. Objects constructed
+ * in the arena do NOT have their destructors invoked by the arena itself.
+ */
+struct yon_arena {
+public:
+	typedef yon_arena   self_type;
+	typedef std::size_t size_type;
+
+private:
+	struct yon_arena_chunk {
+		yon_arena_chunk(void) : capacity(0), data(nullptr) {}
+		yon_arena_chunk(const size_type n) : capacity(n), data(static_cast<char*>(::operator new[](n))) {}
+
+		size_type capacity;
+		char* data;
+	};
+
+public:
+	yon_arena(void) :
+		n_chunk_size_(YON_ARENA_CHUNK_SIZE),
+		n_offset_(0),
+		n_used_(0),
+		n_current_(0)
+	{}
+
+	explicit yon_arena(const size_type chunk_size) :
+		n_chunk_size_(chunk_size == 0 ? YON_ARENA_CHUNK_SIZE : chunk_size),
+		n_offset_(0),
+		n_used_(0),
+		n_current_(0)
+	{}
+
+	~yon_arena() { this->ReleaseChunks(); }
+
+	// The arena owns raw memory that other objects point into:
+	// copying or moving it would invalidate those references.
+	yon_arena(const self_type& other) = delete;
+	yon_arena(self_type&& other) = delete;
+	yon_arena& operator=(const self_type& other) = delete;
+	yon_arena& operator=(self_type&& other) = delete;
+
+	/**<
+	 * Request a block of raw memory from the arena.
+	 * @param n_bytes   Number of bytes to allocate.
+	 * @param alignment Alignment (power of two) of the returned address.
+	 * @return          Returns a pointer to uninitialized memory.
+	 */
+	void* Allocate(const size_type n_bytes, const size_type alignment = alignof(std::max_align_t)) {
+		assert((alignment & (alignment - 1)) == 0);
+
+		if (this->n_current_ < this->chunks_.size()) {
+			const size_type offset = this->Align(this->n_offset_, alignment);
+			if (offset + n_bytes <= this->chunks_[this->n_current_].capacity) {
+				this->n_offset_ = offset + n_bytes;
+				this->n_used_  += n_bytes;
+				return(this->chunks_[this->n_current_].data + offset);
+			}
+			++this->n_current_;
+		}
+
+		// Advance to the next chunk that is large enough or create a new one.
+		while (this->n_current_ < this->chunks_.size()
+		       && this->chunks_[this->n_current_].capacity < n_bytes + alignment)
+		{
+			++this->n_current_;
+		}
+
+		if (this->n_current_ == this->chunks_.size())
+			this->chunks_.push_back(yon_arena_chunk(std::max(this->n_chunk_size_, n_bytes + alignment)));
+
+		this->n_offset_ = this->Align(0, alignment);
+		// Chunks are allocated with operator new and are therefore aligned
+		// to at least alignof(std::max_align_t).
+		void* ret = this->chunks_[this->n_current_].data + this->n_offset_;
+		this->n_offset_ += n_bytes;
+		this->n_used_   += n_bytes;
+		return(ret);
+	}
+
+	/**<
+	 * Typed allocation of n uninitialized objects of type T.
+	 * @param n Number of objects.
+	 * @return  Returns a pointer to the first object.
+	 */
+	template <class T>
+	inline T* Allocate(const size_type n) {
+		if (n == 0) return nullptr;
+		return(static_cast<T*>(this->Allocate(n*sizeof(T), alignof(T))));
+	}
+
+	/**<
+	 * Allocate and default-construct n objects of type T in the arena.
+	 * The caller is responsible for invoking destructors if T is not
+	 * trivially destructible.
+	 * @param n Number of objects.
+	 * @return  Returns a pointer to the first object.
+	 */
+	template <class T>
+	T* Construct(const size_type n) {
+		T* ret = this->Allocate<T>(n);
+		for (size_type i = 0; i < n; ++i) new( &ret[i] ) T();
+		return(ret);
+	}
+
+	/**<
+	 * Copy a byte string into arena-owned memory.
+	 * @param src Src data.
+	 * @param len Number of bytes to copy.
+	 * @return    Returns a pointer to the arena-owned copy.
+	 */
+	inline char* CopyString(const char* src, const size_type len) {
+		char* dst = static_cast<char*>(this->Allocate(len, 1));
+		if (len) memcpy(dst, src, len);
+		return(dst);
+	}
+
+	/**<
+	 * Release all allocations at once. Memory is retained for reuse. If
+	 * the previous cycle spilled into several chunks they are coalesced
+	 * into a single chunk of the total size so that subsequent cycles of
+	 * similar volume are served from one contiguous chunk and resetting
+	 * remains O(1) in the steady state.
+	 */
+	void reset(void) {
+		if (this->chunks_.size() > 1) {
+			size_type total = 0;
+			for (size_type i = 0; i < this->chunks_.size(); ++i)
+				total += this->chunks_[i].capacity;
+
+			this->ReleaseChunks();
+			this->chunks_.push_back(yon_arena_chunk(total));
+		}
+		this->n_current_ = 0;
+		this->n_offset_  = 0;
+		this->n_used_    = 0;
+	}
+
+	inline const size_type& size(void) const { return(this->n_used_); }
+	inline size_type capacity(void) const {
+		size_type total = 0;
+		for (size_type i = 0; i < this->chunks_.size(); ++i)
+			total += this->chunks_[i].capacity;
+		return(total);
+	}
+
+private:
+	static inline size_type Align(const size_type offset, const size_type alignment) {
+		return((offset + alignment - 1) & ~(alignment - 1));
+	}
+
+	void ReleaseChunks(void) {
+		for (size_type i = 0; i < this->chunks_.size(); ++i)
+			::operator delete[](static_cast<void*>(this->chunks_[i].data));
+		this->chunks_.clear();
+	}
+
+private:
+	size_type n_chunk_size_; // size of newly created chunks
+	size_type n_offset_;     // offset into the current chunk
+	size_type n_used_;       // number of bytes handed out since last reset
+	size_type n_current_;    // current chunk
+	std::vector<yon_arena_chunk> chunks_;
+};
+
+}
+
+#endif /* TACHYON_MEMORY_ARENA_H_ */
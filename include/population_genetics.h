@@ -0,0 +1,166 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_POPULATION_GENETICS_H_
+#define TACHYON_POPULATION_GENETICS_H_
+
+#include <cmath>
+#include <vector>
+
+#include "genotypes.h"
+
+namespace tachyon {
+
+// Forward declaration.
+class yon1_vc_t;
+
+/**<
+ * Table of log(n!) that is extended on demand. Exact tests evaluate
+ * hypergeometric probabilities as sums of cached log-factorials rather
+ * than calling a log-gamma function per term.
+ */
+struct yon_log_factorial {
+public:
+	yon_log_factorial() : table(1, 0) {}
+
+	// Extend the table to include log(n!).
+	inline void Reserve(const uint64_t n) {
+		if (n < this->table.size()) return;
+		uint64_t i = this->table.size();
+		this->table.resize(n + 1);
+		for (/**/; i <= n; ++i) this->table[i] = this->table[i - 1] + log((double)i);
+	}
+
+	inline double operator[](const uint64_t n) const { return(this->table[n]); }
+
+public:
+	std::vector<double> table;
+};
+
+/**<
+ * Batched population-genetic statistics of diploid bi-allelic records
+ * over groupings of samples. Genotypes of every record in a block are
+ * tallied per grouping into four ordered genotype classes directly from
+ * the run-length encoded genotypes and the cumulative sums of an Occ
+ * table such that every run costs one row subtraction. All statistics
+ * are then computed over the records x groupings matrices:
+ *    1) Hardy-Weinberg exact and chi-squared P-values
+ *    2) Observed heterozygosity and inbreeding coefficients (F)
+ *    3) FIS, FST, and FIT over all groupings
+ *    4) Fisher's exact test for strand bias (ComputeStrandBias())
+ *
+ * All statistics are reported per grouping by
+ * yon1_vnt_t::AddGenotypeStatisticsOcc().
+ *
+ * Records that are not diploid and bi-allelic, or that have no observed
+ * genotypes, are not valid and have no statistics.
+ */
+class PopulationGenetics {
+public:
+	typedef PopulationGenetics self_type;
+
+public:
+	PopulationGenetics();
+	~PopulationGenetics() = default;
+
+	/**<
+	 * Resize and clear all matrices. Memory is retained between calls.
+	 * @param n_records Number of records.
+	 * @param n_groups  Number of groupings.
+	 */
+	void Setup(const uint32_t n_records, const uint32_t n_groups);
+
+	/**<
+	 * Tally the genotypes of every record in a container and compute all
+	 * statistics except for strand bias.
+	 * @param vc  Src container of variants with evaluated genotypes.
+	 * @param occ Src Occ table built in the permutation of the block.
+	 * @return    Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Evaluate(yon1_vc_t& vc, const yon_occ& occ);
+
+	/**<
+	 * Tally the genotypes of a record per grouping. Setup() has to be
+	 * invoked beforehand.
+	 * @param record Src record number in [0, n_records).
+	 * @param gt     Src genotypes with evaluated records.
+	 * @param occ    Src Occ table built in the permutation of the genotypes.
+	 * @return       Returns TRUE if the record is valid or FALSE otherwise.
+	 */
+	bool Tally(const uint32_t record, const yon_gt& gt, const yon_occ& occ);
+
+	/**<
+	 * Compute Hardy-Weinberg P-values, heterozygosity, inbreeding
+	 * coefficients, and F-statistics from the tallied genotypes.
+	 */
+	void Compute(void);
+
+	/**<
+	 * Compute PHRED-scaled Fisher's exact test P-values for strand bias
+	 * from the tallied genotypes.
+	 */
+	void ComputeStrandBias(void);
+
+	/**<
+	 * Two-sided Fisher's exact test of a 2x2 table.
+	 *    n11  n12  | n1_
+	 *    n21  n22  | n2_
+	 *   -----------+----
+	 *    n_1  n_2  | n
+	 * @return Returns the two-sided P-value.
+	 */
+	double FisherExact(const uint32_t n11, const uint32_t n12, const uint32_t n21, const uint32_t n22);
+
+	/**<
+	 * Hardy-Weinberg exact test of bi-allelic genotype counts.
+	 * @param hom_ref Src number of homozygous reference genotypes.
+	 * @param het     Src number of heterozygous genotypes.
+	 * @param hom_alt Src number of homozygous alternative genotypes.
+	 * @return        Returns the P-value or 1 if no genotypes are observed.
+	 */
+	double HardyWeinbergExact(const uint32_t hom_ref, const uint32_t het, const uint32_t hom_alt);
+
+	inline bool IsValid(const uint32_t record) const { return(this->valid[record]); }
+	inline uint64_t GetOffset(const uint32_t record, const uint32_t group) const { return((uint64_t)record * this->n_groups + group); }
+
+public:
+	uint32_t n_records, n_groups;
+	std::vector<uint8_t> valid; // per record
+	// Ordered genotype counts per record and grouping.
+	std::vector<uint32_t> n_rr, n_ra, n_ar, n_aa;
+	// Statistics per record and grouping.
+	std::vector<float> hwe_p; // Hardy-Weinberg exact P-value
+	std::vector<float> hwe_chisq_p; // Hardy-Weinberg chi-squared P-value
+	std::vector<float> heterozygosity; // observed heterozygosity
+	std::vector<float> f_pic; // inbreeding coefficient
+	std::vector<float> strand_bias; // PHRED-scaled Fisher's exact P-value
+	// Statistics per record over all groupings.
+	std::vector<float> fis, fst, fit;
+
+private:
+	yon_log_factorial lf;
+	std::vector<double> scratch;
+};
+
+}
+
+#endif /* TACHYON_POPULATION_GENETICS_H_ */
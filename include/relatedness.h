@@ -0,0 +1,183 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef TACHYON_RELATEDNESS_H_
+#define TACHYON_RELATEDNESS_H_
+
+#include <string>
+#include <vector>
+
+#include "genotypes.h"
+#include "algorithm/parallel/fork_join.h"
+
+namespace tachyon {
+
+// Number of 64-bit words of records per sample in a panel.
+#define YON_GRM_PANEL_WORDS 8
+#define YON_GRM_PANEL_RECORDS (YON_GRM_PANEL_WORDS*64)
+// Number of samples per side of a tile of pairs computed by one worker.
+#define YON_GRM_TILE_SAMPLES 64
+
+/**<
+ * Relatedness estimators.
+ *    GRM)  Genomic relationship matrix of allele dosages standardized
+ *          by the allele frequency of every record:
+ *          A_jk = 1/N_jk sum_i (g_ij - 2p_i)(g_ik - 2p_i) / (2p_i(1-p_i))
+ *          where N_jk is the number of records observed in both samples.
+ *    KING) KING-robust kinship coefficient:
+ *          phi_jk = 1/2 - (4 N_AA,aa + N_Aa_j + N_Aa_k - 2 N_Aa,Aa) / (4 min(N_Aa_j, N_Aa_k))
+ *          with counts over records observed in both samples.
+ */
+enum TACHYON_GRM_MODE {
+	YON_GRM_STANDARDIZED,
+	YON_GRM_KING
+};
+
+struct yon_grm_settings {
+public:
+	yon_grm_settings() : mode(YON_GRM_STANDARDIZED), n_threads(1) {}
+
+public:
+	TACHYON_GRM_MODE mode;
+	uint32_t n_threads;
+	// Identifier of the input file, intervals, and filters. A checkpoint
+	// is only restored if its identifier matches.
+	std::string fingerprint;
+};
+
+/**<
+ * Relatedness of all pairs of samples accumulated over streamed records.
+ * Diploid records are scattered from their run-length encoded genotypes
+ * into sample-major bitplanes of observed, heterozygous, and homozygous
+ * alternative genotypes for a panel of YON_GRM_PANEL_RECORDS records in
+ * the original sample order. Full panels are accumulated into the upper
+ * triangle of the sample x sample matrices in tiles of pairs computed in
+ * parallel: KING counts are popcounts of the intersections of bitplanes
+ * and standardized dosages are multiplied as a dense panel. Kernels are
+ * dispatched at run-time to the widest instruction set supported by the
+ * processor.
+ *
+ * Any allele other than the reference counts as alternative such that
+ * multi-allelic records are collapsed to bi-allelic. Records that are
+ * not diploid or that are monomorphic are skipped.
+ *
+ * Accumulated counts can be written to and restored from a checkpoint.
+ */
+class Relatedness {
+public:
+	typedef Relatedness self_type;
+
+public:
+	Relatedness();
+	~Relatedness() = default;
+	Relatedness(const self_type& other) = delete;
+	Relatedness& operator=(const self_type& other) = delete;
+
+	/**<
+	 * Prepare the engine for a new set of records. All previous data is
+	 * deleted without consideration.
+	 * @param n_samples Number of samples.
+	 * @param settings  Src settings.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Open(const uint32_t n_samples, const yon_grm_settings& settings);
+
+	/**<
+	 * Add the genotypes of a record. The panel is accumulated when full.
+	 * @param gt Src genotypes with evaluated records.
+	 * @return   Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Add(const yon_gt& gt);
+
+	/**<
+	 * Accumulate the records of a partially filled panel.
+	 */
+	void Flush(void);
+
+	/**<
+	 * Write all accumulated counts to a checkpoint. Pending records are
+	 * flushed beforehand.
+	 * @param file_name Dst file name.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SaveCheckpoint(const std::string& file_name);
+
+	/**<
+	 * Restore accumulated counts from a checkpoint written with the same
+	 * number of samples, mode, and fingerprint. Open() has to be invoked
+	 * beforehand.
+	 * @param file_name Src file name.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool LoadCheckpoint(const std::string& file_name);
+
+	/**<
+	 * Retrieve the relatedness of a pair of samples. Flush() has to be
+	 * invoked beforehand.
+	 * @param a Src sample offset.
+	 * @param b Src sample offset.
+	 * @return  Returns the relatedness or NaN if it is not defined.
+	 */
+	double GetRelatedness(const uint32_t a, const uint32_t b) const;
+	uint32_t GetNumberObserved(const uint32_t a, const uint32_t b) const;
+
+	inline uint32_t GetNumberSamples(void) const { return(this->n_s); }
+	inline uint64_t GetNumberRecords(void) const { return(this->n_records); } // records added
+	inline uint64_t GetNumberSkipped(void) const { return(this->n_skipped); }
+	inline uint64_t GetNumberBlocks(void) const { return(this->n_blocks); } // blocks consumed by the caller
+	inline void SetNumberBlocks(const uint64_t n) { this->n_blocks = n; }
+
+private:
+	// Offset of pair (a,b) with a <= b in the upper triangle.
+	inline uint64_t GetOffset(const uint32_t a, const uint32_t b) const {
+		return((uint64_t)a * (2*(uint64_t)this->n_s - a + 1) / 2 + (b - a));
+	}
+
+	// Compute all pairs in tile t.
+	void AccumulateTile(const uint32_t t);
+
+private:
+	// Tile of pairs: samples [a_from, a_to) against [b_from, b_to).
+	struct yon_grm_tile {
+		uint32_t a_from, a_to, b_from, b_to;
+	};
+
+	uint32_t n_s;
+	uint32_t n_pending; // records in the current panel
+	uint32_t n_panel; // records in the panel padded to a multiple of 8
+	uint64_t n_records, n_skipped, n_blocks;
+	yon_grm_settings settings;
+	// Panel of sample-major bitplanes [observed, het, hom_alt] and
+	// standardized dosages.
+	std::vector<uint64_t> planes;
+	std::vector<float> dosages;
+	// Upper triangles of the accumulated matrices.
+	std::vector<uint32_t> n_observed; // records observed in both samples
+	std::vector<double>   sums; // GRM: sums of products of standardized dosages
+	std::vector<uint32_t> n_het_het, n_ibs0, n_het_a, n_het_b; // KING: counts
+	std::vector<yon_grm_tile> tiles;
+	algorithm::ForkJoinPool pool;
+};
+
+}
+
+#endif /* TACHYON_RELATEDNESS_H_ */
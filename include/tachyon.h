@@ -149,7 +149,7 @@ typedef enum {
 
 typedef enum {
 	YON_GT_RLE_DIPLOID_BIALLELIC, YON_GT_RLE_DIPLOID_NALLELIC, YON_GT_BCF_DIPLOID,
-	YON_GT_BCF_STYLE, YON_GT_RLE_NPLOID
+	YON_GT_BCF_STYLE, YON_GT_RLE_NPLOID, YON_GT_SPARSE, YON_GT_PBWT
 } TACHYON_GT_ENCODING;
 
 typedef enum { YON_GT_BYTE, YON_GT_U16, YON_GT_U32, YON_GT_U64 } TACHYON_GT_PRIMITIVE_TYPE;
@@ -23,6 +23,7 @@ DEALINGS IN THE SOFTWARE.
 #ifndef TACHYON_VARIANT_BLOCK_H_
 #define TACHYON_VARIANT_BLOCK_H_
 
+#include <atomic>
 #include <fstream>
 
 #include "variant_record.h"
@@ -46,7 +47,12 @@ public:
 		has_gt:           1,  // This block has GT FORMAT data
 		has_gt_permuted:  1,  // have the GT fields been permuted
 		any_encrypted:    1,  // any data encrypted
-		unused:          13; // reserved for future use
+		has_ppa_delta:    1,  // permutation array is stored relative to the preceding block
+		has_gt_haplotypes:1,  // GT fields are encoded as a haplotype PBWT
+		unused:          11; // reserved for future use
+
+	// Predicate for whether a permutation array is stored in YON_BLK_PPA.
+	inline bool HasPermutationArray(void) const { return(this->has_gt && (this->has_gt_permuted || this->has_gt_haplotypes)); }
 };
 
 /**<
@@ -580,6 +586,64 @@ private:
 	pointer   entries_;
 };
 
+/**<
+ * Adaptive block size policy. Rather than closing blocks after a fixed
+ * number of records, the number of records per block is chosen such that
+ * blocks approach a target size in bytes, either before or after
+ * compression. The cost per record is tracked as an exponentially weighted
+ * moving average over the blocks written so far, and the resulting record
+ * limit is clamped to [min_records, max_records]. The limit is published
+ * atomically: a producer may query it while another thread calls Update().
+ */
+struct yon_vb_budget {
+public:
+	typedef yon_vb_budget self_type;
+
+public:
+	yon_vb_budget();
+	~yon_vb_budget() = default;
+	yon_vb_budget(const self_type& other) = delete;
+	yon_vb_budget& operator=(const self_type& other) = delete;
+
+	/**<
+	 * Set the target block size and record bounds. If the target size is
+	 * zero the policy is disabled and the record limit is fixed at the
+	 * provided number of start records.
+	 * @param target_bytes  Target number of bytes per block (0 disables).
+	 * @param compressed    Measure the target against compressed bytes.
+	 * @param start_records Number of records per block until an estimate is available.
+	 * @param min_records   Lower bound on the number of records per block.
+	 * @param max_records   Upper bound on the number of records per block.
+	 */
+	void Setup(const uint64_t target_bytes,
+	           const bool compressed,
+	           const uint32_t start_records,
+	           const uint32_t min_records,
+	           const uint32_t max_records);
+
+	/**<
+	 * Update the cost per record estimate with the sizes of a block that
+	 * has been encoded and compressed.
+	 * @param b_uncompressed Uncompressed size of the block in bytes.
+	 * @param b_compressed   Compressed size of the block in bytes.
+	 * @param n_records      Number of records in the block.
+	 */
+	void Update(const uint64_t b_uncompressed, const uint64_t b_compressed, const uint32_t n_records);
+
+	inline bool IsActive(void) const { return(this->target_bytes > 0); }
+	inline uint32_t GetRecordLimit(void) const { return(this->n_limit.load()); }
+	inline double GetRecordCost(void) const { return(this->b_record); }
+
+public:
+	bool     compressed; // target compressed rather than uncompressed bytes
+	uint64_t target_bytes; // target number of bytes per block
+	uint32_t min_records; // lower bound on records per block
+	uint32_t max_records; // upper bound on records per block
+	uint64_t n_updates; // number of blocks seen
+	double   b_record; // moving average of bytes per record
+	std::atomic<uint32_t> n_limit; // current number of records per block
+};
+
 /**<
  * Load and display Settings for the basic variant data block
  */
@@ -986,6 +1050,7 @@ public:
 	container_type*   info_containers;
 	container_type*   format_containers;
 	yon_gt_ppa*       gt_ppa;
+	yon_gt_ppa*       gt_hppa; // haplotype order at the start of a haplotype PBWT block
 	yon_blk_load_settings* load_settings;
 
 	// Utility
@@ -120,7 +120,7 @@ public:
 	{
 		if (this->n_variants_) {
 			for (uint32_t i = 0; i < this->n_variants_; ++i)
-				new( &this->variants_[i] ) yon1_vnt_t( );
+				new( &this->variants_[i] ) yon1_vnt_t( &this->arena_ );
 
 			this->Build(variant_block, header);
 		}
@@ -156,6 +156,7 @@ public:
 
 		this->n_variants_ = 0;
 		this->block_.clear();
+		this->arena_.reset();
 	}
 
 	inline void reserve(void) { this->reserve(n_capacity_ + 1000); }
@@ -264,6 +265,11 @@ public:
 	size_t n_variants_;
 	size_t n_capacity_;
 	yon1_vnt_t* variants_;
+	// Block-local memory arena serving the many small allocations made
+	// for every record (allele strings and lazy-evaluated genotype run
+	// records). These are all released in O(1) when the container is
+	// cleared instead of being freed one by one.
+	yon_arena arena_;
 };
 
 
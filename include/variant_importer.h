@@ -41,24 +41,50 @@ public:
 	inline void SetOutputPrefix(const std::string& output_prefix) { this->output_prefix = output_prefix; }
 	inline void SetThreads(const int32_t n_threads) { this->n_threads = n_threads; }
 	inline void SetHtslibThreads(const int32_t n_threads) { this->htslib_extra_threads = n_threads; }
+	inline void SetPermuteThreads(const int32_t n_threads) { this->permute_threads = n_threads; }
+	inline void SetPermuteCarry(const int32_t interval) { this->permute_carry_interval = interval; }
 	inline void SetPermute(const bool yes) { this->permute_genotypes = yes; }
+	inline void SetHaplotypePbwt(const bool yes = true) { this->haplotype_pbwt = yes; }
+	inline void SetSparseGenotypes(const bool yes = true) { this->sparse_genotypes = yes; }
 	inline void SetEncrypt(const bool yes) { this->encrypt_data = yes; }
 	inline void SetCompressionLevel(const int32_t compression_level) { this->compression_level = compression_level; }
 	inline void SetCheckpointBases(const int32_t bases) { this->checkpoint_bases = bases; }
 	inline void SetCheckpointVariants(const int32_t variants) { this->checkpoint_n_snps = variants; }
+	inline void SetCheckpointBytes(const int64_t bytes, const bool compressed = false) { this->checkpoint_bytes = bytes; this->checkpoint_compressed = compressed; }
+	inline void SetCheckpointVariantsRange(const int32_t min_variants, const int32_t max_variants) { this->checkpoint_min_snps = min_variants; this->checkpoint_max_snps = max_variants; }
 	inline void SetPermuteGenotypes(const bool yes = true) { this->permute_genotypes = yes; }
+	inline void SetResume(const bool yes = true) { this->resume = yes; }
+	inline void SetAppend(const bool yes = true) { this->append = yes; }
+	inline void SetCheckpointInterval(const int32_t n_blocks) { this->checkpoint_interval = n_blocks; }
+	inline void SetSort(const bool yes = true) { this->sort = yes; }
+	inline void SetSortMemory(const int64_t bytes) { this->sort_run_bytes = bytes; }
+	inline void SetTempDirectory(const std::string& directory) { this->temp_directory = directory; }
 
 public:
 	bool verbose;
 	bool permute_genotypes; // permute GT flag
+	bool haplotype_pbwt; // encode fully phased blocks as a haplotype PBWT
+	bool sparse_genotypes; // encode records with few carriers as sparse carrier lists
 	bool encrypt_data; // encryption flag
+	bool resume; // resume a previously interrupted import
+	bool append; // append to an existing archive
+	bool sort; // sort unsorted input prior to import
 	int32_t checkpoint_n_snps; // number of variants until checkpointing
 	int32_t checkpoint_bases; // number of bases until checkpointing
+	bool    checkpoint_compressed; // measure checkpoint_bytes after compression
+	int64_t checkpoint_bytes; // target number of bytes per block (0 disables)
+	int32_t checkpoint_min_snps; // lower bound on variants per block when targeting bytes
+	int32_t checkpoint_max_snps; // upper bound on variants per block when targeting bytes
 	int32_t n_threads; // number of parallel importer threads
 	int32_t compression_level; // compression level sent to ZSTD
 	int32_t htslib_extra_threads; // extra threads for compress/decompress htslib
+	int32_t permute_threads; // threads per importer thread for permuting genotypes
+	int32_t permute_carry_interval; // blocks between full permutations when carrying permutations across blocks (0 disables)
+	int32_t checkpoint_interval; // number of blocks between resume checkpoints (0 disables)
 	int32_t info_end_key; // key mapping to the INFO field END
 	int32_t info_svlen_key; // key mapping to the INFO field SVLEN
+	int64_t sort_run_bytes; // number of bytes of records per sorting run
+	std::string temp_directory; // directory for temporary sorting runs
 	std::string input_file; // input file name
 	std::string output_prefix; // output file prefix
 };
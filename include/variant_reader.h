@@ -26,6 +26,7 @@ DEALINGS IN THE SOFTWARE.
 #include <regex>
 #include <cmath>
 #include <thread>
+#include <functional>
 
 #include "encryption.h"
 #include "primitive_container.h"
@@ -34,6 +35,9 @@ DEALINGS IN THE SOFTWARE.
 #include "index.h"
 #include "support_vcf.h"
 #include "variant_container.h"
+#include "genotype_matrix.h"
+#include "association.h"
+#include "population_genetics.h"
 
 namespace tachyon {
 
@@ -57,6 +61,8 @@ public:
 	inline void SetCompressionLevel(const int32_t compression_level) { this->compression_level = compression_level; }
 	inline void SetCheckpointBases(const int32_t bases) { this->checkpoint_bases = bases; }
 	inline void SetCheckpointVariants(const int32_t variants) { this->checkpoint_n_snps = variants; }
+	inline void SetCheckpointBytes(const int64_t bytes, const bool compressed = false) { this->checkpoint_bytes = bytes; this->checkpoint_compressed = compressed; }
+	inline void SetCheckpointVariantsRange(const int32_t min_variants, const int32_t max_variants) { this->checkpoint_min_snps = min_variants; this->checkpoint_max_snps = max_variants; }
 	inline void SetPermuteGenotypes(const bool yes = true) { this->permute_genotypes = yes; }
 
 public:
@@ -70,6 +76,10 @@ public:
 	bool encrypt_data; // encryption flag
 	int32_t checkpoint_n_snps; // number of variants until checkpointing
 	int32_t checkpoint_bases; // number of bases until checkpointing
+	bool    checkpoint_compressed; // measure checkpoint_bytes after compression
+	int64_t checkpoint_bytes; // target number of bytes per block (0 disables)
+	int32_t checkpoint_min_snps; // lower bound on variants per block when targeting bytes
+	int32_t checkpoint_max_snps; // upper bound on variants per block when targeting bytes
 	int32_t n_threads; // number of parallel importer threads
 	int32_t compression_level; // compression level sent to ZSTD
 };
@@ -89,6 +99,10 @@ public:
 	typedef EncryptionDecorator   encryption_manager_type;
 	typedef Keychain              keychain_type;
 
+	typedef std::function<bool(const yon_gt_matrix&)> matrix_callback_type;
+	typedef std::function<bool(const yon_assoc_workspace&)> assoc_callback_type;
+	typedef std::function<bool(yon1_vc_t&, const std::vector<uint8_t>&)> block_callback_type;
+
 private:
 	// Function pointer to interval slicing.
 	typedef bool (self_type::*filter_intervals_function)(const yon1_vnt_t& rcd) const;
@@ -132,6 +146,7 @@ public:
 	inline const footer_type& GetFooter(void) const { return(this->global_footer); }
 	inline index_type& GetIndex(void) { return(this->index); }
 	inline const index_type& GetIndex(void) const { return(this->index); }
+	inline const uint64_t& GetDataOffset(void) const { return(this->b_data_start); }
 	inline block_entry_type& GetCurrentContainer(void) { return(this->variant_container); }
 	inline const block_entry_type& GetCurrentContainer(void) const { return(this->variant_container); }
 
@@ -191,7 +206,66 @@ public:
 	 */
 	bool CheckNextValid(void);
 
-	block_entry_type ReturnBlock(void);
+	/**<
+	 * Load the next block into a separate block instead of the internal
+	 * one. The same steps as NextBlock() are performed.
+	 * @param block Dst block.
+	 * @return      Returns TRUE if successful or FALSE otherwise.
+	 */
+	bool ReturnBlock(block_entry_type& block);
+
+	/**<
+	 * Convert the genotypes of the next block into a dense matrix. The
+	 * block settings have to load genotypes.
+	 * @param matrix   Dst matrix.
+	 * @param settings Src settings describing the matrix layout.
+	 * @return         Returns TRUE if successful or FALSE otherwise.
+	 */
+	bool NextGenotypeMatrix(yon_gt_matrix& matrix, const yon_gt_matrix_settings& settings);
+
+	/**<
+	 * Convert the genotypes of all remaining blocks into dense matrices.
+	 * Blocks are read in batches of n_threads that are decompressed and
+	 * converted concurrently. Matrices are then passed to the callback in
+	 * the order of the archive and reused for the next batch. Iteration
+	 * stops if the callback returns FALSE, which is not an error.
+	 * @param settings  Src settings describing the matrix layout.
+	 * @param callback  Src function receiving every matrix.
+	 * @param n_threads Src number of blocks converted concurrently.
+	 * @return          Returns TRUE if successful or stopped by the callback or FALSE otherwise.
+	 */
+	bool GetGenotypeMatrices(const yon_gt_matrix_settings& settings,
+	                         const matrix_callback_type& callback,
+	                         const uint32_t n_threads);
+
+	/**<
+	 * Test all remaining records for association with a phenotype.
+	 * Blocks are read in batches of n_threads that are decompressed and
+	 * tested concurrently. The workspace of every block is then passed to
+	 * the callback in the order of the archive such that results are
+	 * sorted. Iteration stops if the callback returns FALSE, which is not
+	 * an error. The block settings have to load genotypes.
+	 * @param engine    Src association engine with a fitted null model.
+	 * @param callback  Src function receiving the results of every block.
+	 * @param n_threads Src number of blocks tested concurrently.
+	 * @return          Returns TRUE if successful or stopped by the callback or FALSE otherwise.
+	 */
+	bool GetAssociations(const Association& engine,
+	                     const assoc_callback_type& callback,
+	                     const uint32_t n_threads);
+
+	/**<
+	 * Iterate over the blocks overlapping the intervals, or all blocks if
+	 * there are none, and pass every block to the callback together with
+	 * a mask of the records passing the interval and variant filters.
+	 * Blocks outside the intervals are never read. Iteration stops if the
+	 * callback returns FALSE. Intervals are built by this function such
+	 * that it cannot be combined with OutputRecords().
+	 * @param callback    Src function receiving every block and its mask.
+	 * @param first_block Src number of leading blocks to skip without reading them.
+	 * @return            Returns TRUE if successful or FALSE otherwise.
+	 */
+	bool GetFilteredBlocks(const block_callback_type& callback, const uint64_t first_block = 0);
 
 	/**<
 	 * Get the target YON block that matches the provided index entry. Internally
@@ -258,6 +332,61 @@ public:
 
 	bool Stats(void);
 
+private:
+	/**<
+	 * Resolve the permutation array of a block that is stored relative to
+	 * the permutation of the preceding block (has_ppa_delta). The resolved
+	 * permutation of the most recent block is cached such that blocks read
+	 * in order are resolved directly. Otherwise the preceding blocks are
+	 * resolved starting from the closest block storing a full permutation.
+	 * This function does nothing if the permutation array was not loaded.
+	 * @param block        Src/Dst block with a decompressed permutation array.
+	 * @param block_offset Byte offset of the block in the archive.
+	 * @return             Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool ResolvePermutation(block_entry_type& block, const uint64_t block_offset);
+
+	/**<
+	 * Resolve and cache the permutation array of the target block by
+	 * walking back to the closest block storing a full permutation. The
+	 * position of the input stream is restored afterwards.
+	 * @param block_id Target block identifier.
+	 * @return         Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool LoadPermutation(const uint32_t block_id);
+
+	/**<
+	 * Retrieve the genotypes of a record expanded into the original sample
+	 * order. Genotypes are expanded a tile of consecutive records at a time
+	 * with gt_tiles such that the permutation array is applied in a cache
+	 * friendly manner. The tile is invalidated with ResetGenotypeTiles()
+	 * whenever a new block is loaded. This function should only be used
+	 * if most records are output as records in a tile are expanded
+	 * regardless of whether they are subsequently filtered out.
+	 * @param vc Src container of the current block.
+	 * @param i  Src record offset in the container.
+	 * @return   Returns a pointer to n_samples expanded records or nullptr upon failure.
+	 */
+	yon_gt_rcd* ExpandGenotypes(yon1_vc_t& vc, const uint32_t i);
+	void ResetGenotypeTiles(void);
+
+	/**<
+	 * Prepare the extra annotations of a newly loaded block. If groupings
+	 * are available the Occ table is built in the permutation of the block
+	 * and population-genetic statistics are computed for all records in
+	 * the block at once.
+	 * @param vc Src container of the current block.
+	 */
+	void AnnotateBlock(yon1_vc_t& vc);
+
+	/**<
+	 * Add the extra annotations to a record. AnnotateBlock() has to be
+	 * invoked for the block beforehand.
+	 * @param vc Src/Dst container of the current block.
+	 * @param i  Src record offset in the container.
+	 */
+	void AnnotateRecord(yon1_vc_t& vc, const uint32_t i);
+
 private:
 	// Pimpl idiom
 	class VariantReaderImpl;
@@ -274,12 +403,17 @@ private:
 	index_type              index;
 	keychain_type           keychain;
 	yon_occ                 occ_table;
+	PopulationGenetics      popgen; // statistics over groupings of the current block
 
 	// External memory allocation for linear use of lazy-evaluated
 	// expansion of genotype records. This is critical when the sample
 	// numbers are becoming large as allocating/deallocating hundreds
 	// of thousands of pointers for every variant is very time consuming.
 	yon_gt_rcd* gt_exp;
+
+	// Cache-blocked expansion of genotype records for unfiltered output.
+	yon_gt_tiled_exp gt_tiles;
+	uint32_t gt_tile_from; // record offset of the first record in gt_tiles
 };
 
 }
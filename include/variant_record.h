@@ -30,6 +30,9 @@ DEALINGS IN THE SOFTWARE.
 
 namespace tachyon {
 
+// Forward declaration.
+class PopulationGenetics;
+
 /****************************
 *  Core
 ****************************/
@@ -83,14 +86,34 @@ public:
 
 	yon_allele& ParseFromBuffer(const char* const in);
 
+	/**<
+	 * Assign allele data using memory served from the provided arena.
+	 * The string is owned by the arena and is released collectively
+	 * when the arena is reset; it is never freed by this object.
+	 * @param value  Src string.
+	 * @param length Length of src string.
+	 * @param arena  Dst arena serving the memory.
+	 * @return       Returns a reference to this object.
+	 */
+	yon_allele& Assign(const char* value, const uint16_t length, yon_arena* arena);
+	yon_allele& ParseFromBuffer(const char* const in, yon_arena* arena);
+
 	inline const uint16_t& size(void) const { return(this->l_allele); }
 	inline const uint16_t& length(void) const { return(this->l_allele); }
 	inline const std::string ToString(void) const { return(std::string(this->allele, this->l_allele)); }
 
 	friend yon_buffer_t& operator<<(yon_buffer_t& buffer, const yon_allele& entry);
 
+private:
+	inline void Release(void) {
+		if (this->is_arena == false) delete [] this->allele;
+		this->allele   = nullptr;
+		this->is_arena = false;
+	}
+
 public:
 	uint16_t l_allele;
+	bool     is_arena; // allele memory is owned by an external yon_arena
 	char*    allele;
 };
 
@@ -104,6 +127,7 @@ public:
 struct yon1_vnt_t {
 public:
 	yon1_vnt_t();
+	explicit yon1_vnt_t(yon_arena* arena);
 	yon1_vnt_t(const yon1_vnt_t& other);
 	yon1_vnt_t& operator=(const yon1_vnt_t& other);
 	yon1_vnt_t(yon1_vnt_t&& other) noexcept;
@@ -112,9 +136,28 @@ public:
 
 	bool UpdateBase(const bcf1_t* record);
 
+	/**<
+	 * Allocate memory for the allele array of this record. Any previous
+	 * alleles are released. If this record was constructed with a
+	 * yon_arena then the memory is served from that arena and released
+	 * collectively when it is reset; otherwise it is heap-allocated.
+	 * @param n Number of alleles.
+	 * @return  Returns a pointer to the allele array.
+	 */
+	yon_allele* AllocateAlleles(const uint16_t n);
+	void ReleaseAlleles(void);
+
+	/**<
+	 * Summarise the genotypes of this record into gt_sum. If this record
+	 * was constructed with a yon_arena then the summary, its buffer, and
+	 * its lazy evaluation are all served from that arena.
+	 * @param lazy_evaluate Predicate for lazy evaluating the summary.
+	 * @return              Returns TRUE upon success or FALSE otherwise.
+	 */
 	bool EvaluateSummary(bool lazy_evaluate = true);
+	void ReleaseSummary(void);
 	bool EvaluateOcc(yon_occ& occ);
-	bool EvaluateOccSummary(bool lazy_evaluate = true);
+	bool EvaluateOccSummary(bool lazy_evaluate = true, bool hypothesis_tests = true);
 
 	/**<
 	 * Check if it is possible to pack the REF and ALT allele strings into
@@ -162,17 +205,24 @@ public:
 
 	void OutputHtslibVcfInfo(bcf1_t* rec, bcf_hdr_t* hdr);
 
+	/**<
+	 * Update the FORMAT fields of a htslib bcf1_t record. Genotypes are
+	 * expanded into external_exp unless expanded is set in which case
+	 * external_exp already holds the expanded genotypes of this record.
+	 */
 	void OutputHtslibVcfFormat(bcf1_t* rec,
 	                           bcf_hdr_t* hdr,
 	                           bool display_genotypes,
-	                           yon_gt_rcd* external_exp) const;
+	                           yon_gt_rcd* external_exp,
+	                           const bool expanded = false) const;
 
 	void OutputHtslibVcfFilter(bcf1_t* rec, bcf_hdr_t* hdr) const;
 
 	void ToVcfString(const yon_vnt_hdr_t& header,
 	           yon_buffer_t& buffer,
 	           uint32_t display,
-	           yon_gt_rcd* external_rcd = nullptr) const;
+	           yon_gt_rcd* external_rcd = nullptr,
+	           const bool expanded = false) const;
 
 	bool AddInfoFlag(const std::string& tag, yon_vnt_hdr_t& header);
 
@@ -227,22 +277,18 @@ public:
 
 	bool AddFilter(const std::string& tag, yon_vnt_hdr_t& header);
 	bool AddGenotypeStatistics(yon_vnt_hdr_t& header, const bool replace_existing = true);
-	bool AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std::string>& names);
 
 	/**<
-	 * Calculates various F-statistics over the provided groupings using
-	 * the Occ table. Calculates one set of statistics over all the groupings
-	 * and for each individual group. The calculations here are available only
-	 * for diploid individuals at biallelic sites.
-	 *
-	 * Warning: this function returns incorrect results if the provided
-	 *          grouping sets are overlapping. The incorrect results arise
-	 *          from the fact that a single individual cannot simultaneously
-	 *          exist in multiple distinct populations.
+	 * Add genotype statistics for every grouping of the Occ table. The
+	 * Hardy-Weinberg P-values, strand bias, and F-statistics are read
+	 * from the batched population-genetic statistics of the block.
 	 * @param header Src yon_vnt_hdr_t.
+	 * @param names  Src names of the groupings.
+	 * @param popgen Src batched statistics of the block.
+	 * @param record Src offset of this record in the batched statistics.
 	 * @return       Returns TRUE upon success or FALSE otherwise.
 	 */
-	bool EvaluatePopGenOcc(yon_vnt_hdr_t& header);
+	bool AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std::string>& names, const PopulationGenetics& popgen, const uint32_t record);
 
 	PrimitiveContainerInterface* GetInfo(const std::string& name) const;
 	PrimitiveGroupContainerInterface* GetFmt(const std::string& name) const;
@@ -274,6 +320,7 @@ public:
 	std::unordered_map<std::string, uint32_t> fmt_map;
 	std::unordered_map<std::string, uint32_t> flt_map;
 
+	yon_arena* arena; // not owned: block-local memory arena (if any)
 	yon_allele* alleles;
 	yon_gt* gt;
 	yon_gt_summary* gt_sum;
@@ -375,7 +422,7 @@ public:
 		if (rec.gt == nullptr)
 			return false;
 
-		if (rec.gt->rcds == nullptr)
+		if (rec.gt->Evaluate() == false)
 			return false;
 
 		// Set the base ploidy. This corresponds to the LARGEST
@@ -469,9 +516,23 @@ public:
 	uint64_t* ins_del_dist; // indel distribution. values are zigzagged.
 };
 
+// Number of per-sample counters in yon_stats_sample that are updated
+// per genotype: the 9x9 base_conv cells followed by the 512 ins_del_dist
+// bins.
+#define YON_STATS_TSTV_CONV_KEYS 81
+#define YON_STATS_TSTV_KEYS      (YON_STATS_TSTV_CONV_KEYS + 512)
+
 /**<
  * Supportive structure for computing variant-centric summary statistics
  * using the genotypes and site-specific meta information.
+ *
+ * Per-sample counters updated from run-length encoded genotypes with
+ * Update(const yon1_vnt_t&) are accumulated as range updates into
+ * difference arrays: every run adds its contribution at its first sample
+ * and removes it past its last sample. The per-sample counters are only
+ * updated when the difference arrays are prefix-summed by Flush(), which
+ * has to be invoked before the per-sample counters are read or added to
+ * another object, typically once per block.
  */
 struct yon_stats_tstv {
 public:
@@ -575,12 +636,40 @@ public:
 	void UpdateDiploid(const yon_gt* gt, yon_stats_tstv_obj& helper);
 	void UpdateNPloidy(const yon_gt* gt, yon_stats_tstv_obj& helper);
 
+	/**<
+	 * Prefix-sum the pending difference arrays into the per-sample
+	 * counters and clear them. Only counters that were updated since the
+	 * previous call are visited.
+	 */
+	void Flush(void);
+
+	/**<
+	 * Add a count to a per-sample counter for the samples [from, to).
+	 * @param key   Src counter: a base_conv cell (ref * 9 + alt) or YON_STATS_TSTV_CONV_KEYS plus an ins_del_dist bin.
+	 * @param from  Src first sample.
+	 * @param to    Src one past the last sample.
+	 * @param count Src count added to every sample.
+	 */
+	inline void AddRange(const uint32_t key, const uint32_t from, const uint32_t to, const int32_t count) {
+		assert(key < YON_STATS_TSTV_KEYS);
+		if (this->slot_map[key] < 0) {
+			this->slot_map[key] = this->slot_key.size();
+			this->slot_key.push_back(key);
+			const uint64_t n_needed = this->slot_key.size() * ((uint64_t)this->n_s + 1);
+			if (this->diff.size() < n_needed) this->diff.resize(n_needed, 0);
+		}
+		int32_t* d = &this->diff[this->slot_map[key] * ((uint64_t)this->n_s + 1)];
+		d[from] += count;
+		d[to]   -= count;
+	}
+
 	/**<
 	 * Short-hand support function for invoking LazyEvaluate() in all available
 	 * children objects. See LazyEvaluate() in the children structure for more
 	 * information.
 	 */
 	void Evaluate(void) {
+		this->Flush();
 		for (uint32_t i = 0; i < this->n_s; ++i)
 			this->sample[i].LazyEvalute();
 	}
@@ -599,6 +688,9 @@ public:
 	uint64_t n_no_alts, n_biallelic, n_multi_allele, n_multi_allele_snp, n_singleton;
 	yon_stats_sample* sample;
 	uint64_t* alt_count; // number of alt distribution
+	int32_t slot_map[YON_STATS_TSTV_KEYS]; // slot of every counter with pending updates or -1
+	std::vector<uint32_t> slot_key; // counter of every slot
+	std::vector<int32_t> diff; // difference arrays of n_s + 1 entries per slot
 };
 
 }
@@ -59,6 +59,7 @@ public:
 
 	yon_vnt_hdr_t& UpdateHeaderImport(yon_vnt_hdr_t& header, const std::string command_string);
 	yon_vnt_hdr_t& UpdateHeaderView(yon_vnt_hdr_t& header, const std::string command_string);
+	yon_vnt_hdr_t& UpdateHeaderConcat(yon_vnt_hdr_t& header);
 
 	bool Write(yon1_vb_t& container, yon1_idx_rec& index_entry);
 	bool UpdateIndex(yon1_idx_rec& index_entry);
@@ -73,11 +74,46 @@ public:
 	 */
 	bool WriteBlock(yon1_vb_t& block, yon1_idx_rec& index_entry);
 
+	/**<
+	 * Copy the compressed blocks of another archive verbatim into this
+	 * archive. The blocks are not decompressed: only the index entries
+	 * describing them are rewritten to their new block identifiers and
+	 * byte offsets. The source archive must have been encoded using a
+	 * header that is compatible with the header of this archive.
+	 * @param stream     Src stream positioned at the start of the first block.
+	 * @param l_data     Number of bytes of block data to copy.
+	 * @param index      Src index of the copied archive.
+	 * @param n_variants Number of variants in the copied archive.
+	 * @return           Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool WriteBlocksRaw(std::istream& stream, const uint64_t l_data, const yon_index_t& index, const uint64_t n_variants);
+
+	/**<
+	 * Copy a single compressed block, including its footer and end-of-block
+	 * marker, of another archive verbatim into this archive. Any records
+	 * added previously are written out first such that block order is kept.
+	 * The block is indexed at block granularity from its index entry.
+	 * @param stream      Src stream of the archive holding the block.
+	 * @param index_entry Src index entry describing the block.
+	 * @return            Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool WriteBlockRaw(std::istream& stream, const yon1_idx_rec& index_entry);
+
 	void operator+=(const yon1_vnt_t& rec);
 	void operator+=(const yon1_vc_t& container);
 
 	bool close(void);
 
+	/**<
+	 * Write out or restore the running (not finalized) state of the archive
+	 * digests. Used together with the index entries to checkpoint a partially
+	 * written archive such that writing can be resumed later.
+	 * @param stream Dst/src stream.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SerializeDigestState(std::ostream& stream) const;
+	bool DeserializeDigestState(std::istream& stream);
+
 private:
 	/**<
 	 * Supportive function to inject the essential Tacyon variant block footer into
@@ -87,6 +123,31 @@ private:
 	 */
 	bool WriteBlockFooter(const container_type& footer);
 
+	/**<
+	 * Hand off the currently accumulated variant container for encoding.
+	 * If more than one thread is available the container is queued for the
+	 * compression worker pool and a free container is made current: finished
+	 * blocks are written out in order as they become available. Otherwise the
+	 * container is encoded and written on the calling thread.
+	 * @return Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool FlushContainer(void);
+
+	/**<
+	 * Index and write an encoded variant container and then clear it.
+	 * @param vc Src variant container with a prepared block.
+	 * @return   Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool WriteContainer(yon1_vc_t& vc);
+
+	/**<
+	 * Write out all blocks finished by the compression workers that are
+	 * next in order.
+	 * @param wait Block until every queued container has been written.
+	 * @return     Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool WriteFinishedContainers(const bool wait);
+
 	/**<
 	 * Supportive function to inject the Tachyon end-of-block marker following the
 	 * emission of a block.
@@ -94,6 +155,15 @@ private:
 	 */
 	bool WriteEndOfBlock(void);
 
+	/**<
+	 * Copy a range of bytes from the provided stream to the output stream
+	 * in large chunks.
+	 * @param stream Src stream positioned at the first byte to copy.
+	 * @param l_data Number of bytes to copy.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool CopyBytes(std::istream& stream, const uint64_t l_data);
+
 	/**<
 	 * Finalize the writing of a Tachyon archive. Writes the
 	 * footer, the index, and the checksums.
@@ -108,10 +178,13 @@ public:
 	std::ostream* stream;
 	yon_index_t index; // local variant index
 
-	// Local variant container to add to.
+	// Contig and start position of the last record in an archive opened
+	// for appending or -1: appended records must not sort before it.
+	int32_t append_contig_id;
+	int64_t append_position;
+
 	uint32_t n_s; // number of samples
 	VariantReaderSettings settings; // import settings
-	yon1_vc_t     variant_container; // local variant container
 
 private:
 	class VariantWriterInterfaceImpl;
@@ -127,7 +200,40 @@ public:
 	~VariantWriterFile();
 	bool open(const std::string output);
 
-private:
+	/**<
+	 * Reopen an existing, partially written, archive for writing. The file
+	 * is truncated to the provided byte offset, generally the end of the
+	 * last block known to have been written completely, and the stream
+	 * is positioned at that offset.
+	 * @param output      Output file prefix.
+	 * @param byte_offset Byte offset to truncate the archive to.
+	 * @return            Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool open(const std::string output, const uint64_t byte_offset);
+
+	/**<
+	 * Open an existing, finalized, archive for appending new blocks. The
+	 * global footer and index are read back and the stream is positioned
+	 * at the end of the existing block data. The file is not modified
+	 * until the first block is written over the trailing index, checksums,
+	 * and footer. Closing the writer re-emits the merged index and trailer,
+	 * which is never shorter than the one it replaces. The archive header
+	 * is not rewritten: the provided header must therefore be compatible
+	 * with the one stored in the archive.
+	 * @param output Output file prefix of the existing archive.
+	 * @param header Header describing the data that will be appended.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool OpenAppend(const std::string output, const yon_vnt_hdr_t& header);
+
+	inline std::string GetFileName(void) const { return(this->basePath + this->baseName + '.' + TACHYON_OUTPUT_SUFFIX); }
+
+	/**<
+	 * Split the provided output prefix into its base path and base name
+	 * components. Invoked by open() but can be used separately to resolve
+	 * the output file name prior to opening the archive.
+	 * @param input Output file prefix.
+	 */
 	void CheckOutputNames(const std::string& input);
 
 public:
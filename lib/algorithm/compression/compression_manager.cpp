@@ -15,6 +15,9 @@ bool CompressionManager::Compress(variant_block_type& block,
 		zstd_codec.SetCompressionLevel(22);
 		zstd_codec.Compress(block.base_containers[YON_BLK_PPA], *block.gt_ppa);
 		//this->CompressEvaluate(block.base_containers[YON_BLK_PPA], block.gt_ppa);
+	} else if (block.header.controller.has_gt_haplotypes) {
+		zstd_codec.SetCompressionLevel(22);
+		zstd_codec.Compress(block.base_containers[YON_BLK_PPA], *block.gt_hppa);
 	}
 
 	zstd_codec.SetCompressionLevel(general_level);
@@ -189,7 +192,8 @@ bool CompressionManager::Decompress(variant_block_type& block) {
 	if (block.base_containers[YON_BLK_PPA].GetSizeCompressed() &&
 	   block.base_containers[YON_BLK_PPA].header.data_header.controller.encryption == YON_ENCRYPTION_NONE)
 	{
-		if (!this->Decompress(block.base_containers[YON_BLK_PPA], *block.gt_ppa)) {
+		yon_gt_ppa* ppa = block.header.controller.has_gt_haplotypes ? block.gt_hppa : block.gt_ppa;
+		if (ppa == nullptr || !this->Decompress(block.base_containers[YON_BLK_PPA], *ppa)) {
 			std::cerr << utility::timestamp("ERROR","COMPRESSION") << "Failed to decompress GT permutation information!" << std::endl;
 			return false;
 		}
@@ -4,43 +4,87 @@ namespace tachyon{
 namespace algorithm{
 
 GenotypeEncoder::GenotypeEncoder() :
-	n_samples(0)
+	n_samples(0),
+	sparse(false),
+	gt_symbols(nullptr),
+	run_offsets(nullptr),
+	hap_order(nullptr),
+	hap_scratch(nullptr)
 {
 }
 
 GenotypeEncoder::GenotypeEncoder(const uint64_t samples) :
-	n_samples(samples)
+	n_samples(0),
+	sparse(false),
+	gt_symbols(nullptr),
+	run_offsets(nullptr),
+	hap_order(nullptr),
+	hap_scratch(nullptr)
 {
+	this->SetSamples(samples);
 }
 
-GenotypeEncoder::~GenotypeEncoder() {}
+GenotypeEncoder::GenotypeEncoder(const self_type& other) :
+	n_samples(0),
+	sparse(other.sparse),
+	stats_(other.stats_),
+	gt_symbols(nullptr),
+	run_offsets(nullptr),
+	hap_order(nullptr),
+	hap_scratch(nullptr)
+{
+	this->SetSamples(other.n_samples);
+}
+
+GenotypeEncoder& GenotypeEncoder::operator=(const self_type& other) {
+	if (this == &other) return(*this);
+	// The buffers are scratch space for the record being encoded and
+	// are therefore only allocated and not copied.
+	this->SetSamples(other.n_samples);
+	this->sparse = other.sparse;
+	this->stats_ = other.stats_;
+	return(*this);
+}
+
+GenotypeEncoder::~GenotypeEncoder() {
+	delete [] this->gt_symbols;
+	delete [] this->run_offsets;
+	delete [] this->hap_order;
+	delete [] this->hap_scratch;
+}
+
+void GenotypeEncoder::SetSamples(const uint64_t samples) {
+	delete [] this->gt_symbols;
+	delete [] this->run_offsets;
+	delete [] this->hap_order;
+	delete [] this->hap_scratch;
+	this->n_samples   = samples;
+	this->gt_symbols  = new uint32_t[samples];
+	this->run_offsets = new uint32_t[samples + 1];
+	this->hap_order   = new uint32_t[2*samples];
+	this->hap_scratch = new uint32_t[2*samples];
+	this->hap_ppa.Allocate(2*samples);
+}
 
 bool GenotypeEncoder::Encode(const containers::VcfContainer& container,
                              yon1_vnt_t* rcds,
                              block_type& block,
-                             const yon_gt_ppa& permutation_array) const
+                             const yon_gt_ppa& permutation_array)
 {
+	if (block.header.controller.has_gt_haplotypes)
+		return(this->EncodeHaplotypes(container, rcds, block));
+
 	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) {
 		if (rcds[i].controller.gt_available == false)
 			continue;
 
-		GenotypeSummary gt_summary = container.GetGenotypeSummary(i, this->n_samples);
-
-		yon_gt_assess assessed = this->Assess(container[i], gt_summary, permutation_array);
-		const uint8_t primitive = assessed.GetCheapestPrimitive();
-		//const uint8_t rprimitive = assessed.GetCheapestRawPrimitive();
-
-		// Debug
-		/*
-		std::cout << rcds[i].rid << "\t" << rcds[i].pos+1 << "\t" << (int)assessed.method << "\t" << (int)primitive << "\t" << assessed.n_cost[primitive] << "\t" << (int)rprimitive-4 << "\t" << assessed.n_cost[rprimitive];
-		for (int i = 0; i < 8; ++i) {
-			std::cout << "\t" << assessed.n_cost[i];
-		}
-		for (int i = 0; i < 8; ++i) {
-			std::cout << "\t" << assessed.n_runs[i];
-		}
-		std::cout << std::endl;
-		*/
+		// Diploid genotypes are summarised while they are gathered such
+		// that the samples are only visited once.
+		GenotypeSummary gt_summary;
+		uint32_t n_gt_runs = 0;
+		if (container[i]->d.fmt[0].n == 2)
+			n_gt_runs = this->GatherDiploid(container[i], permutation_array, gt_summary);
+		else gt_summary = container.GetGenotypeSummary(i, this->n_samples);
 
 		rcds[i].controller.biallelic         = (container[i]->n_allele == 2);
 		rcds[i].controller.diploid           = (gt_summary.base_ploidy == 2);
@@ -53,12 +97,32 @@ bool GenotypeEncoder::Encode(const containers::VcfContainer& container,
 
 		if (container[i]->d.fmt[0].n == 2) {
 			if (container[i]->n_allele == 2 && gt_summary.n_vector_end == 0) {
+				// 1 + hasMissing + hasMixedPhasing
+				const uint8_t shift = gt_summary.n_missing     ? 2 : 1;
+				const uint8_t add   = gt_summary.mixed_phasing ? 1 : 0;
+				const uint8_t bit_shift = 2*shift + add;
+
+				uint64_t limits[4];
+				for (uint32_t k = 0; k < 4; ++k)
+					limits[k] = pow(2, 8*(1 << k) - bit_shift) - 1;
+
+				n_gt_runs = this->PackDiploidBiallelic(n_gt_runs, shift, add);
+				const yon_gt_assess assessed = this->AssessRuns(n_gt_runs, limits, 0);
+				const uint8_t primitive = assessed.GetCheapestPrimitive();
+
+				if (this->sparse && gt_summary.mixed_phasing == false &&
+				    this->AssessSparse(container[i], permutation_array, n_gt_runs, assessed.n_runs[primitive] << primitive))
+				{
+					this->AddSparse(container[i], permutation_array, n_gt_runs, rcds[i], block);
+					continue;
+				}
+
 				uint64_t n_runs = 0;
 				switch(primitive) {
-				case(0): n_runs = this->EncodeDiploidBiallelic<uint8_t> (container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_INT8]);  break;
-				case(1): n_runs = this->EncodeDiploidBiallelic<uint16_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_INT16]); break;
-				case(2): n_runs = this->EncodeDiploidBiallelic<uint32_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_INT32]); break;
-				case(3): n_runs = this->EncodeDiploidBiallelic<uint64_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_INT64]); break;
+				case(0): n_runs = this->EncodeRuns<uint8_t> (n_gt_runs,bit_shift,limits[0],block.base_containers[YON_BLK_GT_INT8]);  break;
+				case(1): n_runs = this->EncodeRuns<uint16_t>(n_gt_runs,bit_shift,limits[1],block.base_containers[YON_BLK_GT_INT16]); break;
+				case(2): n_runs = this->EncodeRuns<uint32_t>(n_gt_runs,bit_shift,limits[2],block.base_containers[YON_BLK_GT_INT32]); break;
+				case(3): n_runs = this->EncodeRuns<uint64_t>(n_gt_runs,bit_shift,limits[3],block.base_containers[YON_BLK_GT_INT64]); break;
 				default:
 					std::cerr << "illegal primitive type" << std::endl;
 					return false;
@@ -70,12 +134,35 @@ bool GenotypeEncoder::Encode(const containers::VcfContainer& container,
 				++block.base_containers[YON_BLK_GT_SUPPORT];
 
 			} else {
+				const uint8_t shift = ceil(log2(container[i]->n_allele + 2 + 1));
+				const uint8_t add   = gt_summary.mixed_phasing ? 1 : 0;
+				const uint8_t bit_shift = 2*shift + add;
+
+				// Primitives that cannot hold the packed genotype
+				// are banned by setting their limit to zero.
+				uint64_t limits[4];
+				for (uint32_t k = 0; k < 4; ++k) {
+					const int64_t limit = pow(2, 8*(1 << k) - bit_shift) - 1;
+					limits[k] = limit <= 0 ? 0 : limit;
+				}
+
+				n_gt_runs = this->PackDiploidMultiAllelic(container[i], n_gt_runs, shift, add);
+				const yon_gt_assess assessed = this->AssessRuns(n_gt_runs, limits, 1);
+				const uint8_t primitive = assessed.GetCheapestPrimitive();
+
+				if (this->sparse && gt_summary.mixed_phasing == false &&
+				    this->AssessSparse(container[i], permutation_array, n_gt_runs, assessed.n_runs[primitive] << primitive))
+				{
+					this->AddSparse(container[i], permutation_array, n_gt_runs, rcds[i], block);
+					continue;
+				}
+
 				uint64_t n_runs = 0;
 				switch(primitive) {
-				case(0): n_runs = this->EncodeDiploidMultiAllelic<uint8_t> (container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_S_INT8]);  break;
-				case(1): n_runs = this->EncodeDiploidMultiAllelic<uint16_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_S_INT16]); break;
-				case(2): n_runs = this->EncodeDiploidMultiAllelic<uint32_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_S_INT32]); break;
-				case(3): n_runs = this->EncodeDiploidMultiAllelic<uint64_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_S_INT64]); break;
+				case(0): n_runs = this->EncodeRuns<uint8_t> (n_gt_runs,bit_shift,limits[0],block.base_containers[YON_BLK_GT_S_INT8]);  break;
+				case(1): n_runs = this->EncodeRuns<uint16_t>(n_gt_runs,bit_shift,limits[1],block.base_containers[YON_BLK_GT_S_INT16]); break;
+				case(2): n_runs = this->EncodeRuns<uint32_t>(n_gt_runs,bit_shift,limits[2],block.base_containers[YON_BLK_GT_S_INT32]); break;
+				case(3): n_runs = this->EncodeRuns<uint64_t>(n_gt_runs,bit_shift,limits[3],block.base_containers[YON_BLK_GT_S_INT64]); break;
 				default:
 					std::cerr << "illegal primitive type" << std::endl;
 					return false;
@@ -88,12 +175,29 @@ bool GenotypeEncoder::Encode(const containers::VcfContainer& container,
 			}
 		}
 		else {
+			uint64_t limits[4];
+			limits[0] = std::numeric_limits<uint8_t>::max();
+			limits[1] = std::numeric_limits<uint16_t>::max();
+			limits[2] = std::numeric_limits<uint32_t>::max();
+			limits[3] = std::numeric_limits<uint64_t>::max();
+
+			n_gt_runs = this->GatherMultiploid(container[i], permutation_array);
+			const yon_gt_assess assessed = this->AssessRuns(n_gt_runs, limits, 2);
+			const uint8_t primitive = assessed.GetCheapestPrimitive();
+
+			if (this->sparse && gt_summary.mixed_phasing == false &&
+			    this->AssessSparse(container[i], permutation_array, n_gt_runs, assessed.n_runs[primitive] * ((1 << primitive) + container[i]->d.fmt[0].n)))
+			{
+				this->AddSparse(container[i], permutation_array, n_gt_runs, rcds[i], block);
+				continue;
+			}
+
 			uint64_t n_runs = 0;
 			switch(primitive) {
-			case(0): n_runs = this->EncodeMultiploid<uint8_t> (container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_N_INT8]);  break;
-			case(1): n_runs = this->EncodeMultiploid<uint16_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_N_INT16]); break;
-			case(2): n_runs = this->EncodeMultiploid<uint32_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_N_INT32]); break;
-			case(3): n_runs = this->EncodeMultiploid<uint64_t>(container[i],gt_summary,permutation_array,block.base_containers[YON_BLK_GT_N_INT64]); break;
+			case(0): n_runs = this->EncodeRunsMultiploid<uint8_t> (container[i],permutation_array,n_gt_runs,block.base_containers[YON_BLK_GT_N_INT8]);  break;
+			case(1): n_runs = this->EncodeRunsMultiploid<uint16_t>(container[i],permutation_array,n_gt_runs,block.base_containers[YON_BLK_GT_N_INT16]); break;
+			case(2): n_runs = this->EncodeRunsMultiploid<uint32_t>(container[i],permutation_array,n_gt_runs,block.base_containers[YON_BLK_GT_N_INT32]); break;
+			case(3): n_runs = this->EncodeRunsMultiploid<uint64_t>(container[i],permutation_array,n_gt_runs,block.base_containers[YON_BLK_GT_N_INT64]); break;
 			default:
 				std::cerr << "illegal primitive type" << std::endl;
 				return false;
@@ -108,6 +212,342 @@ bool GenotypeEncoder::Encode(const containers::VcfContainer& container,
 	return true;
 }
 
+bool GenotypeEncoder::EncodeHaplotypes(const containers::VcfContainer& container,
+                                       yon1_vnt_t* rcds,
+                                       block_type& block)
+{
+	const uint32_t n_haplotypes = 2*this->n_samples;
+
+	// The order at the start of the block is the final order of a first
+	// pass over the block. Haplotypes that are adjacent in this order are
+	// similar across the block and therefore also at its first sites.
+	for (uint32_t j = 0; j < n_haplotypes; ++j) this->hap_order[j] = j;
+	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) {
+		if (rcds[i].controller.gt_available) this->UpdateHaplotypeOrder(container[i]);
+	}
+	memcpy(this->hap_ppa.ordering, this->hap_order, n_haplotypes*sizeof(uint32_t));
+
+	container_type& dst = block.base_containers[YON_BLK_GT_N_INT8];
+	uint8_t varint[5];
+	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) {
+		if (rcds[i].controller.gt_available == false)
+			continue;
+
+		if (IsPhasedBiallelic(container[i], this->n_samples) == false) {
+			std::cerr << utility::timestamp("ERROR","GT") << "Record cannot be encoded as phased haplotypes..." << std::endl;
+			return false;
+		}
+
+		rcds[i].controller.biallelic            = true;
+		rcds[i].controller.diploid              = true;
+		rcds[i].controller.gt_has_mixed_phasing = false;
+		rcds[i].controller.gt_has_missing       = false;
+		rcds[i].controller.gt_phase_uniform     = true;
+		rcds[i].controller.gt_mixed_ploidy      = false;
+		rcds[i].controller.gt_primtive_type     = YON_GT_BYTE;
+		rcds[i].controller.gt_compression_type  = YON_GT_PBWT;
+		rcds[i].n_base_ploidy                   = 2;
+
+		// Allele of the first haplotype followed by the lengths of runs
+		// of alternating alleles.
+		const uint8_t* gt = container[i]->d.fmt[0].p;
+		uint8_t  allele = YON_GT_HAPLOTYPE_ALLELE(gt[this->hap_order[0]]);
+		uint32_t l_run  = 1;
+		uint32_t n_runs = 0;
+		dst.AddLiteral(allele);
+		for (uint32_t j = 1; j < n_haplotypes; ++j) {
+			const uint8_t current = YON_GT_HAPLOTYPE_ALLELE(gt[this->hap_order[j]]);
+			if (current != allele) {
+				dst.AddLiteral(reinterpret_cast<const char*>(varint), SparseGenotypeVarintEncode(l_run, varint));
+				++n_runs;
+				allele = current;
+				l_run  = 0;
+			}
+			++l_run;
+		}
+		dst.AddLiteral(reinterpret_cast<const char*>(varint), SparseGenotypeVarintEncode(l_run, varint));
+		++n_runs;
+		dst.header.n_additions += n_runs;
+		++dst.header.n_entries;
+
+		block.base_containers[YON_BLK_GT_SUPPORT].Add(n_runs);
+		++block.base_containers[YON_BLK_GT_SUPPORT];
+
+		this->UpdateHaplotypeOrder(container[i]);
+	}
+	return true;
+}
+
+bool GenotypeEncoder::IsPhasedBiallelic(const bcf1_t* entry, const uint64_t n_samples) {
+	if (entry->n_allele != 2 || entry->d.fmt[0].n != 2)
+		return false;
+
+	// The first allele of a sample never carries the phase bit in
+	// htslib whereas the second allele has to be phased.
+	const uint8_t* gt = entry->d.fmt[0].p;
+	for (uint64_t s = 0; s < n_samples; ++s) {
+		if ((gt[2*s] != 2 && gt[2*s] != 4) || (gt[2*s+1] != 3 && gt[2*s+1] != 5))
+			return false;
+	}
+	return true;
+}
+
+void GenotypeEncoder::UpdateHaplotypeOrder(const bcf1_t* entry) {
+	const uint8_t* gt = entry->d.fmt[0].p;
+	const uint32_t n_haplotypes = 2*this->n_samples;
+
+	// Haplotypes carrying the reference allele are compacted in-place.
+	uint32_t n_ref = 0, n_alt = 0;
+	for (uint32_t j = 0; j < n_haplotypes; ++j) {
+		const uint32_t h = this->hap_order[j];
+		if (YON_GT_HAPLOTYPE_ALLELE(gt[h])) this->hap_scratch[n_alt++] = h;
+		else this->hap_order[n_ref++] = h;
+	}
+	memcpy(&this->hap_order[n_ref], this->hap_scratch, n_alt*sizeof(uint32_t));
+}
+
+void GenotypeEncoder::AddSparse(const bcf1_t* entry,
+                                const yon_gt_ppa& ppa,
+                                const uint32_t n_runs,
+                                yon1_vnt_t& rcd,
+                                block_type& block)
+{
+	const uint32_t n_carriers = this->EncodeSparse(entry, ppa, n_runs, block.base_containers[YON_BLK_GT_N_INT8]);
+	++this->stats_.sparse_counts;
+
+	rcd.controller.gt_primtive_type    = YON_GT_BYTE;
+	rcd.controller.gt_compression_type = YON_GT_SPARSE;
+	block.base_containers[YON_BLK_GT_SUPPORT].Add(n_carriers);
+	++block.base_containers[YON_BLK_GT_SUPPORT];
+}
+
+// Predicate for a genotype where every allele is the reference allele.
+static inline bool IsReferenceGenotype(const uint8_t* gt, const uint8_t base_ploidy) {
+	for (uint32_t k = 0; k < base_ploidy; ++k) {
+		if ((gt[k] >> 1) != 1) return false;
+	}
+	return true;
+}
+
+bool GenotypeEncoder::AssessSparse(const bcf1_t* entry,
+                                   const yon_gt_ppa& ppa,
+                                   const uint32_t n_runs,
+                                   const uint64_t b_limit) const
+{
+	const uint8_t  base_ploidy = entry->d.fmt[0].n;
+	const uint8_t* gt = entry->d.fmt[0].p;
+
+	uint64_t b_sparse = 0;
+	uint32_t next     = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint32_t offset = this->run_offsets[r];
+		if (IsReferenceGenotype(&gt[ppa[offset] * sizeof(int8_t) * base_ploidy], base_ploidy))
+			continue;
+
+		// Only the first carrier of a run is preceded by a gap
+		// while all remaining carriers have a gap of zero.
+		const uint32_t l_run = this->run_offsets[r + 1] - offset;
+		b_sparse += SparseGenotypeVarintLength(offset - next) + (l_run - 1) + (uint64_t)l_run * base_ploidy;
+		if (b_sparse >= b_limit) return false;
+		next = offset + l_run;
+	}
+
+	return(b_sparse < b_limit);
+}
+
+uint32_t GenotypeEncoder::EncodeSparse(const bcf1_t* entry,
+                                       const yon_gt_ppa& ppa,
+                                       const uint32_t n_runs,
+                                       container_type& dst) const
+{
+	const uint8_t  base_ploidy = entry->d.fmt[0].n;
+	const uint8_t* gt = entry->d.fmt[0].p;
+
+	uint8_t  varint[5];
+	uint32_t n_carriers = 0;
+	uint32_t next       = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		if (IsReferenceGenotype(&gt[ppa[this->run_offsets[r]] * sizeof(int8_t) * base_ploidy], base_ploidy))
+			continue;
+
+		for (uint32_t s = this->run_offsets[r]; s < this->run_offsets[r + 1]; ++s) {
+			const uint8_t* gt_ppa_target = &gt[ppa[s] * sizeof(int8_t) * base_ploidy];
+			const uint32_t l_varint = SparseGenotypeVarintEncode(s - next, varint);
+			dst.AddLiteral(reinterpret_cast<const char*>(varint), l_varint);
+			for (uint32_t k = 0; k < base_ploidy; ++k)
+				dst.AddLiteral((uint8_t)YON_GT_SPARSE_ALLELE(gt_ppa_target[k]));
+
+			++dst.header.n_additions;
+			++n_carriers;
+			next = s + 1;
+		}
+	}
+	++dst.header.n_entries;
+
+	return(n_carriers);
+}
+
+uint32_t GenotypeEncoder::GatherDiploid(const bcf1_t* entry,
+                                        const yon_gt_ppa& ppa,
+                                        GenotypeSummary& gt_summary)
+{
+	assert(entry->d.fmt[0].n == 2);
+	assert(ppa.n_s * 2 == entry->d.fmt[0].p_len);
+	const uint8_t* gt = entry->d.fmt[0].p;
+	gt_summary = GenotypeSummary();
+	gt_summary.base_ploidy = 2;
+	if (this->n_samples == 0) return 0;
+
+	// The raw allele bytes of a sample are stored as its symbol. Adjacent
+	// samples are compared as they are gathered and a boundary is retained
+	// where they differ. The summary of GenotypeSummary::Evaluate() is
+	// accumulated in the same pass: the uniform phase is the phase of the
+	// first sample in the original order with a valid second allele.
+	uint64_t n_missing = 0, n_vector_end = 0;
+	uint32_t first_valid = this->n_samples;
+	uint8_t  phases = 0;
+	uint32_t n_runs = 0;
+	uint32_t prev   = ~(uint32_t)0;
+	for (uint32_t i = 0; i < this->n_samples; ++i) {
+		const uint8_t* gt_ppa_target = &gt[ppa[i] * sizeof(int8_t) * 2];
+		const uint8_t a = gt_ppa_target[0], b = gt_ppa_target[1];
+		const uint32_t symbol = (uint32_t)a | ((uint32_t)b << 8);
+		this->gt_symbols[i] = symbol;
+		this->run_offsets[n_runs] = i;
+		n_runs += (symbol != prev);
+		prev = symbol;
+
+		n_missing    += (a == YON_BCF_GT_MISSING) + (b == YON_BCF_GT_MISSING);
+		n_vector_end += (a == (uint8_t)YON_BYTE_EOV) + (b == (uint8_t)YON_BYTE_EOV);
+		if (b != YON_BCF_GT_MISSING && b != (uint8_t)YON_BYTE_EOV) {
+			phases |= 1 << (b & 1);
+			if (ppa[i] < first_valid) {
+				first_valid = ppa[i];
+				gt_summary.phase_if_uniform = b & 1;
+			}
+		}
+	}
+	this->run_offsets[n_runs] = this->n_samples;
+
+	gt_summary.mixed_phasing = (phases == 3);
+	gt_summary.n_missing     = n_missing;
+	gt_summary.n_vector_end  = n_vector_end;
+	return(n_runs);
+}
+
+uint32_t GenotypeEncoder::PackDiploidBiallelic(const uint32_t n_runs,
+                                               const uint8_t shift,
+                                               const uint8_t add)
+{
+	uint32_t n_packed = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint32_t offset = this->run_offsets[r];
+		const uint8_t a = this->gt_symbols[offset] & 255, b = this->gt_symbols[offset] >> 8;
+		const uint32_t symbol = YON_PACK_GT_DIPLOID(a, b, shift, add);
+		// Distinct raw symbols can pack to the same genotype if the phase
+		// is dropped: such adjacent runs are merged.
+		if (n_packed && this->gt_symbols[this->run_offsets[n_packed - 1]] == symbol)
+			continue;
+
+		this->gt_symbols[offset] = symbol;
+		this->run_offsets[n_packed++] = offset;
+	}
+	this->run_offsets[n_packed] = this->n_samples;
+
+	return(n_packed);
+}
+
+uint32_t GenotypeEncoder::PackDiploidMultiAllelic(const bcf1_t* entry,
+                                                  const uint32_t n_runs,
+                                                  const uint8_t shift,
+                                                  const uint8_t add)
+{
+	uint8_t gt_remap[256];
+	memset(gt_remap, 256, 255);
+	for (uint32_t i = 0; i <= entry->n_allele; ++i) {
+		gt_remap[i << 1]       = ((i+1) << 1);
+		gt_remap[(i << 1) + 1] = ((i+1) << 1) + 1;
+	}
+	gt_remap[0]   = 0;
+	gt_remap[129] = 1;
+
+	uint32_t n_packed = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint32_t offset = this->run_offsets[r];
+		const uint8_t a = this->gt_symbols[offset] & 255, b = this->gt_symbols[offset] >> 8;
+		assert(gt_remap[a] != 255);
+		assert(gt_remap[b] != 255);
+		const uint32_t symbol = YON_PACK_GT_DIPLOID_NALLELIC(gt_remap[a] >> 1,
+		                                                     gt_remap[b] >> 1,
+		                                                     shift, add,
+		                                                     gt_remap[b]);
+		if (n_packed && this->gt_symbols[this->run_offsets[n_packed - 1]] == symbol)
+			continue;
+
+		this->gt_symbols[offset] = symbol;
+		this->run_offsets[n_packed++] = offset;
+	}
+	this->run_offsets[n_packed] = this->n_samples;
+
+	return(n_packed);
+}
+
+uint32_t GenotypeEncoder::GatherMultiploid(const bcf1_t* entry, const yon_gt_ppa& ppa) {
+	// This method is currently only valid if the genotypic
+	// data is stored as BCF_BT_INT8 in the htslib bcf1_t
+	// record.
+	assert(entry->d.fmt[0].type == BCF_BT_INT8);
+	const uint8_t  base_ploidy = entry->d.fmt[0].n;
+	const uint8_t* gt = entry->d.fmt[0].p;
+	assert(ppa.n_s * base_ploidy == entry->d.fmt[0].p_len);
+	if (this->n_samples == 0) return 0;
+
+	uint32_t n_runs = 1;
+	this->run_offsets[0] = 0;
+	const uint8_t* gt_ppa_ref = &gt[ppa[0] * sizeof(int8_t) * base_ploidy];
+	for (uint32_t i = 1; i < this->n_samples; ++i) {
+		const uint8_t* gt_ppa_target = &gt[ppa[i] * sizeof(int8_t) * base_ploidy];
+		this->run_offsets[n_runs] = i;
+		n_runs += (memcmp(gt_ppa_ref, gt_ppa_target, base_ploidy) != 0);
+		gt_ppa_ref = gt_ppa_target;
+	}
+	this->run_offsets[n_runs] = this->n_samples;
+
+	return(n_runs);
+}
+
+yon_gt_assess GenotypeEncoder::AssessRuns(const uint32_t n_runs, const uint64_t* limits, const uint8_t method) const {
+	yon_gt_assess sum;
+	for (uint32_t k = 0; k < 4; ++k) {
+		if (limits[k] == 0) {
+			sum.n_runs[k] = std::numeric_limits<uint64_t>::max();
+			sum.n_cost[k] = std::numeric_limits<uint64_t>::max();
+			continue;
+		}
+
+		// Runs can only be split if the limit is smaller
+		// than the number of samples.
+		uint64_t n_entries = n_runs;
+		if (limits[k] < this->n_samples) {
+			n_entries = 0;
+			for (uint32_t r = 0; r < n_runs; ++r) {
+				const uint64_t l_run = this->run_offsets[r + 1] - this->run_offsets[r];
+				n_entries += (l_run + limits[k] - 1) / limits[k];
+			}
+		}
+		sum.n_runs[k] = n_entries;
+		sum.n_cost[k] = n_entries*(k+1);
+	}
+
+	for (uint32_t k = 4; k < 8; ++k) {
+		sum.n_runs[k] = std::numeric_limits<uint64_t>::max();
+		sum.n_cost[k] = std::numeric_limits<uint64_t>::max();
+	}
+	sum.method = method;
+
+	return sum;
+}
+
 bool GenotypeEncoder::Encode(yon1_vnt_t* rcds,
                              const uint32_t n_rcds,
                              block_type& block,
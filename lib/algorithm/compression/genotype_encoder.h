@@ -25,6 +25,10 @@ const uint8_t YON_RCD_DIPLOID_BIALLELIC[4] = {2, 0, 0, 1};
 #define YON_PACK_GT_RCD_DIPLOID(A, B, SHIFT, ADD) (YON_RCD_DIPLOID_BIALLELIC[YON_GT_RCD_ALLELE_UNPACK(A)] << ((SHIFT) + (ADD))) | (YON_RCD_DIPLOID_BIALLELIC[YON_GT_RCD_ALLELE_UNPACK(B)] << (ADD)) | ((A) & (ADD))
 #define YON_PACK_GT_RCD_DIPLOID_EXPAND(A, SHIFT, ADD) (YON_RCD_DIPLOID_BIALLELIC[YON_GT_RCD_ALLELE_UNPACK(A.allele[0])] << ((SHIFT) + (ADD))) | (YON_RCD_DIPLOID_BIALLELIC[YON_GT_RCD_ALLELE_UNPACK(A.allele[1])] << (ADD)) | ((A.allele[1]) & (ADD))
 #define YON_PACK_GT_RCD_NALLELIC(A, B, SHIFT, ADD, PHASE) (YON_GT_RCD_ALLELE_UNPACK(A) << ((SHIFT) + (ADD))) | (YON_GT_RCD_ALLELE_UNPACK(B) << (ADD)) | ((PHASE) & (ADD))
+// Htslib allele to a yon_gt_rcd allele without phase.
+#define YON_GT_SPARSE_ALLELE(A) ((A) == 129 ? YON_GT_RCD_EOV : (((A) >> 1) == 0 ? YON_GT_RCD_MISS : ((((A) >> 1) + 1) << 1)))
+// Htslib allele of a biallelic site to its allele index {0,1}.
+#define YON_GT_HAPLOTYPE_ALLELE(A) (((A) >> 1) - 1)
 #define YON_PACK_GT_RCD_NALLELIC_EXPAND(A, SHIFT, ADD) (YON_GT_RCD_ALLELE_UNPACK(A.allele[0]) << ((SHIFT) + (ADD))) | (YON_GT_RCD_ALLELE_UNPACK(A.allele[1]) << (ADD)) | ((A.allele[1]) & (ADD))
 
 struct yon_gt_assess {
@@ -64,6 +68,7 @@ struct GenotypeEncoderStatistics{
 		memset(this->rle_simple_counts,  0, sizeof(uint64_t)*4);
 		memset(this->diploid_bcf_counts, 0, sizeof(uint64_t)*3);
 		memset(this->bcf_counts,         0, sizeof(uint64_t)*3);
+		this->sparse_counts = 0;
 	}
 
 	uint64_t getTotal(void) const {
@@ -72,6 +77,7 @@ struct GenotypeEncoderStatistics{
 		for (uint32_t i = 0; i < 4; ++i) total += this->rle_simple_counts[i];
 		for (uint32_t i = 0; i < 3; ++i) total += this->diploid_bcf_counts[i];
 		for (uint32_t i = 0; i < 3; ++i) total += this->bcf_counts[i];
+		total += this->sparse_counts;
 		return(total);
 	}
 
@@ -79,6 +85,7 @@ struct GenotypeEncoderStatistics{
 	uint64_t rle_simple_counts[4];
 	uint64_t diploid_bcf_counts[3];
 	uint64_t bcf_counts[3];
+	uint64_t sparse_counts; // records encoded as YON_GT_SPARSE
 };
 
 class GenotypeEncoder {
@@ -92,14 +99,61 @@ public:
 public:
 	GenotypeEncoder();
 	GenotypeEncoder(const uint64_t samples);
+	GenotypeEncoder(const self_type& other);
+	GenotypeEncoder& operator=(const self_type& other);
 	~GenotypeEncoder();
 
-	inline void SetSamples(const uint64_t samples) { this->n_samples = samples; }
+	void SetSamples(const uint64_t samples);
+	// Sparse carrier lists cannot be read by older versions and are
+	// therefore only considered when enabled.
+	inline void SetSparse(const bool yes) { this->sparse = yes; }
 	inline const stats_type& GetUsageStats(void) const { return(this->stats_); }
 
-	bool Encode(const containers::VcfContainer& container, yon1_vnt_t* rcds, block_type& block, const yon_gt_ppa& ppa) const;
+	/**<
+	 * Encode the genotypes of all records in a VcfContainer. The genotypes
+	 * of a diploid record are visited once: they are gathered in permuted
+	 * order while their run boundaries and summary are computed. The runs
+	 * are then packed, the cost of every primitive width is derived from
+	 * the run lengths alone, and the runs are emitted at the cheapest width
+	 * without revisiting the genotypes. Multiploid records are summarised
+	 * in a separate pass.
+	 * @param container Src container of htslib records.
+	 * @param rcds      Dst variant records receiving the controller flags.
+	 * @param block     Dst variant block.
+	 * @param ppa       Src permutation array.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Encode(const containers::VcfContainer& container, yon1_vnt_t* rcds, block_type& block, const yon_gt_ppa& ppa);
 	bool Encode(yon1_vnt_t* rcds, const uint32_t n_rcds, block_type& block, const yon_gt_ppa& ppa) const;
 
+	/**<
+	 * Encode the genotypes of all records as a positional BWT over the
+	 * 2*n_samples haplotypes (YON_GT_PBWT). Each record is stored as the
+	 * allele of the first haplotype followed by the lengths of the runs of
+	 * alternating alleles in the current haplotype order. The order is then
+	 * updated by stably partitioning the haplotypes by their allele such
+	 * that haplotypes sharing long suffixes remain adjacent. The order at
+	 * the start of the block is the final order of a first pass over the
+	 * block and is available from GetHaplotypeOrder().
+	 * @param container Src container of htslib records.
+	 * @param rcds      Dst variant records receiving the controller flags.
+	 * @param block     Dst variant block.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool EncodeHaplotypes(const containers::VcfContainer& container, yon1_vnt_t* rcds, block_type& block);
+
+	/**<
+	 * Predicate for whether a record can be encoded as part of a haplotype
+	 * PBWT block. Every sample has to be diploid, biallelic, phased, and
+	 * have no missing or EOV alleles.
+	 * @param entry     Src htslib record.
+	 * @param n_samples Number of samples.
+	 * @return          Returns TRUE if the record is eligible or FALSE otherwise.
+	 */
+	static bool IsPhasedBiallelic(const bcf1_t* entry, const uint64_t n_samples);
+
+	inline yon_gt_ppa& GetHaplotypeOrder(void) { return(this->hap_ppa); }
+
 	yon_gt_assess Assess(const bcf1_t* entry, const GenotypeSummary& gt_summary, const yon_gt_ppa& ppa) const;
 	yon_gt_assess Assess(const yon1_vnt_t& entry, const GenotypeSummary& gr_summary, const yon_gt_ppa& ppa) const;
 	yon_gt_assess AssessDiploidBiallelic(const bcf1_t* entry, const GenotypeSummary& gt_summary, const yon_gt_ppa& ppa) const;
@@ -145,11 +199,175 @@ public:
 							  const yon_gt_ppa& ppa,
 							  container_type& dst) const;
 
+private:
+	/**<
+	 * Gather the raw allele bytes of a diploid record in permuted order
+	 * into the symbol buffer, compute its run boundaries, and summarise its
+	 * genotypes in a single pass over the samples.
+	 * @param entry      Src htslib record.
+	 * @param ppa        Src permutation array.
+	 * @param gt_summary Dst summary equivalent to GenotypeSummary::Evaluate().
+	 * @return           Returns the number of runs.
+	 */
+	uint32_t GatherDiploid(const bcf1_t* entry, const yon_gt_ppa& ppa, GenotypeSummary& gt_summary);
+
+	/**<
+	 * Pack the raw symbols of the gathered runs and merge adjacent runs
+	 * that pack to the same genotype.
+	 * @return Returns the number of runs.
+	 */
+	uint32_t PackDiploidBiallelic(const uint32_t n_runs, const uint8_t shift, const uint8_t add);
+	uint32_t PackDiploidMultiAllelic(const bcf1_t* entry, const uint32_t n_runs, const uint8_t shift, const uint8_t add);
+
+	/**<
+	 * Compute the run boundaries of a multiploid record in permuted order by
+	 * comparing the allele bytes of adjacent samples.
+	 * @return Returns the number of runs.
+	 */
+	uint32_t GatherMultiploid(const bcf1_t* entry, const yon_gt_ppa& ppa);
+
+	/**<
+	 * Derive the cost of every primitive width from the gathered runs. A run
+	 * that is longer than the largest run length that fits in a primitive is
+	 * split into several entries. Costs for unpermuted data are not evaluated.
+	 * @param n_runs Number of gathered runs.
+	 * @param limits Largest run length per primitive or 0 if the primitive cannot be used.
+	 * @param method Encoding method.
+	 * @return       Returns the assessed costs.
+	 */
+	yon_gt_assess AssessRuns(const uint32_t n_runs, const uint64_t* limits, const uint8_t method) const;
+
+	/**<
+	 * Emit the gathered diploid runs at the given primitive width.
+	 * @param n_runs    Number of gathered runs.
+	 * @param bit_shift Number of bits used by the packed genotype.
+	 * @param limit     Largest run length that fits in the primitive.
+	 * @param dst       Dst container.
+	 * @return          Returns the number of emitted runs.
+	 */
+	template <class YON_RLE_TYPE>
+	uint64_t EncodeRuns(const uint32_t n_runs, const uint8_t bit_shift, const uint64_t limit, container_type& dst) const;
+
+	template <class YON_RLE_TYPE>
+	uint64_t EncodeRunsMultiploid(const bcf1_t* entry, const yon_gt_ppa& ppa, const uint32_t n_runs, container_type& dst) const;
+
+	/**<
+	 * Predicate for whether the sparse carrier-list encoding of a record is
+	 * smaller than the provided number of bytes. Carriers are samples with
+	 * any allele that is not the reference allele (including missing and
+	 * EOV). The cost is computed from the gathered runs and terminates as
+	 * soon as the limit is reached.
+	 * @param entry   Src htslib record.
+	 * @param ppa     Src permutation array.
+	 * @param n_runs  Number of gathered runs.
+	 * @param b_limit Number of bytes required by the run-length encoding.
+	 * @return        Returns TRUE if the sparse encoding is smaller or FALSE otherwise.
+	 */
+	bool AssessSparse(const bcf1_t* entry, const yon_gt_ppa& ppa, const uint32_t n_runs, const uint64_t b_limit) const;
+
+	/**<
+	 * Emit a record as a sparse carrier list (YON_GT_SPARSE) into the
+	 * byte-wide nploid stream. Each carrier is stored as the gap to the
+	 * previous carrier in permuted order followed by its alleles.
+	 * @return Returns the number of carriers.
+	 */
+	uint32_t EncodeSparse(const bcf1_t* entry, const yon_gt_ppa& ppa, const uint32_t n_runs, container_type& dst) const;
+	void AddSparse(const bcf1_t* entry, const yon_gt_ppa& ppa, const uint32_t n_runs, yon1_vnt_t& rcd, block_type& block);
+
+	/**<
+	 * Stably partition the current haplotype order such that haplotypes
+	 * carrying the reference allele precede those carrying the alternative
+	 * allele at the provided site.
+	 * @param entry Src htslib record.
+	 */
+	void UpdateHaplotypeOrder(const bcf1_t* entry);
+
 private:
 	uint64_t n_samples; // number of samples
+	bool sparse; // allow records to be encoded as YON_GT_SPARSE
 	stats_type stats_;
+	uint32_t* gt_symbols; // packed genotypes in permuted order
+	uint32_t* run_offsets; // permuted offset of the first sample of each run
+	yon_gt_ppa hap_ppa; // haplotype order at the start of the block
+	uint32_t* hap_order; // current haplotype order
+	uint32_t* hap_scratch; // haplotypes carrying the alternative allele
 };
 
+template <class YON_RLE_TYPE>
+uint64_t GenotypeEncoder::EncodeRuns(const uint32_t n_runs,
+                                     const uint8_t bit_shift,
+                                     const uint64_t limit,
+                                     container_type& dst) const
+{
+	uint64_t n_entries = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint32_t symbol = this->gt_symbols[this->run_offsets[r]];
+		uint64_t l_run = this->run_offsets[r + 1] - this->run_offsets[r];
+
+		// Runs exceeding the primitive limit are split.
+		while (true) {
+			const uint64_t l_entry = l_run > limit ? limit : l_run;
+			YON_RLE_TYPE RLE = l_entry;
+			RLE <<= bit_shift;
+			RLE |= symbol;
+			assert((uint64_t)(RLE >> bit_shift) == l_entry);
+
+			dst.AddLiteral((YON_RLE_TYPE)RLE);
+			++dst.header.n_additions;
+			++n_entries;
+
+			l_run -= l_entry;
+			if (l_run == 0) break;
+		}
+	}
+	++dst.header.n_entries;
+
+	return n_entries;
+}
+
+template <class YON_RLE_TYPE>
+uint64_t GenotypeEncoder::EncodeRunsMultiploid(const bcf1_t* entry,
+                                               const yon_gt_ppa& ppa,
+                                               const uint32_t n_runs,
+                                               container_type& dst) const
+{
+	const uint8_t  base_ploidy = entry->d.fmt[0].n;
+	const uint8_t* gt    = entry->d.fmt[0].p;
+	const uint64_t limit = std::numeric_limits<YON_RLE_TYPE>::max();
+
+	// Remap genotype encoding such that 0 maps to missing and
+	// 1 maps to the sentinel node symbol (EOV).
+	uint8_t gt_remap[256];
+	memset(gt_remap, 256, 255);
+	for (uint32_t i = 0; i <= entry->n_allele; ++i) {
+		gt_remap[i << 1]       = ((i+1) << 1);
+		gt_remap[(i << 1) + 1] = ((i+1) << 1) + 1;
+	}
+	gt_remap[0]   = 0;
+	gt_remap[129] = 1;
+
+	uint64_t n_entries = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint8_t* reference = &gt[ppa[this->run_offsets[r]] * sizeof(int8_t) * base_ploidy];
+		uint64_t l_run = this->run_offsets[r + 1] - this->run_offsets[r];
+
+		// Runs exceeding the primitive limit are split.
+		while (true) {
+			const YON_RLE_TYPE l_entry = l_run > limit ? limit : l_run;
+			dst.AddLiteral(l_entry);
+			for (uint32_t k = 0; k < base_ploidy; ++k) dst.AddLiteral(gt_remap[reference[k]]);
+			++dst.header.n_additions;
+			++n_entries;
+
+			l_run -= l_entry;
+			if (l_run == 0) break;
+		}
+	}
+	++dst.header.n_entries;
+
+	return n_entries;
+}
+
 template <class YON_RLE_TYPE>
 uint64_t GenotypeEncoder::EncodeDiploidBiallelic(const bcf1_t* entry,
                                                  const GenotypeSummary& gt_summary,
@@ -107,6 +107,34 @@ public:
 		this->hasInitialized = true;
 	}
 
+	/**<
+	 * Write out the running (not finalized) SHA-512 contexts such that
+	 * hashing can be continued in another process with DeserializeState().
+	 * The contexts are stored as raw bytes and are therefore only portable
+	 * between processes linked against the same OpenSSL build.
+	 * @param stream Dst output stream.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SerializeState(std::ostream& stream) const {
+		stream.write(reinterpret_cast<const char*>(&this->hasInitialized), sizeof(bool));
+		stream.write(reinterpret_cast<const char*>(&this->hasFinished),    sizeof(bool));
+		stream.write(reinterpret_cast<const char*>(&this->data_context),   sizeof(SHA512_CTX));
+		stream.write(reinterpret_cast<const char*>(&this->stride_context), sizeof(SHA512_CTX));
+		stream.write(reinterpret_cast<const char*>(&this->data_digest[0]),   64);
+		stream.write(reinterpret_cast<const char*>(&this->stride_digest[0]), 64);
+		return(stream.good());
+	}
+
+	bool DeserializeState(std::istream& stream) {
+		stream.read(reinterpret_cast<char*>(&this->hasInitialized), sizeof(bool));
+		stream.read(reinterpret_cast<char*>(&this->hasFinished),    sizeof(bool));
+		stream.read(reinterpret_cast<char*>(&this->data_context),   sizeof(SHA512_CTX));
+		stream.read(reinterpret_cast<char*>(&this->stride_context), sizeof(SHA512_CTX));
+		stream.read(reinterpret_cast<char*>(&this->data_digest[0]),   64);
+		stream.read(reinterpret_cast<char*>(&this->stride_digest[0]), 64);
+		return(stream.good());
+	}
+
 private:
 	friend std::ostream& operator<<(std::ostream& stream, const self_type& entry) {
 		stream.write(reinterpret_cast<const char* const>(&entry.data_digest),   64);
@@ -168,6 +196,14 @@ public:
 		this->uncompressed.update(container.data_uncompressed, container.strides_uncompressed, container.header.HasMixedStride());
 	}
 
+	inline bool SerializeState(std::ostream& stream) const {
+		return(this->compressed.SerializeState(stream) && this->uncompressed.SerializeState(stream));
+	}
+
+	inline bool DeserializeState(std::istream& stream) {
+		return(this->compressed.DeserializeState(stream) && this->uncompressed.DeserializeState(stream));
+	}
+
 private:
 	friend std::ostream& operator<<(std::ostream& stream, const self_type& entry) {
 		stream << entry.compressed;
@@ -109,6 +109,36 @@ public:
 		for (uint32_t i = 0; i < this->size(); ++i) this->at(i).finalize();
 	}
 
+	/**<
+	 * Write out the running state of all digests. In contrast to the
+	 * stream operators, which write the finalized checksums, this allows
+	 * hashing to be resumed after restoring with DeserializeState().
+	 * @param stream Dst output stream.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SerializeState(std::ostream& stream) const {
+		stream.write(reinterpret_cast<const char*>(&this->n_entries_), sizeof(size_type));
+		for (size_type i = 0; i < this->size(); ++i) {
+			if (this->at(i).SerializeState(stream) == false)
+				return false;
+		}
+		return(stream.good());
+	}
+
+	bool DeserializeState(std::istream& stream) {
+		stream.read(reinterpret_cast<char*>(&this->n_entries_), sizeof(size_type));
+		if (this->n_entries_ > this->n_capacity_) {
+			delete [] this->__entries;
+			this->n_capacity_ = this->n_entries_;
+			this->__entries   = new value_type[this->n_capacity_];
+		}
+		for (size_type i = 0; i < this->size(); ++i) {
+			if (this->at(i).DeserializeState(stream) == false)
+				return false;
+		}
+		return(stream.good());
+	}
+
 private:
 	friend std::ostream& operator<<(std::ostream& out, const self_type& container) {
 		out.write((const char* const)reinterpret_cast<const size_type* const>(&container.n_entries_), sizeof(size_type));
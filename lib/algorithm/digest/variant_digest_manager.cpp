@@ -68,5 +68,44 @@ void VariantDigestManager::operator+=(const variant_block_type& block) {
 	for (uint32_t i = 0; i < block.footer.n_format_streams; ++i) this->__entries_format[block.footer.format_offsets[i].data_header.global_key] += block.format_containers[i];
 }
 
+bool VariantDigestManager::SerializeState(std::ostream& stream) const {
+	if (parent_type::SerializeState(stream) == false)
+		return false;
+
+	stream.write(reinterpret_cast<const char*>(&this->n_entries_info_),   sizeof(size_type));
+	stream.write(reinterpret_cast<const char*>(&this->n_entries_format_), sizeof(size_type));
+	for (uint32_t i = 0; i < this->n_entries_info_; ++i) {
+		if (this->atINFO(i).SerializeState(stream) == false) return false;
+	}
+	for (uint32_t i = 0; i < this->n_entries_format_; ++i) {
+		if (this->atFORMAT(i).SerializeState(stream) == false) return false;
+	}
+	return(stream.good());
+}
+
+bool VariantDigestManager::DeserializeState(std::istream& stream) {
+	if (parent_type::DeserializeState(stream) == false)
+		return false;
+
+	stream.read(reinterpret_cast<char*>(&this->n_entries_info_),   sizeof(size_type));
+	stream.read(reinterpret_cast<char*>(&this->n_entries_format_), sizeof(size_type));
+	if (stream.good() == false) return false;
+
+	delete [] this->__entries_info;
+	delete [] this->__entries_format;
+	this->n_capacity_info_  = this->n_entries_info_;
+	this->n_capacity_format = this->n_entries_format_;
+	this->__entries_info    = new value_type[this->n_capacity_info_];
+	this->__entries_format  = new value_type[this->n_capacity_format];
+
+	for (uint32_t i = 0; i < this->n_entries_info_; ++i) {
+		if (this->atINFO(i).DeserializeState(stream) == false) return false;
+	}
+	for (uint32_t i = 0; i < this->n_entries_format_; ++i) {
+		if (this->atFORMAT(i).DeserializeState(stream) == false) return false;
+	}
+	return(stream.good());
+}
+
 }
 }
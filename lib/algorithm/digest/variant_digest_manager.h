@@ -30,6 +30,16 @@ public:
 
 	void operator+=(const variant_block_type& block);
 
+	/**<
+	 * Write out or restore the running (not finalized) state of all
+	 * base, Info, and Format digests. Used for checkpointing long-running
+	 * imports such that they can be resumed at a later time.
+	 * @param stream Dst/src stream.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SerializeState(std::ostream& stream) const;
+	bool DeserializeState(std::istream& stream);
+
 	template <class T>
 	static void GenerateMd5(const T& value, uint8_t* dst) {
 	   // uint8_t hash[MD5_DIGEST_LENGTH];
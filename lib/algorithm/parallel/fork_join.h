@@ -0,0 +1,115 @@
+#ifndef ALGORITHM_PARALLEL_FORK_JOIN_H_
+#define ALGORITHM_PARALLEL_FORK_JOIN_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+namespace tachyon{
+namespace algorithm{
+
+/**<
+ * Persistent fork-join pool for short data-parallel sections. Run()
+ * invokes a task once for every worker index in [0, n_workers) and
+ * returns when all of them have completed. The calling thread executes
+ * index 0 such that a pool of one worker spawns no threads at all.
+ */
+class ForkJoinPool {
+public:
+	typedef ForkJoinPool self_type;
+	typedef std::function<void(const uint32_t)> task_type;
+
+public:
+	ForkJoinPool() : n_workers(1), n_pending(0), generation(0), stop(false), task(nullptr) {}
+	~ForkJoinPool() { this->Stop(); }
+	ForkJoinPool(const self_type& other) = delete;
+	ForkJoinPool& operator=(const self_type& other) = delete;
+
+	/**<
+	 * Spawn the workers. Any previously running workers are stopped.
+	 * @param n_workers Total number of workers including the calling thread.
+	 */
+	void Start(const uint32_t n_workers) {
+		this->Stop();
+		this->n_workers = std::max(n_workers, (uint32_t)1);
+		for (uint32_t i = 1; i < this->n_workers; ++i)
+			this->threads.push_back(std::thread(&self_type::Work, this, i, this->generation));
+	}
+
+	void Stop(void) {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->stop = true;
+		}
+		this->cv_start.notify_all();
+		for (uint32_t i = 0; i < this->threads.size(); ++i) this->threads[i].join();
+		this->threads.clear();
+		this->stop = false;
+		this->n_workers = 1;
+	}
+
+	/**<
+	 * Invoke the task for every worker index and wait for completion.
+	 * @param task Task receiving the worker index.
+	 */
+	void Run(const task_type& task) {
+		if (this->threads.size() == 0) {
+			task(0);
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->task = &task;
+			this->n_pending = this->threads.size();
+			++this->generation;
+		}
+		this->cv_start.notify_all();
+
+		task(0);
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->cv_done.wait(lock, [this]{ return(this->n_pending == 0); });
+		this->task = nullptr;
+	}
+
+	inline uint32_t size(void) const { return(this->n_workers); }
+
+private:
+	void Work(const uint32_t worker_id, uint64_t seen) {
+		while (true) {
+			const task_type* current = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->cv_start.wait(lock, [this, &seen]{ return(this->stop || this->generation != seen); });
+				if (this->stop) return;
+				seen = this->generation;
+				current = this->task;
+			}
+
+			(*current)(worker_id);
+
+			std::unique_lock<std::mutex> lock(this->mutex);
+			if (--this->n_pending == 0) this->cv_done.notify_one();
+		}
+	}
+
+private:
+	uint32_t n_workers; // number of workers including the caller
+	uint32_t n_pending; // workers yet to finish the current task
+	uint64_t generation; // incremented for every task
+	bool stop;
+	const task_type* task;
+	std::mutex mutex;
+	std::condition_variable cv_start;
+	std::condition_variable cv_done;
+	std::vector<std::thread> threads;
+};
+
+}
+}
+
+#endif /* ALGORITHM_PARALLEL_FORK_JOIN_H_ */
@@ -165,6 +165,9 @@ public:
 		}
 
 
+		// Prefix-sum the per-sample range updates of this block.
+		s_local.Flush();
+
 		assert(vc.gt_ppa != nullptr);
 
 		if (this->vc.header.controller.has_gt_permuted) {
@@ -7,10 +7,12 @@
 #include <cstdint>
 #include <thread>
 #include <mutex>
+#include <sstream>
 #include <condition_variable>
 
 #include "vcf_importer_slave.h"
 #include "containers/vcf_container.h"
+#include "io/import_checkpoint.h"
 #include "header_footer.h"
 #include "variant_container.h"
 
@@ -22,18 +24,19 @@ namespace tachyon{
  * shared resources.
  */
 struct yon_pool_vcfc_payload {
-	yon_pool_vcfc_payload() : block_id(0), c(nullptr) {}
-	yon_pool_vcfc_payload(const uint32_t bid, containers::VcfContainer* vc) : block_id(bid), c(vc) {}
+	yon_pool_vcfc_payload() : block_id(0), input_offset(-1), c(nullptr) {}
+	yon_pool_vcfc_payload(const uint32_t bid, const int64_t offset, containers::VcfContainer* vc) : block_id(bid), input_offset(offset), c(vc) {}
 	~yon_pool_vcfc_payload() { delete c; }
 	yon_pool_vcfc_payload(const yon_pool_vcfc_payload& other) = delete; // copy is not allowed
 	yon_pool_vcfc_payload& operator=(const yon_pool_vcfc_payload& other) = delete; // copy assign is not allowed
-	yon_pool_vcfc_payload(yon_pool_vcfc_payload&& other) noexcept : block_id(other.block_id), c(nullptr) {
+	yon_pool_vcfc_payload(yon_pool_vcfc_payload&& other) noexcept : block_id(other.block_id), input_offset(other.input_offset), c(nullptr) {
 		std::swap(this->c, other.c);
 	}
 	yon_pool_vcfc_payload& operator=(yon_pool_vcfc_payload&& other) noexcept{
 		if (this == &other) return(*this);
 
 		this->block_id = other.block_id;
+		this->input_offset = other.input_offset;
 		delete this->c;
 		this->c = nullptr;
 		std::swap(this->c, other.c);
@@ -41,6 +44,7 @@ struct yon_pool_vcfc_payload {
 	}
 
 	uint32_t block_id;
+	int64_t  input_offset; // input position of the first record following this block
 	containers::VcfContainer* c;
 };
 
@@ -185,9 +189,11 @@ public:
 	                  std::unique_ptr<io::VcfReader>& reader,
 	                  uint32_t pool_size) :
 		all_finished(false),
+		n_blocks(0),
 		n_rcds_loaded(0),
 		data_available(false),
 		data_pool(pool_size),
+		budget(nullptr),
 		settings(settings),
 		reader(reader)
 	{}
@@ -209,7 +215,6 @@ private:
 	 * @return Returns TRUE if successful or FALSE otherwise.
 	 */
 	bool Produce(void) {
-		uint32_t n_blocks = 0;
 		this->data_available  = true;
 		this->data_pool.alive = true;
 		while(true) {
@@ -218,7 +223,13 @@ private:
 			// the smallest and largest variant exceeds some distance in base pairs.
 			// Vcf records are NOT lazy evaluated (unpacked) in the producer step
 			// that is the job of the consumers.
-			if (this->container.GetVariants(this->settings.checkpoint_n_snps,
+			// The number of records per block is either fixed or adapted
+			// to a byte budget from the sizes of the blocks written so far.
+			const int32_t n_variants = this->budget != nullptr
+			                         ? this->budget->GetRecordLimit()
+			                         : this->settings.checkpoint_n_snps;
+
+			if (this->container.GetVariants(n_variants,
 			                               this->settings.checkpoint_bases,
 			                               this->reader,
 			                               0) == false)
@@ -243,19 +254,30 @@ private:
 				break;
 			}
 			this->n_rcds_loaded += this->container.sizeWithoutCarryOver();
+
+			// Position in the input stream where the data following this
+			// block begins. If a record was carried over to the next block
+			// then that record has already been read from the stream and
+			// its start position is used instead.
+			const int64_t input_offset = this->container.n_carry_over_
+			                           ? this->reader->GetLastRecordOffset()
+			                           : this->reader->Tell();
+
 			// Peculiar syntax for adding a new payload to the cyclic queue. The
 			// move semantics is required for intended functionality!
-			this->data_pool.emplace(new yon_pool_vcfc_payload(n_blocks++, new containers::VcfContainer(std::move(this->container))));
+			this->data_pool.emplace(new yon_pool_vcfc_payload(this->n_blocks++, input_offset, new containers::VcfContainer(std::move(this->container))));
 		}
 		return true;
 	}
 
 public:
 	bool all_finished;
+	uint32_t n_blocks; // identifier of the next block: non-zero when resuming
 	uint64_t n_rcds_loaded;
 	std::atomic<bool> data_available;
 	yon_pool_vcfc data_pool;
 	containers::VcfContainer container;
+	const yon_vb_budget* budget; // adaptive block size policy or nullptr
 	const VariantImporterSettings& settings;
 	std::thread thread_;
 	std::unique_ptr<io::VcfReader>& reader;
@@ -263,18 +285,19 @@ public:
 
 // Synchronised writer.
 struct yon_writer_sync {
-	yon_writer_sync() : n_written_rcds(0), next_block_id(0), alive(true), writer(nullptr) {}
+	yon_writer_sync() : n_written_rcds(0), next_block_id(0), first_block_id(0), checkpoint_interval(0), alive(true), failed(false), writer(nullptr), budget(nullptr) {}
 	~yon_writer_sync() {}
 
 	/**<
 	 * Push a Tachyon archive to the writer queue to be written. Only if the
 	 * next block number matches the provided block number will the block be
 	 * written to disk. This ascertains that the writing of blocks are in order.
-	 * @param block_id  Source block identifier.
-	 * @param container Source VcfContainer.
-	 * @param importer  Source reference to VcfImporterSlave instance that internally has a VariantBlock to be written.
+	 * @param block_id     Source block identifier.
+	 * @param input_offset Input stream position of the first record following this block.
+	 * @param container    Source VcfContainer.
+	 * @param importer     Source reference to VcfImporterSlave instance that internally has a VariantBlock to be written.
 	 */
-	void emplace(uint32_t block_id, const containers::VcfContainer& container, VcfImporterSlave& importer) {
+	void emplace(uint32_t block_id, const int64_t input_offset, const containers::VcfContainer& container, VcfImporterSlave& importer) {
 		std::unique_lock<std::mutex> l(lock);
 
 		cv_next_checkpoint.wait(l, [this, block_id]() {
@@ -289,15 +312,33 @@ struct yon_writer_sync {
 			return;
 		}
 
-		// Write data container.
-		this->Write(importer.block, container, importer.index.GetCurrent());
+		// Write data container. Remaining blocks are discarded on failure.
+		if (this->Write(importer.block, container, importer.index.GetCurrent()) == false) {
+			this->failed = true;
+			this->alive  = false;
+			l.unlock();
+			cv_next_checkpoint.notify_all();
+			return;
+		}
 		// Update compression/storage statistics.
 		importer.block.UpdateOutputStatistics(this->stats_basic, this->stats_info, this->stats_format);
+		if (this->budget != nullptr)
+			this->budget->Update(importer.block.GetUncompressedSize(), importer.block.GetCompressedSize(), container.sizeWithoutCarryOver());
 		//std::cerr << utility::timestamp("LOG") << "Writing: " << this->next_block_id << ": " << importer.block.GetCompressedSize() << "b" << std::endl;
 
 		++this->next_block_id;
 		this->n_written_rcds += container.sizeWithoutCarryOver();
 
+		// Periodically persist a checkpoint describing the archive up to
+		// and including this block. The first block of this run overwrites
+		// the trailer of an archive opened for appending and is therefore
+		// always checkpointed.
+		if (this->checkpoint_interval &&
+		    (this->next_block_id % this->checkpoint_interval == 0 || this->next_block_id == this->first_block_id + 1))
+		{
+			this->WriteCheckpoint(input_offset);
+		}
+
 		l.unlock();
 		cv_next_checkpoint.notify_all();
 	}
@@ -342,11 +383,54 @@ struct yon_writer_sync {
 			   const containers::VcfContainer& container,
 			   yon1_idx_rec& index_entry)
 	{
+		// Records appended to an existing archive have to sort after its
+		// last record. Blocks are written in order such that only the first
+		// block has to be checked.
+		if (this->writer->append_contig_id >= 0) {
+			if (container.front()->rid < this->writer->append_contig_id ||
+			   (container.front()->rid == this->writer->append_contig_id && container.front()->pos < this->writer->append_position))
+			{
+				std::cerr << utility::timestamp("ERROR", "WRITER") << "Appended records do not sort after the last record of the archive..." << std::endl;
+				return false;
+			}
+			this->writer->append_contig_id = -1;
+		}
+
 		this->writer->WriteBlock(block, index_entry); // write block
 		this->UpdateIndex(container, index_entry); // Update index.
 		return(this->writer->stream->good());
 	}
 
+	/**<
+	 * Write a sidecar checkpoint describing all blocks written so far such
+	 * that an interrupted import can be resumed from this point. The output
+	 * stream is flushed first as the checkpoint must never describe data
+	 * that has not been handed to the file system.
+	 * @param input_offset Input stream position of the first record not yet written.
+	 * @return             Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool WriteCheckpoint(const int64_t input_offset) {
+		this->writer->stream->flush();
+		if (this->writer->stream->good() == false)
+			return false;
+
+		this->checkpoint.input_offset       = input_offset;
+		this->checkpoint.n_blocks_written   = this->writer->n_blocks_written;
+		this->checkpoint.n_variants_written = this->writer->n_variants_written;
+		this->checkpoint.byte_offset_end    = this->writer->stream->tellp();
+
+		// Index entries are appended incrementally as the checkpoint
+		// object is kept alive for the duration of the import.
+		for (uint64_t i = this->checkpoint.index_entries.size(); i < this->writer->n_blocks_written; ++i)
+			this->checkpoint.index_entries.push_back(this->writer->index[i]);
+
+		std::ostringstream digest_state;
+		this->writer->SerializeDigestState(digest_state);
+		this->checkpoint.digest_state = digest_state.str();
+
+		return(this->checkpoint.Write(this->checkpoint_path));
+	}
+
 	/**<
 	 * Update the internal VariantIndex with the source VcfContainer
 	 * and source VariantIndexEntry structure.
@@ -377,11 +461,17 @@ struct yon_writer_sync {
 public:
 	uint64_t n_written_rcds;
 	uint32_t next_block_id;
+	uint32_t first_block_id; // first block written by this run
+	uint32_t checkpoint_interval; // number of blocks between checkpoints (0 disables)
+	std::string checkpoint_path;
+	yon_import_ckpt checkpoint;
 	std::atomic<bool> alive;
+	bool failed; // a block could not be written
 	std::mutex lock;
 	std::condition_variable cv_next_checkpoint;
 
 	VariantWriterInterface* writer; // writer
+	yon_vb_budget* budget; // adaptive block size policy or nullptr
 
 	// Stats
 	yon_vb_istats stats_basic;
@@ -471,7 +561,7 @@ private:
 			// Push to the consumer pool. Notify all threads that are listening
 			// that a new block has been placed with the given block_id. The thread
 			// with the next block will push that to the writer.
-			this->poolw->emplace(d->block_id, *d->c, this->importer);
+			this->poolw->emplace(d->block_id, d->input_offset, *d->c, this->importer);
 
 			// Cleanup data popped from the producer queue.
 			delete d;
@@ -5,33 +5,155 @@ namespace tachyon {
 namespace algorithm {
 
 GenotypeSorter::GenotypeSorter() :
+	seeded(false),
 	n_samples(0),
-	gt_pattern(nullptr)
+	gt_pattern(nullptr),
+	gt_key(nullptr),
+	ppa_scratch(nullptr)
 {
 	memset(this->gt_remap, 0, 256*sizeof(uint8_t));
+	memset(this->gt_symbol, 8, 256*sizeof(uint8_t));
 }
 
 GenotypeSorter::~GenotypeSorter() {
 	delete [] this->gt_pattern;
+	delete [] this->gt_key;
+	delete [] this->ppa_scratch;
 }
 
 void GenotypeSorter::SetSamples(const uint64_t n_samples) {
 	delete [] this->gt_pattern;
+	delete [] this->gt_key;
+	delete [] this->ppa_scratch;
 	this->n_samples = n_samples;
 	this->permutation_array.Allocate(n_samples);
-	this->gt_pattern = new yon_radix_gt[n_samples];
+	this->gt_pattern  = new yon_radix_gt[n_samples];
+	this->gt_key      = new uint8_t[n_samples];
+	this->ppa_scratch = new uint32_t[n_samples];
 }
 
 void GenotypeSorter::reset(void) {
 	this->permutation_array.reset();
+	this->seeded = false;
+}
+
+void GenotypeSorter::Seed(const yon_gt_ppa& ppa) {
+	assert(ppa.n_s == this->permutation_array.n_s);
+	memcpy(this->permutation_array.ordering, ppa.ordering, this->GetNumberSamples()*sizeof(uint32_t));
+	this->seeded = true;
+}
+
+void GenotypeSorter::BuildSymbolMap(const uint32_t largest_n_alleles) {
+	memset(this->gt_symbol, 8, 256*sizeof(uint8_t));
+	for (uint32_t i = 0; i <= largest_n_alleles; ++i) {
+		this->gt_symbol[(i << 1) + 0] = ((this->gt_remap[i] << 1) | 0) - 2;
+		this->gt_symbol[(i << 1) + 1] = ((this->gt_remap[i] << 1) | 1) - 2;
+	}
+	this->gt_symbol[(64 << 1) + 0] = ((this->gt_remap[64] << 1) | 0) - 2;
+	this->gt_symbol[(64 << 1) + 1] = ((this->gt_remap[64] << 1) | 1) - 2;
+}
+
+void GenotypeSorter::SetThreads(const uint32_t n_threads) {
+	if (std::max(n_threads, (uint32_t)1) == this->pool.size())
+		return;
+
+	this->pool.Start(n_threads);
+}
+
+uint8_t GenotypeSorter::BuildKeys(const std::function<uint8_t(const uint32_t, const uint32_t)>& fill) {
+	const uint32_t n_ranges = this->GetNumberRanges();
+	if (n_ranges == 1)
+		return(fill(0, this->GetNumberSamples()));
+
+	std::vector<uint8_t> range_invalid(n_ranges, 0);
+	this->pool.Run([&](const uint32_t r) {
+		if (r >= n_ranges) return;
+		range_invalid[r] = fill(this->GetRangeStart(r, n_ranges), this->GetRangeStart(r + 1, n_ranges));
+	});
+
+	uint8_t invalid = 0;
+	for (uint32_t r = 0; r < n_ranges; ++r) invalid |= range_invalid[r];
+	return(invalid);
+}
+
+void GenotypeSorter::SortDiploid(void) {
+	const uint32_t n_ranges = this->GetNumberRanges();
+	if (n_ranges == 1) {
+		// Histogram of keys. The counts are independent of the order
+		// of samples so they are computed in sample order.
+		uint32_t offsets[64];
+		memset(offsets, 0, 64*sizeof(uint32_t));
+		for (uint32_t s = 0; s < this->GetNumberSamples(); ++s)
+			++offsets[this->gt_key[s]];
+
+		// Exclusive prefix sum.
+		uint32_t cum = 0;
+		for (uint32_t k = 0; k < 64; ++k) {
+			const uint32_t count = offsets[k];
+			offsets[k] = cum;
+			cum += count;
+		}
+		assert(cum == this->GetNumberSamples());
+
+		// Stable scatter of the current permutation.
+		for (uint32_t s = 0; s < this->GetNumberSamples(); ++s) {
+			const uint32_t id = this->permutation_array[s];
+			this->ppa_scratch[offsets[this->gt_key[id]]++] = id;
+		}
+		memcpy(this->permutation_array.ordering, this->ppa_scratch, this->GetNumberSamples()*sizeof(uint32_t));
+		return;
+	}
+
+	// Histogram of keys for each range of the current permutation.
+	this->range_offsets.assign(64 * n_ranges, 0);
+	this->pool.Run([&](const uint32_t r) {
+		if (r >= n_ranges) return;
+		uint32_t* offsets = &this->range_offsets[64 * r];
+		const uint32_t to = this->GetRangeStart(r + 1, n_ranges);
+		for (uint32_t s = this->GetRangeStart(r, n_ranges); s < to; ++s)
+			++offsets[this->gt_key[this->permutation_array[s]]];
+	});
+
+	// Exclusive prefix sum ordered by key and then by range such that
+	// every range scatters into the same positions as the sequential
+	// stable scatter.
+	uint32_t cum = 0;
+	for (uint32_t k = 0; k < 64; ++k) {
+		for (uint32_t r = 0; r < n_ranges; ++r) {
+			const uint32_t count = this->range_offsets[64 * r + k];
+			this->range_offsets[64 * r + k] = cum;
+			cum += count;
+		}
+	}
+	assert(cum == this->GetNumberSamples());
+
+	// Stable scatter of each range.
+	this->pool.Run([&](const uint32_t r) {
+		if (r >= n_ranges) return;
+		uint32_t* offsets = &this->range_offsets[64 * r];
+		const uint32_t to = this->GetRangeStart(r + 1, n_ranges);
+		for (uint32_t s = this->GetRangeStart(r, n_ranges); s < to; ++s) {
+			const uint32_t id = this->permutation_array[s];
+			this->ppa_scratch[offsets[this->gt_key[id]]++] = id;
+		}
+	});
+
+	this->pool.Run([&](const uint32_t r) {
+		if (r >= n_ranges) return;
+		const uint32_t from = this->GetRangeStart(r, n_ranges);
+		const uint32_t to   = this->GetRangeStart(r + 1, n_ranges);
+		memcpy(&this->permutation_array.ordering[from], &this->ppa_scratch[from], (to - from)*sizeof(uint32_t));
+	});
 }
 
 bool GenotypeSorter::Build(const vcf_container_type& vcf_container, io::VcfHeader& vcf_header) {
 	if (this->GetNumberSamples() == 0)
 		return true;
 
-	// Reset the permutation array to [0, n_samples).
-	this->permutation_array.reset();
+	// Reset the permutation array to [0, n_samples) unless it
+	// was seeded.
+	if (this->seeded == false) this->permutation_array.reset();
+	this->seeded = false;
 
 	// Allocate tetraploid worth of memory in the first instance.
 	int32_t  largest_ploidy    = 0;
@@ -79,6 +201,13 @@ bool GenotypeSorter::Build(const vcf_container_type& vcf_container, io::VcfHeade
 	this->gt_remap[0]  = largest_n_alleles - 1; // Missing value.
 	this->gt_remap[64] = largest_n_alleles;     // Sentinel node symbol in unsigned space (129 >> 1 = 64).
 
+	// Diploid blocks with at most two alleles have at most eight remapped
+	// allele bytes per chromosome such that a pair of alleles fits into a
+	// 64-bucket histogram. These records are sorted with a counting sort
+	// instead of hashing every pattern.
+	const bool diploid_biallelic = (largest_ploidy == 2 && largest_n_alleles <= 4);
+	if (diploid_biallelic) this->BuildSymbolMap(largest_n_alleles);
+
 	// In order to keep track of bins that are non-empty we use a
 	// vector of pointers to the bins and a map from bins to the vector
 	// offsets. The map uses the hash of the alleles as the key.
@@ -115,6 +244,26 @@ bool GenotypeSorter::Build(const vcf_container_type& vcf_container, io::VcfHeade
 		const uint32_t base_ploidy = bcf->d.fmt[0].n;
 		assert(bcf->d.fmt[0].p_len == sizeof(int8_t) * base_ploidy * this->GetNumberSamples());
 
+		if (diploid_biallelic && base_ploidy == 2) {
+			// Records with allele bytes outside of the symbol map
+			// fall back to the general path.
+			const uint8_t invalid = this->BuildKeys([this, gt](const uint32_t from, const uint32_t to) {
+				uint8_t invalid = 0;
+				for (uint32_t s = from; s < to; ++s) {
+					const uint8_t a = this->gt_symbol[gt[2*s+0]];
+					const uint8_t b = this->gt_symbol[gt[2*s+1]];
+					this->gt_key[s] = (a << 3) | b;
+					invalid |= a | b;
+				}
+				return(invalid);
+			});
+
+			if ((invalid & 8) == 0) {
+				this->SortDiploid();
+				continue;
+			}
+		}
+
 		// Keep track of buffer position.
 		uint32_t gt_offset = 0;
 
@@ -187,8 +336,10 @@ bool GenotypeSorter::Build(const yon1_vnt_t* rec, const uint32_t n_rec) {
 	if (this->GetNumberSamples() == 0)
 		return true;
 
-	// Reset the permutation array to [0, n_samples).
-	this->permutation_array.reset();
+	// Reset the permutation array to [0, n_samples) unless it
+	// was seeded.
+	if (this->seeded == false) this->permutation_array.reset();
+	this->seeded = false;
 
 	// Allocate tetraploid worth of memory in the first instance.
 	int32_t  largest_ploidy    = 0;
@@ -235,6 +386,13 @@ bool GenotypeSorter::Build(const yon1_vnt_t* rec, const uint32_t n_rec) {
 	this->gt_remap[0]  = largest_n_alleles - 1; // Missing value.
 	this->gt_remap[64] = largest_n_alleles;     // Sentinel node symbol in unsigned space (129 >> 1 = 64).
 
+	// Diploid blocks with at most two alleles have at most eight remapped
+	// allele bytes per chromosome such that a pair of alleles fits into a
+	// 64-bucket histogram. These records are sorted with a counting sort
+	// instead of hashing every pattern.
+	const bool diploid_biallelic = (largest_ploidy == 2 && largest_n_alleles <= 4);
+	if (diploid_biallelic) this->BuildSymbolMap(largest_n_alleles);
+
 	// In order to keep track of bins that are non-empty we use a
 	// vector of pointers to the bins and a map from bins to the vector
 	// offsets. The map uses the hash of the alleles as the key.
@@ -265,6 +423,27 @@ bool GenotypeSorter::Build(const yon1_vnt_t* rec, const uint32_t n_rec) {
 		//const uint8_t* gt = bcf->d.fmt[0].p;
 		const uint32_t base_ploidy = rec[i].gt->m;
 
+		if (diploid_biallelic && base_ploidy == 2) {
+			// Records with allele bytes outside of the symbol map
+			// fall back to the general path.
+			const yon_gt_rcd* d_exp = rec[i].gt->d_exp;
+			const uint8_t invalid = this->BuildKeys([this, d_exp](const uint32_t from, const uint32_t to) {
+				uint8_t invalid = 0;
+				for (uint32_t s = from; s < to; ++s) {
+					const uint8_t a = this->gt_symbol[d_exp[s].allele[0]];
+					const uint8_t b = this->gt_symbol[d_exp[s].allele[1]];
+					this->gt_key[s] = (a << 3) | b;
+					invalid |= a | b;
+				}
+				return(invalid);
+			});
+
+			if ((invalid & 8) == 0) {
+				this->SortDiploid();
+				continue;
+			}
+		}
+
 		// Iterate over all available samples.
 		for (uint32_t s = 0; s < this->GetNumberSamples(); ++s) {
 			yon_radix_gt& target_pattern = this->gt_pattern[s];
@@ -1,16 +1,28 @@
 #ifndef ALGORITHM_COMPRESSION_RADIXSORTGT_H_
 #define ALGORITHM_COMPRESSION_RADIXSORTGT_H_
 
+#include <functional>
+#include <vector>
+
 #include "genotypes.h"
 #include "containers/vcf_container.h"
+#include "algorithm/parallel/fork_join.h"
 
 namespace tachyon {
 namespace algorithm {
 
+// Minimum number of samples per range when permuting with multiple threads.
+const uint32_t YON_GT_SORT_RANGE_MIN = 32768;
+
 /*
  * This class performs a radix sort on a
- * block of variant lines given they are
- * bi-allelic diploid.
+ * block of variant lines according to their
+ * genotypes. Diploid records in blocks with
+ * at most two alleles are sorted with a direct
+ * counting sort and all other records with the
+ * general hashed bin sort. The counting sort
+ * is optionally split over ranges of samples
+ * that are processed by multiple threads.
  */
 class GenotypeSorter {
 public:
@@ -38,6 +50,23 @@ public:
 	 */
 	void SetSamples(const uint64_t n_samples);
 
+	/**<
+	 * Set the number of threads used to permute a single block. Threads
+	 * are only used for the diploid counting sort and only when there are
+	 * at least YON_GT_SORT_RANGE_MIN samples per thread. The resulting
+	 * permutation is identical to the single-threaded one.
+	 * @param n_threads Number of threads including the calling thread.
+	 */
+	void SetThreads(const uint32_t n_threads);
+
+	/**<
+	 * Seed the next invocation of Build() with the provided permutation
+	 * instead of the identity permutation. Samples with identical
+	 * genotypes then retain their relative order from the seed.
+	 * @param ppa Src permutation, usually that of the preceding block.
+	 */
+	void Seed(const yon_gt_ppa& ppa);
+
 	/**<
 	 * Permutes the genotypes in the provided VcfContainer. This
 	 * functions needs to have knowledge of the global Vcf header
@@ -61,11 +90,54 @@ public:
 	bool Build(const yon1_vnt_t* rec, const uint32_t n_rec);
 	void Debug(std::ostream& stream, const vcf_container_type& vcf_container, const yon_gt_ppa& ppa);
 
+private:
+	/**<
+	 * Construct the map from a raw allele byte (allele << 1 | phase) to
+	 * its diploid counting sort symbol given the current allele remapping.
+	 * The symbol equals the remapped allele byte minus two and therefore
+	 * preserves the order used by yon_radix_gt::GetPackedInteger. Allele
+	 * bytes not handled by the remapping are marked as invalid (8).
+	 * @param largest_n_alleles Largest number of alleles in the block plus two.
+	 */
+	void BuildSymbolMap(const uint32_t largest_n_alleles);
+
+	/**<
+	 * Stable counting sort of the current permutation array using the
+	 * diploid keys (symbol_a << 3 | symbol_b) stored in gt_key. The
+	 * result is identical to the general hashed bin sort.
+	 */
+	void SortDiploid(void);
+
+	/**<
+	 * Compute the diploid keys for all samples by invoking the provided
+	 * function for each range of samples, concurrently if possible.
+	 * @param fill Function computing keys for samples [from, to) and
+	 *             returning the bitwise OR of all symbols.
+	 * @return     Returns the bitwise OR of all symbols.
+	 */
+	uint8_t BuildKeys(const std::function<uint8_t(const uint32_t, const uint32_t)>& fill);
+
+	// Number of sample ranges processed concurrently.
+	inline uint32_t GetNumberRanges(void) const {
+		return(std::max((uint64_t)1, std::min((uint64_t)this->pool.size(), this->n_samples / YON_GT_SORT_RANGE_MIN)));
+	}
+
+	// Bounds of range r of n_ranges.
+	inline uint32_t GetRangeStart(const uint32_t r, const uint32_t n_ranges) const {
+		return((this->n_samples * r) / n_ranges);
+	}
+
 public:
+	bool          seeded; // permutation array holds a seed for the next Build()
 	uint64_t      n_samples; // total number of entries in file
 	yon_gt_ppa    permutation_array;
 	yon_radix_gt* gt_pattern;
 	uint8_t       gt_remap[256];
+	uint8_t       gt_symbol[256]; // allele byte to diploid symbol
+	uint8_t*      gt_key; // diploid key for each sample
+	uint32_t*     ppa_scratch; // scatter buffer for the counting sort
+	std::vector<uint32_t> range_offsets; // histogram for each range of samples
+	ForkJoinPool  pool; // workers for the counting sort
 };
 
 }
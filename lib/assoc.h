@@ -0,0 +1,212 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef ASSOC_H_
+#define ASSOC_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <getopt.h>
+
+#include "program_utils.h"
+#include "variant_reader.h"
+#include "association.h"
+
+void assoc_usage(void) {
+	programMessage(true);
+	std::cerr <<
+	"About:  Test every record for association with a phenotype using score tests\n"
+	"        of the alternative allele dosage in a linear or logistic model adjusted\n"
+	"        for covariates. Phenotype and covariate files are tab-delimited with a\n"
+	"        header line and one line per sample with the sample name first.\n"
+	"        Summary statistics are written in the order of the archive.\n"
+	"Usage:  " << tachyon::TACHYON_PROGRAM_NAME << " assoc [options] -i <in.yon> -p <phenotypes.tsv>\n\n"
+	"Options:\n"
+	"  -i FILE   input YON file (required)\n"
+	"  -o FILE   output file (- for stdout) [-]\n"
+	"  -p FILE   phenotype file (required)\n"
+	"  -n STRING phenotype column name [first column]\n"
+	"  -c FILE   covariate file (every column is used)\n"
+	"  -m STRING model: linear or logistic (phenotypes coded 0/1) [linear]\n"
+	"  -a INT    minimum minor allele count of tested records [1]\n"
+	"  -t INT    number of threads [all]\n"
+	"  -k FILE   keychain file with encryption keys (required if the file is encrypted)\n"
+	"  -s        hide all program messages [null]\n" << std::endl;
+}
+
+int assoc(int argc, char** argv) {
+	if (argc <= 2) {
+		assoc_usage();
+		return(1);
+	}
+
+	int c;
+	int option_index = 0;
+	static struct option long_options[] = {
+		{"input",      required_argument, 0, 'i' },
+		{"output",     required_argument, 0, 'o' },
+		{"phenotypes", required_argument, 0, 'p' },
+		{"phenotype-name", required_argument, 0, 'n' },
+		{"covariates", required_argument, 0, 'c' },
+		{"model",      required_argument, 0, 'm' },
+		{"min-mac",    required_argument, 0, 'a' },
+		{"threads",    required_argument, 0, 't' },
+		{"keychain",   required_argument, 0, 'k' },
+		{"silent",     no_argument,       0, 's' },
+		{0,0,0,0}
+	};
+
+	SILENT = 0;
+	tachyon::VariantReaderSettings settings;
+	tachyon::yon_assoc_settings assoc_settings;
+	assoc_settings.n_threads = std::thread::hardware_concurrency();
+	std::string phenotypes, covariates, model;
+
+	while ((c = getopt_long(argc, argv, "i:o:p:n:c:m:a:t:k:s?", long_options, &option_index)) != -1) {
+		switch (c) {
+		case 0:
+			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
+			break;
+		case 'i':
+			settings.input = std::string(optarg);
+			break;
+		case 'o':
+			settings.output = std::string(optarg);
+			break;
+		case 'p':
+			phenotypes = std::string(optarg);
+			break;
+		case 'n':
+			assoc_settings.phenotype = std::string(optarg);
+			break;
+		case 'c':
+			covariates = std::string(optarg);
+			break;
+		case 'm':
+			model = std::string(optarg);
+			if (model == "linear") assoc_settings.model = tachyon::YON_ASSOC_LINEAR;
+			else if (model == "logistic") assoc_settings.model = tachyon::YON_ASSOC_LOGISTIC;
+			else {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Unknown model: " << model << "..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'a':
+			assoc_settings.min_mac = atoi(optarg);
+			break;
+		case 't':
+			assoc_settings.n_threads = atoi(optarg);
+			break;
+		case 'k':
+			settings.keychain_file = std::string(optarg);
+			break;
+		case 's':
+			SILENT = 1;
+			break;
+		default:
+			assoc_usage();
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Unrecognized option: " << (char)c << std::endl;
+			return(1);
+		}
+	}
+
+	if (settings.input.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No input value specified..." << std::endl;
+		return(1);
+	}
+
+	if (phenotypes.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No phenotype file specified..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		programMessage();
+		std::cerr << tachyon::utility::timestamp("LOG") << "Calling assoc..." << std::endl;
+	}
+
+	tachyon::VariantReader reader;
+	reader.GetSettings() = settings;
+	if (!reader.open(settings.input)) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open file: " << settings.input << "..." << std::endl;
+		return(1);
+	}
+	reader.GetBlockSettings().LoadMinimumVcf(true).LoadGenotypes(true);
+
+	const tachyon::yon_vnt_hdr_t& header = reader.GetHeader();
+	tachyon::Association engine;
+	if (engine.Open(header, phenotypes, covariates, assoc_settings) == false)
+		return(1);
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Testing " << engine.GetPhenotypeName() << " in "
+		          << tachyon::utility::ToPrettyString(engine.GetNumberIncluded()) << " samples with "
+		          << engine.GetNumberCovariates() << " covariates..." << std::endl;
+	}
+
+	std::ofstream out_file;
+	if (settings.output.size() && settings.output != "-") {
+		out_file.open(settings.output);
+		if (!out_file.good()) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open: " << settings.output << std::endl;
+			return(1);
+		}
+	}
+	std::ostream& out = out_file.is_open() ? out_file : std::cout;
+
+	out << "CHROM\tPOS\tID\tREF\tALT\tN\tAF\tBETA\tSE\tCHISQ\tP\n";
+
+	uint64_t n_tested = 0, n_skipped = 0;
+	const bool ret = reader.GetAssociations(engine, [&](const tachyon::yon_assoc_workspace& ws) {
+		for (uint32_t i = 0; i < ws.results.size(); ++i) {
+			const tachyon::yon_assoc_result& r = ws.results[i];
+			out << header.contigs_[r.rid].name << '\t' << r.pos + 1 << '\t'
+			    << (r.name.size() ? r.name : ".") << '\t' << r.ref << '\t' << (r.alt.size() ? r.alt : ".") << '\t'
+			    << r.n << '\t' << r.af << '\t' << r.beta << '\t' << r.se << '\t' << r.chisq << '\t' << r.p << '\n';
+		}
+		n_tested  += ws.n_tested;
+		n_skipped += ws.n_skipped;
+		return(out.good());
+	}, assoc_settings.n_threads);
+	out.flush();
+
+	if (ret == false) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to test associations..." << std::endl;
+		return(1);
+	}
+
+	if (out.good() == false) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to write output..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Tested " << tachyon::utility::ToPrettyString(n_tested) << " records ("
+		          << tachyon::utility::ToPrettyString(n_skipped) << " skipped)..." << std::endl;
+	}
+
+	return 0;
+}
+
+#endif /* ASSOC_H_ */
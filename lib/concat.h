@@ -0,0 +1,198 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef CONCAT_H_
+#define CONCAT_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+
+#include "program_utils.h"
+#include "variant_reader.h"
+#include "variant_writer.h"
+
+void concat_usage(void) {
+	programMessage(true);
+	std::cerr <<
+	"About:  Concatenate YON archives with compatible headers (identical samples,\n"
+	"        contigs, and Info/Format/Filter fields) by copying their compressed\n"
+	"        blocks. Archives must be provided in sorted order such that contigs\n"
+	"        are not interleaved. Encrypted archives are not supported.\n"
+	"Usage:  " << tachyon::TACHYON_PROGRAM_NAME << " concat [options] -o <out.yon> <in1.yon> [in2.yon ...]\n\n"
+	"Options:\n"
+	"  -o FILE   output file prefix (required)\n"
+	"  -f FILE   file with one input YON file per line\n"
+	"  -s        hide all program messages [null]\n" << std::endl;
+}
+
+int concat(int argc, char** argv) {
+	if (argc <= 2) {
+		concat_usage();
+		return(1);
+	}
+
+	int c;
+	int option_index = 0;
+	static struct option long_options[] = {
+		{"output",   required_argument, 0, 'o' },
+		{"file-list",required_argument, 0, 'f' },
+		{"silent",   no_argument,       0, 's' },
+		{0,0,0,0}
+	};
+
+	SILENT = 0;
+	std::string output;
+	std::vector<std::string> inputs;
+
+	while ((c = getopt_long(argc, argv, "o:f:s?", long_options, &option_index)) != -1) {
+		switch (c) {
+		case 0:
+			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
+			break;
+		case 'o':
+			output = std::string(optarg);
+			break;
+		case 'f':
+		{
+			std::ifstream file_list(optarg);
+			if (!file_list.good()) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open file list: " << optarg << std::endl;
+				return(1);
+			}
+			std::string line;
+			while (std::getline(file_list, line)) {
+				if (line.size()) inputs.push_back(line);
+			}
+			break;
+		}
+		case 's':
+			SILENT = 1;
+			break;
+		default:
+			concat_usage();
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Unrecognized option: " << (char)c << std::endl;
+			return(1);
+		}
+	}
+
+	// Positional arguments following the subcommand are input files.
+	for (int i = optind + 1; i < argc; ++i)
+		inputs.push_back(std::string(argv[i]));
+
+	if (output.size() == 0 || output == "-") {
+		concat_usage();
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Concat requires an output file..." << std::endl;
+		return(1);
+	}
+
+	if (inputs.size() == 0) {
+		concat_usage();
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No input files specified..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		programMessage();
+		std::cerr << tachyon::utility::timestamp("LOG") << "Calling concat on " << inputs.size() << " archives..." << std::endl;
+	}
+
+	// The header of the first archive is used as the output header. All
+	// other archives have to be compatible with it.
+	tachyon::VariantReader first;
+	if (!first.open(inputs[0])) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open: " << inputs[0] << std::endl;
+		return(1);
+	}
+	tachyon::yon_vnt_hdr_t header = first.GetHeader();
+
+	tachyon::VariantWriterFile writer;
+	if (!writer.open(output)) return(1);
+
+	writer.UpdateHeaderConcat(header);
+	if (!writer.WriteFileHeader(header)) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to write header..." << std::endl;
+		return(1);
+	}
+	writer.index.Setup(header.contigs_);
+
+	for (uint32_t i = 0; i < inputs.size(); ++i) {
+		tachyon::VariantReader reader;
+		if (!reader.open(inputs[i])) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open: " << inputs[i] << std::endl;
+			return(1);
+		}
+
+		if (!first.GetHeader().IsCompatible(reader.GetHeader())) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Header of " << inputs[i] << " is not compatible with " << inputs[0] << std::endl;
+			return(1);
+		}
+
+		// Encrypted blocks cannot be copied as their keys are stored in a
+		// separate keychain per archive.
+		std::ifstream stream(inputs[i], std::ios::in | std::ios::binary);
+		for (uint32_t j = 0; j < reader.GetIndex().GetLinearSize(); ++j) {
+			tachyon::yon_vb_hdr block_header;
+			stream.seekg(reader.GetIndex()[j].byte_offset);
+			stream >> block_header;
+			if (!stream.good()) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to read block " << j << " in: " << inputs[i] << std::endl;
+				return(1);
+			}
+
+			if (block_header.controller.any_encrypted) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot concatenate encrypted archive: " << inputs[i] << std::endl;
+				return(1);
+			}
+		}
+
+		// Block data is located between the end of the header and the
+		// start of the index.
+		stream.seekg(reader.GetDataOffset());
+		const uint64_t l_data = reader.GetFooter().GetEODOffset() - reader.GetDataOffset();
+
+		if (!writer.WriteBlocksRaw(stream, l_data, reader.GetIndex(), reader.GetFooter().GetNumberVariants())) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to copy blocks from: " << inputs[i] << std::endl;
+			return(1);
+		}
+
+		if (!SILENT) {
+			std::cerr << tachyon::utility::timestamp("LOG") << "Copied " << reader.GetFooter().GetNumberBlocks() << " blocks (" << tachyon::utility::ToPrettyDiskString(l_data) << ") from " << inputs[i] << std::endl;
+		}
+	}
+
+	// Write index, checksums, and footer.
+	if (!writer.close()) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to finalize output archive..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Wrote " << tachyon::utility::ToPrettyString(writer.n_variants_written) << " variants in " << writer.n_blocks_written << " blocks..." << std::endl;
+	}
+
+	return 0;
+}
+
+#endif /* CONCAT_H_ */
@@ -96,6 +96,27 @@ public:
 		return(this->at(rcd.rid).findOverlapping(rcd.pos, rcd.pos + 1));
 	}
 
+	/**<
+	 * Checks if the closed range [start_position, end_position] on the
+	 * target contig lies entirely within any single interval.
+	 * @param contigID       Target contig identifier.
+	 * @param start_position Start position of the range.
+	 * @param end_position   End position of the range.
+	 * @return               Returns TRUE if covered or FALSE otherwise.
+	 */
+	inline bool IsCovered(const uint32_t& contigID,
+	                      const int64_t& start_position,
+	                      const int64_t& end_position) const
+	{
+		if (contigID >= this->size()) return false;
+		const std::vector<interval_type> overlaps = this->at(contigID).findOverlapping(start_position, end_position);
+		for (uint32_t i = 0; i < overlaps.size(); ++i) {
+			if (overlaps[i].start <= start_position && overlaps[i].stop >= end_position)
+				return true;
+		}
+		return false;
+	}
+
 private:
 	void DedupeBlockList(void);
 
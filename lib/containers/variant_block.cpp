@@ -9,6 +9,8 @@ yon_vb_hdr_cont::yon_vb_hdr_cont():
 	has_gt(0),
 	has_gt_permuted(0),
 	any_encrypted(0),
+	has_ppa_delta(0),
+	has_gt_haplotypes(0),
 	unused(0)
 {}
 yon_vb_hdr_cont::~yon_vb_hdr_cont() {}
@@ -19,7 +21,9 @@ std::ostream& operator<<(std::ostream& stream, const yon_vb_hdr_cont& controller
 	const uint16_t c = controller.has_gt |
 				  controller.has_gt_permuted << 1 |
 				  controller.any_encrypted   << 2 |
-				  controller.unused          << 3;
+				  controller.has_ppa_delta   << 3 |
+				  controller.has_gt_haplotypes << 4 |
+				  controller.unused          << 5;
 
 	stream.write(reinterpret_cast<const char*>(&c), sizeof(uint16_t));
 	return(stream);
@@ -711,6 +715,49 @@ uint64_t yon_vb_ftr::HashIdentifiers(const std::vector<int>& id_vector) {
 }
 
 // Variant block settings
+yon_vb_budget::yon_vb_budget() :
+	compressed(false),
+	target_bytes(0),
+	min_records(1),
+	max_records(std::numeric_limits<uint32_t>::max()),
+	n_updates(0),
+	b_record(0),
+	n_limit(1000)
+{}
+
+void yon_vb_budget::Setup(const uint64_t target_bytes,
+                          const bool compressed,
+                          const uint32_t start_records,
+                          const uint32_t min_records,
+                          const uint32_t max_records)
+{
+	this->compressed   = compressed;
+	this->target_bytes = target_bytes;
+	this->min_records  = std::max(min_records, (uint32_t)1);
+	this->max_records  = std::max(max_records, this->min_records);
+	this->n_updates    = 0;
+	this->b_record     = 0;
+
+	uint32_t n_start = start_records;
+	if (this->IsActive())
+		n_start = std::min(std::max(n_start, this->min_records), this->max_records);
+	this->n_limit.store(std::max(n_start, (uint32_t)1));
+}
+
+void yon_vb_budget::Update(const uint64_t b_uncompressed, const uint64_t b_compressed, const uint32_t n_records) {
+	if (this->IsActive() == false || n_records == 0) return;
+
+	// Weight of the most recent block in the moving average.
+	const double alpha = 0.25;
+	const double cost  = (double)(this->compressed ? b_compressed : b_uncompressed) / n_records;
+	this->b_record = this->n_updates == 0 ? cost : alpha*cost + (1 - alpha)*this->b_record;
+	++this->n_updates;
+
+	double n_target = this->b_record > 0 ? this->target_bytes / this->b_record : this->max_records;
+	n_target = std::min(std::max(n_target, (double)this->min_records), (double)this->max_records);
+	this->n_limit.store((uint32_t)n_target);
+}
+
 yon_vb_settings::yon_vb_settings() :
 	show_vcf_header(true),
 	display_ref(true),
@@ -1079,6 +1126,7 @@ yon1_vb_t::yon1_vb_t() :
 	info_containers(nullptr),
 	format_containers(nullptr),
 	gt_ppa(nullptr),
+	gt_hppa(nullptr),
 	load_settings(nullptr),
 	end_block_(0),
 	start_compressed_data_(0),
@@ -1097,6 +1145,7 @@ yon1_vb_t::yon1_vb_t(const uint16_t n_info, const uint16_t n_format) :
 	info_containers(new container_type[n_info]),
 	format_containers(new container_type[n_format]),
 	gt_ppa(nullptr),
+	gt_hppa(nullptr),
 	load_settings(nullptr),
 	end_block_(0),
 	start_compressed_data_(0),
@@ -1113,6 +1162,7 @@ yon1_vb_t::~yon1_vb_t() {
 	delete [] this->info_containers;
 	delete [] this->format_containers;
 	delete this->gt_ppa;
+	delete this->gt_hppa;
 	delete this->load_settings;
 }
 
@@ -1125,6 +1175,7 @@ yon1_vb_t::yon1_vb_t(const self_type& other) :
 	info_containers(new container_type[other.m_info]),
 	format_containers(new container_type[other.m_format]),
 	gt_ppa(nullptr),
+	gt_hppa(nullptr),
 	load_settings(nullptr),
 	end_block_(other.end_block_),
 	start_compressed_data_(other.start_compressed_data_),
@@ -1136,6 +1187,9 @@ yon1_vb_t::yon1_vb_t(const self_type& other) :
 		this->gt_ppa = new yon_gt_ppa(*other.gt_ppa);
 	}
 
+	if (other.gt_hppa != nullptr)
+		this->gt_hppa = new yon_gt_ppa(*other.gt_hppa);
+
 	if (other.load_settings != nullptr) {
 		this->load_settings = new yon_blk_load_settings(*other.load_settings);
 	}
@@ -1154,6 +1208,7 @@ yon1_vb_t::yon1_vb_t(self_type&& other) noexcept :
 	info_containers(nullptr),
 	format_containers(nullptr),
 	gt_ppa(nullptr),
+	gt_hppa(nullptr),
 	load_settings(nullptr),
 	end_block_(other.end_block_),
 	start_compressed_data_(other.start_compressed_data_),
@@ -1164,6 +1219,7 @@ yon1_vb_t::yon1_vb_t(self_type&& other) noexcept :
 	std::swap(this->info_containers, other.info_containers);
 	std::swap(this->format_containers, other.format_containers);
 	std::swap(this->gt_ppa, other.gt_ppa);
+	std::swap(this->gt_hppa, other.gt_hppa);
 	std::swap(this->load_settings, other.load_settings);
 }
 
@@ -1195,6 +1251,8 @@ yon1_vb_t& yon1_vb_t::operator=(self_type&& other) noexcept{
 	std::swap(this->format_containers, other.format_containers);
 	delete this->gt_ppa; this->gt_ppa = nullptr;
 	std::swap(this->gt_ppa, other.gt_ppa);
+	delete this->gt_hppa; this->gt_hppa = nullptr;
+	std::swap(this->gt_hppa, other.gt_hppa);
 	this->end_block_ = other.end_block_;
 	this->start_compressed_data_ = other.start_compressed_data_;
 	this->end_compressed_data_ = other.end_compressed_data_;
@@ -1278,6 +1336,7 @@ void yon1_vb_t::clear(void) {
 	this->footer_support.reset();
 
 	if (this->gt_ppa != nullptr) this->gt_ppa->reset();
+	if (this->gt_hppa != nullptr) this->gt_hppa->reset();
 }
 
 /*
@@ -1518,7 +1577,7 @@ bool yon1_vb_t::ReadHeaderFooter(std::ifstream& stream) {
 }
 
 bool yon1_vb_t::read(std::ifstream& stream) {
-	if (this->header.controller.has_gt_permuted && this->header.controller.has_gt) {
+	if (this->header.controller.HasPermutationArray()) {
 		stream.seekg(this->start_compressed_data_ + this->footer.offsets[YON_BLK_PPA].data_header.offset);
 		stream >> this->base_containers[YON_BLK_PPA];
 	}
@@ -1746,6 +1805,18 @@ bool yon1_vb_t::read(std::ifstream& stream,
 			this->gt_ppa = new yon_gt_ppa;
 			this->gt_ppa->n_s = header.GetNumberSamples();
 		}
+		// Blocks encoded as a haplotype PBWT store the haplotype order
+		// at the start of the block in the same container.
+		else if (this->header.controller.has_gt_haplotypes && this->header.controller.has_gt) {
+			stream.seekg(this->start_compressed_data_ + this->footer.offsets[YON_BLK_PPA].data_header.offset);
+			this->LoadContainerSeek(stream,
+									this->footer.offsets[YON_BLK_PPA],
+									this->base_containers[YON_BLK_PPA]);
+
+			delete this->gt_hppa;
+			this->gt_hppa = new yon_gt_ppa;
+			this->gt_hppa->n_s = 2*header.GetNumberSamples();
+		}
 	}
 
 	// Load base meta containers.
@@ -1819,7 +1890,7 @@ bool yon1_vb_t::read(std::ifstream& stream,
 
 uint64_t yon1_vb_t::GetCompressedSize(void) const {
 	uint64_t total = 0;
-	if (this->header.controller.has_gt && this->header.controller.has_gt_permuted)
+	if (this->header.controller.HasPermutationArray())
 		total += this->base_containers[YON_BLK_PPA].GetObjectSize();
 
 	for (uint32_t i = 1; i < YON_BLK_N_STATIC; ++i)              total += this->base_containers[i].GetObjectSize();
@@ -1831,7 +1902,7 @@ uint64_t yon1_vb_t::GetCompressedSize(void) const {
 
 uint64_t yon1_vb_t::GetUncompressedSize(void) const {
 	uint64_t total = 0;
-	if (this->header.controller.has_gt && this->header.controller.has_gt_permuted)
+	if (this->header.controller.HasPermutationArray())
 		total += this->base_containers[YON_BLK_PPA].data_uncompressed.size();
 
 	for (uint32_t i = 1; i < YON_BLK_N_STATIC; ++i)              total += this->base_containers[i].data_uncompressed.size() + this->base_containers[i].strides_uncompressed.size();
@@ -1845,7 +1916,7 @@ void yon1_vb_t::UpdateOutputStatistics(import_stats_type& stats_basic,
                                           import_stats_type& stats_info,
                                           import_stats_type& stats_format)
 {
-	if (this->header.controller.has_gt && this->header.controller.has_gt_permuted)
+	if (this->header.controller.HasPermutationArray())
 		stats_basic[0] += this->base_containers[YON_BLK_PPA];
 
 	for (uint32_t i = 1; i < YON_BLK_N_STATIC; ++i)
@@ -1873,7 +1944,7 @@ bool yon1_vb_t::write(std::ostream& stream)
 	stream << this->header;
 	const uint64_t start_pos = stream.tellp();
 
-	if (this->header.controller.has_gt && this->header.controller.has_gt_permuted)
+	if (this->header.controller.HasPermutationArray())
 		this->WriteContainer(stream, this->footer.offsets[YON_BLK_PPA], this->base_containers[YON_BLK_PPA], (uint64_t)stream.tellp() - start_pos);
 
 	// Start at offset 1 because offset 0 (YON_BLK_PPA) is encoding for the
@@ -2077,7 +2148,7 @@ void yon1_vb_t::Finalize(void) {
 	// want to the writer slave to spend time compressing or doing any
 	// other compute instead of simply writing at I/O saturated speeds.
 	uint64_t b_offset = 0;
-	if (this->header.controller.has_gt && this->header.controller.has_gt_permuted) {
+	if (this->header.controller.HasPermutationArray()) {
 		this->UpdateHeader(this->footer.offsets[YON_BLK_PPA], this->base_containers[YON_BLK_PPA], 0);
 		b_offset += this->base_containers[YON_BLK_PPA].GetObjectSize();
 	}
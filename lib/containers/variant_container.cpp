@@ -57,6 +57,8 @@ bool yon1_vc_t::Build(yon1_vb_t& variant_block, const yon_vnt_hdr_t& header) {
 		this->variants_[i].m_info = variant_block.footer.n_info_streams;
 		this->variants_[i].fmt    = new PrimitiveGroupContainerInterface*[variant_block.footer.n_format_streams];
 		this->variants_[i].m_fmt  = variant_block.footer.n_format_streams;
+		this->variants_[i].info_hdr.reserve(variant_block.footer.n_info_streams);
+		this->variants_[i].fmt_hdr.reserve(variant_block.footer.n_format_streams);
 	}
 
 	this->AddFilter(variant_block, header);
@@ -176,10 +178,8 @@ bool yon1_vc_t::AddFormat(yon1_vb_t& variant_block, const yon_vnt_hdr_t& header)
 				assert(this->variants_[j].fmt_hdr.size() == 0);
 				this->variants_[j].is_loaded_gt = true;
 				// Do not store header pointer and allocate a new format container
-				// because this data is hidden.
-
-				this->variants_[j].gt->Evaluate();
-				//records[i].gt->Expand();
+				// because this data is hidden. Records are evaluated
+				// on demand by their consumers.
 			}
 		}
 	}
@@ -205,10 +205,7 @@ bool yon1_vc_t::AddFormat(yon1_vb_t& variant_block, const yon_vnt_hdr_t& header)
 					this->variants_[j].is_loaded_gt = true;
 					this->variants_[j].fmt[this->variants_[j].n_fmt++] = new PrimitiveGroupContainer<int32_t>();
 					this->variants_[j].fmt_hdr.push_back(&header.format_fields_[dc.GetGlobalKey()]);
-
-					// Lazy-evaluate minimum genotypes.
-					this->variants_[j].gt->Evaluate();
-					//records[i].gt->Expand();
+					// Records are evaluated on demand by their consumers.
 				}
 			}
 			continue;
@@ -446,6 +443,73 @@ bool yon1_vc_t::AddFormatWrapper(dc_type& container, const yon_vnt_hdr_t& header
 	return true;
 }
 
+/**<
+ * Decode a record encoded as a haplotype PBWT (YON_GT_PBWT). The runs of
+ * alternating alleles are scattered over the current haplotype order which
+ * is then updated in the same way as during encoding. The alleles are
+ * returned as 32-bit run-length encoded diploid biallelic genotypes in
+ * sample order (YON_GT_RLE_DIPLOID_BIALLELIC) without missing values or
+ * mixed phasing. Decoding a record touches all 2*n_samples haplotypes
+ * regardless of the number of runs: this encoding reduces the size of
+ * the genotypes but not the cost of reading them.
+ * @param data        Src encoded record.
+ * @param offset      Src/dst offset into data.
+ * @param n_runs      Number of runs in the record.
+ * @param n_samples   Number of samples.
+ * @param hap_order   Src/dst current haplotype order.
+ * @param hap_scratch Buffer of 2*n_samples entries.
+ * @param hap_alleles Buffer of 2*n_samples entries.
+ * @param gt_runs     Dst buffer of n_samples entries.
+ * @return            Returns the number of runs in gt_runs or 0 if the record is corrupted.
+ */
+static uint32_t DecodeHaplotypes(const uint8_t* data,
+                                 uint64_t& offset,
+                                 const uint32_t n_runs,
+                                 const uint32_t n_samples,
+                                 uint32_t* hap_order,
+                                 uint32_t* hap_scratch,
+                                 uint8_t* hap_alleles,
+                                 uint32_t* gt_runs)
+{
+	const uint32_t n_haplotypes = 2*n_samples;
+
+	uint8_t  allele = data[offset++];
+	if (allele > 1) return 0;
+
+	uint32_t j = 0;
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		const uint32_t l_run = SparseGenotypeVarintDecode(data, offset);
+		if (l_run > n_haplotypes - j) return 0;
+		for (uint32_t k = 0; k < l_run; ++k) hap_alleles[hap_order[j++]] = allele;
+		allele ^= 1;
+	}
+	if (j != n_haplotypes) return 0;
+
+	uint32_t n_ref = 0, n_alt = 0;
+	for (j = 0; j < n_haplotypes; ++j) {
+		const uint32_t h = hap_order[j];
+		if (hap_alleles[h]) hap_scratch[n_alt++] = h;
+		else hap_order[n_ref++] = h;
+	}
+	memcpy(&hap_order[n_ref], hap_scratch, n_alt*sizeof(uint32_t));
+
+	uint32_t n_entries = 0;
+	uint32_t symbol = (hap_alleles[0] << 1) | hap_alleles[1];
+	uint32_t l_run  = 1;
+	for (uint32_t s = 1; s < n_samples; ++s) {
+		const uint32_t current = (hap_alleles[2*s] << 1) | hap_alleles[2*s+1];
+		if (current != symbol) {
+			gt_runs[n_entries++] = (l_run << 2) | symbol;
+			symbol = current;
+			l_run  = 0;
+		}
+		++l_run;
+	}
+	gt_runs[n_entries++] = (l_run << 2) | symbol;
+
+	return(n_entries);
+}
+
 bool yon1_vc_t::AddGenotypes(yon1_vb_t& block, const yon_vnt_hdr_t& header) {
 	const bool uniform_stride = block.base_containers[YON_BLK_GT_SUPPORT].header.data_header.IsUniform();
 	PrimitiveContainer<uint32_t> lengths(block.base_containers[YON_BLK_GT_SUPPORT]); // n_runs / objects size
@@ -478,6 +542,26 @@ bool yon1_vc_t::AddGenotypes(yon1_vb_t& block, const yon_vnt_hdr_t& header) {
 	uint8_t incrementor = 1;
 	if (uniform_stride) incrementor = 0;
 
+	// Records encoded as a haplotype PBWT depend on the haplotype order
+	// left by the preceding record and are decoded in order starting
+	// from the order stored for the block.
+	const uint32_t n_haplotypes = 2*header.GetNumberSamples();
+	uint32_t* hap_order   = nullptr;
+	uint32_t* hap_scratch = nullptr;
+	uint8_t*  hap_alleles = nullptr;
+	uint32_t* hap_runs    = nullptr;
+	if (block.header.controller.has_gt_haplotypes) {
+		if (block.gt_hppa == nullptr || block.gt_hppa->ordering == nullptr || block.gt_hppa->n_s != n_haplotypes) {
+			std::cerr << utility::timestamp("ERROR","GT") << "Haplotype order is not available..." << std::endl;
+			return false;
+		}
+		hap_order   = this->arena_.Allocate<uint32_t>(n_haplotypes);
+		hap_scratch = this->arena_.Allocate<uint32_t>(n_haplotypes);
+		hap_alleles = this->arena_.Allocate<uint8_t>(n_haplotypes);
+		hap_runs    = this->arena_.Allocate<uint32_t>(header.GetNumberSamples());
+		memcpy(hap_order, block.gt_hppa->ordering, n_haplotypes*sizeof(uint32_t));
+	}
+
 	for (uint32_t i = 0; i < this->n_variants_; ++i) {
 		if (this->variants_[i].controller.gt_available) {
 			// Case run-length encoding diploid and biallelic and no missing
@@ -574,6 +658,31 @@ bool yon1_vc_t::AddGenotypes(yon1_vb_t& block, const yon_vnt_hdr_t& header) {
 					exit(1);
 				}
 			}
+			// Case sparse carrier lists stored in the byte-wide nploid stream
+			else if (this->variants_[i].controller.gt_compression_type == TACHYON_GT_ENCODING::YON_GT_SPARSE) {
+				this->variants_[i].gt = GetGenotypeSparse(&nploid8[offset_nploid8], lengths[gt_offset], header.GetNumberSamples(), this->variants_[i].n_alleles, this->variants_[i].n_base_ploidy, this->variants_[i].controller.ToValue(), block.gt_ppa);
+				offset_nploid8 += SparseGenotypeLength(reinterpret_cast<const uint8_t*>(&nploid8[offset_nploid8]), lengths[gt_offset], this->variants_[i].n_base_ploidy);
+			}
+			// Case haplotype PBWT stored in the byte-wide nploid stream
+			else if (this->variants_[i].controller.gt_compression_type == TACHYON_GT_ENCODING::YON_GT_PBWT) {
+				if (hap_order == nullptr) {
+					std::cerr << utility::timestamp("ERROR","GT") << "Haplotype encoding in a block without haplotype order..." << std::endl;
+					return false;
+				}
+				uint64_t offset = 0;
+				const uint32_t n_entries = DecodeHaplotypes(reinterpret_cast<const uint8_t*>(&nploid8[offset_nploid8]), offset, lengths[gt_offset], header.GetNumberSamples(), hap_order, hap_scratch, hap_alleles, hap_runs);
+				if (n_entries == 0) {
+					std::cerr << utility::timestamp("ERROR","GT") << "Corrupted haplotype encoding..." << std::endl;
+					return false;
+				}
+				offset_nploid8 += offset;
+
+				// The runs are served from the block-local arena as they
+				// are lazily evaluated.
+				uint32_t* gt_runs = this->arena_.Allocate<uint32_t>(n_entries);
+				memcpy(gt_runs, hap_runs, n_entries*sizeof(uint32_t));
+				this->variants_[i].gt = GetGenotypeDiploidRLE<uint32_t>(reinterpret_cast<const char*>(gt_runs), n_entries, header.GetNumberSamples(), this->variants_[i].n_alleles, this->variants_[i].n_base_ploidy, this->variants_[i].controller.ToValue(), nullptr);
+			}
 			// Case other potential encodings
 			else {
 				std::cerr << utility::timestamp("ERROR","GT") << "Unknown GT encoding family..." << std::endl;
@@ -587,6 +696,10 @@ bool yon1_vc_t::AddGenotypes(yon1_vb_t& block, const yon_vnt_hdr_t& header) {
 		} else { // No GT available
 			this->variants_[i].gt = new yon_gt();
 		}
+
+		// Lazy-evaluated genotype records are served from the
+		// block-local arena.
+		this->variants_[i].gt->arena = this->variants_[i].arena;
 	}
 
 	assert(offset_rle8     == block.base_containers[YON_BLK_GT_INT8].GetSizeUncompressed());
@@ -702,28 +815,25 @@ bool yon1_vc_t::AddRefAlt(dc_type& container) {
 			// load from special packed
 			// this is always diploid
 			this->variants_[i].n_alleles = 2;
-			this->variants_[i].alleles   = new yon_allele[2];
-			this->variants_[i].m_allele  = 2;
+			this->variants_[i].AllocateAlleles(2);
 
 			// If data is <non_ref> or not
 			if ((it[refalt_position] & 15) != 5) {
 				//assert((refalt[refalt_position] & 15) < 5);
 				const char ref = YON_REFALT_LOOKUP[it[refalt_position] & 15];
-				this->variants_[i].alleles[1] = ref;
+				this->variants_[i].alleles[1].Assign(&ref, 1, this->variants_[i].arena);
 
 			} else {
-				const std::string s = "<NON_REF>";
-				this->variants_[i].alleles[1] = s;
+				this->variants_[i].alleles[1].Assign("<NON_REF>", 9, this->variants_[i].arena);
 			}
 
 			// If data is <non_ref> or not
 			if (((it[refalt_position] >> 4) & 15) != 5) {
 				//assert(((refalt[refalt_position] >> 4) & 15) < 5);
 				const char alt = YON_REFALT_LOOKUP[(it[refalt_position] >> 4) & 15];
-				this->variants_[i].alleles[0] = alt;
+				this->variants_[i].alleles[0].Assign(&alt, 1, this->variants_[i].arena);
 			} else {
-				const std::string s = "<NON_REF>";
-				this->variants_[i].alleles[1] = s;
+				this->variants_[i].alleles[0].Assign("<NON_REF>", 9, this->variants_[i].arena);
 			}
 			// Do not increment in case this data is uniform
 			if (it.is_uniform_ == false) refalt_position += stride_add;
@@ -756,12 +866,11 @@ bool yon1_vc_t::AddAlleles(dc_type& container) {
 		for (uint32_t i = 0; i < this->n_variants_; ++i) {
 			if (this->variants_[i].controller.alleles_packed == false) {
 				this->variants_[i].n_alleles = it->GetInt32(stride_offset);
-				this->variants_[i].alleles   = new yon_allele[it->GetInt32(stride_offset)];
-				this->variants_[i].m_allele  = it->GetInt32(stride_offset);
+				this->variants_[i].AllocateAlleles(it->GetInt32(stride_offset));
 
 				for (uint32_t j = 0; j < this->variants_[i].n_alleles; ++j) {
 					const uint16_t& l_string = *reinterpret_cast<const uint16_t* const>(&container.data_uncompressed[offset]);
-					this->variants_[i].alleles[j].ParseFromBuffer(&container.data_uncompressed[offset]);
+					this->variants_[i].alleles[j].ParseFromBuffer(&container.data_uncompressed[offset], this->variants_[i].arena);
 					offset += sizeof(uint16_t) + l_string;
 				}
 				++stride_offset;
@@ -775,12 +884,11 @@ bool yon1_vc_t::AddAlleles(dc_type& container) {
 		for (uint32_t i = 0; i < this->n_variants_; ++i) {
 			if (this->variants_[i].controller.alleles_packed == false) {
 				this->variants_[i].n_alleles = stride;
-				this->variants_[i].alleles   = new yon_allele[stride];
-				this->variants_[i].m_allele  = stride;
+				this->variants_[i].AllocateAlleles(stride);
 
 				for (uint32_t j = 0; j < this->variants_[i].n_alleles; ++j) {
 					const uint16_t& l_string = *reinterpret_cast<const uint16_t* const>(&container.data_uncompressed[offset]);
-					this->variants_[i].alleles[j].ParseFromBuffer(&container.data_uncompressed[offset]);
+					this->variants_[i].alleles[j].ParseFromBuffer(&container.data_uncompressed[offset], this->variants_[i].arena);
 					offset += sizeof(uint16_t) + l_string;
 				}
 			}
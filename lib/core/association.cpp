@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "association.h"
+#include "utility.h"
+
+namespace tachyon {
+
+// Maximum number of iteratively reweighted least squares iterations
+// when fitting the logistic null model.
+const uint32_t YON_ASSOC_MAX_ITERATIONS = 25;
+
+// Columns with a norm smaller than this fraction of their original norm
+// after projecting out previous columns are linearly dependent.
+const double YON_ASSOC_RANK_TOLERANCE = 1e-8;
+
+static inline double Dot(const double* __restrict a, const double* __restrict b, const uint32_t n) {
+	double sum = 0;
+	for (uint32_t i = 0; i < n; ++i) sum += a[i] * b[i];
+	return(sum);
+}
+
+// Orthonormalize the k columns of length n of a column-major matrix in
+// place with modified Gram-Schmidt and reorthogonalization. Dependent
+// columns are dropped and the remaining columns are moved to the front.
+static uint32_t Orthonormalize(double* a, const uint32_t n, const uint32_t k) {
+	uint32_t rank = 0;
+	for (uint32_t j = 0; j < k; ++j) {
+		double* v = &a[(uint64_t)j * n];
+		const double norm_in = sqrt(Dot(v, v, n));
+		if (norm_in == 0) continue;
+
+		for (uint32_t pass = 0; pass < 2; ++pass) {
+			for (uint32_t i = 0; i < rank; ++i) {
+				const double* q = &a[(uint64_t)i * n];
+				const double d = Dot(q, v, n);
+				for (uint32_t s = 0; s < n; ++s) v[s] -= d * q[s];
+			}
+		}
+
+		const double norm = sqrt(Dot(v, v, n));
+		if (norm <= YON_ASSOC_RANK_TOLERANCE * norm_in) continue;
+
+		double* dst = &a[(uint64_t)rank * n];
+		for (uint32_t s = 0; s < n; ++s) dst[s] = v[s] / norm;
+		++rank;
+	}
+	return(rank);
+}
+
+static inline bool ParseValue(const std::string& token, double& value) {
+	if (token.size() == 0 || token == "NA" || token == "." || token == "nan" || token == "NaN") {
+		value = std::numeric_limits<double>::quiet_NaN();
+		return true;
+	}
+
+	char* end = nullptr;
+	value = strtod(token.c_str(), &end);
+	return(end == token.c_str() + token.size());
+}
+
+// Read a tab-delimited table with a header line and one line per sample.
+// Values are stored as a samples x columns matrix in sample order and
+// missing values are NaN.
+static bool ReadSampleTable(const std::string& file_name,
+                            const yon_vnt_hdr_t& header,
+                            std::vector<std::string>& names,
+                            std::vector<double>& values,
+                            std::vector<uint8_t>& present)
+{
+	std::ifstream f;
+	f.open(file_name);
+	if (!f.good()) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "Stream is bad! Cannot open " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	std::string line;
+	if (!getline(f, line)) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "File " << file_name << " is empty..." << std::endl;
+		return false;
+	}
+
+	std::vector<std::string> params = utility::split(line, '\t', true);
+	if (params.size() < 2) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "Header of " << file_name << " has no value columns..." << std::endl;
+		return false;
+	}
+	names.assign(params.begin() + 1, params.end());
+	const uint32_t n_cols = names.size();
+	values.assign((uint64_t)header.GetNumberSamples() * n_cols, std::numeric_limits<double>::quiet_NaN());
+	present.assign(header.GetNumberSamples(), false);
+
+	uint32_t n_line = 1;
+	while (getline(f, line)) {
+		++n_line;
+		if (line.size() == 0) continue;
+
+		params = utility::split(line, '\t', true);
+		if (params.size() != n_cols + 1) {
+			std::cerr << utility::timestamp("ERROR","ASSOC") << "Expected " << n_cols + 1 << " columns but found " << params.size() << " on line " << n_line << " in " << file_name << "..." << std::endl;
+			return false;
+		}
+
+		const int32_t sample_id = header.GetSampleId(params[0]);
+		if (sample_id < 0) {
+			std::cerr << utility::timestamp("WARNING","ASSOC") << "Cannot find sample \"" << params[0] << "\" in " << file_name << "..." << std::endl;
+			continue;
+		}
+
+		// Only the first row of a sample is used.
+		if (present[sample_id]) {
+			std::cerr << utility::timestamp("WARNING","ASSOC") << "Duplicated sample \"" << params[0] << "\" on line " << n_line << " in " << file_name << " is ignored..." << std::endl;
+			continue;
+		}
+
+		present[sample_id] = true;
+		for (uint32_t i = 0; i < n_cols; ++i) {
+			if (ParseValue(params[i + 1], values[(uint64_t)sample_id * n_cols + i]) == false) {
+				std::cerr << utility::timestamp("ERROR","ASSOC") << "Illegal value \"" << params[i + 1] << "\" on line " << n_line << " in " << file_name << "..." << std::endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Sum rows [0, n_rows) of a row-major matrix into dst.
+static inline void AccumulateRows_(const double* __restrict rows, const uint32_t n_rows, const uint32_t stride, double* __restrict dst) {
+	for (uint32_t i = 0; i < n_rows; ++i) {
+		const double* __restrict row = &rows[(uint64_t)i * stride];
+		for (uint32_t k = 0; k < stride; ++k)
+			dst[k] += row[k];
+	}
+}
+
+static void AccumulateRowsDefault(const double* rows, const uint32_t n_rows, const uint32_t stride, double* dst) {
+	AccumulateRows_(rows, n_rows, stride, dst);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2")))
+static void AccumulateRowsAvx2(const double* rows, const uint32_t n_rows, const uint32_t stride, double* dst) {
+	AccumulateRows_(rows, n_rows, stride, dst);
+}
+
+__attribute__((target("avx512f")))
+static void AccumulateRowsAvx512(const double* rows, const uint32_t n_rows, const uint32_t stride, double* dst) {
+	AccumulateRows_(rows, n_rows, stride, dst);
+}
+#endif
+
+typedef void (*yon_assoc_accumulate_func)(const double*, const uint32_t, const uint32_t, double*);
+
+// Select the accumulation kernel once for the lifetime of the process.
+static yon_assoc_accumulate_func SelectAccumulateRows(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return(&AccumulateRowsAvx512);
+	if (__builtin_cpu_supports("avx2")) return(&AccumulateRowsAvx2);
+#endif
+	return(&AccumulateRowsDefault);
+}
+
+static void AccumulateRows(const double* rows, const uint32_t n_rows, const uint32_t stride, double* dst) {
+	static const yon_assoc_accumulate_func func = SelectAccumulateRows();
+	(*func)(rows, n_rows, stride, dst);
+}
+
+Association::Association() : n_samples(0), n_included(0), rank(0), stride(0), scale(1) {}
+
+bool Association::Open(const yon_vnt_hdr_t& header,
+                       const std::string& phenotypes,
+                       const std::string& covariates,
+                       const yon_assoc_settings& settings)
+{
+	this->settings  = settings;
+	this->n_samples = header.GetNumberSamples();
+
+	std::vector<std::string> pheno_names;
+	std::vector<double>  pheno_values;
+	std::vector<uint8_t> pheno_present;
+	if (ReadSampleTable(phenotypes, header, pheno_names, pheno_values, pheno_present) == false)
+		return false;
+
+	if (pheno_names.size() == 0) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "No phenotypes in " << phenotypes << "..." << std::endl;
+		return false;
+	}
+
+	uint32_t pheno_col = 0;
+	if (settings.phenotype.size()) {
+		pheno_col = std::find(pheno_names.begin(), pheno_names.end(), settings.phenotype) - pheno_names.begin();
+		if (pheno_col == pheno_names.size()) {
+			std::cerr << utility::timestamp("ERROR","ASSOC") << "Cannot find phenotype \"" << settings.phenotype << "\" in " << phenotypes << "..." << std::endl;
+			return false;
+		}
+	}
+	this->phenotype_name = pheno_names[pheno_col];
+
+	std::vector<double>  cov_values;
+	std::vector<uint8_t> cov_present;
+	this->covariate_names.clear();
+	if (covariates.size()) {
+		if (ReadSampleTable(covariates, header, this->covariate_names, cov_values, cov_present) == false)
+			return false;
+	}
+	const uint32_t n_cov = this->covariate_names.size();
+
+	// Samples with a phenotype and all covariates.
+	std::vector<uint32_t> included;
+	std::vector<double> y;
+	for (uint32_t s = 0; s < this->n_samples; ++s) {
+		if (pheno_present[s] == false) continue;
+		const double value = pheno_values[(uint64_t)s * pheno_names.size() + pheno_col];
+		if (std::isnan(value)) continue;
+
+		bool complete = true;
+		if (n_cov) {
+			complete = cov_present[s];
+			for (uint32_t i = 0; i < n_cov && complete; ++i)
+				complete = !std::isnan(cov_values[(uint64_t)s * n_cov + i]);
+		}
+		if (complete == false) continue;
+
+		if (settings.model == YON_ASSOC_LOGISTIC && value != 0 && value != 1) {
+			std::cerr << utility::timestamp("ERROR","ASSOC") << "Binary phenotypes have to be coded as 0 or 1 but found " << value << "..." << std::endl;
+			return false;
+		}
+
+		included.push_back(s);
+		y.push_back(value);
+	}
+
+	this->n_included = included.size();
+	const uint32_t n_cols = n_cov + 1;
+	if (this->n_included <= n_cols) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "Too few samples (" << this->n_included << ") with a phenotype and covariates..." << std::endl;
+		return false;
+	}
+
+	// Column-major design matrix with an intercept.
+	const uint32_t n = this->n_included;
+	std::vector<double> x((uint64_t)n * n_cols, 1);
+	for (uint32_t i = 0; i < n_cov; ++i) {
+		for (uint32_t s = 0; s < n; ++s)
+			x[(uint64_t)(i + 1) * n + s] = cov_values[(uint64_t)included[s] * n_cov + i];
+	}
+
+	if (settings.model == YON_ASSOC_LOGISTIC) return(this->FitLogistic(included, y, x, n_cols));
+	else return(this->FitLinear(included, y, x, n_cols));
+}
+
+bool Association::FitLinear(const std::vector<uint32_t>& included, const std::vector<double>& y, std::vector<double>& x, uint32_t n_cols) {
+	const uint32_t n = included.size();
+	this->rank = Orthonormalize(x.data(), n, n_cols);
+
+	// Residuals of the phenotype after projecting out the covariates.
+	std::vector<double> r(y);
+	for (uint32_t j = 0; j < this->rank; ++j) {
+		const double* q = &x[(uint64_t)j * n];
+		const double d = Dot(q, r.data(), n);
+		for (uint32_t s = 0; s < n; ++s) r[s] -= d * q[s];
+	}
+
+	this->scale = Dot(r.data(), r.data(), n) / (n - this->rank);
+	if (this->scale <= 0) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "Phenotype is fully explained by the covariates..." << std::endl;
+		return false;
+	}
+
+	this->SetRows(included, r, std::vector<double>(n, 1), x);
+	return true;
+}
+
+bool Association::FitLogistic(const std::vector<uint32_t>& included, const std::vector<double>& y, std::vector<double>& x, uint32_t n_cols) {
+	const uint32_t n = included.size();
+
+	double y_mean = 0;
+	for (uint32_t s = 0; s < n; ++s) y_mean += y[s];
+	y_mean /= n;
+	if (y_mean == 0 || y_mean == 1) {
+		std::cerr << utility::timestamp("ERROR","ASSOC") << "Binary phenotype has no " << (y_mean == 0 ? "cases" : "controls") << "..." << std::endl;
+		return false;
+	}
+
+	// Iteratively reweighted least squares on the linear predictor eta:
+	// the working response z is regressed on X with weights W through an
+	// orthonormal basis of W^(1/2)X.
+	std::vector<double> eta(n, log(y_mean / (1 - y_mean)));
+	std::vector<double> mu(n), w(n), sw(n), t(n), fit(n);
+	std::vector<double> q(x.size());
+	double deviance = std::numeric_limits<double>::max();
+	bool converged = false;
+
+	for (uint32_t iter = 0; iter <= YON_ASSOC_MAX_ITERATIONS; ++iter) {
+		for (uint32_t s = 0; s < n; ++s) {
+			mu[s] = std::min(std::max(1 / (1 + exp(-eta[s])), 1e-10), 1 - 1e-10);
+			w[s]  = mu[s] * (1 - mu[s]);
+			sw[s] = sqrt(w[s]);
+		}
+		for (uint32_t j = 0; j < n_cols; ++j) {
+			for (uint32_t s = 0; s < n; ++s)
+				q[(uint64_t)j * n + s] = sw[s] * x[(uint64_t)j * n + s];
+		}
+		this->rank = Orthonormalize(q.data(), n, n_cols);
+
+		double deviance_new = 0;
+		for (uint32_t s = 0; s < n; ++s)
+			deviance_new -= 2 * (y[s] ? log(mu[s]) : log(1 - mu[s]));
+		if (fabs(deviance_new - deviance) < 1e-8 * (fabs(deviance_new) + 0.1)) {
+			converged = true;
+			break;
+		}
+		deviance = deviance_new;
+		if (iter == YON_ASSOC_MAX_ITERATIONS) break;
+
+		for (uint32_t s = 0; s < n; ++s)
+			t[s] = sw[s] * (eta[s] + (y[s] - mu[s]) / w[s]);
+
+		std::fill(fit.begin(), fit.end(), 0);
+		for (uint32_t j = 0; j < this->rank; ++j) {
+			const double* qj = &q[(uint64_t)j * n];
+			const double d = Dot(qj, t.data(), n);
+			for (uint32_t s = 0; s < n; ++s) fit[s] += d * qj[s];
+		}
+		for (uint32_t s = 0; s < n; ++s)
+			eta[s] = fit[s] / sw[s];
+	}
+
+	if (converged == false)
+		std::cerr << utility::timestamp("WARNING","ASSOC") << "Logistic null model did not converge in " << YON_ASSOC_MAX_ITERATIONS << " iterations..." << std::endl;
+
+	std::vector<double> r(n);
+	for (uint32_t s = 0; s < n; ++s) r[s] = y[s] - mu[s];
+
+	this->scale = 1;
+	this->SetRows(included, r, w, q);
+	return true;
+}
+
+void Association::SetRows(const std::vector<uint32_t>& included, const std::vector<double>& r, const std::vector<double>& w, const std::vector<double>& q) {
+	const uint32_t n = included.size();
+	this->stride = (3 + this->rank + YON_ASSOC_LANES - 1) / YON_ASSOC_LANES * YON_ASSOC_LANES;
+	this->rows.assign((uint64_t)this->n_samples * this->stride, 0);
+	this->totals.assign(this->stride, 0);
+
+	for (uint32_t s = 0; s < n; ++s) {
+		double* row = &this->rows[(uint64_t)included[s] * this->stride];
+		const double sw = sqrt(w[s]);
+		row[0] = 1;
+		row[1] = r[s];
+		row[2] = w[s];
+		for (uint32_t j = 0; j < this->rank; ++j)
+			row[3 + j] = sw * q[(uint64_t)j * n + s];
+
+		for (uint32_t k = 0; k < this->stride; ++k)
+			this->totals[k] += row[k];
+	}
+}
+
+void Association::SetPermutation(const yon_gt_ppa* ppa, yon_assoc_workspace& ws) const {
+	if (ppa == nullptr) {
+		ws.rows = this->rows.data();
+		return;
+	}
+
+	// Retain the rows if they were permuted for the same permutation.
+	if (ws.permuted == false || ws.rows_permuted.size() != this->rows.size()
+	    || memcmp(ppa->ordering, ws.ordering.data(), sizeof(uint32_t) * this->n_samples) != 0)
+	{
+		ws.ordering.assign(ppa->ordering, ppa->ordering + this->n_samples);
+		ws.rows_permuted.resize(this->rows.size());
+		for (uint32_t i = 0; i < this->n_samples; ++i) {
+			memcpy(&ws.rows_permuted[(uint64_t)i * this->stride],
+			       &this->rows[(uint64_t)ws.ordering[i] * this->stride],
+			       sizeof(double) * this->stride);
+		}
+		ws.permuted = true;
+	}
+	ws.rows = ws.rows_permuted.data();
+}
+
+bool Association::Evaluate(yon1_vc_t& vc, yon_assoc_workspace& ws) const {
+	ws.results.clear();
+	ws.n_tested  = 0;
+	ws.n_skipped = 0;
+
+	// Rows are selected for every record as records of a block may be
+	// stored in different orders: records in haplotype blocks that are
+	// encoded in their own order have no permutation whereas the other
+	// records use the permutation of the block. Permuted rows are only
+	// compared against a permutation once per block.
+	const yon_gt_ppa* ppa_rows = nullptr;
+	for (uint32_t i = 0; i < vc.size(); ++i) {
+		const yon1_vnt_t& rcd = vc[i];
+		if (rcd.is_loaded_gt == false || rcd.controller.gt_available == false || rcd.gt->Evaluate() == false) {
+			++ws.n_skipped;
+			continue;
+		}
+
+		if (rcd.gt->n_s != this->n_samples) {
+			std::cerr << utility::timestamp("ERROR","ASSOC") << "Record has " << rcd.gt->n_s << " samples but expected " << this->n_samples << "..." << std::endl;
+			return false;
+		}
+
+		const yon_gt_ppa* ppa = rcd.gt->ppa;
+		if (ppa == nullptr) ws.rows = this->rows.data();
+		else if (ppa == ppa_rows) ws.rows = ws.rows_permuted.data();
+		else {
+			if (ppa->n_s != this->n_samples) {
+				std::cerr << utility::timestamp("ERROR","ASSOC") << "Permutation has " << ppa->n_s << " samples but expected " << this->n_samples << "..." << std::endl;
+				return false;
+			}
+			this->SetPermutation(ppa, ws);
+			ppa_rows = ppa;
+		}
+
+		yon_assoc_result result;
+		if (this->Test(*rcd.gt, ws, result) == false) {
+			++ws.n_skipped;
+			continue;
+		}
+
+		result.rid  = rcd.rid;
+		result.pos  = rcd.pos;
+		result.name = rcd.name;
+		if (rcd.n_alleles) result.ref = rcd.alleles[0].ToString();
+		for (uint32_t j = 1; j < rcd.n_alleles; ++j) {
+			if (j != 1) result.alt += ',';
+			result.alt += rcd.alleles[j].ToString();
+		}
+
+		ws.results.push_back(std::move(result));
+		++ws.n_tested;
+	}
+
+	return true;
+}
+
+bool Association::Test(const yon_gt& gt, yon_assoc_workspace& ws, yon_assoc_result& result) const {
+	if (gt.m == 0) return false;
+
+	// Dosage classes 0 to m and missing.
+	const uint32_t n_classes = gt.m + 2;
+	const uint32_t missing   = gt.m + 1;
+
+	ws.classes.resize(gt.n_i);
+	ws.class_counts.assign(n_classes, 0);
+	for (uint32_t j = 0; j < gt.n_i; ++j) {
+		const yon_gt_rcd& rcd = gt.rcds[j];
+		uint32_t dosage = 0;
+		for (uint32_t a = 0; a < gt.m; ++a) {
+			const uint8_t code = YON_GT_RCD_ALLELE_UNPACK(rcd.allele[a]);
+			if (code == YON_GT_RCD_MISS) { dosage = missing; break; }
+			dosage += (code > YON_GT_RCD_REF);
+		}
+		ws.classes[j] = dosage;
+		ws.class_counts[dosage] += rcd.run_length;
+	}
+
+	// The largest class is never visited but derived from the totals.
+	const uint32_t skip = std::max_element(ws.class_counts.begin(), ws.class_counts.end()) - ws.class_counts.begin();
+
+	ws.sums.assign((uint64_t)n_classes * this->stride, 0);
+	uint32_t position = 0;
+	for (uint32_t j = 0; j < gt.n_i; ++j) {
+		const uint32_t run_length = gt.rcds[j].run_length;
+		if (ws.classes[j] != skip)
+			AccumulateRows(&ws.rows[(uint64_t)position * this->stride], run_length, this->stride, &ws.sums[(uint64_t)ws.classes[j] * this->stride]);
+		position += run_length;
+	}
+	if (position != this->n_samples) return false;
+
+	double* skipped = &ws.sums[(uint64_t)skip * this->stride];
+	for (uint32_t k = 0; k < this->stride; ++k) {
+		skipped[k] = this->totals[k];
+		for (uint32_t c = 0; c < n_classes; ++c) {
+			if (c != skip) skipped[k] -= ws.sums[(uint64_t)c * this->stride + k];
+		}
+	}
+
+	// Included samples with observed genotypes and their allele counts.
+	double n_obs = 0, n_alt = 0;
+	for (uint32_t c = 0; c < missing; ++c) {
+		n_obs += ws.sums[(uint64_t)c * this->stride];
+		n_alt += c * ws.sums[(uint64_t)c * this->stride];
+	}
+	if (n_obs < 0.5) return false;
+
+	result.n  = n_obs + 0.5;
+	result.af = n_alt / (gt.m * n_obs);
+	const double mac = std::min(n_alt, gt.m * n_obs - n_alt);
+	if (mac + 0.5 < std::max(this->settings.min_mac, (uint32_t)1)) return false;
+
+	// Dot products of the mean-imputed dosages with every column.
+	const double mean = n_alt / n_obs;
+	const double* m_sums = &ws.sums[(uint64_t)missing * this->stride];
+	double u   = mean * m_sums[1];
+	double gwg = mean * mean * m_sums[2];
+	for (uint32_t c = 1; c < missing; ++c) {
+		u   += c * ws.sums[(uint64_t)c * this->stride + 1];
+		gwg += c * c * ws.sums[(uint64_t)c * this->stride + 2];
+	}
+
+	double info = gwg;
+	for (uint32_t j = 0; j < this->rank; ++j) {
+		double gq = mean * m_sums[3 + j];
+		for (uint32_t c = 1; c < missing; ++c)
+			gq += c * ws.sums[(uint64_t)c * this->stride + 3 + j];
+		info -= gq * gq;
+	}
+
+	// Dosages explained by the covariates cannot be tested.
+	if (info <= YON_ASSOC_RANK_TOLERANCE * gwg) return false;
+
+	result.beta  = u / info;
+	result.se    = sqrt(this->scale / info);
+	result.chisq = u * u / (this->scale * info);
+	result.p     = erfc(sqrt(result.chisq / 2));
+
+	return true;
+}
+
+}
@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <sstream>
+
+#include "genotype_matrix.h"
+#include "utility.h"
+
+namespace tachyon {
+
+yon_gt_matrix::yon_gt_matrix() :
+	block_id(0), n_rows(0), n_cols(0), transposed(false), owned(true),
+	n_capacity(0), data(nullptr), arena(nullptr)
+{}
+
+yon_gt_matrix::~yon_gt_matrix() {
+	if (this->owned) delete [] this->data;
+}
+
+void yon_gt_matrix::SetBuffer(int8_t* buffer, const uint64_t capacity) {
+	if (this->owned) delete [] this->data;
+	this->data       = buffer;
+	this->n_capacity = capacity;
+	this->owned      = false;
+	this->arena      = nullptr;
+}
+
+void yon_gt_matrix::SetArena(yon_arena* arena) {
+	if (this->owned) delete [] this->data;
+	this->data       = nullptr;
+	this->n_capacity = 0;
+	this->owned      = false;
+	this->arena      = arena;
+}
+
+bool yon_gt_matrix::Allocate(const uint32_t n_rows, const uint32_t n_cols) {
+	const uint64_t n_cells = (uint64_t)n_rows * n_cols;
+
+	if (this->arena != nullptr) {
+		this->data       = this->arena->Allocate<int8_t>(n_cells);
+		this->n_capacity = n_cells;
+	} else if (n_cells > this->n_capacity) {
+		if (this->owned == false) {
+			std::cerr << utility::timestamp("ERROR","MATRIX") << "Buffer of " << this->n_capacity << " elements cannot hold a " << n_rows << "x" << n_cols << " matrix..." << std::endl;
+			return false;
+		}
+		delete [] this->data;
+		this->data       = new int8_t[n_cells];
+		this->n_capacity = n_cells;
+	}
+
+	this->n_rows = n_rows;
+	this->n_cols = n_cols;
+	this->rid.resize(n_rows);
+	this->pos.resize(n_rows);
+	return true;
+}
+
+bool yon_gt_matrix::Fill(yon1_vc_t& vc, const yon_gt_matrix_settings& settings, yon_gt_tiled_exp& tiles) {
+	const uint32_t n_samples = tiles.n_s;
+	// The permutation array of this block may be stored at the same
+	// address as that of the previous block.
+	tiles.ResetPermutation();
+
+	for (uint32_t i = 0; i < settings.samples.size(); ++i) {
+		if (settings.samples[i] >= n_samples) {
+			std::cerr << utility::timestamp("ERROR","MATRIX") << "Illegal sample offset " << settings.samples[i] << " for " << n_samples << " samples..." << std::endl;
+			return false;
+		}
+	}
+
+	if (this->Allocate(vc.size(), settings.GetNumberColumns(n_samples)) == false)
+		return false;
+	this->transposed = settings.transpose;
+
+	std::vector<yon_gt*> gts(tiles.capacity(), nullptr);
+	for (uint32_t from = 0; from < vc.size(); from += tiles.capacity()) {
+		const uint32_t n_records = std::min((uint32_t)vc.size() - from, tiles.capacity());
+		for (uint32_t j = 0; j < n_records; ++j) {
+			const yon1_vnt_t& rcd = vc[from + j];
+			gts[j] = (rcd.is_loaded_gt && rcd.controller.gt_available) ? rcd.gt : nullptr;
+		}
+
+		if (tiles.Expand(gts.data(), n_records) == false)
+			return false;
+
+		for (uint32_t j = 0; j < n_records; ++j) {
+			this->rid[from + j] = vc[from + j].rid;
+			this->pos[from + j] = vc[from + j].pos;
+			if (gts[j] == nullptr) this->FillMissing(from + j, settings);
+			else this->FillRow(from + j, tiles.GetRow(j), gts[j]->m, n_samples, settings);
+		}
+	}
+
+	return true;
+}
+
+void yon_gt_matrix::FillRow(const uint32_t row, const uint8_t* alleles, const uint8_t m, const uint32_t n_samples, const yon_gt_matrix_settings& settings) {
+	const uint32_t n_s = settings.samples.size() ? settings.samples.size() : n_samples;
+	const uint32_t* subset = settings.samples.size() ? settings.samples.data() : nullptr;
+
+	for (uint32_t i = 0; i < n_s; ++i) {
+		const uint8_t* a = &alleles[(subset != nullptr ? subset[i] : i) * m];
+
+		switch(settings.layout) {
+		case(YON_GT_MATRIX_DOSAGE):
+		{
+			int8_t dosage = 0;
+			for (uint32_t j = 0; j < m; ++j) {
+				const uint8_t code = YON_GT_RCD_ALLELE_UNPACK(a[j]);
+				if (code == YON_GT_RCD_MISS) { dosage = YON_GT_MATRIX_MISSING; break; }
+				dosage += (code > YON_GT_RCD_REF);
+			}
+			this->at(row, i) = dosage;
+			break;
+		}
+		case(YON_GT_MATRIX_HAPLOTYPE):
+			for (uint32_t j = 0; j < settings.ploidy; ++j) {
+				int8_t value = YON_GT_MATRIX_EOV;
+				if (j < m) {
+					const uint8_t code = YON_GT_RCD_ALLELE_UNPACK(a[j]);
+					if (code == YON_GT_RCD_MISS) value = YON_GT_MATRIX_MISSING;
+					else if (code != YON_GT_RCD_EOV) value = code - YON_GT_RCD_REF;
+				}
+				this->at(row, i*settings.ploidy + j) = value;
+			}
+			break;
+		case(YON_GT_MATRIX_MISSING_MASK):
+		{
+			int8_t missing = 0;
+			for (uint32_t j = 0; j < m; ++j)
+				missing |= (YON_GT_RCD_ALLELE_UNPACK(a[j]) == YON_GT_RCD_MISS);
+			this->at(row, i) = missing;
+			break;
+		}
+		}
+	}
+}
+
+void yon_gt_matrix::FillMissing(const uint32_t row, const yon_gt_matrix_settings& settings) {
+	const int8_t value = settings.layout == YON_GT_MATRIX_MISSING_MASK ? 1 : YON_GT_MATRIX_MISSING;
+	for (uint32_t i = 0; i < this->n_cols; ++i)
+		this->at(row, i) = value;
+}
+
+yon_npy_writer::yon_npy_writer() : transpose(false), n_cols(0), n_rows(0) {}
+yon_npy_writer::~yon_npy_writer() { if (this->stream.is_open()) this->close(); }
+
+bool yon_npy_writer::open(const std::string& path, const uint32_t n_cols, const bool transpose) {
+	this->transpose = transpose;
+	this->n_cols    = n_cols;
+	this->n_rows    = 0;
+
+	this->stream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!this->stream.good()) {
+		std::cerr << utility::timestamp("ERROR","MATRIX") << "Could not open: " << path << "!" << std::endl;
+		return false;
+	}
+
+	// The header is rewritten with the final shape upon closing.
+	const std::string header = this->BuildHeader();
+	this->stream.write(header.data(), header.size());
+	return(this->stream.good());
+}
+
+bool yon_npy_writer::Add(const yon_gt_matrix& matrix) {
+	if (matrix.transposed) {
+		std::cerr << utility::timestamp("ERROR","MATRIX") << "Transposed matrices cannot be appended..." << std::endl;
+		return false;
+	}
+
+	if (matrix.n_rows && matrix.n_cols != this->n_cols) {
+		std::cerr << utility::timestamp("ERROR","MATRIX") << "Matrix has " << matrix.n_cols << " columns but expected " << this->n_cols << "..." << std::endl;
+		return false;
+	}
+
+	this->stream.write(reinterpret_cast<const char*>(matrix.data), matrix.size());
+	this->n_rows += matrix.n_rows;
+	return(this->stream.good());
+}
+
+bool yon_npy_writer::close(void) {
+	const std::string header = this->BuildHeader();
+	this->stream.seekp(0);
+	this->stream.write(header.data(), header.size());
+	this->stream.close();
+	if (this->stream.fail()) {
+		std::cerr << utility::timestamp("ERROR","MATRIX") << "Failed to finalize .npy file..." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string yon_npy_writer::BuildHeader(void) const {
+	std::stringstream dict;
+	dict << "{'descr': '|i1', 'fortran_order': " << (this->transpose ? "True" : "False") << ", 'shape': (";
+	if (this->transpose) dict << this->n_cols << ", " << this->n_rows;
+	else dict << this->n_rows << ", " << this->n_cols;
+	dict << "), }";
+
+	// Magic string, version 1.0, and the little-endian length of the
+	// header that is padded with spaces and terminated by a newline.
+	const uint16_t l_header = YON_NPY_HEADER_LENGTH - 10;
+	std::string header("\x93NUMPY\x01\x00", 8);
+	header += (char)(l_header & 0xFF);
+	header += (char)(l_header >> 8);
+	header += dict.str();
+	header.resize(YON_NPY_HEADER_LENGTH - 1, ' ');
+	header += '\n';
+	return(header);
+}
+
+}
@@ -54,6 +54,79 @@ void yon_gt_ppa::reset(void) {
 		this->ordering[i] = i;
 }
 
+bool yon_gt_ppa::ToDelta(const yon_gt_ppa& reference, yon_gt_ppa& delta) const {
+	if (reference.n_s != this->n_s) return false;
+
+	// Position of each sample in the reference.
+	std::vector<uint32_t> rank(this->n_s);
+	for (uint32_t i = 0; i < this->n_s; ++i)
+		rank[reference.ordering[i]] = i;
+
+	// Differences between successive positions are zigzag encoded such
+	// that small negative differences remain small and are then stored
+	// as base-128 varints.
+	std::vector<uint8_t> bytes;
+	bytes.reserve(this->n_s);
+	int64_t prev = 0;
+	for (uint32_t i = 0; i < this->n_s; ++i) {
+		const int64_t r = rank[this->ordering[i]];
+		const int64_t d = r - prev;
+		uint64_t z = ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+		while (z >= 128) {
+			bytes.push_back((uint8_t)(z | 128));
+			z >>= 7;
+		}
+		bytes.push_back((uint8_t)z);
+		prev = r;
+	}
+
+	// The first word stores the number of encoded bytes followed by the
+	// bytes packed into words.
+	const uint32_t n_words = 1 + (bytes.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+	delta.Allocate(n_words);
+	memset(delta.ordering, 0, sizeof(uint32_t)*n_words);
+	delta.ordering[0] = bytes.size();
+	memcpy(&delta.ordering[1], bytes.data(), bytes.size());
+	return true;
+}
+
+bool yon_gt_ppa::ApplyDelta(const yon_gt_ppa& reference) {
+	if (this->n_s == 0 || this->ordering == nullptr) return false;
+
+	const uint64_t n_bytes = this->ordering[0];
+	if (n_bytes > (uint64_t)(this->n_s - 1) * sizeof(uint32_t)) return false;
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&this->ordering[1]);
+
+	// Every position in the reference has to be used exactly once for the
+	// result to be a permutation.
+	uint32_t* ordering = new uint32_t[reference.n_s];
+	std::vector<bool> seen(reference.n_s, false);
+	uint64_t offset = 0;
+	int64_t r = 0;
+	for (uint32_t i = 0; i < reference.n_s; ++i) {
+		uint64_t z = 0;
+		uint32_t shift = 0;
+		while (true) {
+			if (offset == n_bytes || shift > 63) { delete [] ordering; return false; }
+			const uint8_t b = bytes[offset++];
+			z |= (uint64_t)(b & 127) << shift;
+			if ((b & 128) == 0) break;
+			shift += 7;
+		}
+
+		r += (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+		if (r < 0 || r >= reference.n_s || seen[r]) { delete [] ordering; return false; }
+		seen[r] = true;
+		ordering[i] = reference.ordering[r];
+	}
+	if (offset != n_bytes) { delete [] ordering; return false; }
+
+	delete [] this->ordering;
+	this->ordering = ordering;
+	this->n_s = reference.n_s;
+	return true;
+}
+
 yon_buffer_t& operator>>(yon_buffer_t& buffer, yon_gt_ppa& ppa) {
 	DeserializePrimitive(ppa.n_s, buffer);
 	ppa.ordering = new uint32_t[ppa.n_s];
@@ -218,18 +291,108 @@ yon_buffer_t& yon_gt_rcd::PrintVcf(yon_buffer_t& buffer, const uint8_t& n_ploidy
 
 // Start GT
 
-yon_gt::yon_gt() : eval_cont(0), add(0), global_phase(0), shift(0), p(0), m(0), method(0), n_s(0), n_i(0), n_o(0),
+// Branchless unpacking of diploid run-length encoded genotypes. Alleles
+// stored as biallelic M1 codes {0: ref, 1: alt, 2: missing} are recoded
+// to record codes {2, 3, 0} as (code + 2) & 3 to avoid a table lookup
+// that would prevent vectorization.
+template <class T>
+static inline uint64_t UnpackDiploidRuns_(const T* __restrict data,
+                                          const uint32_t n,
+                                          const uint8_t shift,
+                                          const uint8_t add,
+                                          const uint8_t global_phase,
+                                          const bool recode,
+                                          uint32_t* __restrict run_length,
+                                          uint8_t* __restrict allele0,
+                                          uint8_t* __restrict allele1)
+{
+	const T mask         = ((T)1 << shift) - 1;
+	const T offset       = recode ? 2 : 0;
+	const T code_mask    = recode ? 3 : mask;
+	const T phase_mask   = add ? 1 : 0;
+	const T phase_global = add ? 0 : global_phase;
+	const uint32_t shift_a  = add;
+	const uint32_t shift_b  = add + shift;
+	const uint32_t shift_rl = add + 2*shift;
+
+	uint64_t n_total = 0;
+	for (uint32_t i = 0; i < n; ++i) {
+		const T w = data[i];
+		const T phase = (w & phase_mask) | phase_global;
+		run_length[i] = w >> shift_rl;
+		allele0[i] = (((((w >> shift_b) & mask) + offset) & code_mask) << 1) | phase;
+		allele1[i] = (((((w >> shift_a) & mask) + offset) & code_mask) << 1) | phase;
+		n_total += run_length[i];
+	}
+	return(n_total);
+}
+
+static uint64_t UnpackDiploidRunsDefault(const uint8_t* data, const uint8_t p, const uint32_t n, const uint8_t shift, const uint8_t add, const uint8_t global_phase, const bool recode, yon_gt_soa& soa) {
+	switch(p) {
+	case(1): return(UnpackDiploidRuns_(reinterpret_cast<const uint8_t*>(data),  n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(2): return(UnpackDiploidRuns_(reinterpret_cast<const uint16_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(4): return(UnpackDiploidRuns_(reinterpret_cast<const uint32_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(8): return(UnpackDiploidRuns_(reinterpret_cast<const uint64_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	default: return(0);
+	}
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// Identical kernels compiled for AVX2 and AVX-512BW such that the
+// compiler vectorizes the shift/mask loop over wider lanes. These
+// are only invoked if the processor supports them.
+__attribute__((target("avx2")))
+static uint64_t UnpackDiploidRunsAvx2(const uint8_t* data, const uint8_t p, const uint32_t n, const uint8_t shift, const uint8_t add, const uint8_t global_phase, const bool recode, yon_gt_soa& soa) {
+	switch(p) {
+	case(1): return(UnpackDiploidRuns_(reinterpret_cast<const uint8_t*>(data),  n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(2): return(UnpackDiploidRuns_(reinterpret_cast<const uint16_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(4): return(UnpackDiploidRuns_(reinterpret_cast<const uint32_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(8): return(UnpackDiploidRuns_(reinterpret_cast<const uint64_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	default: return(0);
+	}
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t UnpackDiploidRunsAvx512(const uint8_t* data, const uint8_t p, const uint32_t n, const uint8_t shift, const uint8_t add, const uint8_t global_phase, const bool recode, yon_gt_soa& soa) {
+	switch(p) {
+	case(1): return(UnpackDiploidRuns_(reinterpret_cast<const uint8_t*>(data),  n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(2): return(UnpackDiploidRuns_(reinterpret_cast<const uint16_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(4): return(UnpackDiploidRuns_(reinterpret_cast<const uint32_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	case(8): return(UnpackDiploidRuns_(reinterpret_cast<const uint64_t*>(data), n, shift, add, global_phase, recode, soa.run_length, soa.allele0, soa.allele1));
+	default: return(0);
+	}
+}
+#endif
+
+typedef uint64_t (*yon_gt_unpack_func)(const uint8_t*, const uint8_t, const uint32_t, const uint8_t, const uint8_t, const uint8_t, const bool, yon_gt_soa&);
+
+// Select the unpacking kernel once for the lifetime of the process.
+static yon_gt_unpack_func SelectUnpackDiploidRuns(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) return(&UnpackDiploidRunsAvx512);
+	if (__builtin_cpu_supports("avx2")) return(&UnpackDiploidRunsAvx2);
+#endif
+	return(&UnpackDiploidRunsDefault);
+}
+
+uint64_t UnpackDiploidRuns(const uint8_t* data, const uint8_t p, const uint32_t n, const uint8_t shift, const uint8_t add, const uint8_t global_phase, const bool recode, yon_gt_soa& soa) {
+	static const yon_gt_unpack_func func = SelectUnpackDiploidRuns();
+	return((*func)(data, p, n, shift, add, global_phase, recode, soa));
+}
+
+yon_gt::yon_gt() : eval_cont(0), add(0), global_phase(0), shift(0), p(0), m(0), method(0), n_s(0), n_i(0), n_o(0), n_c(0),
 		   n_allele(0), ppa(nullptr), data(nullptr),
 		   d_exp(nullptr), rcds(nullptr), n_i_occ(nullptr), d_occ(nullptr),
-		   dirty(false)
+		   arena(nullptr), dirty(false)
 {}
 
 yon_gt::yon_gt(const yon_gt& other) :
-	eval_cont(other.eval_cont), add(other.add), global_phase(other.global_phase), shift(other.shift),
-	p(other.p), m(other.m), method(other.method), n_s(other.n_s), n_i(other.n_i), n_o(other.n_o),
+	eval_cont(other.eval_cont & ~YON_GT_UN_SOA), add(other.add), global_phase(other.global_phase), shift(other.shift),
+	p(other.p), m(other.m), method(other.method), n_s(other.n_s), n_i(other.n_i), n_o(other.n_o), n_c(other.n_c),
 	n_allele(other.n_allele), ppa(other.ppa), data(other.data),
 	d_exp(nullptr), rcds(nullptr), n_i_occ(nullptr), d_occ(nullptr),
-	dirty(other.dirty)
+	arena(nullptr), dirty(other.dirty)
 {
 	if (other.d_exp != nullptr) {
 		d_exp = new yon_gt_rcd[n_s];
@@ -257,20 +420,14 @@ yon_gt::yon_gt(const yon_gt& other) :
 
 yon_gt& yon_gt::operator=(const yon_gt& other) {
 	// Destroy local data.
-	delete [] rcds;
-	delete [] d_exp;
-	if (d_occ != nullptr) {
-		for (uint32_t i = 0; i < this->n_o; ++i)
-			delete [] d_occ[i];
-	}
-	delete [] n_i_occ;
-	delete [] d_occ;
+	this->ReleaseRecords();
 
-	eval_cont = other.eval_cont; add = other.add; global_phase = other.global_phase;
+	eval_cont = other.eval_cont & ~YON_GT_UN_SOA; add = other.add; global_phase = other.global_phase;
 	shift = other.shift; p = other.p; m = other.m; method = other.method;
-	n_s = other.n_s; n_i = other.n_i; n_o = other.n_o;
+	n_s = other.n_s; n_i = other.n_i; n_o = other.n_o; n_c = other.n_c;
 	n_allele = other.n_allele; ppa = other.ppa; data = other.data;
 	d_exp = nullptr; rcds = nullptr; n_i_occ = nullptr; d_occ = nullptr;
+	arena = nullptr; // copies never borrow the src arena
 	dirty = other.dirty;
 
 	if (other.d_exp != nullptr) {
@@ -301,13 +458,14 @@ yon_gt& yon_gt::operator=(const yon_gt& other) {
 
 yon_gt::yon_gt(yon_gt&& other) noexcept :
 		eval_cont(other.eval_cont), add(other.add), global_phase(other.global_phase), shift(other.shift),
-		p(other.p), m(other.m), method(other.method), n_s(other.n_s), n_i(other.n_i), n_o(other.n_o),
+		p(other.p), m(other.m), method(other.method), n_s(other.n_s), n_i(other.n_i), n_o(other.n_o), n_c(other.n_c),
 		n_allele(other.n_allele), ppa(other.ppa), data(other.data),
 		d_exp(nullptr), rcds(nullptr), n_i_occ(nullptr), d_occ(nullptr),
-		dirty(other.dirty)
+		arena(other.arena), dirty(other.dirty)
 {
 	std::swap(d_exp, other.d_exp);
 	std::swap(rcds, other.rcds);
+	std::swap(soa, other.soa);
 	std::swap(n_i_occ, other.n_i_occ);
 	std::swap(d_occ, other.d_occ);
 }
@@ -319,24 +477,18 @@ yon_gt& yon_gt::operator=(yon_gt&& other) noexcept{
 	}
 
 	// Destroy local data.
-	delete [] rcds;
-	delete [] d_exp;
-	if (d_occ != nullptr) {
-		for (uint32_t i = 0; i < this->n_o; ++i)
-			delete [] d_occ[i];
-	}
-	delete [] n_i_occ;
-	delete [] d_occ;
+	this->ReleaseRecords();
 
 	eval_cont = other.eval_cont; add = other.add; global_phase = other.global_phase;
 	shift = other.shift; p = other.p; m = other.m; method = other.method;
-	n_s = other.n_s; n_i = other.n_i; n_o = other.n_o;
+	n_s = other.n_s; n_i = other.n_i; n_o = other.n_o; n_c = other.n_c;
 	n_allele = other.n_allele; ppa = other.ppa; data = other.data;
 	d_exp = nullptr; rcds = nullptr; n_i_occ = nullptr; d_occ = nullptr;
-	dirty = other.dirty;
+	arena = other.arena; dirty = other.dirty;
 
 	std::swap(d_exp, other.d_exp);
 	std::swap(rcds, other.rcds);
+	std::swap(soa, other.soa);
 	std::swap(n_i_occ, other.n_i_occ);
 	std::swap(d_occ, other.d_occ);
 
@@ -344,15 +496,44 @@ yon_gt& yon_gt::operator=(yon_gt&& other) noexcept{
 }
 
 
-yon_gt::~yon_gt() {
-	delete [] rcds;
+yon_gt::~yon_gt() { this->ReleaseRecords(); }
+
+void yon_gt::ReleaseRecords(void) {
 	delete [] d_exp;
-	if (d_occ != nullptr) {
-		for (uint32_t i = 0; i < this->n_o; ++i)
-			delete [] d_occ[i];
+	if (this->arena == nullptr) {
+		delete [] rcds;
+		if (d_occ != nullptr) {
+			for (uint32_t i = 0; i < this->n_o; ++i)
+				delete [] d_occ[i];
+		}
+		delete [] n_i_occ;
+		delete [] d_occ;
+		delete [] soa.run_length;
+		delete [] soa.allele0;
+		delete [] soa.allele1;
+	}
+	d_exp = nullptr; rcds = nullptr; n_i_occ = nullptr; d_occ = nullptr;
+	soa = yon_gt_soa();
+}
+
+yon_gt_rcd* yon_gt::AllocateRecords(const uint32_t n_records) const {
+	if (this->arena == nullptr) {
+		yon_gt_rcd* records = new yon_gt_rcd[n_records];
+		for (uint32_t i = 0; i < n_records; ++i)
+			records[i].allele = new uint8_t[this->m];
+		return(records);
 	}
-	delete [] n_i_occ;
-	delete [] d_occ;
+
+	// Records and alleles are served from the arena. Destructors for
+	// these records are never invoked: the allele pointers refer into
+	// a shared slab that is released when the arena is reset.
+	yon_gt_rcd* records = this->arena->Allocate<yon_gt_rcd>(n_records);
+	uint8_t* alleles = this->arena->Allocate<uint8_t>((size_t)n_records * this->m);
+	for (uint32_t i = 0; i < n_records; ++i) {
+		new( &records[i] ) yon_gt_rcd();
+		records[i].allele = &alleles[i * this->m];
+	}
+	return(records);
 }
 
 bool yon_gt::Evaluate(void) {
@@ -363,6 +544,7 @@ bool yon_gt::Evaluate(void) {
 	if (this->method == 1) return(this->EvaluateRecordsM1());
 	else if (this->method == 2) return(this->EvaluateRecordsM2());
 	else if (this->method == 4) return(this->EvaluateRecordsM4());
+	else if (this->method == 8) return(this->EvaluateRecordsM8());
 	else {
 		std::cerr << "not implemented method " << (int)this->method << std::endl;
 	}
@@ -370,35 +552,70 @@ bool yon_gt::Evaluate(void) {
 }
 
 bool yon_gt::EvaluateRecordsM1() {
+	assert(this->n_allele == 2);
+	return(this->EvaluateRecordsDiploid());
+}
+
+bool yon_gt::EvaluateRecordsM2() {
+	return(this->EvaluateRecordsDiploid());
+}
+
+bool yon_gt::EvaluateRecordsDiploid() {
 	// Prevent double evaluation.
 	if (this->eval_cont & YON_GT_UN_RCDS)
 		return true;
 
-	switch(this->p) {
-	case(1): return(this->EvaluateRecordsM1_<uint8_t>());
-	case(2): return(this->EvaluateRecordsM1_<uint16_t>());
-	case(4): return(this->EvaluateRecordsM1_<uint32_t>());
-	case(8): return(this->EvaluateRecordsM1_<uint64_t>());
-	default:
-		std::cerr << "illegal primitive in EvaluateRecordsM1" << std::endl;
-		exit(1);
+	if (this->EvaluateSoa() == false)
+		return false;
+
+	if (this->rcds != nullptr && this->arena == nullptr) delete [] this->rcds;
+
+	// Allocate memory for new records.
+	this->rcds = this->AllocateRecords(this->n_i);
+
+	for (uint32_t i = 0; i < this->n_i; ++i) {
+		this->rcds[i].run_length = this->soa.run_length[i];
+		this->rcds[i].allele[0]  = this->soa.allele0[i];
+		this->rcds[i].allele[1]  = this->soa.allele1[i];
 	}
+	this->eval_cont |= YON_GT_UN_RCDS;
+
+	return true;
 }
 
-bool yon_gt::EvaluateRecordsM2() {
+bool yon_gt::EvaluateSoa(void) {
 	// Prevent double evaluation.
-	if (this->eval_cont & YON_GT_UN_RCDS)
+	if (this->eval_cont & YON_GT_UN_SOA)
 		return true;
 
-	switch(this->p) {
-	case(1): return(this->EvaluateRecordsM2_<uint8_t>());
-	case(2): return(this->EvaluateRecordsM2_<uint16_t>());
-	case(4): return(this->EvaluateRecordsM2_<uint32_t>());
-	case(8): return(this->EvaluateRecordsM2_<uint64_t>());
-	default:
-		std::cerr << "illegal primitive in EvaluateRecordsM2" << std::endl;
-		exit(1);
+	if (this->method != 1 && this->method != 2) {
+		std::cerr << utility::timestamp("ERROR","GT") << "Cannot decode method " << (int)this->method << " into diploid runs..." << std::endl;
+		return false;
+	}
+	assert(this->m == 2);
+
+	if (this->arena == nullptr) {
+		delete [] this->soa.run_length;
+		delete [] this->soa.allele0;
+		delete [] this->soa.allele1;
+		this->soa.run_length = new uint32_t[this->n_i];
+		this->soa.allele0    = new uint8_t[this->n_i];
+		this->soa.allele1    = new uint8_t[this->n_i];
+	} else {
+		this->soa.run_length = this->arena->Allocate<uint32_t>(this->n_i);
+		this->soa.allele0    = this->arena->Allocate<uint8_t>(this->n_i);
+		this->soa.allele1    = this->arena->Allocate<uint8_t>(this->n_i);
+	}
+	this->soa.n = this->n_i;
+
+	const uint64_t n_total = UnpackDiploidRuns(this->data, this->p, this->n_i, this->shift, this->add, this->global_phase, this->method == 1, this->soa);
+	if (n_total != this->n_s) {
+		std::cerr << utility::timestamp("ERROR","GT") << "Run lengths sum to " << n_total << " but expected " << this->n_s << " samples..." << std::endl;
+		return false;
 	}
+	this->eval_cont |= YON_GT_UN_SOA;
+
+	return true;
 }
 
 bool yon_gt::EvaluateRecordsM4() {
@@ -417,6 +634,63 @@ bool yon_gt::EvaluateRecordsM4() {
 	}
 }
 
+bool yon_gt::EvaluateRecordsM8() {
+	// Prevent double evaluation.
+	if (this->eval_cont & YON_GT_UN_RCDS)
+		return true;
+
+	if (this->rcds != nullptr && this->arena == nullptr) delete [] this->rcds;
+
+	// Every carrier is at most preceded by one background record
+	// and there is at most one trailing background record.
+	this->rcds = this->AllocateRecords(2*this->n_c + 1);
+	this->n_i  = 0;
+
+	const uint8_t background = (YON_GT_RCD_REF << 1) | this->global_phase;
+	uint64_t b_offset = 0;
+	uint32_t next     = 0; // permuted offset following the previous carrier
+	bool prev_carrier = false;
+
+	for (uint32_t i = 0; i < this->n_c; ++i) {
+		const uint32_t gap = SparseGenotypeVarintDecode(this->data, b_offset);
+		if (gap) {
+			this->rcds[this->n_i].run_length = gap;
+			for (uint32_t j = 0; j < this->m; ++j) this->rcds[this->n_i].allele[j] = background;
+			++this->n_i;
+			prev_carrier = false;
+		}
+
+		const uint8_t* alleles = &this->data[b_offset];
+		b_offset += this->m;
+
+		// Merge with the preceding carrier if it shares the same alleles.
+		// Missing and EOV symbols carry no phase.
+		bool merge = prev_carrier;
+		for (uint32_t j = 0; j < this->m && merge; ++j)
+			merge = (this->rcds[this->n_i - 1].allele[j] == YON_GT_SPARSE_PHASE(alleles[j], this->global_phase));
+
+		if (merge) ++this->rcds[this->n_i - 1].run_length;
+		else {
+			this->rcds[this->n_i].run_length = 1;
+			for (uint32_t j = 0; j < this->m; ++j)
+				this->rcds[this->n_i].allele[j] = YON_GT_SPARSE_PHASE(alleles[j], this->global_phase);
+			++this->n_i;
+		}
+		prev_carrier = true;
+		next += gap + 1;
+	}
+	assert(next <= this->n_s);
+
+	if (next < this->n_s) {
+		this->rcds[this->n_i].run_length = this->n_s - next;
+		for (uint32_t j = 0; j < this->m; ++j) this->rcds[this->n_i].allele[j] = background;
+		++this->n_i;
+	}
+	this->eval_cont |= YON_GT_UN_RCDS;
+
+	return true;
+}
+
 bool yon_gt::ExpandRecordsPpa(void) {
 	if (this->eval_cont & YON_GT_UN_EXPAND)
 		return true;
@@ -535,6 +809,183 @@ bool yon_gt::ExpandRecordsExternal(yon_gt_rcd* d_expe) {
 	return true;
 }
 
+yon_gt_tiled_exp::yon_gt_tiled_exp(void) :
+	n_s(0), n_tile_r(0), n_tile_s(0), n_r(0), m_row(0), b_row(0),
+	ppa(nullptr), inverse(nullptr), ploidy(nullptr),
+	scratch(nullptr), rows(nullptr), view_r(0), view_m(0), view(nullptr)
+{}
+
+yon_gt_tiled_exp::~yon_gt_tiled_exp(void) {
+	// Records in the view do not own their alleles.
+	if (this->view != nullptr) {
+		for (uint32_t i = 0; i < this->n_s; ++i)
+			this->view[i].allele = nullptr;
+	}
+	delete [] this->view;
+	delete [] this->inverse;
+	delete [] this->ploidy;
+	delete [] this->scratch;
+	delete [] this->rows;
+}
+
+void yon_gt_tiled_exp::Allocate(const uint32_t n_samples, const uint32_t n_tile_records, const uint32_t n_tile_samples) {
+	if (this->view != nullptr) {
+		for (uint32_t i = 0; i < this->n_s; ++i)
+			this->view[i].allele = nullptr;
+	}
+	delete [] this->view;
+	delete [] this->inverse;
+	delete [] this->ploidy;
+	delete [] this->scratch;
+	delete [] this->rows;
+
+	this->n_s      = n_samples;
+	this->n_tile_r = std::max(n_tile_records, (uint32_t)1);
+	this->n_tile_s = std::max(n_tile_samples, (uint32_t)1);
+	this->n_r      = 0;
+	this->m_row    = 0;
+	this->b_row    = 0;
+	this->ppa      = nullptr;
+	this->inverse  = new uint32_t[n_samples];
+	this->ploidy   = new uint8_t[this->n_tile_r];
+	this->scratch  = nullptr;
+	this->rows     = nullptr;
+	this->view_r   = 0;
+	this->view_m   = 0;
+	this->view     = new yon_gt_rcd[n_samples];
+	for (uint32_t i = 0; i < n_samples; ++i)
+		this->view[i].run_length = 1;
+}
+
+void yon_gt_tiled_exp::ResetPermutation(void) { this->ppa = nullptr; }
+
+void yon_gt_tiled_exp::SetPermutation(const yon_gt_ppa* ppa) {
+	assert(ppa->n_s == this->n_s);
+	for (uint32_t i = 0; i < this->n_s; ++i)
+		this->inverse[ppa->ordering[i]] = i;
+	this->ppa = ppa;
+}
+
+bool yon_gt_tiled_exp::ExpandRuns(yon_gt* gt, uint8_t* dst) const {
+	if ((gt->eval_cont & YON_GT_UN_RCDS) == false) {
+		if (gt->Evaluate() == false) return false;
+	}
+	assert(gt->rcds != nullptr);
+
+	uint64_t n_total = 0;
+	if (gt->m == 2) {
+		for (uint32_t i = 0; i < gt->n_i; ++i) {
+			const uint8_t a = gt->rcds[i].allele[0];
+			const uint8_t b = gt->rcds[i].allele[1];
+			if (n_total + gt->rcds[i].run_length > this->n_s) return false;
+			for (uint32_t j = 0; j < gt->rcds[i].run_length; ++j, ++n_total) {
+				dst[2*n_total]     = a;
+				dst[2*n_total + 1] = b;
+			}
+		}
+	} else {
+		for (uint32_t i = 0; i < gt->n_i; ++i) {
+			if (n_total + gt->rcds[i].run_length > this->n_s) return false;
+			for (uint32_t j = 0; j < gt->rcds[i].run_length; ++j, ++n_total)
+				memcpy(&dst[n_total * gt->m], gt->rcds[i].allele, gt->m);
+		}
+	}
+	return(n_total == this->n_s);
+}
+
+bool yon_gt_tiled_exp::Expand(yon_gt* const* gts, const uint32_t n_records) {
+	assert(n_records <= this->n_tile_r);
+	this->n_r = 0;
+
+	// Rows are sized for the largest base ploidy in the tile.
+	uint8_t m_max = 0;
+	const yon_gt_ppa* ppa = nullptr;
+	for (uint32_t r = 0; r < n_records; ++r) {
+		if (gts[r] == nullptr) continue;
+		if (gts[r]->n_s != this->n_s) {
+			std::cerr << utility::timestamp("ERROR","GT") << "Record has " << gts[r]->n_s << " samples but expected " << this->n_s << "..." << std::endl;
+			return false;
+		}
+		m_max = std::max(m_max, gts[r]->m);
+		if (ppa == nullptr) ppa = gts[r]->ppa;
+		else if (gts[r]->ppa != nullptr && gts[r]->ppa != ppa) {
+			std::cerr << utility::timestamp("ERROR","GT") << "Records in a tile do not share a permutation array..." << std::endl;
+			return false;
+		}
+	}
+
+	if (m_max > this->m_row) {
+		delete [] this->scratch;
+		delete [] this->rows;
+		this->m_row   = m_max;
+		this->b_row   = (uint64_t)this->n_s * m_max;
+		this->scratch = new uint8_t[this->n_tile_r * this->b_row];
+		this->rows    = new uint8_t[this->n_tile_r * this->b_row];
+		// The view points into the previous rows.
+		this->view_m  = 0;
+	}
+
+	if (ppa != nullptr && ppa != this->ppa)
+		this->SetPermutation(ppa);
+
+	// Expand records in stored order. Records without a permutation
+	// are expanded directly into their rows.
+	for (uint32_t r = 0; r < n_records; ++r) {
+		this->ploidy[r] = 0;
+		if (gts[r] == nullptr) continue;
+
+		this->ploidy[r] = gts[r]->m;
+		uint8_t* dst = (gts[r]->ppa == nullptr ? this->rows : this->scratch) + r * this->b_row;
+		if (this->ExpandRuns(gts[r], dst) == false) {
+			std::cerr << utility::timestamp("ERROR","GT") << "Failed to expand genotype record..." << std::endl;
+			return false;
+		}
+	}
+
+	// Un-permute the tile a range of samples at a time such that the
+	// range of the inverse permutation and of every row stays cached.
+	if (ppa != nullptr) {
+		for (uint32_t from = 0; from < this->n_s; from += this->n_tile_s) {
+			const uint32_t to = std::min(from + this->n_tile_s, this->n_s);
+			for (uint32_t r = 0; r < n_records; ++r) {
+				if (gts[r] == nullptr || gts[r]->ppa == nullptr) continue;
+
+				const uint8_t  m   = this->ploidy[r];
+				const uint8_t* src = &this->scratch[r * this->b_row];
+				uint8_t*       dst = &this->rows[r * this->b_row];
+				if (m == 2) {
+					for (uint32_t s = from; s < to; ++s) {
+						dst[2*s]     = src[2*this->inverse[s]];
+						dst[2*s + 1] = src[2*this->inverse[s] + 1];
+					}
+				} else {
+					for (uint32_t s = from; s < to; ++s)
+						memcpy(&dst[s*m], &src[this->inverse[s]*m], m);
+				}
+			}
+		}
+	}
+
+	this->n_r = n_records;
+	return true;
+}
+
+yon_gt_rcd* yon_gt_tiled_exp::GetRecords(const uint32_t record) {
+	assert(record < this->n_r);
+
+	// Records only depend on the row and its ploidy and are therefore
+	// reused between calls and tiles.
+	const uint8_t m = this->ploidy[record];
+	if (m != 0 && (this->view_r != record || this->view_m != m)) {
+		uint8_t* row = &this->rows[record * this->b_row];
+		for (uint32_t i = 0; i < this->n_s; ++i)
+			this->view[i].allele = &row[i * m];
+		this->view_r = record;
+		this->view_m = m;
+	}
+	return(this->view);
+}
+
 bcf1_t* yon_gt::UpdateHtslibGenotypes(bcf1_t* rec, bcf_hdr_t* hdr) {
    // Prevent double evaluation.
    if ((this->eval_cont & YON_GT_UN_EXPAND)) {
@@ -568,13 +1019,13 @@ bcf1_t* yon_gt::UpdateHtslibGenotypes(bcf1_t* rec, bcf_hdr_t* hdr) {
 yon_gt_summary_rcd::yon_gt_summary_rcd() :
 	n_ploidy(0), n_ac_af(0), n_fs(0), ac(nullptr), af(nullptr),
 	nm(0), npm(0), an(0), fs_a(nullptr), hwe_p(0),
-	f_pic(0), heterozygosity(0)
+	f_pic(0), heterozygosity(0), is_arena(false)
 {}
 
 yon_gt_summary_rcd::yon_gt_summary_rcd(const yon_gt_summary_rcd& other) :
 	n_ploidy(other.n_ploidy), n_ac_af(other.n_ac_af), n_fs(other.n_fs), ac(nullptr), af(nullptr),
 	nm(other.nm), npm(other.npm), an(other.an), fs_a(nullptr), hwe_p(other.hwe_p),
-	f_pic(other.f_pic), heterozygosity(other.heterozygosity)
+	f_pic(other.f_pic), heterozygosity(other.heterozygosity), is_arena(false)
 {
 	if (other.ac != nullptr) { ac = new uint32_t[n_ac_af]; memcpy(ac, other.ac, n_ac_af*sizeof(uint32_t)); }
 	if (other.af != nullptr) { af = new float[n_ac_af]; memcpy(af, other.af, n_ac_af*sizeof(float)); }
@@ -582,9 +1033,13 @@ yon_gt_summary_rcd::yon_gt_summary_rcd(const yon_gt_summary_rcd& other) :
 }
 
 yon_gt_summary_rcd& yon_gt_summary_rcd::operator=(const yon_gt_summary_rcd& other) {
-	delete [] ac; ac = nullptr;
-	delete [] af; af = nullptr;
-	delete [] fs_a; fs_a = nullptr;
+	if (this == &other) return(*this);
+	if (is_arena == false) {
+		delete [] ac; delete [] af;
+		delete [] fs_a;
+	}
+	ac = nullptr; af = nullptr; fs_a = nullptr;
+	is_arena = false; // copies are always owned
 	n_ploidy = other.n_ploidy; n_ac_af = other.n_ac_af; n_fs = other.n_fs;
 	nm = other.nm; npm = other.npm; an = other.an; hwe_p = other.hwe_p;
 	f_pic = other.f_pic; heterozygosity = other.heterozygosity;
@@ -598,8 +1053,9 @@ yon_gt_summary_rcd& yon_gt_summary_rcd::operator=(const yon_gt_summary_rcd& othe
 yon_gt_summary_rcd::yon_gt_summary_rcd(yon_gt_summary_rcd&& other) noexcept :
 	n_ploidy(other.n_ploidy), n_ac_af(other.n_ac_af), n_fs(other.n_fs), ac(nullptr), af(nullptr),
 	nm(other.nm), npm(other.npm), an(other.an), fs_a(nullptr), hwe_p(other.hwe_p),
-	f_pic(other.f_pic), heterozygosity(other.heterozygosity)
+	f_pic(other.f_pic), heterozygosity(other.heterozygosity), is_arena(false)
 {
+	std::swap(is_arena, other.is_arena);
 	std::swap(ac, other.ac);
 	std::swap(af, other.af);
 	std::swap(fs_a, other.fs_a);
@@ -614,6 +1070,7 @@ yon_gt_summary_rcd& yon_gt_summary_rcd::operator=(yon_gt_summary_rcd&& other) no
 	n_ploidy = other.n_ploidy; n_ac_af = other.n_ac_af; n_fs = other.n_fs;
 	nm = other.nm; npm = other.npm; an = other.an; hwe_p = other.hwe_p;
 	f_pic = other.f_pic; heterozygosity = other.heterozygosity;
+	std::swap(is_arena, other.is_arena);
 	std::swap(ac, other.ac);
 	std::swap(af, other.af);
 	std::swap(fs_a, other.fs_a);
@@ -622,74 +1079,60 @@ yon_gt_summary_rcd& yon_gt_summary_rcd::operator=(yon_gt_summary_rcd&& other) no
 }
 
 yon_gt_summary_rcd::~yon_gt_summary_rcd() {
+	// Arrays served from an arena are released with it.
+	if (is_arena) return;
 	delete [] ac; delete [] af;
 	delete [] fs_a;
 	// Do not delete ac_p as it is borrowed
 }
 
-// summary object
-yon_gt_summary_obj::yon_gt_summary_obj() : n_cnt(0), children(nullptr) {}
-yon_gt_summary_obj::yon_gt_summary_obj(yon_gt_summary_obj&& other) noexcept : n_cnt(other.n_cnt), children(nullptr) { std::swap(children, other.children); }
-yon_gt_summary_obj& yon_gt_summary_obj::operator=(yon_gt_summary_obj&& other) noexcept{
-	if (this == &other) return *this;
-	delete [] children; children = nullptr;
-	n_cnt = other.n_cnt;
-	std::swap(children, other.children);
-	return(*this);
-}
-yon_gt_summary_obj::~yon_gt_summary_obj() { delete [] this->children; }
-
-// Clone helper ctor.
-yon_gt_summary_obj::yon_gt_summary_obj(const uint8_t n_alleles, const uint64_t cnt, yon_gt_summary_obj* c) :
-	n_cnt(cnt), children(nullptr)
-{
-	if (c != nullptr) {
-		children = new yon_gt_summary_obj[n_alleles];
-		for (int i = 0; i < n_alleles; ++i) {
-			children[i] = std::move(c[i].Clone(n_alleles));
-		}
-	}
-}
-
 // genotype summary
 yon_gt_summary::yon_gt_summary(void) :
 	n_ploidy(0),
 	n_alleles(0),
+	is_arena(false),
+	n_cells(0),
+	m_buffer(0),
+	buffer(nullptr),
+	genotypes(nullptr),
 	alleles(nullptr),
 	alleles_strand(nullptr),
-	gt(nullptr),
-	d(nullptr)
+	d(nullptr),
+	d_unused(nullptr),
+	arena(nullptr)
 {
 
 }
 
 yon_gt_summary::yon_gt_summary(const uint8_t base_ploidy, const uint8_t n_alleles) :
-	n_ploidy(base_ploidy),
-	n_alleles(n_alleles + 2),
-	alleles(new uint32_t[this->n_alleles]),
-	alleles_strand(new uint32_t*[this->n_ploidy]),
-	gt(new yon_gt_summary_obj[this->n_alleles]),
-	d(nullptr)
+	n_ploidy(0),
+	n_alleles(0),
+	is_arena(false),
+	n_cells(0),
+	m_buffer(0),
+	buffer(nullptr),
+	genotypes(nullptr),
+	alleles(nullptr),
+	alleles_strand(nullptr),
+	d(nullptr),
+	d_unused(nullptr),
+	arena(nullptr)
 {
-	memset(this->alleles, 0, sizeof(uint32_t)*this->n_alleles);
-	for (uint32_t i = 0; i < this->n_ploidy; ++i) {
-		this->alleles_strand[i] = new uint32_t[this->n_alleles];
-		memset(this->alleles_strand[i], 0, sizeof(uint32_t)*this->n_alleles);
-	}
-
-	// Add layers to the root node.
-	for (uint32_t i = 0; i < this->n_alleles; ++i)
-		this->AddGenotypeLayer(&this->gt[i], 1);
+	this->Setup(base_ploidy, n_alleles);
 }
 
 yon_gt_summary::yon_gt_summary(yon_gt_summary&& other) noexcept :
-	n_ploidy(other.n_ploidy), n_alleles(other.n_alleles),
-	alleles(nullptr), alleles_strand(nullptr), gt(nullptr), d(nullptr)
+	n_ploidy(other.n_ploidy), n_alleles(other.n_alleles), is_arena(other.is_arena),
+	n_cells(other.n_cells), m_buffer(other.m_buffer), buffer(nullptr),
+	genotypes(other.genotypes), alleles(other.alleles), alleles_strand(other.alleles_strand),
+	sparse_table(std::move(other.sparse_table)), sparse_alleles(std::move(other.sparse_alleles)),
+	sparse_counts(std::move(other.sparse_counts)), d(nullptr), d_unused(nullptr), arena(other.arena)
 {
-	std::swap(alleles, other.alleles);
-	std::swap(alleles_strand, other.alleles_strand);
-	std::swap(gt, other.gt);
+	std::swap(buffer, other.buffer);
 	std::swap(d, other.d);
+	std::swap(d_unused, other.d_unused);
+	other.genotypes = nullptr; other.alleles = nullptr; other.alleles_strand = nullptr;
+	other.n_cells = 0; other.m_buffer = 0; other.is_arena = false;
 }
 
 yon_gt_summary& yon_gt_summary::operator=(yon_gt_summary&& other) noexcept {
@@ -699,65 +1142,63 @@ yon_gt_summary& yon_gt_summary::operator=(yon_gt_summary&& other) noexcept {
 	}
 
 	// Clear local data without cosideration.
-	delete [] this->alleles;
-	delete [] this->gt;
-	if (this->alleles_strand != nullptr) {
-		for (uint32_t i = 0; i < this->n_ploidy; ++i)
-			delete this->alleles_strand[i];
-		delete [] this->alleles_strand;
-	}
-	delete this->d;
+	this->Release();
+	ReleaseEvaluation(this->d); this->d = nullptr;
+	ReleaseEvaluation(this->d_unused); this->d_unused = nullptr;
 
 	// Move.
-	n_ploidy = other.n_ploidy; n_alleles = other.n_alleles;
-	alleles = nullptr; alleles_strand = nullptr; gt = nullptr; d = nullptr;
-	std::swap(alleles, other.alleles);
-	std::swap(alleles_strand, other.alleles_strand);
-	std::swap(gt, other.gt);
+	n_ploidy = other.n_ploidy; n_alleles = other.n_alleles; is_arena = other.is_arena;
+	n_cells = other.n_cells; m_buffer = other.m_buffer; arena = other.arena;
+	genotypes = other.genotypes; alleles = other.alleles; alleles_strand = other.alleles_strand;
+	sparse_table   = std::move(other.sparse_table);
+	sparse_alleles = std::move(other.sparse_alleles);
+	sparse_counts  = std::move(other.sparse_counts);
+	std::swap(buffer, other.buffer);
 	std::swap(d, other.d);
+	std::swap(d_unused, other.d_unused);
+	other.genotypes = nullptr; other.alleles = nullptr; other.alleles_strand = nullptr;
+	other.n_cells = 0; other.m_buffer = 0; other.is_arena = false;
 
 	return(*this);
 }
 
 yon_gt_summary::yon_gt_summary(const yon_gt_summary& other) :
-	n_ploidy(other.n_ploidy), n_alleles(other.n_alleles),
-	alleles(new uint32_t[n_alleles]),
-	alleles_strand(new uint32_t*[n_ploidy]),
-	gt(new yon_gt_summary_obj[n_alleles]),
-	d(nullptr)
+	n_ploidy(0),
+	n_alleles(0),
+	is_arena(false),
+	n_cells(0),
+	m_buffer(0),
+	buffer(nullptr),
+	genotypes(nullptr),
+	alleles(nullptr),
+	alleles_strand(nullptr),
+	d(nullptr),
+	d_unused(nullptr),
+	arena(nullptr)
 {
-	for (int i = 0; i < n_alleles; ++i) alleles[i] = other.alleles[i];
-	for (uint32_t i = 0; i < n_ploidy; ++i) {
-		alleles_strand[i] = new uint32_t[n_alleles];
-		for (int j = 0; j < n_alleles; ++j) alleles_strand[i][j] = other.alleles_strand[i][j];
-	}
-	if (other.d != nullptr) this->d = new yon_gt_summary_rcd(*other.d);
-	for (int i = 0; i < n_alleles; ++i) gt[i] = std::move(other.gt[i].Clone(n_alleles));
+	*this = other;
 }
 
 yon_gt_summary& yon_gt_summary::operator=(const yon_gt_summary& other) {
-	// Delete previous data without consideration.
-	delete [] this->alleles;
-	delete [] this->gt;
-	if (this->alleles_strand != nullptr) {
-		for (uint32_t i = 0; i < this->n_ploidy; ++i)
-			delete this->alleles_strand[i];
-		delete [] this->alleles_strand;
-	}
-	delete this->d; this->d = nullptr;
+	if (this == &other) return(*this);
 
-	n_ploidy = other.n_ploidy; n_alleles = other.n_alleles;
-	alleles = new uint32_t[n_alleles];
-	alleles_strand = new uint32_t*[n_ploidy];
-	gt = new yon_gt_summary_obj[n_alleles];
+	// Copies never borrow the arena of the src.
+	this->arena = nullptr;
+	ReleaseEvaluation(this->d); this->d = nullptr;
 
-	for (int i = 0; i < n_alleles; ++i) alleles[i] = other.alleles[i];
-	for (uint32_t i = 0; i < this->n_ploidy; ++i) {
-		alleles_strand[i] = new uint32_t[n_alleles];
-		for (int j = 0; j < n_alleles; ++j) alleles_strand[i][j] = other.alleles_strand[i][j];
+	if (other.buffer == nullptr) {
+		this->Release();
+		this->n_ploidy = other.n_ploidy; this->n_alleles = other.n_alleles; this->n_cells = 0;
+		this->genotypes = nullptr; this->alleles = nullptr; this->alleles_strand = nullptr;
+		return(*this);
 	}
+
+	this->Setup(other.n_ploidy, other.n_alleles - 2);
+	memcpy(this->buffer, other.buffer, (this->n_cells + (this->n_alleles * (1 + this->n_ploidy) + 1) / 2) * sizeof(uint64_t));
+	this->sparse_table   = other.sparse_table;
+	this->sparse_alleles = other.sparse_alleles;
+	this->sparse_counts  = other.sparse_counts;
 	if (other.d != nullptr) this->d = new yon_gt_summary_rcd(*other.d);
-	for (int i = 0; i < n_alleles; ++i) gt[i] = std::move(other.gt[i].Clone(n_alleles));
 
 	return(*this);
 }
@@ -765,109 +1206,215 @@ yon_gt_summary& yon_gt_summary::operator=(const yon_gt_summary& other) {
 void yon_gt_summary::Setup(const uint8_t base_ploidy, const uint8_t n_als) {
 	n_ploidy  = base_ploidy;
 	n_alleles = n_als + 2;
-	// Destroy previous data without consideration.
-	delete [] this->alleles;
-	delete [] this->gt;
-	if (this->alleles_strand != nullptr) {
-		for (uint32_t i = 0; i < this->n_ploidy; ++i)
-			delete this->alleles_strand[i];
-		delete [] this->alleles_strand;
+
+	// The genotype tensor is dense if n_alleles ^ ploidy is small.
+	uint64_t n_dense = 1;
+	for (uint32_t i = 0; i < this->n_ploidy && n_dense <= YON_GT_SUMMARY_DENSE_MAX; ++i)
+		n_dense *= this->n_alleles;
+	this->n_cells = (n_dense <= YON_GT_SUMMARY_DENSE_MAX ? n_dense : 0);
+
+	// Allele counts and allele counts per chromosome are stored as
+	// 32-bit counts after the tensor.
+	const uint64_t n_words = this->n_cells + (this->n_alleles * (1 + this->n_ploidy) + 1) / 2;
+	if (n_words > this->m_buffer || (this->arena != nullptr && this->is_arena == false)) {
+		this->Release();
+		if (this->arena != nullptr) {
+			this->buffer   = this->arena->Allocate<uint64_t>(n_words);
+			this->is_arena = true;
+		} else {
+			this->buffer   = new uint64_t[n_words];
+			this->is_arena = false;
+		}
+		this->m_buffer = n_words;
 	}
-	delete this->d;
+	memset(this->buffer, 0, n_words*sizeof(uint64_t));
 
-	alleles = new uint32_t[n_alleles];
-	alleles_strand = new uint32_t*[this->n_ploidy];
-	gt = new yon_gt_summary_obj[this->n_alleles];
-	d = nullptr;
+	this->genotypes      = this->buffer;
+	this->alleles        = reinterpret_cast<uint32_t*>(this->buffer + this->n_cells);
+	this->alleles_strand = this->alleles + this->n_alleles;
 
-	memset(this->alleles, 0, sizeof(uint32_t)*this->n_alleles);
-	for (uint32_t i = 0; i < this->n_ploidy; ++i) {
-		this->alleles_strand[i] = new uint32_t[this->n_alleles];
-		memset(this->alleles_strand[i], 0, sizeof(uint32_t)*this->n_alleles);
+	// Clear the sparse table while retaining its memory.
+	std::fill(this->sparse_table.begin(), this->sparse_table.end(), 0);
+	this->sparse_alleles.clear();
+	this->sparse_counts.clear();
+
+	// Retain the previous evaluation such that its arrays can be reused.
+	if (this->d != nullptr) {
+		ReleaseEvaluation(this->d_unused);
+		this->d_unused = this->d;
+		this->d = nullptr;
 	}
+}
 
-	// Add layers to the root node.
-	for (uint32_t i = 0; i < this->n_alleles; ++i)
-		this->AddGenotypeLayer(&this->gt[i], 1);
+void yon_gt_summary::Release(void) {
+	if (this->is_arena == false) delete [] this->buffer;
+	this->buffer   = nullptr;
+	this->m_buffer = 0;
+	this->is_arena = false;
+}
+
+void yon_gt_summary::ReleaseEvaluation(yon_gt_summary_rcd* d) {
+	if (d == nullptr) return;
+	if (d->is_arena) d->~yon_gt_summary_rcd();
+	else delete d;
 }
 
 yon_gt_summary::~yon_gt_summary() {
-	delete [] this->alleles;
-	delete [] this->gt;
-	if (this->alleles_strand != nullptr) {
-		for (uint32_t i = 0; i < this->n_ploidy; ++i)
-			delete this->alleles_strand[i];
-		delete [] this->alleles_strand;
+	this->Release();
+	ReleaseEvaluation(this->d);
+	ReleaseEvaluation(this->d_unused);
+}
+
+uint32_t yon_gt_summary::FindSparse(const uint8_t* alleles) const {
+	// FNV-1a hash of the allele tuple.
+	uint32_t hash = 2166136261u;
+	for (uint32_t i = 0; i < this->n_ploidy; ++i) {
+		hash ^= alleles[i];
+		hash *= 16777619u;
 	}
-	delete this->d;
+
+	const uint32_t mask = this->sparse_table.size() - 1;
+	uint32_t slot = hash & mask;
+	while (this->sparse_table[slot] != 0) {
+		if (memcmp(&this->sparse_alleles[(uint64_t)(this->sparse_table[slot] - 1) * this->n_ploidy], alleles, this->n_ploidy) == 0)
+			break;
+		slot = (slot + 1) & mask;
+	}
+	return(slot);
 }
 
-bool yon_gt_summary::AddGenotypeLayer(yon_gt_summary_obj* target, uint8_t depth) {
-	if (depth == this->n_ploidy) return false;
-	if (target->children == nullptr) {
-		target->children = new yon_gt_summary_obj[this->n_alleles];
+void yon_gt_summary::AddSparse(const uint8_t* alleles, const uint64_t count) {
+	// Keep the load factor of the table at most one half.
+	if (2*(this->sparse_counts.size() + 1) > this->sparse_table.size()) {
+		this->sparse_table.assign(std::max<size_t>(64, 2*this->sparse_table.size()), 0);
+		for (uint32_t i = 0; i < this->sparse_counts.size(); ++i)
+			this->sparse_table[this->FindSparse(&this->sparse_alleles[(uint64_t)i * this->n_ploidy])] = i + 1;
 	}
 
-	for (uint32_t i = 0; i < this->n_alleles; ++i)
-		this->AddGenotypeLayer(&target->children[i], depth+1);
+	const uint32_t slot = this->FindSparse(alleles);
+	if (this->sparse_table[slot] == 0) {
+		this->sparse_alleles.insert(this->sparse_alleles.end(), alleles, alleles + this->n_ploidy);
+		this->sparse_counts.push_back(0);
+		this->sparse_table[slot] = this->sparse_counts.size();
+	}
+	this->sparse_counts[this->sparse_table[slot] - 1] += count;
+}
 
-	return false;
+uint64_t yon_gt_summary::GetGenotypeCount(const uint8_t* alleles) const {
+	if (this->n_cells) return(this->genotypes[this->GetGenotypeIndex(alleles)]);
+	if (this->sparse_table.size() == 0) return(0);
+
+	const uint32_t slot = this->FindSparse(alleles);
+	return(this->sparse_table[slot] ? this->sparse_counts[this->sparse_table[slot] - 1] : 0);
 }
 
 yon_gt_summary& yon_gt_summary::operator+=(const yon_gt& gt) {
 	assert(gt.rcds != nullptr);
+	return(this->Add(gt, gt.n_i, gt.rcds));
+}
 
-	// Iterate over available genotype records.
-	for (uint32_t i = 0; i < gt.n_i; ++i) {
-		// Target root node.
-		yon_gt_summary_obj* target = &this->gt[gt.rcds[i].allele[0] >> 1];
-		target->n_cnt += gt.rcds[i].run_length;
+yon_gt_summary& yon_gt_summary::Add(const yon_gt& gt, const uint32_t n_items, const yon_gt_rcd* rcds) {
+	assert(rcds != nullptr);
+	assert(gt.m == this->n_ploidy);
 
+	uint8_t genotype[256];
+	// Iterate over available genotype records.
+	for (uint32_t i = 0; i < n_items; ++i) {
 		// Iterate over alleles given the base ploidy.
 		for (uint32_t j = 0; j < gt.m; ++j) {
-			assert((gt.rcds[i].allele[j] >> 1) < this->n_alleles);
+			genotype[j] = YON_GT_RCD_ALLELE_UNPACK(rcds[i].allele[j]);
+			assert(genotype[j] < this->n_alleles);
 			// Add allelic counts.
-			this->alleles[gt.rcds[i].allele[j] >> 1] += gt.rcds[i].run_length;
+			this->alleles[genotype[j]] += rcds[i].run_length;
 			// Add strand-specific (ploidy-aware) alleleic counts.
-			this->alleles_strand[j][gt.rcds[i].allele[j] >> 1] += gt.rcds[i].run_length;
+			this->alleles_strand[j * this->n_alleles + genotype[j]] += rcds[i].run_length;
 		}
+		this->AddGenotype(genotype, rcds[i].run_length);
+	}
+	return(*this);
+}
 
-		// Update remainder.
-		for (uint32_t j = 1; j < gt.m; ++j) {
-			target = &target->children[gt.rcds[i].allele[j] >> 1];
-			target->n_cnt += gt.rcds[i].run_length;
-		}
+yon_gt_summary& yon_gt_summary::operator+=(const yon_gt_summary& other) {
+	assert(this->n_ploidy == other.n_ploidy && this->n_alleles == other.n_alleles);
+
+	if (this->n_cells) {
+		uint64_t* __restrict__ dst = this->genotypes;
+		const uint64_t* __restrict__ src = other.genotypes;
+		for (uint32_t i = 0; i < this->n_cells; ++i) dst[i] += src[i];
+	} else {
+		for (uint32_t i = 0; i < other.sparse_counts.size(); ++i)
+			this->AddSparse(&other.sparse_alleles[(uint64_t)i * this->n_ploidy], other.sparse_counts[i]);
 	}
+
+	// Allele counts and allele counts per chromosome are contiguous.
+	uint32_t* __restrict__ dst = this->alleles;
+	const uint32_t* __restrict__ src = other.alleles;
+	const uint32_t n_counts = this->n_alleles * (1 + this->n_ploidy);
+	for (uint32_t i = 0; i < n_counts; ++i) dst[i] += src[i];
+
 	return(*this);
 }
 
-yon_gt_summary& yon_gt_summary::Add(const yon_gt& gt, const uint32_t n_items, const yon_gt_rcd* rcds) {
-	assert(rcds != nullptr);
+bool yon_gt_summary::AddEncoded(const yon_gt& gt) {
+	if (gt.data == nullptr || gt.m != this->n_ploidy)
+		return false;
 
-	// Iterate over available genotype records.
-	uint32_t n_total_rle = 0;
-	for (uint32_t i = 0; i < n_items; ++i) {
-		// Target root node.
-		yon_gt_summary_obj* target = &this->gt[rcds[i].allele[0] >> 1];
-		target->n_cnt += rcds[i].run_length;
+	if (gt.method == 8)
+		return(this->AddEncodedSparse(gt));
 
-		// Iterate over alleles given the base ploidy.
+	if ((gt.method != 1 && gt.method != 2) || gt.m != 2)
+		return false;
+
+	switch(gt.p) {
+	case(1): return(this->AddEncodedDiploid_<uint8_t>(gt));
+	case(2): return(this->AddEncodedDiploid_<uint16_t>(gt));
+	case(4): return(this->AddEncodedDiploid_<uint32_t>(gt));
+	case(8): return(this->AddEncodedDiploid_<uint64_t>(gt));
+	default: return false;
+	}
+}
+
+bool yon_gt_summary::AddEncodedSparse(const yon_gt& gt) {
+	if (gt.n_c > gt.n_s) return false;
+
+	// Validate the alleles of every carrier before adding any counts
+	// such that the summary is left untouched if the list is rejected.
+	uint64_t b_offset = 0;
+	for (uint32_t i = 0; i < gt.n_c; ++i) {
+		SparseGenotypeVarintDecode(gt.data, b_offset);
 		for (uint32_t j = 0; j < gt.m; ++j) {
-			assert((rcds[i].allele[j] >> 1) < this->n_alleles);
-			// Add allelic counts.
-			this->alleles[rcds[i].allele[j] >> 1] += rcds[i].run_length;
-			// Add strand-specific (ploidy-aware) alleleic counts.
-			this->alleles_strand[j][rcds[i].allele[j] >> 1] += rcds[i].run_length;
-			n_total_rle += rcds[i].run_length;
+			if (YON_GT_RCD_ALLELE_UNPACK(gt.data[b_offset + j]) >= this->n_alleles)
+				return false;
 		}
+		b_offset += gt.m;
+	}
 
-		// Update remainder.
-		for (uint32_t j = 1; j < gt.m; ++j) {
-			target = &target->children[rcds[i].allele[j] >> 1];
-			target->n_cnt += rcds[i].run_length;
+	// Samples that are not carriers are homozygous for the
+	// reference allele.
+	uint8_t genotype[256];
+	const uint64_t n_background = gt.n_s - gt.n_c;
+	memset(genotype, YON_GT_RCD_REF, gt.m);
+	this->AddGenotype(genotype, n_background);
+	this->alleles[YON_GT_RCD_REF] += n_background * gt.m;
+	for (uint32_t j = 0; j < gt.m; ++j)
+		this->alleles_strand[j * this->n_alleles + YON_GT_RCD_REF] += n_background;
+
+	b_offset = 0;
+	for (uint32_t i = 0; i < gt.n_c; ++i) {
+		SparseGenotypeVarintDecode(gt.data, b_offset);
+		const uint8_t* alleles = &gt.data[b_offset];
+		b_offset += gt.m;
+
+		for (uint32_t j = 0; j < gt.m; ++j)
+			genotype[j] = YON_GT_RCD_ALLELE_UNPACK(alleles[j]);
+
+		this->AddGenotype(genotype, 1);
+		for (uint32_t j = 0; j < gt.m; ++j) {
+			++this->alleles[genotype[j]];
+			++this->alleles_strand[j * this->n_alleles + genotype[j]];
 		}
 	}
-	return(*this);
+	return true;
 }
 
 std::vector<uint64_t> yon_gt_summary::GetAlleleCounts(void) const {
@@ -903,60 +1450,37 @@ std::vector< std::vector<uint64_t> > yon_gt_summary::GetAlleleStrandCounts(void)
 	std::vector< std::vector<uint64_t> > c_allele(this->n_ploidy, std::vector<uint64_t>(this->n_alleles));
 	for (uint32_t i = 0; i < this->n_ploidy; ++i) {
 		for (uint32_t j = 0; j < this->n_alleles; ++j) {
-			c_allele[i][j] = this->alleles_strand[i][j];
+			c_allele[i][j] = this->GetAlleleStrandCount(i, j);
 		}
 	}
 
 	return(c_allele);
 }
 
-bool yon_gt_summary::GetGenotype(std::vector<uint64_t>& data,
-                                 yon_gt_summary_obj* target,
-                                 uint8_t depth) const
-{
-	if (depth + 1 == this->n_ploidy) {
-		assert(target->children != nullptr);
-		for (uint32_t i = 0; i < this->n_alleles; ++i) {
-			if (target->children[i].n_cnt != 0) {
-				data.push_back(target->children[i].n_cnt);
-			}
-		}
-		return false;
-	}
-
-	for (uint32_t i = 0; i < this->n_alleles; ++i) {
-		this->GetGenotype(data, &target->children[i], depth + 1);
-	}
-
-	return(true);
-}
-
-// Todo: unfinished.
 std::vector<yon_gt_rcd> yon_gt_summary::GetGenotypeCounts(bool drop_empty) const {
 	std::vector<yon_gt_rcd> genotypes;
+	uint8_t genotype[256];
 
-	// Traverse the trie and store records when hitting the leafs.
-	std::vector<uint64_t> d;
+	if (this->n_cells) {
+		for (uint32_t i = 0; i < this->n_cells; ++i) {
+			if (drop_empty && this->genotypes[i] == 0) continue;
 
-	// If the target ploidy is greater than one (haploid) we collect
-	// the genotypes by traversing the trie. Otherwise the genotypes
-	// are the allele counts at the roots.
-	if (this->n_ploidy > 1) {
-		for (uint32_t i = 0; i < this->n_alleles; ++i) {
-			//std::cerr << "outer " << i << "/" << (int)this->n_alleles << std::endl;
-			this->GetGenotype(d, &this->gt[i], 1);
+			// Unpack the allele tuple from the tensor position.
+			uint32_t index = i;
+			for (int32_t j = this->n_ploidy - 1; j >= 0; --j) {
+				genotype[j] = YON_GT_RCD_ALLELE_PACK(index % this->n_alleles);
+				index /= this->n_alleles;
+			}
+			genotypes.push_back(yon_gt_rcd(this->genotypes[i], this->n_ploidy, genotype));
 		}
 	} else {
-		for (uint32_t i = 0; i < this->n_alleles; ++i) {
-			if (this->gt[i].n_cnt != 0) {
-				d.push_back(this->gt[i].n_cnt);
-			}
+		for (uint32_t i = 0; i < this->sparse_counts.size(); ++i) {
+			for (uint32_t j = 0; j < this->n_ploidy; ++j)
+				genotype[j] = YON_GT_RCD_ALLELE_PACK(this->sparse_alleles[(uint64_t)i * this->n_ploidy + j]);
+			genotypes.push_back(yon_gt_rcd(this->sparse_counts[i], this->n_ploidy, genotype));
 		}
 	}
-	uint64_t n_total = 0;
-	for (uint32_t i = 0; i < d.size(); ++i)
-		n_total += d[i];
-	std::cerr << "collected: " << d.size() << " total = " << n_total << std::endl;
+
 	return(genotypes);
 }
 
@@ -970,15 +1494,15 @@ std::vector<double> yon_gt_summary::GetStrandBiasAlleles(const bool phred_scale)
 	uint64_t n_cnt_fwd = 0;
 	uint64_t n_cnt_rev = 0;
 	for (uint32_t i = 2; i < this->n_alleles; ++i) {
-		n_cnt_fwd += this->alleles_strand[0][i];
-		n_cnt_rev += this->alleles_strand[1][i];
+		n_cnt_fwd += this->GetAlleleStrandCount(0, i);
+		n_cnt_rev += this->GetAlleleStrandCount(1, i);
 	}
 
 	kt_fisher_exact(
-	this->alleles_strand[0][2], // A: Allele on forward strand
-	this->alleles_strand[1][2], // B: Allele on reverse strand
-	n_cnt_fwd - this->alleles_strand[0][2], // C: Not allele on forward strand
-	n_cnt_rev - this->alleles_strand[1][2], // D: Not allele on reverse strand
+	this->GetAlleleStrandCount(0, 2), // A: Allele on forward strand
+	this->GetAlleleStrandCount(1, 2), // B: Allele on reverse strand
+	n_cnt_fwd - this->GetAlleleStrandCount(0, 2), // C: Not allele on forward strand
+	n_cnt_rev - this->GetAlleleStrandCount(1, 2), // D: Not allele on reverse strand
 	&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
 
 	if (phred_scale) strand_bias_p_values.push_back(std::abs(-10 * log10(fisher_twosided_p)));
@@ -988,10 +1512,10 @@ std::vector<double> yon_gt_summary::GetStrandBiasAlleles(const bool phred_scale)
 	if (this->n_alleles - 2 > 2) {
 		for (uint32_t p = 3; p < this->n_alleles; ++p) {
 			kt_fisher_exact(
-			this->alleles_strand[0][p], // A: Allele on forward strand
-			this->alleles_strand[1][p], // B: Allele on reverse strand
-			n_cnt_fwd - this->alleles_strand[0][p], // C: Not allele on forward strand
-			n_cnt_rev - this->alleles_strand[1][p], // D: Not allele on reverse strand
+			this->GetAlleleStrandCount(0, p), // A: Allele on forward strand
+			this->GetAlleleStrandCount(1, p), // B: Allele on reverse strand
+			n_cnt_fwd - this->GetAlleleStrandCount(0, p), // C: Not allele on forward strand
+			n_cnt_rev - this->GetAlleleStrandCount(1, p), // D: Not allele on reverse strand
 			&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
 
 			if (phred_scale) strand_bias_p_values.push_back(std::abs(-10 * log10(fisher_twosided_p)));
@@ -1004,9 +1528,9 @@ std::vector<double> yon_gt_summary::GetStrandBiasAlleles(const bool phred_scale)
 double yon_gt_summary::CalculateHardyWeinberg(void) const {
 	if (this->n_ploidy != 2 || this->n_alleles - 2 != 2) return -1;
 
-	uint64_t obs_hets = this->gt[2][3].n_cnt + this->gt[3][2].n_cnt; // alts
-	uint64_t obs_hom1 = this->gt[2][2].n_cnt; // hom ref
-	uint64_t obs_hom2 = this->gt[3][3].n_cnt; // hom alt
+	uint64_t obs_hets = this->GetGenotypeCount(2, 3) + this->GetGenotypeCount(3, 2); // alts
+	uint64_t obs_hom1 = this->GetGenotypeCount(2, 2); // hom ref
+	uint64_t obs_hom2 = this->GetGenotypeCount(3, 3); // hom alt
 
 	uint64_t obs_homc = obs_hom1 < obs_hom2 ? obs_hom2 : obs_hom1;
 	uint64_t obs_homr = obs_hom1 < obs_hom2 ? obs_hom1 : obs_hom2;
@@ -1075,16 +1599,40 @@ double yon_gt_summary::CalculateHardyWeinberg(void) const {
 	return(p_hwe);
 }
 
-bool yon_gt_summary::LazyEvaluate(void) {
-	// Delete previous data without consideration.
-	delete this->d;
-	this->d = new yon_gt_summary_rcd;
+bool yon_gt_summary::LazyEvaluate(const bool hypothesis_tests) {
+	// Reuse the previous evaluation if available.
+	if (this->d == nullptr) {
+		// Evaluations served from an arena can only be reused while an
+		// arena is attached.
+		if (this->d_unused != nullptr && this->d_unused->is_arena && this->arena == nullptr) {
+			ReleaseEvaluation(this->d_unused);
+			this->d_unused = nullptr;
+		}
+
+		if (this->d_unused != nullptr) this->d = this->d_unused;
+		else if (this->arena != nullptr) {
+			this->d = this->arena->Construct<yon_gt_summary_rcd>(1);
+			this->d->is_arena = true;
+		} else this->d = new yon_gt_summary_rcd;
+		this->d_unused = nullptr;
+	}
 
 	// Allele count and frequency
 	this->d->n_ploidy = this->n_ploidy;
-	this->d->n_ac_af  = this->n_alleles;
-	this->d->ac       = new uint32_t[this->n_alleles];
-	this->d->af       = new float[this->n_alleles];
+	if (this->d->ac == nullptr || this->d->n_ac_af != this->n_alleles) {
+		if (this->d->is_arena) {
+			this->d->ac = this->arena->Allocate<uint32_t>(this->n_alleles);
+			this->d->af = this->arena->Allocate<float>(this->n_alleles);
+		} else {
+			delete [] this->d->ac;
+			delete [] this->d->af;
+			this->d->ac = new uint32_t[this->n_alleles];
+			this->d->af = new float[this->n_alleles];
+		}
+	}
+	this->d->n_ac_af = this->n_alleles;
+	this->d->f_pic   = 0;
+	this->d->heterozygosity = 0;
 
 	uint64_t n_total = 0;
 	for (uint32_t i = 0; i < 2; ++i) this->d->ac[i] = this->alleles[i];
@@ -1106,63 +1654,74 @@ bool yon_gt_summary::LazyEvaluate(void) {
 	this->d->nm  = n_total;
 	this->d->an  = n_total + this->d->ac[0];
 
-	if (n_total)
+	if (n_total == 0)
+		this->d->hwe_p = 1;
+	else if (hypothesis_tests)
 		this->d->hwe_p = this->CalculateHardyWeinberg();
 	else
-		this->d->hwe_p = 1;
+		this->d->hwe_p = -1;
 
 	// Strand-specific bias and inbreeding coefficient (F-statistic)
 	if (this->n_ploidy == 2) {
 		// Total number of genotypes is the sum of the root
 		// nodes excluding special missing and sentinel node
 		// (0 and 1).
-		const uint32_t n_total_gt = (this->gt[2][2].n_cnt + this->gt[2][3].n_cnt + this->gt[3][2].n_cnt + this->gt[3][3].n_cnt);
+		const uint32_t n_total_gt = (this->GetGenotypeCount(2, 2) + this->GetGenotypeCount(2, 3) + this->GetGenotypeCount(3, 2) + this->GetGenotypeCount(3, 3));
 
 		if (n_total_gt)
-			this->d->heterozygosity = ((double)this->gt[2][3].n_cnt + this->gt[3][2].n_cnt) / n_total_gt;
+			this->d->heterozygosity = ((double)this->GetGenotypeCount(2, 3) + this->GetGenotypeCount(3, 2)) / n_total_gt;
 		else
 			this->d->heterozygosity = 0;
 
-		uint8_t n_fs_used = (this->n_alleles - 2 == 2 ? 1 : this->n_alleles - 2);
-		this->d->n_fs = n_fs_used;
-		this->d->fs_a = new float[n_fs_used];
-		double fisher_left_p, fisher_right_p, fisher_twosided_p;
-		uint64_t n_cnt_fwd = 0;
-		uint64_t n_cnt_rev = 0;
-		for (uint32_t i = 2; i < this->n_alleles; ++i) {
-			n_cnt_fwd += this->alleles_strand[0][i];
-			n_cnt_rev += this->alleles_strand[1][i];
-		}
+		// Strand bias of every alternative allele.
+		if (hypothesis_tests) {
+			uint8_t n_fs_used = (this->n_alleles - 2 == 2 ? 1 : this->n_alleles - 2);
+			if (this->d->fs_a == nullptr || this->d->n_fs != n_fs_used) {
+				if (this->d->is_arena) this->d->fs_a = this->arena->Allocate<float>(n_fs_used);
+				else {
+					delete [] this->d->fs_a;
+					this->d->fs_a = new float[n_fs_used];
+				}
+			}
+			this->d->n_fs = n_fs_used;
+			double fisher_left_p, fisher_right_p, fisher_twosided_p;
+			uint64_t n_cnt_fwd = 0;
+			uint64_t n_cnt_rev = 0;
+			for (uint32_t i = 2; i < this->n_alleles; ++i) {
+				n_cnt_fwd += this->GetAlleleStrandCount(0, i);
+				n_cnt_rev += this->GetAlleleStrandCount(1, i);
+			}
+
+			kt_fisher_exact(
+			this->GetAlleleStrandCount(0, 2), // A: Allele on forward strand
+			this->GetAlleleStrandCount(1, 2), // B: Allele on reverse strand
+			n_cnt_fwd - this->GetAlleleStrandCount(0, 2), // C: Not allele on forward strand
+			n_cnt_rev - this->GetAlleleStrandCount(1, 2), // D: Not allele on reverse strand
+			&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
 
-		kt_fisher_exact(
-		this->alleles_strand[0][2], // A: Allele on forward strand
-		this->alleles_strand[1][2], // B: Allele on reverse strand
-		n_cnt_fwd - this->alleles_strand[0][2], // C: Not allele on forward strand
-		n_cnt_rev - this->alleles_strand[1][2], // D: Not allele on reverse strand
-		&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
-
-		this->d->fs_a[0] = std::abs(-10 * log10(fisher_twosided_p));
-
-		// If n_alleles = 2 then they are identical because of symmetry
-		uint8_t pos = 1;
-		if (this->n_alleles - 2 > 2) {
-			for (uint32_t p = 3; p < this->n_alleles; ++p) {
-				kt_fisher_exact(
-				this->alleles_strand[0][p], // A: Allele on forward strand
-				this->alleles_strand[1][p], // B: Allele on reverse strand
-				n_cnt_fwd - this->alleles_strand[0][p], // C: Not allele on forward strand
-				n_cnt_rev - this->alleles_strand[1][p], // D: Not allele on reverse strand
-				&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
-
-				this->d->fs_a[pos++] = std::abs(-10 * log10(fisher_twosided_p));
+			this->d->fs_a[0] = std::abs(-10 * log10(fisher_twosided_p));
+
+			// If n_alleles = 2 then they are identical because of symmetry
+			uint8_t pos = 1;
+			if (this->n_alleles - 2 > 2) {
+				for (uint32_t p = 3; p < this->n_alleles; ++p) {
+					kt_fisher_exact(
+					this->GetAlleleStrandCount(0, p), // A: Allele on forward strand
+					this->GetAlleleStrandCount(1, p), // B: Allele on reverse strand
+					n_cnt_fwd - this->GetAlleleStrandCount(0, p), // C: Not allele on forward strand
+					n_cnt_rev - this->GetAlleleStrandCount(1, p), // D: Not allele on reverse strand
+					&fisher_left_p, &fisher_right_p, &fisher_twosided_p);
+
+					this->d->fs_a[pos++] = std::abs(-10 * log10(fisher_twosided_p));
+				}
 			}
-		}
+		} else this->d->n_fs = 0;
 
 		if (n_total_gt) {
 			// Allele frequency of A
-			const double p = ((double)2*this->gt[2][2].n_cnt + this->gt[2][3].n_cnt + this->gt[3][2].n_cnt) / (2*n_total_gt);
+			const double p = ((double)2*this->GetGenotypeCount(2, 2) + this->GetGenotypeCount(2, 3) + this->GetGenotypeCount(3, 2)) / (2*n_total_gt);
 			// Genotype frequency of heterozyotes
-			const double pg = ((double)this->gt[2][3].n_cnt + this->gt[3][2].n_cnt) / n_total_gt;
+			const double pg = ((double)this->GetGenotypeCount(2, 3) + this->GetGenotypeCount(3, 2)) / n_total_gt;
 			// Expected heterozygosity
 			const double exp = 2*p*(1-p);
 			// Population inbreeding coefficient: F
@@ -1174,6 +1733,61 @@ bool yon_gt_summary::LazyEvaluate(void) {
 	return true;
 }
 
+// Cumulative sums of set memberships over samples: every row is the
+// previous row plus the memberships of the next sample in the given
+// ordering. Rows are added element-wise over all groupings. The first
+// row is read and not written such that a range of rows can be rebuilt
+// from the row preceding it.
+static inline void OccPrefixSums_(const uint8_t* __restrict table,
+                                  const uint32_t* __restrict ordering,
+                                  const uint32_t n_samples,
+                                  const uint32_t stride,
+                                  uint32_t* __restrict occ)
+{
+	for (uint32_t j = 0; j < n_samples; ++j) {
+		const uint8_t* __restrict member = &table[(uint64_t)ordering[j] * stride];
+		const uint32_t* __restrict prev  = &occ[(uint64_t)j * stride];
+		uint32_t* __restrict cur = &occ[(uint64_t)(j + 1) * stride];
+		for (uint32_t g = 0; g < stride; ++g)
+			cur[g] = prev[g] + member[g];
+	}
+}
+
+static void OccPrefixSumsDefault(const uint8_t* table, const uint32_t* ordering, const uint32_t n_samples, const uint32_t stride, uint32_t* occ) {
+	OccPrefixSums_(table, ordering, n_samples, stride, occ);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2")))
+static void OccPrefixSumsAvx2(const uint8_t* table, const uint32_t* ordering, const uint32_t n_samples, const uint32_t stride, uint32_t* occ) {
+	OccPrefixSums_(table, ordering, n_samples, stride, occ);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void OccPrefixSumsAvx512(const uint8_t* table, const uint32_t* ordering, const uint32_t n_samples, const uint32_t stride, uint32_t* occ) {
+	OccPrefixSums_(table, ordering, n_samples, stride, occ);
+}
+#endif
+
+typedef void (*yon_occ_prefix_func)(const uint8_t*, const uint32_t*, const uint32_t, const uint32_t, uint32_t*);
+
+// Select the prefix sum kernel once for the lifetime of the process.
+static yon_occ_prefix_func SelectOccPrefixSums(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) return(&OccPrefixSumsAvx512);
+	if (__builtin_cpu_supports("avx2")) return(&OccPrefixSumsAvx2);
+#endif
+	return(&OccPrefixSumsDefault);
+}
+
+static void OccPrefixSums(const uint8_t* table, const uint32_t* ordering, const uint32_t n_samples, const uint32_t stride, uint32_t* occ) {
+	static const yon_occ_prefix_func func = SelectOccPrefixSums();
+	(*func)(table, ordering, n_samples, stride, occ);
+}
+
+yon_occ::yon_occ() : n_groups(0), n_samples(0), stride(0), built(false), permuted(false) {}
+
 bool yon_occ::ReadTable(const std::string file_name,
                         const yon_vnt_hdr_t& header,
                         const char delimiter)
@@ -1185,12 +1799,13 @@ bool yon_occ::ReadTable(const std::string file_name,
 		return false;
 	}
 
-	uint32_t n_line = 0;
+	// Pairs of (sample, grouping) memberships. The number of groupings
+	// is not known until the entire file has been read.
+	std::vector< std::pair<uint32_t, uint32_t> > members;
+
 	std::string line;
 	// Iterate over available lines in the input file.
 	while (getline(f, line)) {
-		//std::cerr << line << std::endl;
-
 		// Tokenize string with delimiter.
 		std::vector<std::string> params = utility::split(line, delimiter, false);
 
@@ -1206,84 +1821,69 @@ bool yon_occ::ReadTable(const std::string file_name,
 			map_type::const_iterator it = this->map.find(params[i]);
 			if (it == this->map.end()) {
 				// Not already set
-				this->table.push_back(std::vector<uint32_t>(header.GetNumberSamples() + 1, 0));
-				this->table.back()[sample_id + 1] = true;
+				members.push_back(std::pair<uint32_t, uint32_t>(sample_id, this->row_names.size()));
 				this->map[params[i]] = this->row_names.size();
 				this->row_names.push_back(params[i]);
-				//std::cerr << "Adding group: " << params[i] << " for " << this->table.back().size() << " samples" << std::endl;
 			} else {
 				// Already set
-				this->table[it->second][sample_id + 1] = true;
+				members.push_back(std::pair<uint32_t, uint32_t>(sample_id, it->second));
 			}
 		}
 	}
 
+	this->n_groups  = this->row_names.size();
+	this->n_samples = header.GetNumberSamples();
+	this->stride    = (this->n_groups + YON_OCC_LANES - 1) / YON_OCC_LANES * YON_OCC_LANES;
+	this->built     = false;
+	this->table.assign((uint64_t)this->n_samples * this->stride, 0);
+	for (uint32_t i = 0; i < members.size(); ++i)
+		this->table[(uint64_t)members[i].first * this->stride + members[i].second] = true;
+
 	return true;
 }
 
 bool yon_occ::BuildTable(void) {
-	this->occ.clear();
-	this->vocc.clear();
-	if (this->table.size() == 0) {
-		return false;
-	}
-
-	this->occ = std::vector< std::vector<uint32_t> >(this->table.size(), std::vector<uint32_t>( this->table[0].size(), 0));
-	this->cum_sums = std::vector< uint32_t >( this->occ.size() );
-
-	for (uint32_t i = 0; i < this->table.size(); ++i) {
-		assert(this->table[i][0] == 0);
-		for (uint32_t j = 1; j < this->occ[i].size(); ++j)
-			this->occ[i][j] += this->occ[i][j-1] + this->table[i][j];
-
-		this->cum_sums[i] = this->occ[i].back();
-	}
-
-	// Matrix transpose for faster random access lookups.
-	this->vocc = std::vector< std::vector<uint32_t> >(this->table[0].size() , std::vector<uint32_t>(this->occ.size(), 0));
-	for (int i = 0; i < this->table[0].size(); ++i) {
-		for (int j = 0; j < this->occ.size(); ++j) {
-			vocc[i][j] = occ[j][i];
-		}
-	}
-
-	return true;
+	return(this->BuildTable(nullptr));
 }
 
 bool yon_occ::BuildTable(const yon_gt_ppa* ppa_p) {
-	if (ppa_p == nullptr)
-		return(this->BuildTable());
-
-	this->occ.clear();
-	this->vocc.clear();
-	if (this->table.size() == 0) {
+	if (this->n_groups == 0)
 		return false;
-	}
-
-	// Convert pointer to reference.
-	const yon_gt_ppa& ppa = *ppa_p;
 
-	assert(ppa.n_s + 1 == this->table[0].size());
+	assert(ppa_p == nullptr || ppa_p->n_s == this->n_samples);
+	const uint32_t* ordering_p = (ppa_p != nullptr ? ppa_p->ordering : nullptr);
+	this->permuted = (ppa_p != nullptr);
 
-	this->occ = std::vector< std::vector<uint32_t> >(this->table.size(), std::vector<uint32_t>( this->table[0].size(), 0));
-	this->cum_sums = std::vector< uint32_t >( this->occ.size() );
+	if (this->built == false) {
+		this->ordering.resize(this->n_samples);
+		for (uint32_t i = 0; i < this->n_samples; ++i)
+			this->ordering[i] = (ordering_p != nullptr ? ordering_p[i] : i);
 
-	for (uint32_t i = 0; i < this->table.size(); ++i) {
-		assert(this->table[i][0] == 0);
-		for (uint32_t j = 1; j < this->occ[i].size(); ++j)
-			this->occ[i][j] += this->occ[i][j - 1] + this->table[i][ppa[j - 1] + 1];
+		this->occ.resize((uint64_t)(this->n_samples + 1) * this->stride);
+		memset(this->occ.data(), 0, sizeof(uint32_t)*this->stride);
+		OccPrefixSums(this->table.data(), this->ordering.data(), this->n_samples, this->stride, this->occ.data());
 
-		assert(this->occ[i][0] == 0);
-		this->cum_sums[i] = this->occ[i].back();
+		const uint32_t* totals = this->GetRow(this->n_samples);
+		this->cum_sums.assign(totals, totals + this->n_groups);
+		this->built = true;
+		return true;
 	}
 
-	// Matrix transpose for faster random access lookups.
-	this->vocc = std::vector< std::vector<uint32_t> >(this->table[0].size() , std::vector<uint32_t>(this->occ.size(), 0));
-	for (int i = 0; i < this->table[0].size(); ++i) {
-		for (int j = 0; j < this->occ.size(); ++j) {
-			vocc[i][j] = occ[j][i];
-		}
-	}
+	// Only rows between the first and the last sample offset that moved
+	// change: the samples preceding any other offset are the same set
+	// in both orderings. The table is retained if nothing moved.
+	uint32_t from = 0, to = this->n_samples;
+	while (from < to && this->ordering[from] == (ordering_p != nullptr ? ordering_p[from] : from)) ++from;
+	while (to > from && this->ordering[to - 1] == (ordering_p != nullptr ? ordering_p[to - 1] : to - 1)) --to;
+	if (from == to)
+		return true;
+
+	for (uint32_t i = from; i < to; ++i)
+		this->ordering[i] = (ordering_p != nullptr ? ordering_p[i] : i);
+
+	// Rebuild rows (from, to] from row from. Row to is unchanged but
+	// rebuilding it keeps the kernel simple.
+	OccPrefixSums(this->table.data(), &this->ordering[from], to - from, this->stride, &this->occ[(uint64_t)from * this->stride]);
 
 	return true;
 }
@@ -122,6 +122,67 @@ bool yon_vnt_hdr_t::BuildMaps(void) {
 	return true;
 }
 
+bool yon_vnt_hdr_t::IsCompatible(const self_type& other) const {
+	if (this->samples_ != other.samples_) {
+		std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different samples..." << std::endl;
+		return false;
+	}
+
+	if (this->contigs_.size() != other.contigs_.size()) {
+		std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have a different number of contigs (" << this->contigs_.size() << " != " << other.contigs_.size() << ")..." << std::endl;
+		return false;
+	}
+	for (uint32_t i = 0; i < this->contigs_.size(); ++i) {
+		if (this->contigs_[i].name != other.contigs_[i].name || this->contigs_[i].n_bases != other.contigs_[i].n_bases) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different contigs at offset " << i << " (" << this->contigs_[i].name << " != " << other.contigs_[i].name << ")..." << std::endl;
+			return false;
+		}
+	}
+
+	if (this->info_fields_.size() != other.info_fields_.size()) {
+		std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have a different number of Info fields (" << this->info_fields_.size() << " != " << other.info_fields_.size() << ")..." << std::endl;
+		return false;
+	}
+	for (uint32_t i = 0; i < this->info_fields_.size(); ++i) {
+		if (this->info_fields_[i].id != other.info_fields_[i].id || this->info_fields_[i].type != other.info_fields_[i].type) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different Info fields at offset " << i << " (" << this->info_fields_[i].id << " != " << other.info_fields_[i].id << ")..." << std::endl;
+			return false;
+		}
+		if (this->info_fields_[i].number != other.info_fields_[i].number) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different Number for Info field " << this->info_fields_[i].id << " (" << this->info_fields_[i].number << " != " << other.info_fields_[i].number << ")..." << std::endl;
+			return false;
+		}
+	}
+
+	if (this->format_fields_.size() != other.format_fields_.size()) {
+		std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have a different number of Format fields (" << this->format_fields_.size() << " != " << other.format_fields_.size() << ")..." << std::endl;
+		return false;
+	}
+	for (uint32_t i = 0; i < this->format_fields_.size(); ++i) {
+		if (this->format_fields_[i].id != other.format_fields_[i].id || this->format_fields_[i].type != other.format_fields_[i].type) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different Format fields at offset " << i << " (" << this->format_fields_[i].id << " != " << other.format_fields_[i].id << ")..." << std::endl;
+			return false;
+		}
+		if (this->format_fields_[i].number != other.format_fields_[i].number) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different Number for Format field " << this->format_fields_[i].id << " (" << this->format_fields_[i].number << " != " << other.format_fields_[i].number << ")..." << std::endl;
+			return false;
+		}
+	}
+
+	if (this->filter_fields_.size() != other.filter_fields_.size()) {
+		std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have a different number of Filter fields (" << this->filter_fields_.size() << " != " << other.filter_fields_.size() << ")..." << std::endl;
+		return false;
+	}
+	for (uint32_t i = 0; i < this->filter_fields_.size(); ++i) {
+		if (this->filter_fields_[i].id != other.filter_fields_[i].id) {
+			std::cerr << utility::timestamp("ERROR", "HEADER") << "Headers have different Filter fields at offset " << i << " (" << this->filter_fields_[i].id << " != " << other.filter_fields_[i].id << ")..." << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool yon_vnt_hdr_t::RecodeIndices(void) {
 	for (uint32_t i = 0; i < this->contigs_.size(); ++i)       this->contigs_[i].idx = i;
 	for (uint32_t i = 0; i < this->info_fields_.size(); ++i)   this->info_fields_[i].idx = i;
@@ -380,6 +441,19 @@ void yon_vnt_hdr_t::AddGenotypeAnnotationFields(const std::vector<std::string>&
 			this->info_fields_.push_back(npm);
 		}
 
+		info = this->GetInfo(group_names[i] + "_HWE_CHISQ_P");
+		if (info == nullptr) {
+			YonInfo npm;
+			npm.id = group_names[i] + "_HWE_CHISQ_P";
+			npm.number = "1";
+			npm.type = "Float";
+			npm.yon_type = YON_VCF_HEADER_FLOAT;
+			npm.description = "\"Hardy-Weinberg equilibrium chi-squared P-value\"";
+			npm.idx = this->info_fields_.size();
+			this->literals_ += npm.ToVcfString(false) + "\n";
+			this->info_fields_.push_back(npm);
+		}
+
 		info = this->GetInfo(group_names[i] + "_AC");
 		if (info == nullptr) {
 			YonInfo npm;
@@ -0,0 +1,444 @@
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "linkage_disequilibrium.h"
+#include "utility.h"
+
+namespace tachyon {
+
+// Bits of the first and second allele of every sample.
+const uint64_t YON_LD_EVEN = 0x5555555555555555ULL;
+const uint64_t YON_LD_ODD  = 0xAAAAAAAAAAAAAAAAULL;
+
+static uint64_t PopcountAndDefault(const uint64_t* __restrict a, const uint64_t* __restrict b, const uint32_t n_words) {
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < n_words; ++i)
+		count += __builtin_popcountll(a[i] & b[i]);
+	return(count);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// Popcount of 256-bit words by looking up the count of every nibble
+// with a byte shuffle and summing the bytes with SAD. Counts of at most
+// 8 bits per byte are accumulated for at most 31 words before being
+// widened to avoid overflow.
+__attribute__((target("avx2")))
+static uint64_t PopcountAndAvx2(const uint64_t* __restrict a, const uint64_t* __restrict b, const uint32_t n_words) {
+	const __m256i lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+	                                        0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0F);
+	__m256i total = _mm256_setzero_si256();
+
+	uint32_t i = 0;
+	while (i + 4 <= n_words) {
+		__m256i local = _mm256_setzero_si256();
+		for (uint32_t k = 0; k < 31 && i + 4 <= n_words; ++k, i += 4) {
+			const __m256i v  = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&a[i])),
+			                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&b[i])));
+			const __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask));
+			const __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+			local = _mm256_add_epi8(local, _mm256_add_epi8(lo, hi));
+		}
+		total = _mm256_add_epi64(total, _mm256_sad_epu8(local, _mm256_setzero_si256()));
+	}
+
+	uint64_t count = _mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+	                 _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3);
+	for (; i < n_words; ++i)
+		count += __builtin_popcountll(a[i] & b[i]);
+	return(count);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static uint64_t PopcountAndAvx512(const uint64_t* __restrict a, const uint64_t* __restrict b, const uint32_t n_words) {
+	__m512i total = _mm512_setzero_si512();
+	uint32_t i = 0;
+	for (; i + 8 <= n_words; i += 8) {
+		const __m512i v = _mm512_and_si512(_mm512_loadu_si512(&a[i]), _mm512_loadu_si512(&b[i]));
+		total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+	}
+
+	uint64_t count = _mm512_reduce_add_epi64(total);
+	for (; i < n_words; ++i)
+		count += __builtin_popcountll(a[i] & b[i]);
+	return(count);
+}
+#endif
+
+typedef uint64_t (*yon_ld_popcount_func)(const uint64_t*, const uint64_t*, const uint32_t);
+
+// Select the popcount kernel once for the lifetime of the process.
+static yon_ld_popcount_func SelectPopcountAnd(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512vpopcntdq")) return(&PopcountAndAvx512);
+	if (__builtin_cpu_supports("avx2")) return(&PopcountAndAvx2);
+#endif
+	return(&PopcountAndDefault);
+}
+
+// Number of set bits in the intersection of two bitmaps.
+static inline uint64_t PopcountAnd(const uint64_t* a, const uint64_t* b, const uint32_t n_words) {
+	static const yon_ld_popcount_func func = SelectPopcountAnd();
+	return((*func)(a, b, n_words));
+}
+
+static inline uint64_t Popcount(const std::vector<uint64_t>& bits) {
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < bits.size(); ++i)
+		count += __builtin_popcountll(bits[i]);
+	return(count);
+}
+
+// Set or clear the bits of pattern in the range [from, to).
+static void SetBits(uint64_t* bits, uint64_t from, const uint64_t to, const uint64_t pattern, const bool set) {
+	while (from < to) {
+		const uint64_t word = from >> 6;
+		const uint64_t end  = std::min(to, (word + 1) << 6);
+		const uint64_t n    = end - from;
+		const uint64_t mask = (n == 64 ? ~0ULL : (((1ULL << n) - 1) << (from & 63))) & pattern;
+		if (set) bits[word] |= mask;
+		else bits[word] &= ~mask;
+		from = end;
+	}
+}
+
+bool yon_ld_bitmap::Build(yon_gt& gt, const TACHYON_LD_MODE mode) {
+	if (gt.m != 2) {
+		std::cerr << utility::timestamp("ERROR","LD") << "Bitmaps can only be built for diploid records..." << std::endl;
+		return false;
+	}
+
+	const uint64_t n_haps  = 2 * (uint64_t)gt.n_s;
+	const uint32_t n_words = (n_haps + 63) / 64;
+	this->n_pad = n_words * 64 - n_haps;
+	this->alt.assign(n_words, 0);
+	this->valid.assign(n_words, 0);
+	SetBits(this->valid.data(), 0, n_haps, ~0ULL, true);
+
+	// Diploid runs are decoded into arrays without allocating records.
+	const bool runs = (gt.method == 1 || gt.method == 2);
+	if (runs) {
+		if (gt.EvaluateSoa() == false) return false;
+	} else if ((gt.eval_cont & YON_GT_UN_RCDS) == false) {
+		if (gt.Evaluate() == false) return false;
+	}
+
+	const uint32_t n_runs = runs ? gt.soa.n : gt.n_i;
+	uint64_t n_total = 0;
+	for (uint32_t i = 0; i < n_runs; ++i) {
+		const uint32_t length = runs ? gt.soa.run_length[i] : gt.rcds[i].run_length;
+		const uint8_t  a0 = (runs ? gt.soa.allele0[i] : gt.rcds[i].allele[0]) >> 1;
+		const uint8_t  a1 = (runs ? gt.soa.allele1[i] : gt.rcds[i].allele[1]) >> 1;
+		if (n_total + length > gt.n_s) return false;
+
+		const uint64_t from = 2 * n_total, to = 2 * (n_total + length);
+		n_total += length;
+
+		// Missing alleles and EOV are not observed.
+		if (mode == YON_LD_GENOTYPE && (a0 < 2 || a1 < 2)) {
+			SetBits(this->valid.data(), from, to, ~0ULL, false);
+			continue;
+		}
+		if (a0 < 2) SetBits(this->valid.data(), from, to, YON_LD_EVEN, false);
+		if (a1 < 2) SetBits(this->valid.data(), from, to, YON_LD_ODD, false);
+
+		const uint64_t pattern = (a0 >= 3 ? YON_LD_EVEN : 0) | (a1 >= 3 ? YON_LD_ODD : 0);
+		if (pattern) SetBits(this->alt.data(), from, to, pattern, true);
+	}
+	if (n_total != gt.n_s) return false;
+
+	this->n_alt   = Popcount(this->alt);
+	this->n_valid = Popcount(this->valid);
+	this->n_hom   = 0;
+
+	if (mode == YON_LD_GENOTYPE) {
+		this->swap.resize(n_words);
+		this->hom.resize(n_words);
+		for (uint32_t i = 0; i < n_words; ++i) {
+			const uint64_t w = this->alt[i];
+			this->swap[i] = ((w >> 1) & YON_LD_EVEN) | ((w & YON_LD_EVEN) << 1);
+			this->hom[i]  = w & (w >> 1) & YON_LD_EVEN;
+		}
+		this->n_hom = Popcount(this->hom);
+	}
+
+	return true;
+}
+
+void yon_ld_bitmap::Permute(const uint32_t* from, const uint32_t* inverse, const TACHYON_LD_MODE mode, std::vector<uint64_t>& scratch) {
+	const uint32_t n_words   = this->alt.size();
+	const uint32_t n_samples = (n_words * 64 - this->n_pad) / 2;
+
+	// Samples never straddle words as both alleles are stored in
+	// adjacent bits starting at an even offset.
+	std::vector<uint64_t>* bitmaps[2] = {&this->alt, &this->valid};
+	for (uint32_t k = 0; k < 2; ++k) {
+		const uint64_t* src = bitmaps[k]->data();
+		scratch.assign(n_words, 0);
+		for (uint32_t i = 0; i < n_samples; ++i) {
+			const uint32_t sample = from != nullptr ? from[i] : i;
+			const uint32_t j = inverse != nullptr ? inverse[sample] : sample;
+			const uint64_t bits = (src[(2*i) >> 6] >> ((2*i) & 63)) & 3;
+			scratch[(2*j) >> 6] |= bits << ((2*j) & 63);
+		}
+		std::swap(*bitmaps[k], scratch);
+	}
+
+	if (mode == YON_LD_GENOTYPE) {
+		for (uint32_t i = 0; i < n_words; ++i) {
+			const uint64_t w = this->alt[i];
+			this->swap[i] = ((w >> 1) & YON_LD_EVEN) | ((w & YON_LD_EVEN) << 1);
+			this->hom[i]  = w & (w >> 1) & YON_LD_EVEN;
+		}
+	}
+}
+
+LinkageDisequilibrium::LinkageDisequilibrium() :
+	n_s(0), n_records(0), n_skipped(0), permuted(false)
+{}
+
+LinkageDisequilibrium::~LinkageDisequilibrium() {
+	for (uint32_t i = 0; i < this->window.size(); ++i) delete this->window[i];
+	for (uint32_t i = 0; i < this->unused.size(); ++i) delete this->unused[i];
+}
+
+bool LinkageDisequilibrium::Open(const uint32_t n_samples, const yon_ld_settings& settings) {
+	if (n_samples == 0) {
+		std::cerr << utility::timestamp("ERROR","LD") << "Linkage disequilibrium requires samples..." << std::endl;
+		return false;
+	}
+
+	while (this->window.size()) {
+		this->unused.push_back(this->window.front());
+		this->window.pop_front();
+	}
+
+	this->n_s       = n_samples;
+	this->n_records = 0;
+	this->n_skipped = 0;
+	this->settings  = settings;
+	this->permuted  = false;
+	this->ordering.resize(n_samples);
+	this->inverse.resize(n_samples);
+	this->pairs.clear();
+	this->records.clear();
+	this->pool.Start(settings.n_threads);
+	return true;
+}
+
+yon_ld_bitmap* LinkageDisequilibrium::AcquireBitmap(void) {
+	if (this->unused.size() == 0) return(new yon_ld_bitmap());
+	yon_ld_bitmap* bitmap = this->unused.back();
+	this->unused.pop_back();
+	return(bitmap);
+}
+
+void LinkageDisequilibrium::SetPermutation(const yon_gt_ppa* ppa) {
+	if (ppa == nullptr && this->permuted == false) return;
+	if (ppa != nullptr && this->permuted &&
+	    memcmp(ppa->ordering, this->ordering.data(), sizeof(uint32_t) * this->n_s) == 0)
+		return;
+
+	if (ppa != nullptr) {
+		for (uint32_t i = 0; i < this->n_s; ++i)
+			this->inverse[ppa->ordering[i]] = i;
+	}
+
+	for (uint32_t i = 0; i < this->window.size(); ++i) {
+		this->window[i]->Permute(this->permuted ? this->ordering.data() : nullptr,
+		                         ppa != nullptr ? this->inverse.data() : nullptr,
+		                         this->settings.mode, this->scratch);
+	}
+
+	if (ppa != nullptr) memcpy(this->ordering.data(), ppa->ordering, sizeof(uint32_t) * this->n_s);
+	this->permuted = (ppa != nullptr);
+}
+
+bool LinkageDisequilibrium::Add(yon1_vc_t& vc) {
+	this->pairs.clear();
+	this->records.clear();
+
+	// Records of a block share a permutation (if any).
+	const yon_gt_ppa* ppa = nullptr;
+	for (uint32_t i = 0; i < vc.size() && ppa == nullptr; ++i) {
+		if (vc[i].is_loaded_gt && vc[i].controller.gt_available && vc[i].gt->ppa != nullptr)
+			ppa = vc[i].gt->ppa;
+	}
+	if (ppa != nullptr && ppa->n_s != this->n_s) {
+		std::cerr << utility::timestamp("ERROR","LD") << "Permutation has " << ppa->n_s << " samples but expected " << this->n_s << "..." << std::endl;
+		return false;
+	}
+	this->SetPermutation(ppa);
+
+	const uint32_t n_old = this->window.size();
+	for (uint32_t i = 0; i < vc.size(); ++i, ++this->n_records) {
+		yon1_vnt_t& rcd = vc[i];
+		if (rcd.is_loaded_gt == false || rcd.controller.gt_available == false || rcd.gt->m != 2) {
+			++this->n_skipped;
+			continue;
+		}
+
+		if (rcd.gt->n_s != this->n_s) {
+			std::cerr << utility::timestamp("ERROR","LD") << "Record has " << rcd.gt->n_s << " samples but expected " << this->n_s << "..." << std::endl;
+			return false;
+		}
+
+		yon_ld_bitmap* bitmap = this->AcquireBitmap();
+		if (bitmap->Build(*rcd.gt, this->settings.mode) == false) {
+			std::cerr << utility::timestamp("ERROR","LD") << "Failed to build bitmaps of record at " << rcd.pos + 1 << "..." << std::endl;
+			this->unused.push_back(bitmap);
+			return false;
+		}
+
+		// Records stored without the permutation of their block.
+		if (rcd.gt->ppa != ppa) {
+			bitmap->Permute(rcd.gt->ppa != nullptr ? rcd.gt->ppa->ordering : nullptr,
+			                ppa != nullptr ? this->inverse.data() : nullptr,
+			                this->settings.mode, this->scratch);
+		}
+
+		bitmap->id  = this->n_records;
+		bitmap->rid = rcd.rid;
+		bitmap->pos = rcd.pos;
+		this->window.push_back(bitmap);
+		this->records.push_back(yon_ld_record(bitmap->id, bitmap->rid, bitmap->pos));
+	}
+
+	const uint32_t n_window = this->window.size();
+	if (n_window == n_old) return true;
+
+	// First record in the window paired with each new record. This is
+	// non-decreasing for sorted records.
+	this->lower.resize(n_window);
+	uint32_t lo = 0;
+	for (uint32_t b = n_old; b < n_window; ++b) {
+		const yon_ld_bitmap* rb = this->window[b];
+		while (lo < b) {
+			const yon_ld_bitmap* ra = this->window[lo];
+			if (ra->rid == rb->rid &&
+			    (this->settings.window_bp == 0 || rb->pos - ra->pos <= this->settings.window_bp) &&
+			    (this->settings.window_records == 0 || rb->id - ra->id <= this->settings.window_records))
+				break;
+			++lo;
+		}
+		this->lower[b] = lo;
+	}
+
+	// Partition the pairs into square tiles such that the bitmaps of
+	// a tile remain in cache while it is computed.
+	this->tiles.clear();
+	for (uint32_t b_from = n_old; b_from < n_window; b_from += YON_LD_TILE_RECORDS) {
+		const uint32_t b_to = std::min(b_from + YON_LD_TILE_RECORDS, n_window);
+		for (uint32_t a_from = this->lower[b_from]; a_from < b_to - 1; a_from += YON_LD_TILE_RECORDS) {
+			yon_ld_tile tile;
+			tile.b_from = b_from;
+			tile.b_to   = b_to;
+			tile.a_from = a_from;
+			tile.a_to   = std::min(a_from + YON_LD_TILE_RECORDS, b_to - 1);
+			this->tiles.push_back(tile);
+		}
+	}
+
+	if (this->tile_pairs.size() < this->tiles.size())
+		this->tile_pairs.resize(this->tiles.size());
+
+	std::atomic<uint32_t> next(0);
+	this->pool.Run([this, &next](const uint32_t) {
+		uint32_t t;
+		while ((t = next++) < this->tiles.size())
+			this->ComputeTile(t, this->tile_pairs[t]);
+	});
+
+	for (uint32_t t = 0; t < this->tiles.size(); ++t)
+		this->pairs.insert(this->pairs.end(), this->tile_pairs[t].begin(), this->tile_pairs[t].end());
+
+	std::sort(this->pairs.begin(), this->pairs.end(), [](const yon_ld_pair& x, const yon_ld_pair& y) {
+		return(x.b != y.b ? x.b < y.b : x.a < y.a);
+	});
+
+	// Records preceding the window of the last record are never paired
+	// again.
+	for (uint32_t i = 0; i < this->lower[n_window - 1]; ++i) {
+		this->unused.push_back(this->window.front());
+		this->window.pop_front();
+	}
+
+	return true;
+}
+
+void LinkageDisequilibrium::ComputeTile(const uint32_t t, std::vector<yon_ld_pair>& out) const {
+	const yon_ld_tile& tile = this->tiles[t];
+	out.clear();
+
+	yon_ld_pair pair;
+	for (uint32_t b = tile.b_from; b < tile.b_to; ++b) {
+		const uint32_t a_to = std::min(tile.a_to, b);
+		for (uint32_t a = std::max(tile.a_from, this->lower[b]); a < a_to; ++a) {
+			if (this->Compute(*this->window[a], *this->window[b], pair))
+				out.push_back(pair);
+		}
+	}
+}
+
+bool LinkageDisequilibrium::Compute(const yon_ld_bitmap& a, const yon_ld_bitmap& b, yon_ld_pair& pair) const {
+	const uint32_t n_words  = a.alt.size();
+	const bool     complete = a.IsComplete() && b.IsComplete();
+	const float    nan      = std::numeric_limits<float>::quiet_NaN();
+
+	pair.a = a.id; pair.rid_a = a.rid; pair.pos_a = a.pos;
+	pair.b = b.id; pair.rid_b = b.rid; pair.pos_b = b.pos;
+	pair.r2 = nan; pair.d_prime = nan;
+
+	// Counts restricted to jointly observed alleles. Alternative bits
+	// are only set for observed alleles such that intersecting with the
+	// other record's observed bits suffices.
+	if (this->settings.mode == YON_LD_HAPLOTYPE) {
+		const double n   = complete ? a.n_valid : PopcountAnd(a.valid.data(), b.valid.data(), n_words);
+		const double nA  = complete ? a.n_alt : PopcountAnd(a.alt.data(), b.valid.data(), n_words);
+		const double nB  = complete ? b.n_alt : PopcountAnd(b.alt.data(), a.valid.data(), n_words);
+		const double nAB = PopcountAnd(a.alt.data(), b.alt.data(), n_words);
+		pair.n = n;
+
+		if (n > 0) {
+			const double pA = nA / n, pB = nB / n;
+			const double D  = nAB / n - pA * pB;
+			const double denom = pA * (1 - pA) * pB * (1 - pB);
+			if (denom > 0) {
+				const double d_max = D < 0 ? std::min(pA * pB, (1 - pA) * (1 - pB))
+				                           : std::min(pA * (1 - pB), (1 - pA) * pB);
+				pair.r2      = D * D / denom;
+				pair.d_prime = std::abs(D) / d_max;
+			}
+		}
+	} else {
+		// Dosage correlation: for dosages x = a0 + a1 and y = b0 + b1 the
+		// cross product is sum(a0 b0 + a1 b1) + sum(a0 b1 + a1 b0) and the
+		// squares are the number of alternative alleles plus twice the
+		// number of homozygous alternative samples.
+		const double n   = (complete ? a.n_valid : PopcountAnd(a.valid.data(), b.valid.data(), n_words)) / 2;
+		const double sA  = complete ? a.n_alt : PopcountAnd(a.alt.data(), b.valid.data(), n_words);
+		const double sB  = complete ? b.n_alt : PopcountAnd(b.alt.data(), a.valid.data(), n_words);
+		const double sAA = sA + 2 * (complete ? a.n_hom : PopcountAnd(a.hom.data(), b.valid.data(), n_words));
+		const double sBB = sB + 2 * (complete ? b.n_hom : PopcountAnd(b.hom.data(), a.valid.data(), n_words));
+		const double sAB = PopcountAnd(a.alt.data(), b.alt.data(), n_words) + PopcountAnd(a.alt.data(), b.swap.data(), n_words);
+		pair.n = n;
+
+		const double cov = n * sAB - sA * sB;
+		const double vA  = n * sAA - sA * sA;
+		const double vB  = n * sBB - sB * sB;
+		if (n > 0 && vA > 0 && vB > 0)
+			pair.r2 = cov * cov / (vA * vB);
+	}
+
+	if (this->settings.min_r2 <= 0) return true;
+	return(pair.r2 >= this->settings.min_r2);
+}
+
+}
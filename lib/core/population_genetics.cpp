@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cassert>
+
+#include "population_genetics.h"
+#include "variant_container.h"
+#include "utility.h"
+
+namespace tachyon {
+
+// Log-probabilities within this relative tolerance of the observed
+// table are considered equally likely in exact tests.
+static const double YON_POPGEN_EXACT_TOLERANCE = 1e-7;
+
+PopulationGenetics::PopulationGenetics() : n_records(0), n_groups(0) {}
+
+void PopulationGenetics::Setup(const uint32_t n_records, const uint32_t n_groups) {
+	this->n_records = n_records;
+	this->n_groups  = n_groups;
+
+	const uint64_t n_cells = (uint64_t)n_records * n_groups;
+	this->valid.assign(n_records, false);
+	this->n_rr.assign(n_cells, 0);
+	this->n_ra.assign(n_cells, 0);
+	this->n_ar.assign(n_cells, 0);
+	this->n_aa.assign(n_cells, 0);
+	this->hwe_p.resize(n_cells);
+	this->hwe_chisq_p.resize(n_cells);
+	this->heterozygosity.resize(n_cells);
+	this->f_pic.resize(n_cells);
+	this->fis.resize(n_records);
+	this->fst.resize(n_records);
+	this->fit.resize(n_records);
+}
+
+bool PopulationGenetics::Evaluate(yon1_vc_t& vc, const yon_occ& occ) {
+	if (occ.size() == 0)
+		return false;
+
+	this->Setup(vc.size(), occ.size());
+	for (uint32_t i = 0; i < vc.size(); ++i) {
+		if (vc[i].gt == nullptr || vc[i].gt->Evaluate() == false) continue;
+		this->Tally(i, *vc[i].gt, occ);
+	}
+	this->Compute();
+
+	return true;
+}
+
+bool PopulationGenetics::Tally(const uint32_t record, const yon_gt& gt, const yon_occ& occ) {
+	assert(record < this->n_records);
+	this->valid[record] = false;
+
+	if (gt.m != 2 || gt.n_allele != 2 || gt.rcds == nullptr)
+		return false;
+
+	if (occ.size() != this->n_groups || occ.n_samples != gt.n_s) {
+		std::cerr << utility::timestamp("ERROR","POPGEN") << "Occ table does not match the genotypes..." << std::endl;
+		return false;
+	}
+
+	// Genotype classes are indexed by the ordered alleles with the
+	// first allele in the upper bit.
+	const uint64_t offset = this->GetOffset(record, 0);
+	uint32_t* classes[4] = { &this->n_rr[offset], &this->n_ra[offset], &this->n_ar[offset], &this->n_aa[offset] };
+
+	uint32_t position = 0;
+	for (uint32_t j = 0; j < gt.n_i; ++j) {
+		const yon_gt_rcd& rcd = gt.rcds[j];
+		const uint32_t a = YON_GT_RCD_ALLELE_UNPACK(rcd.allele[0]) - YON_GT_RCD_REF;
+		const uint32_t b = YON_GT_RCD_ALLELE_UNPACK(rcd.allele[1]) - YON_GT_RCD_REF;
+
+		// Genotypes with missing alleles are not counted.
+		if (a < 2 && b < 2) {
+			uint32_t* __restrict dst = classes[(a << 1) | b];
+			const uint32_t* __restrict from = occ.GetRow(position);
+			const uint32_t* __restrict to   = occ.GetRow(position + rcd.run_length);
+			for (uint32_t g = 0; g < this->n_groups; ++g)
+				dst[g] += to[g] - from[g];
+		}
+		position += rcd.run_length;
+	}
+	assert(position == gt.n_s);
+
+	this->valid[record] = true;
+	return true;
+}
+
+void PopulationGenetics::Compute(void) {
+	const uint64_t n_cells = (uint64_t)this->n_records * this->n_groups;
+
+	// Heterozygosity, inbreeding coefficients, and the Hardy-Weinberg
+	// chi-squared statistic are computed over all cells at once.
+	uint32_t n_max = 0;
+	for (uint64_t i = 0; i < n_cells; ++i) {
+		const uint32_t n_het = this->n_ra[i] + this->n_ar[i];
+		const uint32_t n_gt  = this->n_rr[i] + n_het + this->n_aa[i];
+		n_max = std::max(n_max, n_gt);
+
+		const double n   = n_gt;
+		const double p   = n_gt ? (2.0*this->n_rr[i] + n_het) / (2*n) : 0;
+		const double q   = 1 - p;
+		const double obs = n_gt ? n_het / n : 0;
+		const double exp = 2*p*q;
+		this->heterozygosity[i] = obs;
+		this->f_pic[i] = (exp > 0 ? (exp - obs) / exp : 0);
+
+		// Chi-squared statistic with one degree of freedom.
+		const double e_rr  = n*p*p;
+		const double e_het = n*exp;
+		const double e_aa  = n*q*q;
+		double chisq = 0;
+		if (e_rr > 0 && e_het > 0 && e_aa > 0) {
+			chisq = (this->n_rr[i] - e_rr) * (this->n_rr[i] - e_rr) / e_rr
+			      + (n_het - e_het) * (n_het - e_het) / e_het
+			      + (this->n_aa[i] - e_aa) * (this->n_aa[i] - e_aa) / e_aa;
+		}
+		this->hwe_chisq_p[i] = chisq;
+	}
+
+	for (uint64_t i = 0; i < n_cells; ++i)
+		this->hwe_chisq_p[i] = erfc(sqrt(this->hwe_chisq_p[i] / 2));
+
+	// Exact tests share a single table of log-factorials.
+	this->lf.Reserve(2*(uint64_t)n_max);
+	for (uint64_t i = 0; i < n_cells; ++i)
+		this->hwe_p[i] = this->HardyWeinbergExact(this->n_rr[i], this->n_ra[i] + this->n_ar[i], this->n_aa[i]);
+
+	// F-statistics over all groupings: FIS = (HS - HI)/HS,
+	// FST = (HT - HS)/HT, and FIT = (HT - HI)/HT.
+	for (uint32_t r = 0; r < this->n_records; ++r) {
+		this->fis[r] = 0; this->fst[r] = 0; this->fit[r] = 0;
+		if (this->valid[r] == false) continue;
+
+		uint64_t n_gt_all = 0, n_gt_ref = 0, n_gt_alt = 0, n_gt_het = 0;
+		double obs_sum = 0, exp_sum = 0;
+		for (uint32_t g = 0; g < this->n_groups; ++g) {
+			const uint64_t i = this->GetOffset(r, g);
+			const uint32_t n_het = this->n_ra[i] + this->n_ar[i];
+			const uint32_t n_gt  = this->n_rr[i] + n_het + this->n_aa[i];
+			if (n_gt == 0) continue;
+
+			const double p = (2.0*this->n_rr[i] + n_het) / (2.0*n_gt);
+			n_gt_all += n_gt;
+			n_gt_ref += this->n_rr[i];
+			n_gt_alt += this->n_aa[i];
+			n_gt_het += n_het;
+			obs_sum  += n_het;
+			exp_sum  += 2*p*(1-p) * n_gt;
+		}
+
+		// Records without any genotypes in the groupings have no statistics.
+		if (n_gt_all == 0) {
+			this->valid[r] = false;
+			continue;
+		}
+
+		const double h_i   = obs_sum / n_gt_all;
+		const double h_s   = exp_sum / n_gt_all;
+		const double p_bar = (2.0*n_gt_ref + n_gt_het) / (2.0*n_gt_all);
+		const double q_bar = (2.0*n_gt_alt + n_gt_het) / (2.0*n_gt_all);
+		const double h_t   = 2*p_bar*q_bar;
+
+		if (h_s != 0) this->fis[r] = (h_s - h_i) / h_s;
+		if (h_t != 0) this->fst[r] = (h_t - h_s) / h_t;
+		if (h_t != 0) this->fit[r] = (h_t - h_i) / h_t;
+	}
+}
+
+void PopulationGenetics::ComputeStrandBias(void) {
+	const uint64_t n_cells = (uint64_t)this->n_records * this->n_groups;
+	this->strand_bias.resize(n_cells);
+
+	// Alternative and reference alleles on the first and second
+	// chromosome.
+	for (uint64_t i = 0; i < n_cells; ++i) {
+		const uint32_t alt_fwd = this->n_ar[i] + this->n_aa[i];
+		const uint32_t alt_rev = this->n_ra[i] + this->n_aa[i];
+		const uint32_t ref_fwd = this->n_rr[i] + this->n_ra[i];
+		const uint32_t ref_rev = this->n_rr[i] + this->n_ar[i];
+		this->strand_bias[i] = std::abs(-10 * log10(this->FisherExact(alt_fwd, alt_rev, ref_fwd, ref_rev)));
+	}
+}
+
+double PopulationGenetics::FisherExact(const uint32_t n11, const uint32_t n12, const uint32_t n21, const uint32_t n22) {
+	const int64_t n1_ = (int64_t)n11 + n12;
+	const int64_t n2_ = (int64_t)n21 + n22;
+	const int64_t n_1 = (int64_t)n11 + n21;
+	const int64_t n   = n1_ + n2_;
+	if (n == 0) return(1);
+
+	this->lf.Reserve(n);
+
+	// Hypergeometric log-probabilities of every table with the same
+	// margins indexed by n11.
+	const int64_t lo = std::max<int64_t>(0, n_1 - n2_);
+	const int64_t hi = std::min<int64_t>(n1_, n_1);
+	const double c = this->lf[n1_] + this->lf[n2_] + this->lf[n_1] + this->lf[n - n_1] - this->lf[n];
+
+	this->scratch.resize(hi - lo + 1);
+	for (int64_t k = lo; k <= hi; ++k)
+		this->scratch[k - lo] = c - this->lf[k] - this->lf[n1_ - k] - this->lf[n_1 - k] - this->lf[n2_ - n_1 + k];
+
+	const double limit = this->scratch[n11 - lo] + YON_POPGEN_EXACT_TOLERANCE;
+	double p = 0;
+	for (int64_t k = 0; k <= hi - lo; ++k)
+		p += (this->scratch[k] <= limit ? exp(this->scratch[k]) : 0);
+
+	return(std::min(1.0, p));
+}
+
+double PopulationGenetics::HardyWeinbergExact(const uint32_t hom_ref, const uint32_t het, const uint32_t hom_alt) {
+	const uint64_t n = (uint64_t)hom_ref + het + hom_alt;
+	if (n == 0) return(1);
+
+	this->lf.Reserve(2*n);
+
+	// The number of heterozygotes has the same parity as the number of
+	// rare alleles. The log-probability of k heterozygotes is
+	// log(n! n_a! n_b! 2^k / ((2n)! k! ((n_a-k)/2)! ((n_b-k)/2)!)).
+	const uint64_t n_a    = 2*(uint64_t)hom_ref + het;
+	const uint64_t n_b    = 2*(uint64_t)hom_alt + het;
+	const uint64_t n_rare = std::min(n_a, n_b);
+	const uint64_t n_k    = n_rare / 2 + 1;
+	const double   ln2    = log(2.0);
+	const double   c      = this->lf[n] + this->lf[n_a] + this->lf[n_b] - this->lf[2*n];
+
+	this->scratch.resize(n_k);
+	for (uint64_t i = 0; i < n_k; ++i) {
+		const uint64_t k = (n_rare & 1) + 2*i;
+		this->scratch[i] = c + k*ln2 - this->lf[k] - this->lf[(n_a - k) / 2] - this->lf[(n_b - k) / 2];
+	}
+
+	const double limit = this->scratch[(het - (n_rare & 1)) / 2] + YON_POPGEN_EXACT_TOLERANCE;
+	double p = 0;
+	for (uint64_t i = 0; i < n_k; ++i)
+		p += (this->scratch[i] <= limit ? exp(this->scratch[i]) : 0);
+
+	return(std::min(1.0, p));
+}
+
+}
@@ -0,0 +1,457 @@
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "relatedness.h"
+#include "utility.h"
+
+namespace tachyon {
+
+// Checkpoint identifier and version.
+static const char     YON_GRM_CHECKPOINT_MAGIC[8] = {'Y','O','N','G','R','M','\0','\0'};
+static const uint32_t YON_GRM_CHECKPOINT_VERSION  = 2;
+
+/**<
+ * KING counts of a pair of samples over one panel: heterozygous in both,
+ * opposite homozygous genotypes, heterozygous in a and observed in b,
+ * heterozygous in b and observed in a, and observed in both. Planes of a
+ * sample are stored as [observed, het, hom_alt] of YON_GRM_PANEL_WORDS
+ * words each.
+ */
+struct yon_grm_king_counts {
+	uint32_t het_het, ibs0, het_a, het_b, n_obs;
+};
+
+static inline void KingCounts_(const uint64_t* __restrict a, const uint64_t* __restrict b, yon_grm_king_counts& c) {
+	for (uint32_t i = 0; i < YON_GRM_PANEL_WORDS; ++i) {
+		const uint64_t oa = a[i], ha = a[YON_GRM_PANEL_WORDS + i], xa = a[2*YON_GRM_PANEL_WORDS + i];
+		const uint64_t ob = b[i], hb = b[YON_GRM_PANEL_WORDS + i], xb = b[2*YON_GRM_PANEL_WORDS + i];
+		const uint64_t ra = oa & ~(ha | xa);
+		const uint64_t rb = ob & ~(hb | xb);
+		c.het_het += __builtin_popcountll(ha & hb);
+		c.ibs0    += __builtin_popcountll((ra & xb) | (xa & rb));
+		c.het_a   += __builtin_popcountll(ha & ob);
+		c.het_b   += __builtin_popcountll(oa & hb);
+		c.n_obs   += __builtin_popcountll(oa & ob);
+	}
+}
+
+static void KingCountsDefault(const uint64_t* a, const uint64_t* b, yon_grm_king_counts& c) {
+	KingCounts_(a, b, c);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("popcnt")))
+static void KingCountsPopcnt(const uint64_t* a, const uint64_t* b, yon_grm_king_counts& c) {
+	KingCounts_(a, b, c);
+}
+
+// Every plane of a panel is exactly one 512-bit vector.
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static void KingCountsAvx512(const uint64_t* a, const uint64_t* b, yon_grm_king_counts& c) {
+	const __m512i oa = _mm512_loadu_si512(&a[0]);
+	const __m512i ha = _mm512_loadu_si512(&a[YON_GRM_PANEL_WORDS]);
+	const __m512i xa = _mm512_loadu_si512(&a[2*YON_GRM_PANEL_WORDS]);
+	const __m512i ob = _mm512_loadu_si512(&b[0]);
+	const __m512i hb = _mm512_loadu_si512(&b[YON_GRM_PANEL_WORDS]);
+	const __m512i xb = _mm512_loadu_si512(&b[2*YON_GRM_PANEL_WORDS]);
+	const __m512i ra = _mm512_andnot_si512(_mm512_or_si512(ha, xa), oa);
+	const __m512i rb = _mm512_andnot_si512(_mm512_or_si512(hb, xb), ob);
+	c.het_het += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_and_si512(ha, hb)));
+	c.ibs0    += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_or_si512(_mm512_and_si512(ra, xb), _mm512_and_si512(xa, rb))));
+	c.het_a   += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_and_si512(ha, ob)));
+	c.het_b   += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_and_si512(oa, hb)));
+	c.n_obs   += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_and_si512(oa, ob)));
+}
+#endif
+
+typedef void (*yon_grm_king_func)(const uint64_t*, const uint64_t*, yon_grm_king_counts&);
+
+// Select the KING kernel once for the lifetime of the process.
+static yon_grm_king_func SelectKingCounts(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512vpopcntdq")) return(&KingCountsAvx512);
+	if (__builtin_cpu_supports("popcnt")) return(&KingCountsPopcnt);
+#endif
+	return(&KingCountsDefault);
+}
+
+static inline void KingCounts(const uint64_t* a, const uint64_t* b, yon_grm_king_counts& c) {
+	static const yon_grm_king_func func = SelectKingCounts();
+	(*func)(a, b, c);
+}
+
+// Number of records observed in a pair of samples over one panel.
+static inline uint32_t ObservedCount(const uint64_t* __restrict a, const uint64_t* __restrict b) {
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < YON_GRM_PANEL_WORDS; ++i)
+		count += __builtin_popcountll(a[i] & b[i]);
+	return(count);
+}
+
+// Dot product of n_records standardized dosages where n_records is a
+// multiple of 8.
+static float DotDefault(const float* __restrict a, const float* __restrict b, const uint32_t n_records) {
+	float sum[4] = {0, 0, 0, 0};
+	for (uint32_t i = 0; i < n_records; i += 4) {
+		sum[0] += a[i+0] * b[i+0];
+		sum[1] += a[i+1] * b[i+1];
+		sum[2] += a[i+2] * b[i+2];
+		sum[3] += a[i+3] * b[i+3];
+	}
+	return((sum[0] + sum[1]) + (sum[2] + sum[3]));
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2,fma")))
+static float DotAvx2(const float* __restrict a, const float* __restrict b, const uint32_t n_records) {
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 16 <= n_records; i += 16) {
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]),     _mm256_loadu_ps(&b[i]),     sum0);
+		sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i + 8]), _mm256_loadu_ps(&b[i + 8]), sum1);
+	}
+	if (i < n_records)
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]), sum0);
+
+	const __m256 sum = _mm256_add_ps(sum0, sum1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x1));
+	return(_mm_cvtss_f32(s));
+}
+#endif
+
+typedef float (*yon_grm_dot_func)(const float*, const float*, const uint32_t);
+
+// Select the dot product kernel once for the lifetime of the process.
+static yon_grm_dot_func SelectDot(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return(&DotAvx2);
+#endif
+	return(&DotDefault);
+}
+
+static inline float Dot(const float* a, const float* b, const uint32_t n_records) {
+	static const yon_grm_dot_func func = SelectDot();
+	return((*func)(a, b, n_records));
+}
+
+Relatedness::Relatedness() : n_s(0), n_pending(0), n_panel(0), n_records(0), n_skipped(0), n_blocks(0) {}
+
+bool Relatedness::Open(const uint32_t n_samples, const yon_grm_settings& settings) {
+	if (n_samples == 0) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "No samples to compute relatedness for..." << std::endl;
+		return false;
+	}
+
+	this->settings  = settings;
+	this->n_s       = n_samples;
+	this->n_pending = 0;
+	this->n_records = 0;
+	this->n_skipped = 0;
+	this->n_blocks  = 0;
+
+	// Bitplanes of a sample are stored consecutively such that a pair
+	// reads two contiguous runs of memory.
+	const uint64_t n_pairs = (uint64_t)n_samples * (n_samples + 1) / 2;
+	this->planes.assign((uint64_t)n_samples * 3 * YON_GRM_PANEL_WORDS, 0);
+	this->n_observed.assign(n_pairs, 0);
+
+	if (settings.mode == YON_GRM_STANDARDIZED) {
+		this->dosages.assign((uint64_t)n_samples * YON_GRM_PANEL_RECORDS, 0);
+		this->sums.assign(n_pairs, 0);
+		this->n_het_het.clear(); this->n_ibs0.clear(); this->n_het_a.clear(); this->n_het_b.clear();
+	} else {
+		this->dosages.clear();
+		this->sums.clear();
+		this->n_het_het.assign(n_pairs, 0);
+		this->n_ibs0.assign(n_pairs, 0);
+		this->n_het_a.assign(n_pairs, 0);
+		this->n_het_b.assign(n_pairs, 0);
+	}
+
+	// Tiles of the upper triangle including the diagonal.
+	this->tiles.clear();
+	for (uint32_t a = 0; a < n_samples; a += YON_GRM_TILE_SAMPLES) {
+		for (uint32_t b = a; b < n_samples; b += YON_GRM_TILE_SAMPLES) {
+			yon_grm_tile tile;
+			tile.a_from = a; tile.a_to = std::min(n_samples, a + YON_GRM_TILE_SAMPLES);
+			tile.b_from = b; tile.b_to = std::min(n_samples, b + YON_GRM_TILE_SAMPLES);
+			this->tiles.push_back(tile);
+		}
+	}
+
+	this->pool.Start(settings.n_threads);
+	return true;
+}
+
+bool Relatedness::Add(const yon_gt& gt) {
+	if (gt.rcds == nullptr) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Genotypes have not been evaluated..." << std::endl;
+		return false;
+	}
+
+	if (gt.n_s != this->n_s) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Record has " << gt.n_s << " samples but expected " << this->n_s << "..." << std::endl;
+		return false;
+	}
+
+	if (gt.m != 2) {
+		++this->n_skipped;
+		return true;
+	}
+
+	// Allele frequency over the observed genotypes. Alleles are offset
+	// such that missing and end-of-vector sentinels wrap around to
+	// large values.
+	uint64_t n_obs = 0, n_alt = 0;
+	for (uint32_t j = 0; j < gt.n_i; ++j) {
+		const uint32_t a = YON_GT_RCD_ALLELE_UNPACK(gt.rcds[j].allele[0]) - YON_GT_RCD_REF;
+		const uint32_t b = YON_GT_RCD_ALLELE_UNPACK(gt.rcds[j].allele[1]) - YON_GT_RCD_REF;
+		if (a >= gt.n_allele || b >= gt.n_allele) continue;
+		n_obs += gt.rcds[j].run_length;
+		n_alt += ((a != 0) + (b != 0)) * gt.rcds[j].run_length;
+	}
+
+	if (n_alt == 0 || n_alt == 2*n_obs) {
+		++this->n_skipped;
+		return true;
+	}
+
+	// Standardized dosage of every genotype class: 0, 1, or 2
+	// alternative alleles.
+	const double p = (double)n_alt / (2*n_obs);
+	const double s = 1.0 / sqrt(2*p*(1-p));
+	const float levels[3] = { (float)((0 - 2*p)*s), (float)((1 - 2*p)*s), (float)((2 - 2*p)*s) };
+
+	const uint32_t word = this->n_pending >> 6;
+	const uint64_t mask = 1ULL << (this->n_pending & 63);
+	const uint32_t* ordering = (gt.ppa != nullptr ? gt.ppa->ordering : nullptr);
+	const bool standardized = (this->settings.mode == YON_GRM_STANDARDIZED);
+
+	uint32_t position = 0;
+	for (uint32_t j = 0; j < gt.n_i; ++j) {
+		const yon_gt_rcd& rcd = gt.rcds[j];
+		const uint32_t a = YON_GT_RCD_ALLELE_UNPACK(rcd.allele[0]) - YON_GT_RCD_REF;
+		const uint32_t b = YON_GT_RCD_ALLELE_UNPACK(rcd.allele[1]) - YON_GT_RCD_REF;
+		const bool observed = (a < gt.n_allele && b < gt.n_allele);
+		const uint32_t dosage = observed ? (a != 0) + (b != 0) : 0;
+
+		for (uint32_t k = position; k < position + rcd.run_length; ++k) {
+			const uint32_t sample = (ordering != nullptr ? ordering[k] : k);
+			uint64_t* __restrict dst = &this->planes[(uint64_t)sample * 3 * YON_GRM_PANEL_WORDS + word];
+			if (observed) {
+				dst[0] |= mask;
+				if (dosage == 1) dst[YON_GRM_PANEL_WORDS]   |= mask;
+				if (dosage == 2) dst[2*YON_GRM_PANEL_WORDS] |= mask;
+			}
+			if (standardized)
+				this->dosages[(uint64_t)sample * YON_GRM_PANEL_RECORDS + this->n_pending] = observed ? levels[dosage] : 0;
+		}
+		position += rcd.run_length;
+	}
+
+	++this->n_records;
+	if (++this->n_pending == YON_GRM_PANEL_RECORDS)
+		this->Flush();
+
+	return true;
+}
+
+void Relatedness::Flush(void) {
+	if (this->n_pending == 0) return;
+
+	// Pad the dosages of a partial panel to a multiple of 8 records with
+	// zeroes.
+	this->n_panel = (this->n_pending + 7) & ~7U;
+	if (this->settings.mode == YON_GRM_STANDARDIZED) {
+		for (uint32_t i = 0; i < this->n_s; ++i) {
+			float* dst = &this->dosages[(uint64_t)i * YON_GRM_PANEL_RECORDS];
+			for (uint32_t k = this->n_pending; k < this->n_panel; ++k) dst[k] = 0;
+		}
+	}
+
+	std::atomic<uint32_t> next(0);
+	this->pool.Run([this, &next](const uint32_t) {
+		uint32_t t;
+		while ((t = next++) < this->tiles.size())
+			this->AccumulateTile(t);
+	});
+
+	memset(this->planes.data(), 0, this->planes.size() * sizeof(uint64_t));
+	this->n_pending = 0;
+}
+
+void Relatedness::AccumulateTile(const uint32_t t) {
+	const yon_grm_tile& tile = this->tiles[t];
+	const uint64_t stride = 3 * YON_GRM_PANEL_WORDS;
+
+	for (uint32_t a = tile.a_from; a < tile.a_to; ++a) {
+		const uint64_t* planes_a = &this->planes[a * stride];
+		const uint64_t offset = this->GetOffset(a, a) - a;
+
+		if (this->settings.mode == YON_GRM_KING) {
+			for (uint32_t b = std::max(a, tile.b_from); b < tile.b_to; ++b) {
+				yon_grm_king_counts c = {0, 0, 0, 0, 0};
+				KingCounts(planes_a, &this->planes[b * stride], c);
+				this->n_het_het[offset + b]  += c.het_het;
+				this->n_ibs0[offset + b]     += c.ibs0;
+				this->n_het_a[offset + b]    += c.het_a;
+				this->n_het_b[offset + b]    += c.het_b;
+				this->n_observed[offset + b] += c.n_obs;
+			}
+		} else {
+			const float* dosages_a = &this->dosages[(uint64_t)a * YON_GRM_PANEL_RECORDS];
+			for (uint32_t b = std::max(a, tile.b_from); b < tile.b_to; ++b) {
+				this->sums[offset + b] += Dot(dosages_a, &this->dosages[(uint64_t)b * YON_GRM_PANEL_RECORDS], this->n_panel);
+				this->n_observed[offset + b] += ObservedCount(planes_a, &this->planes[b * stride]);
+			}
+		}
+	}
+}
+
+double Relatedness::GetRelatedness(const uint32_t a, const uint32_t b) const {
+	const uint64_t offset = (a <= b ? this->GetOffset(a, b) : this->GetOffset(b, a));
+	if (this->n_observed[offset] == 0)
+		return(std::numeric_limits<double>::quiet_NaN());
+
+	if (this->settings.mode == YON_GRM_STANDARDIZED)
+		return(this->sums[offset] / this->n_observed[offset]);
+
+	// Counts of heterozygotes are stored for the smaller sample offset
+	// first.
+	const uint32_t n_het = std::min(this->n_het_a[offset], this->n_het_b[offset]);
+	if (n_het == 0)
+		return(std::numeric_limits<double>::quiet_NaN());
+
+	const double d = 4.0*this->n_ibs0[offset] + this->n_het_a[offset] + this->n_het_b[offset] - 2.0*this->n_het_het[offset];
+	return(0.5 - d / (4.0*n_het));
+}
+
+uint32_t Relatedness::GetNumberObserved(const uint32_t a, const uint32_t b) const {
+	return(this->n_observed[a <= b ? this->GetOffset(a, b) : this->GetOffset(b, a)]);
+}
+
+template <class T>
+static inline void WriteArray(std::ofstream& stream, const std::vector<T>& values) {
+	stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <class T>
+static inline void ReadArray(std::ifstream& stream, std::vector<T>& values) {
+	stream.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+}
+
+bool Relatedness::SaveCheckpoint(const std::string& file_name) {
+	this->Flush();
+
+	// Write to a temporary file first such that an interrupted write
+	// never replaces the previous checkpoint.
+	const std::string temp_name = file_name + ".tmp";
+	std::ofstream stream(temp_name, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (stream.good() == false) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Failed to open checkpoint: " << temp_name << "..." << std::endl;
+		return false;
+	}
+
+	const uint32_t mode = this->settings.mode;
+	stream.write(YON_GRM_CHECKPOINT_MAGIC, sizeof(YON_GRM_CHECKPOINT_MAGIC));
+	stream.write(reinterpret_cast<const char*>(&YON_GRM_CHECKPOINT_VERSION), sizeof(uint32_t));
+	stream.write(reinterpret_cast<const char*>(&mode), sizeof(uint32_t));
+	stream.write(reinterpret_cast<const char*>(&this->n_s), sizeof(uint32_t));
+	const uint32_t l_fingerprint = this->settings.fingerprint.size();
+	stream.write(reinterpret_cast<const char*>(&l_fingerprint), sizeof(uint32_t));
+	stream.write(this->settings.fingerprint.data(), l_fingerprint);
+	stream.write(reinterpret_cast<const char*>(&this->n_records), sizeof(uint64_t));
+	stream.write(reinterpret_cast<const char*>(&this->n_skipped), sizeof(uint64_t));
+	stream.write(reinterpret_cast<const char*>(&this->n_blocks), sizeof(uint64_t));
+	WriteArray(stream, this->n_observed);
+	WriteArray(stream, this->sums);
+	WriteArray(stream, this->n_het_het);
+	WriteArray(stream, this->n_ibs0);
+	WriteArray(stream, this->n_het_a);
+	WriteArray(stream, this->n_het_b);
+	stream.close();
+
+	if (stream.fail()) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Failed to write checkpoint: " << temp_name << "..." << std::endl;
+		return false;
+	}
+
+	if (rename(temp_name.c_str(), file_name.c_str()) != 0) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Failed to replace checkpoint: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Relatedness::LoadCheckpoint(const std::string& file_name) {
+	std::ifstream stream(file_name, std::ios::binary | std::ios::in);
+	if (stream.good() == false) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Failed to open checkpoint: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	char magic[sizeof(YON_GRM_CHECKPOINT_MAGIC)];
+	uint32_t version = 0, mode = 0, n_samples = 0, l_fingerprint = 0;
+	stream.read(magic, sizeof(magic));
+	stream.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+	stream.read(reinterpret_cast<char*>(&mode), sizeof(uint32_t));
+	stream.read(reinterpret_cast<char*>(&n_samples), sizeof(uint32_t));
+	stream.read(reinterpret_cast<char*>(&l_fingerprint), sizeof(uint32_t));
+	if (stream.good() == false || memcmp(magic, YON_GRM_CHECKPOINT_MAGIC, sizeof(magic)) != 0 || version != YON_GRM_CHECKPOINT_VERSION) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Not a valid checkpoint: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	if (mode != (uint32_t)this->settings.mode || n_samples != this->n_s) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Checkpoint was computed with different settings or samples: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	// The fingerprint is compared before any counts are restored.
+	if (l_fingerprint != this->settings.fingerprint.size()) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Checkpoint was computed from a different input, intervals, or filters: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	std::string fingerprint(l_fingerprint, '\0');
+	stream.read(&fingerprint[0], l_fingerprint);
+	if (stream.good() == false || fingerprint != this->settings.fingerprint) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Checkpoint was computed from a different input, intervals, or filters: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	stream.read(reinterpret_cast<char*>(&this->n_records), sizeof(uint64_t));
+	stream.read(reinterpret_cast<char*>(&this->n_skipped), sizeof(uint64_t));
+	stream.read(reinterpret_cast<char*>(&this->n_blocks), sizeof(uint64_t));
+	ReadArray(stream, this->n_observed);
+	ReadArray(stream, this->sums);
+	ReadArray(stream, this->n_het_het);
+	ReadArray(stream, this->n_ibs0);
+	ReadArray(stream, this->n_het_a);
+	ReadArray(stream, this->n_het_b);
+
+	if (stream.fail()) {
+		std::cerr << utility::timestamp("ERROR","GRM") << "Truncated checkpoint: " << file_name << "..." << std::endl;
+		return false;
+	}
+
+	this->n_pending = 0;
+	return true;
+}
+
+}
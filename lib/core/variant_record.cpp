@@ -1,22 +1,23 @@
 #include "tachyon.h"
 #include "variant_record.h"
+#include "population_genetics.h"
 
 namespace tachyon{
 
 /****************************
 *  Allele description
 ****************************/
-yon_allele::yon_allele() : l_allele(0), allele(nullptr) {}
-yon_allele::yon_allele(const std::string& string) : l_allele(string.size()), allele(new char[l_allele]) { memcpy(allele, string.data(), l_allele); }
-yon_allele& yon_allele::operator=(const std::string& value) { delete [] allele; l_allele = value.size(); allele = new char[l_allele]; memcpy(allele, value.data(), l_allele); return(*this); }
-yon_allele& yon_allele::operator=(const char* value) { delete [] allele; l_allele = strlen(value); allele = new char[l_allele]; memcpy(allele, value, l_allele); return(*this); }
-yon_allele& yon_allele::operator=(const char& value) { delete [] allele; l_allele = 1; allele = new char[l_allele]; allele[0] = value; return(*this); }
+yon_allele::yon_allele() : l_allele(0), is_arena(false), allele(nullptr) {}
+yon_allele::yon_allele(const std::string& string) : l_allele(string.size()), is_arena(false), allele(new char[l_allele]) { memcpy(allele, string.data(), l_allele); }
+yon_allele& yon_allele::operator=(const std::string& value) { this->Release(); l_allele = value.size(); allele = new char[l_allele]; memcpy(allele, value.data(), l_allele); return(*this); }
+yon_allele& yon_allele::operator=(const char* value) { this->Release(); l_allele = strlen(value); allele = new char[l_allele]; memcpy(allele, value, l_allele); return(*this); }
+yon_allele& yon_allele::operator=(const char& value) { this->Release(); l_allele = 1; allele = new char[l_allele]; allele[0] = value; return(*this); }
 
-yon_allele::yon_allele(const yon_allele& other) : l_allele(other.l_allele), allele(new char[l_allele]) { memcpy(allele, other.allele, l_allele); }
-yon_allele::yon_allele(yon_allele&& other) noexcept : l_allele(other.l_allele), allele(nullptr) { std::swap(allele, other.allele); other.l_allele = 0; }
+yon_allele::yon_allele(const yon_allele& other) : l_allele(other.l_allele), is_arena(false), allele(new char[l_allele]) { memcpy(allele, other.allele, l_allele); }
+yon_allele::yon_allele(yon_allele&& other) noexcept : l_allele(other.l_allele), is_arena(other.is_arena), allele(nullptr) { std::swap(allele, other.allele); other.l_allele = 0; other.is_arena = false; }
 
 yon_allele& yon_allele::operator=(const yon_allele& other) {
-	delete [] allele;
+	this->Release();
 	l_allele = other.l_allele;
 	allele = new char[l_allele];
 	memcpy(allele, other.allele, l_allele);
@@ -28,22 +29,45 @@ yon_allele& yon_allele::operator=(yon_allele&& other) noexcept {
 		// precautions against self-moves
 		return *this;
 	}
+	this->Release();
 	l_allele = other.l_allele;
+	is_arena = other.is_arena;
 	std::swap(allele, other.allele);
 	other.l_allele = 0;
+	other.is_arena = false;
 	return(*this);
 }
 
-yon_allele::~yon_allele() { delete [] allele; }
+yon_allele::~yon_allele() { this->Release(); }
 
 yon_allele& yon_allele::ParseFromBuffer(const char* const in) {
-	delete [] this->allele;
+	this->Release();
 	this->l_allele = *reinterpret_cast<const uint16_t* const>(in);
 	this->allele = new char[this->l_allele];
 	memcpy(this->allele, &in[sizeof(uint16_t)], this->l_allele);
 	return(*this);
 }
 
+yon_allele& yon_allele::Assign(const char* value, const uint16_t length, yon_arena* arena) {
+	if (arena == nullptr) {
+		this->Release();
+		this->l_allele = length;
+		this->allele = new char[length];
+		memcpy(this->allele, value, length);
+		return(*this);
+	}
+
+	this->Release();
+	this->l_allele = length;
+	this->allele   = arena->CopyString(value, length);
+	this->is_arena = true;
+	return(*this);
+}
+
+yon_allele& yon_allele::ParseFromBuffer(const char* const in, yon_arena* arena) {
+	return(this->Assign(&in[sizeof(uint16_t)], *reinterpret_cast<const uint16_t* const>(in), arena));
+}
+
 /****************************
 *  Core record
 ****************************/
@@ -51,7 +75,16 @@ yon1_vnt_t::yon1_vnt_t() :
 	is_dirty(false), is_loaded_gt(false), n_base_ploidy(0), n_alleles(0),
 	n_flt(0), n_fmt(0), n_info(0), info_pid(-1), flt_pid(-1), fmt_pid(-1),
 	m_fmt(0), m_info(0), m_allele(0),
-	qual(NAN), rid(0), pos(0),
+	qual(NAN), rid(0), pos(0), arena(nullptr),
+	alleles(nullptr), gt(nullptr), gt_sum(nullptr), gt_sum_occ(nullptr),
+	info(nullptr), fmt(nullptr)
+{}
+
+yon1_vnt_t::yon1_vnt_t(yon_arena* arena) :
+	is_dirty(false), is_loaded_gt(false), n_base_ploidy(0), n_alleles(0),
+	n_flt(0), n_fmt(0), n_info(0), info_pid(-1), flt_pid(-1), fmt_pid(-1),
+	m_fmt(0), m_info(0), m_allele(0),
+	qual(NAN), rid(0), pos(0), arena(arena),
 	alleles(nullptr), gt(nullptr), gt_sum(nullptr), gt_sum_occ(nullptr),
 	info(nullptr), fmt(nullptr)
 {}
@@ -65,7 +98,7 @@ yon1_vnt_t::yon1_vnt_t(const yon1_vnt_t& other) :
 	qual(other.qual), rid(other.rid), pos(other.pos), name(other.name),
 	info_hdr(other.info_hdr), fmt_hdr(other.fmt_hdr), flt_hdr(other.flt_hdr),
 	info_map(other.info_map), fmt_map(other.fmt_map), flt_map(other.flt_map),
-	alleles(new yon_allele[n_alleles]),
+	arena(nullptr), alleles(new yon_allele[n_alleles]),
 	gt(nullptr), gt_sum(nullptr), gt_sum_occ(nullptr),
 	info(nullptr), fmt(nullptr)
 {
@@ -84,8 +117,8 @@ yon1_vnt_t::yon1_vnt_t(const yon1_vnt_t& other) :
 
 yon1_vnt_t& yon1_vnt_t::operator=(const yon1_vnt_t& other) {
 	// Delete existing data without consideration.
-	delete [] alleles;
-	delete gt; delete gt_sum;
+	this->ReleaseAlleles();
+	delete gt; this->ReleaseSummary();
 	delete [] gt_sum_occ;
 	for (int i = 0; i < n_info; ++i) delete info[i];
 	for (int i = 0; i < n_fmt;  ++i) delete fmt[i];
@@ -100,6 +133,7 @@ yon1_vnt_t& yon1_vnt_t::operator=(const yon1_vnt_t& other) {
 	qual = other.qual; rid = other.rid; pos = other.pos; name = other.name;
 	info_hdr = other.info_hdr; fmt_hdr = other.fmt_hdr; flt_hdr = other.flt_hdr;
 	info_map = other.info_map; fmt_map = other.fmt_map; flt_map = other.flt_map;
+	arena = nullptr; // copies never borrow the src arena
 	alleles = new yon_allele[n_alleles];
 	gt = nullptr; gt_sum = nullptr; gt_sum_occ = nullptr,
 	info = nullptr; fmt = nullptr;
@@ -128,7 +162,7 @@ yon1_vnt_t::yon1_vnt_t(yon1_vnt_t&& other) noexcept :
 	qual(other.qual), rid(other.rid), pos(other.pos), name(std::move(other.name)),
 	info_hdr(other.info_hdr), fmt_hdr(other.fmt_hdr), flt_hdr(other.flt_hdr),
 	info_map(other.info_map), fmt_map(other.fmt_map), flt_map(other.flt_map),
-	alleles(nullptr),
+	arena(other.arena), alleles(nullptr),
 	gt(nullptr), gt_sum(nullptr), gt_sum_occ(nullptr),
 	info(nullptr), fmt(nullptr)
 {
@@ -149,8 +183,8 @@ yon1_vnt_t::yon1_vnt_t(yon1_vnt_t&& other) noexcept :
 //yon1_vnt_t& operator=(yon1_vnt_t&& other) noexcept = delete; // temporarily deleted
 
 yon1_vnt_t::~yon1_vnt_t() {
-	delete [] alleles;
-	delete gt; delete gt_sum;
+	this->ReleaseAlleles();
+	delete gt; this->ReleaseSummary();
 	delete [] gt_sum_occ;
 	for (int i = 0; i < n_info; ++i) delete info[i];
 	for (int i = 0; i < n_fmt;  ++i) delete fmt[i];
@@ -163,21 +197,17 @@ bool yon1_vnt_t::UpdateBase(const bcf1_t* record) {
 	rid  = record->rid;
 	pos  = record->pos;
 	name = std::string(record->d.id);
-	delete [] alleles;
-	alleles = new yon_allele[n_alleles];
 
 	// Fix for the special case when ALT is not encoded
 	if (this->n_alleles == 1) {
-		delete [] alleles;
 		this->n_alleles = 2;
-		this->alleles = new yon_allele[n_alleles];
-		this->alleles[0] = record->d.allele[0];
-		this->alleles[1].allele    = new char[1];
-		this->alleles[1].allele[0] = '.';
-		this->alleles[1].l_allele  = 1;
+		this->AllocateAlleles(this->n_alleles);
+		this->alleles[0].Assign(record->d.allele[0], strlen(record->d.allele[0]), this->arena);
+		this->alleles[1].Assign(".", 1, this->arena);
 	} else {
+		this->AllocateAlleles(this->n_alleles);
 		for (uint32_t i = 0; i < this->n_alleles; ++i) {
-			this->alleles[i] = record->d.allele[i];
+			this->alleles[i].Assign(record->d.allele[i], strlen(record->d.allele[i]), this->arena);
 		}
 	}
 
@@ -187,6 +217,28 @@ bool yon1_vnt_t::UpdateBase(const bcf1_t* record) {
 	return true;
 }
 
+yon_allele* yon1_vnt_t::AllocateAlleles(const uint16_t n) {
+	this->ReleaseAlleles();
+	if (this->arena != nullptr) this->alleles = this->arena->Construct<yon_allele>(n);
+	else this->alleles = new yon_allele[n];
+	this->m_allele = n;
+	return(this->alleles);
+}
+
+void yon1_vnt_t::ReleaseAlleles(void) {
+	if (this->alleles == nullptr) return;
+
+	if (this->arena != nullptr) {
+		// The array itself is owned by the arena but individual
+		// alleles may still hold heap memory if they were assigned
+		// after construction.
+		for (uint32_t i = 0; i < this->m_allele; ++i)
+			(this->alleles + i)->~yon_allele();
+	} else delete [] this->alleles;
+
+	this->alleles = nullptr;
+}
+
 std::string yon1_vnt_t::GetAlleleString(void) const {
 	std::string ret = this->alleles[0].ToString();
 	for (uint32_t i = 1; i < this->n_alleles; ++i)
@@ -194,20 +246,45 @@ std::string yon1_vnt_t::GetAlleleString(void) const {
 	return(ret);
 }
 
+void yon1_vnt_t::ReleaseSummary(void) {
+	if (this->gt_sum == nullptr) return;
+
+	// The object itself is owned by the arena but its sparse table
+	// may hold heap memory.
+	if (this->arena != nullptr) this->gt_sum->~yon_gt_summary();
+	else delete this->gt_sum;
+
+	this->gt_sum = nullptr;
+}
+
 bool yon1_vnt_t::EvaluateSummary(bool lazy_evaluate) {
 	assert(this->gt != nullptr);
-	assert(this->gt->rcds != nullptr);
 
 	if (this->gt_sum != nullptr)
 		return true;
 
-	this->gt_sum = new yon_gt_summary(this->gt->m, this->gt->n_allele);
-	*this->gt_sum += *this->gt;
+	// Summarise directly from the encoded genotypes if possible and
+	// fall back to the records otherwise: these are only evaluated if
+	// the encoding is not supported. A rejected encoding leaves the
+	// summary untouched.
+	// The summary and its memory are served from the arena of this
+	// record if available.
+	if (this->arena != nullptr) this->gt_sum = this->arena->Construct<yon_gt_summary>(1);
+	else this->gt_sum = new yon_gt_summary;
+	this->gt_sum->SetArena(this->arena);
+	this->gt_sum->Setup(this->gt->m, this->gt->n_allele);
+	if (this->gt_sum->AddEncoded(*this->gt) == false) {
+		if (this->gt->Evaluate() == false) {
+			this->ReleaseSummary();
+			return false;
+		}
+		*this->gt_sum += *this->gt;
+	}
 	if (lazy_evaluate) this->gt_sum->LazyEvaluate();
 	return true;
 }
 
-bool yon1_vnt_t::EvaluateOccSummary(bool lazy_evaluate) {
+bool yon1_vnt_t::EvaluateOccSummary(bool lazy_evaluate, bool hypothesis_tests) {
 	assert(this->gt != nullptr);
 	assert(this->gt->rcds != nullptr);
 
@@ -219,9 +296,10 @@ bool yon1_vnt_t::EvaluateOccSummary(bool lazy_evaluate) {
 
 	this->gt_sum_occ = new yon_gt_summary[this->gt->n_o];
 	for (int i = 0; i < this->gt->n_o; ++i) {
+		this->gt_sum_occ[i].SetArena(this->arena);
 		this->gt_sum_occ[i].Setup(this->gt->m, this->gt->n_allele);
 		this->gt_sum_occ[i].Add(*this->gt, this->gt->n_i_occ[i], this->gt->d_occ[i]);
-		if (lazy_evaluate) this->gt_sum_occ[i].LazyEvaluate();
+		if (lazy_evaluate) this->gt_sum_occ[i].LazyEvaluate(hypothesis_tests);
 	}
 
 	return true;
@@ -235,52 +313,49 @@ bool yon1_vnt_t::EvaluateOcc(yon_occ& occ) {
 	if (this->gt == nullptr)
 		return false;
 
-	this->gt->n_o     = occ.occ.size();
-	this->gt->n_i_occ = new uint32_t[this->gt->n_o];
-	this->gt->d_occ   = new yon_gt_rcd*[this->gt->n_o];
+	// Records are evaluated on demand.
+	if (this->gt->Evaluate() == false)
+		return false;
 
-	uint32_t* cum_sums = new uint32_t[this->gt->n_o]; // Total cumulative genotypes observed.
-	uint32_t* cum_sums_hit = new uint32_t[this->gt->n_o]; // Number of non-zero runs observed.
-	memset(cum_sums, 0, sizeof(uint32_t)*this->gt->n_o);
-	memset(cum_sums_hit, 0, sizeof(uint32_t)*this->gt->n_o);
+	this->gt->n_o = occ.size();
+	if (this->gt->arena != nullptr) {
+		this->gt->n_i_occ = this->gt->arena->Allocate<uint32_t>(this->gt->n_o);
+		this->gt->d_occ   = this->gt->arena->Allocate<yon_gt_rcd*>(this->gt->n_o);
+	} else {
+		this->gt->n_i_occ = new uint32_t[this->gt->n_o];
+		this->gt->d_occ   = new yon_gt_rcd*[this->gt->n_o];
+	}
 
 	for (uint32_t i = 0; i < this->gt->n_o; ++i) {
-		this->gt->d_occ[i]   = new yon_gt_rcd[std::min(this->gt->n_i, occ.cum_sums[i])];
+		this->gt->d_occ[i]   = this->gt->AllocateRecords(std::min(this->gt->n_i, occ.cum_sums[i]));
 		this->gt->n_i_occ[i] = 0;
 	}
 
-	// Iterate over available gt rcds.
+	// Iterate over available gt rcds. The number of members of every
+	// grouping in a run is the difference between the cumulative sums
+	// at the end and the start of the run.
+	uint32_t offset = 0; // Total cumulative genotypes observed.
 	for (uint32_t j = 0; j < this->gt->n_i; ++j) {
-		// Iterate over available groupings in transposed occ.
-		for (uint32_t i = 0; i < this->gt->n_o; ++i) {
-			const uint32_t to   = occ.vocc[cum_sums[i] + this->gt->rcds[j].run_length][i];
-			const uint32_t from = occ.vocc[cum_sums[i]][i];
-			if (to - from != 0) {
-				// Allocate memory for alleles.
-				this->gt->d_occ[i][this->gt->n_i_occ[i]].allele = new uint8_t[this->gt->m];
-
-				// Copy allelic data from recerence gt rcd.
-				for (uint32_t k = 0; k < this->gt->m; ++k) {
-					this->gt->d_occ[i][this->gt->n_i_occ[i]].allele[k] = this->gt->rcds[j].allele[k];
-				}
+		const uint32_t* from = occ.GetRow(offset);
+		const uint32_t* to   = occ.GetRow(offset + this->gt->rcds[j].run_length);
 
-				// Set run-length representation.
-				this->gt->d_occ[i][this->gt->n_i_occ[i]].run_length = to - from;
-				assert(this->gt->n_i_occ[i] < this->gt->n_i);
-				++this->gt->n_i_occ[i];
-				cum_sums_hit[i] += to - from;
-			}
-			cum_sums[i] += this->gt->rcds[j].run_length;
+		for (uint32_t i = 0; i < this->gt->n_o; ++i) {
+			const uint32_t n_members = to[i] - from[i];
+			if (n_members == 0) continue;
+
+			// Copy allelic data from recerence gt rcd.
+			yon_gt_rcd& rcd = this->gt->d_occ[i][this->gt->n_i_occ[i]];
+			for (uint32_t k = 0; k < this->gt->m; ++k)
+				rcd.allele[k] = this->gt->rcds[j].allele[k];
+
+			// Set run-length representation.
+			rcd.run_length = n_members;
+			assert(this->gt->n_i_occ[i] < this->gt->n_i);
+			++this->gt->n_i_occ[i];
 		}
+		offset += this->gt->rcds[j].run_length;
 	}
-	// Debug assertions.
-	for (int i = 0; i < this->gt->n_o; ++i) {
-		assert(cum_sums[i] == this->gt->n_s);
-		assert(cum_sums_hit[i] == occ.cum_sums[i]);
-	}
-
-	delete [] cum_sums;
-	delete [] cum_sums_hit;
+	assert(offset == this->gt->n_s);
 
 	return(true);
 }
@@ -360,7 +435,8 @@ void yon1_vnt_t::OutputHtslibVcfInfo(bcf1_t* rec, bcf_hdr_t* hdr) {
 void yon1_vnt_t::OutputHtslibVcfFormat(bcf1_t* rec,
 						   bcf_hdr_t* hdr,
 						   const bool display_genotypes,
-						   yon_gt_rcd* external_exp) const
+						   yon_gt_rcd* external_exp,
+						   const bool expanded) const
 {
 	if (n_fmt) {
 		// Case when the only available FORMAT field is the GT field.
@@ -368,7 +444,7 @@ void yon1_vnt_t::OutputHtslibVcfFormat(bcf1_t* rec,
 		   controller.gt_available &&
 		   display_genotypes)
 		{
-			gt->ExpandExternal(external_exp);
+			if (expanded == false) gt->ExpandExternal(external_exp);
 			gt->d_exp = external_exp;
 			gt->UpdateHtslibGenotypes(rec, hdr);
 			gt->d_exp = nullptr;
@@ -379,7 +455,7 @@ void yon1_vnt_t::OutputHtslibVcfFormat(bcf1_t* rec,
 				controller.gt_available &&
 				display_genotypes)
 		{
-			gt->ExpandExternal(external_exp);
+			if (expanded == false) gt->ExpandExternal(external_exp);
 			gt->d_exp = external_exp;
 
 			gt->UpdateHtslibGenotypes(rec, hdr);
@@ -420,7 +496,8 @@ void yon1_vnt_t::OutputHtslibVcfFilter(bcf1_t* rec, bcf_hdr_t* hdr) const {
 void yon1_vnt_t::ToVcfString(const yon_vnt_hdr_t& header,
 		   yon_buffer_t& buffer,
 		   uint32_t display,
-		   yon_gt_rcd* external_rcd) const
+		   yon_gt_rcd* external_rcd,
+		   const bool expanded) const
 {
 	buffer.Add(header.contigs_[rid].name.data(), header.contigs_[rid].name.size());
 	buffer += '\t';
@@ -479,7 +556,7 @@ void yon1_vnt_t::ToVcfString(const yon_vnt_hdr_t& header,
 		   controller.gt_available &&
 		   (display & YON_BLK_BV_GT))
 		{
-			gt->ExpandExternal(external_rcd);
+			if (expanded == false) gt->ExpandExternal(external_rcd);
 			gt->d_exp = external_rcd;
 
 			// Iterate over samples and print FORMAT:GT value in Vcf format.
@@ -497,7 +574,7 @@ void yon1_vnt_t::ToVcfString(const yon_vnt_hdr_t& header,
 				controller.gt_available &&
 				(display & YON_BLK_BV_GT))
 		{
-			gt->ExpandExternal(external_rcd);
+			if (expanded == false) gt->ExpandExternal(external_rcd);
 			gt->d_exp = external_rcd;
 
 			gt->d_exp[0].PrintVcf(buffer, gt->m);
@@ -591,7 +668,7 @@ bool yon1_vnt_t::AddGenotypeStatistics(yon_vnt_hdr_t& header, const bool replace
 	int j = 0;
 	for (uint32_t p = 0; p < n_base_ploidy; ++p) {
 		for (uint32_t i = 2; i < gt_sum->d->n_ac_af; ++i, ++j) {
-			ac_p->at(j) = gt_sum->alleles_strand[p][i];
+			ac_p->at(j) = gt_sum->GetAlleleStrandCount(p, i);
 			++(*ac_p);
 		}
 	}
@@ -606,28 +683,34 @@ bool yon1_vnt_t::AddGenotypeStatistics(yon_vnt_hdr_t& header, const bool replace
 	return true;
 }
 
-bool yon1_vnt_t::AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std::string>& names) {
+bool yon1_vnt_t::AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std::string>& names, const PopulationGenetics& popgen, const uint32_t record) {
 	if (names.size() == 0)
 		return true;
 
-	if (n_info + names.size()*10 + 3 > m_info) {
-		m_info += names.size()*10 + 3;
+	if (popgen.IsValid(record) == false)
+		return false;
+
+	if (n_info + names.size()*12 + 3 > m_info) {
+		m_info += names.size()*12 + 3;
 		PrimitiveContainerInterface** old = info;
 		info = new PrimitiveContainerInterface*[m_info];
 		for (int i = 0; i < n_info; ++i) info[i] = old[i];
 		delete [] old;
 	}
 
-	if (EvaluatePopGenOcc(header) == false) {
-		//std::cerr << utility::timestamp("ERROR") << "Failed to evaluate popgen for occ..." << std::endl;
-		return false;
-	}
+	float fis = popgen.fis[record], fst = popgen.fst[record], fit = popgen.fit[record];
+	this->AddInfo("FIS", header, fis);
+	this->AddInfo("FST", header, fst);
+	this->AddInfo("FIT", header, fit);
 
 	for (int i = 0; i < names.size(); ++i) {
+		const uint64_t offset = popgen.GetOffset(record, i);
 		this->AddInfo(names[i]+"_NM",    header, gt_sum_occ[i].d->nm);
 		this->AddInfo(names[i]+"_NPM",   header, gt_sum_occ[i].d->npm);
 		this->AddInfo(names[i]+"_AN",    header, gt_sum_occ[i].d->an);
-		this->AddInfo(names[i]+"_HWE_P", header, gt_sum_occ[i].d->hwe_p);
+		float hwe_p = popgen.hwe_p[offset], hwe_chisq_p = popgen.hwe_chisq_p[offset];
+		this->AddInfo(names[i]+"_HWE_P", header, hwe_p);
+		this->AddInfo(names[i]+"_HWE_CHISQ_P", header, hwe_chisq_p);
 
 		if (gt_sum_occ[i].d->n_ac_af > 2) {
 			this->AddInfo(names[i]+"_AC", header, &gt_sum_occ[i].d->ac[2], gt_sum_occ[i].d->n_ac_af - 2);
@@ -643,12 +726,19 @@ bool yon1_vnt_t::AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std
 		int j = 0;
 		for (uint32_t p = 0; p < n_base_ploidy; ++p) {
 			for (uint32_t k = 2; k < gt_sum_occ[i].d->n_ac_af; ++k, ++j) {
-				ac_p->at(j) = gt_sum_occ->alleles_strand[p][k];
+				ac_p->at(j) = gt_sum_occ[i].GetAlleleStrandCount(p, k);
 				++(*ac_p);
 			}
 		}
 		this->AddInfo(names[i]+"_AC_P", header, ac_p);
 
+		// Strand bias is only computed for bi-allelic records and
+		// therefore has a single value.
+		if (offset < popgen.strand_bias.size()) {
+			float fs_a = popgen.strand_bias[offset];
+			this->AddInfo(names[i]+"_FS_A", header, &fs_a, 1);
+		}
+
 		if (n_base_ploidy == 2) {
 			this->AddInfo(names[i]+"_F_PIC", header, gt_sum_occ[i].d->f_pic);
 			this->AddInfo(names[i]+"_HET",   header, gt_sum_occ[i].d->heterozygosity);
@@ -659,100 +749,6 @@ bool yon1_vnt_t::AddGenotypeStatisticsOcc(yon_vnt_hdr_t& header, std::vector<std
 	return true;
 }
 
-bool yon1_vnt_t::EvaluatePopGenOcc(yon_vnt_hdr_t& header) {
-	if (this->gt == nullptr) return false;
-	if (this->gt->n_o == 0) return false;
-	if (gt->n_allele != 2 || gt->m != 2) return false;
-
-	// Number of genotypes across populations.
-	uint32_t n_gt_all = 0;
-	uint32_t n_gt_ref = 0, n_gt_alt, n_gt_het = 0;
-
-	float* obs = new float[this->gt->n_o];
-	float* exp = new float[this->gt->n_o];
-	uint32_t* n_s = new uint32_t[this->gt->n_o];
-
-	for (int i = 0; i < this->gt->n_o; ++i) {
-		const uint32_t het  = this->gt_sum_occ[i].gt[2][3].n_cnt + this->gt_sum_occ[i].gt[3][2].n_cnt;
-		const uint32_t n_gt = het + this->gt_sum_occ[i].gt[2][2].n_cnt + this->gt_sum_occ[i].gt[3][3].n_cnt;
-
-		if (n_gt == 0) {
-			obs[i] = 0; exp[i] = 0; n_s[i] = 0;
-			continue;
-		}
-		n_gt_all += n_gt;
-		n_gt_ref += this->gt_sum_occ[i].gt[2][2].n_cnt;
-		n_gt_alt += this->gt_sum_occ[i].gt[3][3].n_cnt;
-		n_gt_het += het;
-
-		const float p  = (2*(float)this->gt_sum_occ[i].gt[2][2].n_cnt + het) / (2*n_gt);
-		const float q  = (2*(float)this->gt_sum_occ[i].gt[3][3].n_cnt + het) / (2*n_gt);
-		const float pq2 = 2*p*q;
-
-
-		// F = (Hexp - Hobs) / Hexp
-		const float Hobs = (float)het/n_gt; // observed heterozygosities in populations
-		const float Hexp = (float)pq2;      // expected heterozygosities in populations
-
-		/*
-		std::cerr << "occ" << i << "\t" <<
-		this->gt_sum_occ[i].gt[2][2].n_cnt << "\t" <<
-		this->gt_sum_occ[i].gt[2][3].n_cnt << "\t" <<
-		this->gt_sum_occ[i].gt[3][2].n_cnt << "\t" <<
-		this->gt_sum_occ[i].gt[3][3].n_cnt << "\t" <<
-		p << "\t" << (1-p) << "\t" <<
-		Hexp << "\t" << Hobs << "\t" << "F=" <<
-		(Hexp - Hobs) / Hexp << "\t" << Hobs*n_gt << "/" << Hexp*n_gt << "/" << n_gt << std::endl;
-		*/
-
-		obs[i] = Hobs;
-		exp[i] = Hexp;
-		n_s[i] = n_gt;
-	}
-
-	if (n_gt_all == 0)
-		return false;
-
-	float exp_sum = 0, obs_sum = 0;
-	for (int i = 0; i < this->gt->n_o; ++i) {
-		exp_sum += exp[i] * n_s[i];
-		obs_sum += obs[i] * n_s[i];
-	}
-
-	const float h_i = obs_sum / n_gt_all;
-	const float h_s = exp_sum / n_gt_all;
-	// p-bar (frequency of allele A) over all populations
-	// q-bar
-	const float p_bar = (2*(float)n_gt_ref + n_gt_het) / (2*n_gt_all);
-	const float q_bar = (2*(float)n_gt_alt + n_gt_het) / (2*n_gt_all);
-	const float h_t   =  2*p_bar*q_bar;
-
-	//std::cerr << "pbar=" << p_bar << " qbar=" << q_bar << " with " << n_gt_all << std::endl;
-	//std::cerr << "sums: " << exp_sum << ", " << obs_sum << std::endl;
-	//std::cerr << "hi=" << h_i << ", hs=" << h_s << ", ht=" << h_t << std::endl;
-
-	// Fstatistics
-	// FIS [= (HS - HI)/HS]
-	//std::cerr << "FIS=" << (h_s - h_i) / h_s << std::endl;
-	// FST [= (HT - HS)/HT]
-	//std::cerr << "FST=" << (h_t - h_s) / h_t << std::endl;
-	// FIT [= (HT - HI)/HT]
-	//std::cerr << "FIT=" << (h_t - h_i) / h_t << std::endl;
-	float fis = 0, fst = 0, fit = 0;
-
-	if (h_s != 0) fis = (h_s - h_i) / h_s;
-	if (h_t != 0) fst = (h_t - h_s) / h_t;
-	if (h_t != 0) fit = (h_t - h_i) / h_t;
-
-	this->AddInfo("FIS", header, fis);
-	this->AddInfo("FST", header, fst);
-	this->AddInfo("FIT", header, fit);
-
-	delete [] exp; delete [] obs; delete [] n_s;
-
-	return true;
-}
-
 PrimitiveContainerInterface* yon1_vnt_t::GetInfo(const std::string& name) const {
 	std::unordered_map<std::string, uint32_t>::const_iterator it = info_map.find(name);
 	if (it != info_map.end()) return(info[it->second]);
@@ -899,13 +895,22 @@ void yon_stats_sample::reset(void) {
 }
 
 yon_stats_tstv::yon_stats_tstv() : n_s(0), n_rcds(0), n_snp(0), n_mnp(0), n_ins(0), n_del(0), n_other(0), n_no_alts(0), n_singleton(0),
-				   n_biallelic(0), n_multi_allele(0), n_multi_allele_snp(0), sample(nullptr), alt_count(new uint64_t[32]) { memset(alt_count, 0, sizeof(uint64_t)*32); }
+				   n_biallelic(0), n_multi_allele(0), n_multi_allele_snp(0), sample(nullptr), alt_count(new uint64_t[32])
+{
+	memset(alt_count, 0, sizeof(uint64_t)*32);
+	memset(slot_map, -1, sizeof(int32_t)*YON_STATS_TSTV_KEYS);
+}
 yon_stats_tstv::yon_stats_tstv(const uint32_t n_samples) : n_s(n_samples), n_rcds(0), n_snp(0), n_mnp(0), n_ins(0), n_del(0), n_other(0), n_no_alts(0), n_singleton(0),
-										   n_biallelic(0), n_multi_allele(0), n_multi_allele_snp(0), sample(new yon_stats_sample[n_samples]), alt_count(new uint64_t[32]) { memset(alt_count, 0, sizeof(uint64_t)*32); }
+										   n_biallelic(0), n_multi_allele(0), n_multi_allele_snp(0), sample(new yon_stats_sample[n_samples]), alt_count(new uint64_t[32])
+{
+	memset(alt_count, 0, sizeof(uint64_t)*32);
+	memset(slot_map, -1, sizeof(int32_t)*YON_STATS_TSTV_KEYS);
+}
 yon_stats_tstv::~yon_stats_tstv(void) { delete [] this->sample; delete [] this->alt_count; }
 
 yon_stats_tstv& yon_stats_tstv::operator+=(const yon_stats_tstv& other) {
 	assert(other.n_s == this->n_s);
+	assert(other.slot_key.size() == 0);
 	this->n_rcds  += other.n_rcds;
 	this->n_snp   += other.n_snp;
 	this->n_mnp   += other.n_mnp;
@@ -930,6 +935,7 @@ yon_stats_tstv& yon_stats_tstv::Add(const yon_stats_tstv& other, const yon_gt_pp
 
 	assert(ppa->n_s == this->n_s);
 	assert(other.n_s == this->n_s);
+	assert(other.slot_key.size() == 0);
 
 	this->n_rcds += other.n_rcds;
 	this->n_snp += other.n_snp;
@@ -953,6 +959,11 @@ void yon_stats_tstv::SetSize(const uint32_t n_samples) {
 	delete [] sample;
 	n_s = n_samples;
 	sample = new yon_stats_sample[n_samples];
+
+	// Difference arrays are strided by the number of samples.
+	memset(slot_map, -1, sizeof(int32_t)*YON_STATS_TSTV_KEYS);
+	slot_key.clear();
+	diff.clear();
 }
 
 yon_buffer_t& yon_stats_tstv::ToJsonString(yon_buffer_t& buffer, const std::vector<std::string>& sample_names) const {
@@ -1202,24 +1213,37 @@ bool yon_stats_tstv::Update(const yon1_vnt_t& rcd) {
 	return true;
 }
 
+// Bin of an indel length in ins_del_dist: lengths are zigzagged.
+static inline uint32_t YonStatsIndelBin(const int32_t b_size) {
+	return((b_size << 1) ^ (b_size >> 31));
+}
+
 void yon_stats_tstv::UpdateDiploid(const yon_gt* gt,
                                    yon_stats_tstv_obj& helper)
 {
+	const uint32_t ref = helper.allele_encodings[YON_GT_RCD_REF] * 9;
 	uint32_t sample_offset = 0;
 	for (uint32_t i = 0; i < gt->n_i; ++i) {
-		if ((YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[0]) == YON_GT_RCD_REF) && (YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[1]) == YON_GT_RCD_REF)) {
-			sample_offset += gt->rcds[i].run_length;
+		const uint32_t from = sample_offset;
+		sample_offset += gt->rcds[i].run_length;
+
+		const uint8_t a0 = YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[0]);
+		const uint8_t a1 = YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[1]);
+		if (a0 == YON_GT_RCD_REF && a1 == YON_GT_RCD_REF)
 			continue;
-		}
 
-		for (uint32_t r = 0; r < gt->rcds[i].run_length; ++r, ++sample_offset) {
-			for (uint32_t j = 0; j < gt->m; ++j) {
-				const uint8_t allele = YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[j]);
-				++this->sample[sample_offset].base_conv[helper.allele_encodings[YON_GT_RCD_REF]][helper.allele_encodings[allele]];
-				++this->sample[sample_offset].ins_del_dist[(helper.b_size[allele] << 1) ^ (helper.b_size[allele] >> 31)];
-				helper.n_non_ref += helper.non_ref_encodings[allele];
-				helper.t_non_ref += helper.non_ref_encodings[allele] * sample_offset;
-			}
+		// Every sample in the run receives the same updates.
+		this->AddRange(ref + helper.allele_encodings[a0], from, sample_offset, 1);
+		this->AddRange(ref + helper.allele_encodings[a1], from, sample_offset, 1);
+		this->AddRange(YON_STATS_TSTV_CONV_KEYS + YonStatsIndelBin(helper.b_size[a0]), from, sample_offset, 1);
+		this->AddRange(YON_STATS_TSTV_CONV_KEYS + YonStatsIndelBin(helper.b_size[a1]), from, sample_offset, 1);
+
+		// The carrier is only used if there is a single non-reference
+		// allele in which case it is the first sample of its run.
+		const uint32_t n_non_ref = helper.non_ref_encodings[a0] + helper.non_ref_encodings[a1];
+		if (n_non_ref) {
+			helper.n_non_ref += n_non_ref * gt->rcds[i].run_length;
+			helper.t_non_ref  = from;
 		}
 	}
 	assert(sample_offset == this->n_s);
@@ -1228,34 +1252,76 @@ void yon_stats_tstv::UpdateDiploid(const yon_gt* gt,
 void yon_stats_tstv::UpdateNPloidy(const yon_gt* gt,
                                    yon_stats_tstv_obj& helper)
 {
+	const uint32_t ref = helper.allele_encodings[YON_GT_RCD_REF] * 9;
 	uint32_t sample_offset = 0;
 	for (uint32_t i = 0; i < gt->n_i; ++i) {
+		const uint32_t from = sample_offset;
+		sample_offset += gt->rcds[i].run_length;
+
 		// If current run-length encoded object has all reference
 		// template then continue.
 		uint32_t n_refs = 0;
 		for (uint32_t j = 0; j < gt->m; ++j)
 			n_refs += (YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[j]) == YON_GT_RCD_REF);
 
-		if (n_refs == gt->m) {
-			sample_offset += gt->rcds[i].run_length;
+		if (n_refs == gt->m)
 			continue;
+
+		// Every sample in the run receives the same updates.
+		uint32_t n_non_ref = 0;
+		for (uint32_t j = 0; j < gt->m; ++j) {
+			const uint8_t allele = YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[j]);
+			this->AddRange(ref + helper.allele_encodings[allele], from, sample_offset, 1);
+			this->AddRange(YON_STATS_TSTV_CONV_KEYS + YonStatsIndelBin(helper.b_size[allele]), from, sample_offset, 1);
+			n_non_ref += helper.non_ref_encodings[allele];
 		}
 
-		// Iterate over samples in the current run-length encoded object.
-		for (uint32_t r = 0; r < gt->rcds[i].run_length; ++r, ++sample_offset) {
-			for (uint32_t j = 0; j < gt->m; ++j) {
-				const uint8_t allele = YON_GT_RCD_ALLELE_UNPACK(gt->rcds[i].allele[j]);
-				++this->sample[sample_offset].base_conv[helper.allele_encodings[YON_GT_RCD_REF]][helper.allele_encodings[allele]];
-				++this->sample[sample_offset].ins_del_dist[(helper.b_size[allele] << 1) ^ (helper.b_size[allele] >> 31)];
-				helper.n_non_ref += helper.non_ref_encodings[allele];
-				helper.t_non_ref += helper.non_ref_encodings[allele] * sample_offset;
-			}
+		if (n_non_ref) {
+			helper.n_non_ref += n_non_ref * gt->rcds[i].run_length;
+			helper.t_non_ref  = from;
 		}
 	}
 	assert(sample_offset == this->n_s);
 }
 
+void yon_stats_tstv::Flush(void) {
+	const uint64_t stride = (uint64_t)this->n_s + 1;
+	for (uint32_t k = 0; k < this->slot_key.size(); ++k) {
+		const uint32_t key = this->slot_key[k];
+		int32_t* d = &this->diff[k * stride];
+
+		// Stream over the samples once per counter and clear the
+		// difference array for the next block.
+		int64_t running = 0;
+		if (key < YON_STATS_TSTV_CONV_KEYS) {
+			const uint32_t r = key / 9, c = key % 9;
+			for (uint32_t i = 0; i < this->n_s; ++i) {
+				running += d[i];
+				d[i] = 0;
+				if (running) this->sample[i].base_conv[r][c] += running;
+			}
+		} else {
+			const uint32_t bin = key - YON_STATS_TSTV_CONV_KEYS;
+			for (uint32_t i = 0; i < this->n_s; ++i) {
+				running += d[i];
+				d[i] = 0;
+				if (running) this->sample[i].ins_del_dist[bin] += running;
+			}
+		}
+		d[this->n_s] = 0;
+		this->slot_map[key] = -1;
+	}
+	this->slot_key.clear();
+}
+
 void yon_stats_tstv::reset(void) {
+	// Discard pending updates.
+	for (uint32_t k = 0; k < slot_key.size(); ++k) {
+		memset(&diff[k * ((uint64_t)n_s + 1)], 0, sizeof(int32_t)*(n_s + 1));
+		slot_map[slot_key[k]] = -1;
+	}
+	slot_key.clear();
+
 	n_rcds = 0;
 	n_snp = 0, n_mnp = 0, n_ins = 0, n_del = 0, n_other = 0;
 	n_no_alts = 0, n_biallelic = 0, n_multi_allele = 0, n_multi_allele_snp = 0, n_singleton = 0;
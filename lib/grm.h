@@ -0,0 +1,277 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef GRM_H_
+#define GRM_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <getopt.h>
+
+#include "program_utils.h"
+#include "variant_reader.h"
+#include "relatedness.h"
+
+void grm_usage(void) {
+	programMessage(true);
+	std::cerr <<
+	"About:  Compute the genomic relationship matrix or KING-robust kinship\n"
+	"        coefficients of all pairs of samples over diploid polymorphic records.\n"
+	"        Output is either one line per pair of samples or a dense matrix.\n"
+	"        Long runs can be checkpointed and resumed from the last checkpoint.\n"
+	"Usage:  " << tachyon::TACHYON_PROGRAM_NAME << " grm [options] -i <in.yon>\n\n"
+	"Options:\n"
+	"  -i FILE   input YON file (required)\n"
+	"  -o FILE   output file (- for stdout) [-]\n"
+	"  -m STRING estimator: grm or king [grm]\n"
+	"  -r STRING interval string (e.g. chr20:10e6-11e6 or chr11:451021)\n"
+	"  -d FLOAT  minimum allele frequency\n"
+	"  -D FLOAT  maximum allele frequency\n"
+	"  -x        output a dense samples x samples matrix\n"
+	"  -c FILE   checkpoint file\n"
+	"  -C INT    number of blocks between checkpoints [100]\n"
+	"  -R        resume from the checkpoint file\n"
+	"  -t INT    number of threads [all]\n"
+	"  -k FILE   keychain file with encryption keys (required if the file is encrypted)\n"
+	"  -s        hide all program messages [null]\n" << std::endl;
+}
+
+int grm(int argc, char** argv) {
+	if (argc <= 2) {
+		grm_usage();
+		return(1);
+	}
+
+	int c;
+	int option_index = 0;
+	static struct option long_options[] = {
+		{"input",      required_argument, 0, 'i' },
+		{"output",     required_argument, 0, 'o' },
+		{"mode",       required_argument, 0, 'm' },
+		{"region",     required_argument, 0, 'r' },
+		{"af-min",     required_argument, 0, 'd' },
+		{"af-max",     required_argument, 0, 'D' },
+		{"dense",      no_argument,       0, 'x' },
+		{"checkpoint", required_argument, 0, 'c' },
+		{"checkpoint-blocks", required_argument, 0, 'C' },
+		{"resume",     no_argument,       0, 'R' },
+		{"threads",    required_argument, 0, 't' },
+		{"keychain",   required_argument, 0, 'k' },
+		{"silent",     no_argument,       0, 's' },
+		{0,0,0,0}
+	};
+
+	SILENT = 0;
+	tachyon::VariantReaderSettings settings;
+	tachyon::yon_grm_settings grm_settings;
+	grm_settings.n_threads = std::thread::hardware_concurrency();
+	std::vector<std::string> interval_strings;
+	std::string mode, checkpoint, filter_strings;
+	int32_t checkpoint_blocks = 100;
+	bool dense = false, resume = false;
+
+	tachyon::VariantReader reader;
+	tachyon::VariantReaderFilters& filters = reader.GetFilterSettings();
+
+	while ((c = getopt_long(argc, argv, "i:o:m:r:d:D:xc:C:Rt:k:s?", long_options, &option_index)) != -1) {
+		switch (c) {
+		case 0:
+			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
+			break;
+		case 'i':
+			settings.input = std::string(optarg);
+			break;
+		case 'o':
+			settings.output = std::string(optarg);
+			break;
+		case 'm':
+			mode = std::string(optarg);
+			if (mode == "grm") grm_settings.mode = tachyon::YON_GRM_STANDARDIZED;
+			else if (mode == "king") grm_settings.mode = tachyon::YON_GRM_KING;
+			else {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Unknown estimator: " << mode << "..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'r':
+			interval_strings.push_back(std::string(optarg));
+			break;
+		case 'd':
+			filter_strings += "d=" + std::string(optarg) + ';';
+			filters.Add(tachyon::YON_FILTER_ALLELE_FREQUENCY, atof(optarg), tachyon::YON_CMP_GREATER);
+			break;
+		case 'D':
+			filter_strings += "D=" + std::string(optarg) + ';';
+			filters.Add(tachyon::YON_FILTER_ALLELE_FREQUENCY, atof(optarg), tachyon::YON_CMP_LESS_EQUAL);
+			break;
+		case 'x':
+			dense = true;
+			break;
+		case 'c':
+			checkpoint = std::string(optarg);
+			break;
+		case 'C':
+			checkpoint_blocks = atoi(optarg);
+			if (checkpoint_blocks <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set checkpoint to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'R':
+			resume = true;
+			break;
+		case 't':
+			grm_settings.n_threads = atoi(optarg);
+			break;
+		case 'k':
+			settings.keychain_file = std::string(optarg);
+			break;
+		case 's':
+			SILENT = 1;
+			break;
+		default:
+			grm_usage();
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Unrecognized option: " << (char)c << std::endl;
+			return(1);
+		}
+	}
+
+	if (settings.input.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No input value specified..." << std::endl;
+		return(1);
+	}
+
+	if (resume && checkpoint.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot resume without a checkpoint file..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		programMessage();
+		std::cerr << tachyon::utility::timestamp("LOG") << "Calling grm..." << std::endl;
+	}
+
+	reader.GetSettings() = settings;
+	if (!reader.open(settings.input)) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open file: " << settings.input << "..." << std::endl;
+		return(1);
+	}
+	reader.GetBlockSettings().LoadMinimumVcf(true).LoadGenotypes(true);
+	if (reader.AddIntervals(interval_strings) == false) return(1);
+
+	// A checkpoint is only valid for the same input, intervals, and
+	// filters.
+	std::ifstream input_stream(settings.input, std::ios::binary | std::ios::ate);
+	grm_settings.fingerprint = "bytes=" + std::to_string((int64_t)input_stream.tellg()) + ';'
+	                         + "blocks=" + std::to_string(reader.GetIndex().GetLinearSize()) + ';';
+	for (uint32_t i = 0; i < interval_strings.size(); ++i)
+		grm_settings.fingerprint += "r=" + interval_strings[i] + ';';
+	grm_settings.fingerprint += filter_strings;
+
+	const tachyon::yon_vnt_hdr_t& header = reader.GetHeader();
+	tachyon::Relatedness engine;
+	if (engine.Open(header.GetNumberSamples(), grm_settings) == false)
+		return(1);
+
+	if (resume) {
+		if (engine.LoadCheckpoint(checkpoint) == false)
+			return(1);
+
+		if (!SILENT) {
+			std::cerr << tachyon::utility::timestamp("LOG") << "Resuming after " << tachyon::utility::ToPrettyString(engine.GetNumberBlocks()) << " blocks and "
+			          << tachyon::utility::ToPrettyString(engine.GetNumberRecords()) << " records..." << std::endl;
+		}
+	}
+
+	// Blocks consumed are counted by the engine such that a checkpoint
+	// records where to resume.
+	const bool ret = reader.GetFilteredBlocks([&](tachyon::yon1_vc_t& vc, const std::vector<uint8_t>& pass) {
+		for (uint32_t i = 0; i < vc.size(); ++i) {
+			if (pass[i] == false) continue;
+			if (vc[i].is_loaded_gt == false || vc[i].controller.gt_available == false || vc[i].gt == nullptr) continue;
+			if (vc[i].gt->Evaluate() == false) return false;
+			if (engine.Add(*vc[i].gt) == false) return false;
+		}
+
+		engine.SetNumberBlocks(engine.GetNumberBlocks() + 1);
+		if (checkpoint.size() && engine.GetNumberBlocks() % checkpoint_blocks == 0)
+			return(engine.SaveCheckpoint(checkpoint));
+
+		return true;
+	}, engine.GetNumberBlocks());
+
+	if (ret == false) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to compute relatedness..." << std::endl;
+		return(1);
+	}
+
+	engine.Flush();
+	if (checkpoint.size() && engine.SaveCheckpoint(checkpoint) == false)
+		return(1);
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Used " << tachyon::utility::ToPrettyString(engine.GetNumberRecords()) << " records ("
+		          << tachyon::utility::ToPrettyString(engine.GetNumberSkipped()) << " skipped)..." << std::endl;
+	}
+
+	std::ofstream out_file;
+	if (settings.output.size() && settings.output != "-") {
+		out_file.open(settings.output);
+		if (!out_file.good()) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open: " << settings.output << std::endl;
+			return(1);
+		}
+	}
+	std::ostream& out = out_file.is_open() ? out_file : std::cout;
+
+	const uint32_t n_samples = engine.GetNumberSamples();
+	if (dense) {
+		out << "SAMPLE";
+		for (uint32_t j = 0; j < n_samples; ++j) out << '\t' << header.samples_[j];
+		out << '\n';
+		for (uint32_t i = 0; i < n_samples; ++i) {
+			out << header.samples_[i];
+			for (uint32_t j = 0; j < n_samples; ++j) out << '\t' << engine.GetRelatedness(i, j);
+			out << '\n';
+		}
+	} else {
+		out << "SAMPLE_A\tSAMPLE_B\tN\t" << (grm_settings.mode == tachyon::YON_GRM_KING ? "KINSHIP" : "GRM") << '\n';
+		for (uint32_t i = 0; i < n_samples; ++i) {
+			for (uint32_t j = i; j < n_samples; ++j) {
+				out << header.samples_[i] << '\t' << header.samples_[j] << '\t'
+				    << engine.GetNumberObserved(i, j) << '\t' << engine.GetRelatedness(i, j) << '\n';
+			}
+		}
+	}
+	out.flush();
+
+	if (out.good() == false) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to write output..." << std::endl;
+		return(1);
+	}
+
+	return 0;
+}
+
+#endif /* GRM_H_ */
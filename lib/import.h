@@ -36,12 +36,28 @@ void import_usage(void) {
 	"  -o FILE  output file prefix (required, \"-\" for piping to stdout)\n"
 	"  -c INT   Import checkpoint size in number of variants (default: 1000)\n"
 	"  -C FLOAT Import checkpoint size in bases (default: 5 Mb)\n"
+	"  -b INT   Target uncompressed block size in bytes: adapts -c to the data (default: off)\n"
+	"  -B INT   Target compressed block size in bytes: adapts -c to the data (default: off)\n"
+	"  -m INT   Minimum number of variants per block when using -b/-B (default: 100)\n"
+	"  -M INT   Maximum number of variants per block when using -b/-B (default: 100000)\n"
 	"  -L INT   Compression level 1-20 (default: 6)\n"
 	"  -t INT   Number of compression threads (default: all available)\n"
 	"  -p/-P    Permute/Do not permute diploid genotypes\n"
+	"  -g INT   Number of threads used to permute genotypes in each block (default: 1)\n"
+	"  -K INT   Seed each block's permutation with that of the preceding block and store it\n"
+	"           as a delta, with a full permutation every INT blocks (default: off)\n"
+	"  -H       Encode fully phased diploid biallelic blocks as a haplotype PBWT\n"
+	"  -z       Encode records with few carriers as sparse carrier lists (not readable\n"
+	"           by versions prior to sparse genotype support)\n"
 	"  -e       Encrypt data with AES-256\n"
 	"  -t       Number of consumer threads for import (default: max available)\n"
 	"  -T       Number of (extra) htslib threads for decompression (default: max available)\n"
+	"  -k INT   Write a resume checkpoint every INT blocks (default: 100, 0 to disable)\n"
+	"  -R       Resume an interrupted import from its checkpoint (not with -e)\n"
+	"  -a       Append to an existing archive with a compatible header (not with -e or -S)\n"
+	"  -S       Sort unsorted input by contig and position prior to import\n"
+	"  -x INT   Memory per sorting run in MB when using -S (default: 1024)\n"
+	"  -d DIR   Directory for temporary sorting runs when using -S (default: .)\n"
 	"  -s       Hide all program messages [null]\n";
 }
 
@@ -63,12 +79,26 @@ int import(int argc, char** argv) {
 		{"output",              optional_argument, 0, 'o' },
 		{"checkpoint-variants", optional_argument, 0, 'c' },
 		{"checkpoint-bases",    optional_argument, 0, 'C' },
+		{"block-bytes",         optional_argument, 0, 'b' },
+		{"block-bytes-compressed", optional_argument, 0, 'B' },
+		{"min-block-variants",  optional_argument, 0, 'm' },
+		{"max-block-variants",  optional_argument, 0, 'M' },
 		{"compression-level",   optional_argument, 0, 'L' },
 		{"permute",             no_argument,       0, 'p' },
 		{"encrypt",             no_argument,       0, 'e' },
 		{"no-permute",          no_argument,       0, 'P' },
+		{"permute-threads",     optional_argument, 0, 'g' },
+		{"carry-permutation",   optional_argument, 0, 'K' },
+		{"haplotypes",          no_argument,       0, 'H' },
+		{"sparse-genotypes",    no_argument,       0, 'z' },
 		{"threads",             optional_argument, 0, 't' },
 		{"hts-threads",         optional_argument, 0, 'T' },
+		{"checkpoint-interval", optional_argument, 0, 'k' },
+		{"resume",              no_argument,       0, 'R' },
+		{"append",              no_argument,       0, 'a' },
+		{"sort",                no_argument,       0, 'S' },
+		{"sort-memory",         optional_argument, 0, 'x' },
+		{"temp-dir",            optional_argument, 0, 'd' },
 		{"silent",              no_argument,       0, 's' },
 		{0,0,0,0}
 	};
@@ -77,7 +107,7 @@ int import(int argc, char** argv) {
 
 	tachyon::VariantImporterSettings settings;
 
-	while ((c = getopt_long(argc, argv, "i:o:c:C:L:t:T:sepP?", long_options, &option_index)) != -1) {
+	while ((c = getopt_long(argc, argv, "i:o:c:C:b:B:m:M:L:t:T:g:K:k:x:d:sepPRaSHz?", long_options, &option_index)) != -1) {
 		switch (c) {
 		case 0:
 			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
@@ -105,6 +135,29 @@ int import(int argc, char** argv) {
 				return(1);
 			}
 			break;
+		case 'b':
+		case 'B':
+			settings.checkpoint_bytes      = atoll(optarg);
+			settings.checkpoint_compressed = (c == 'B');
+			if (settings.checkpoint_bytes <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set block size to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'm':
+			settings.checkpoint_min_snps = atoi(optarg);
+			if (settings.checkpoint_min_snps <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set minimum number of variants per block to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'M':
+			settings.checkpoint_max_snps = atoi(optarg);
+			if (settings.checkpoint_max_snps <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set maximum number of variants per block to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
 		case 'L':
 			settings.compression_level = atoi(optarg);
 			if (settings.compression_level <= 0) {
@@ -114,8 +167,42 @@ int import(int argc, char** argv) {
 			break;
 		case 'p': settings.permute_genotypes = true;  break;
 		case 'P': settings.permute_genotypes = false; break;
+		case 'H': settings.haplotype_pbwt = true; break;
+		case 'z': settings.sparse_genotypes = true; break;
 		case 't': settings.n_threads = atoi(optarg); break;
 		case 'T': settings.htslib_extra_threads = atoi(optarg); break;
+		case 'g':
+			settings.permute_threads = atoi(optarg);
+			if (settings.permute_threads <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set the number of permutation threads to " << settings.permute_threads << std::endl;
+				return(1);
+			}
+			break;
+		case 'K':
+			settings.permute_carry_interval = atoi(optarg);
+			if (settings.permute_carry_interval < 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set the permutation interval to < 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'k':
+			settings.checkpoint_interval = atoi(optarg);
+			if (settings.checkpoint_interval < 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set checkpoint interval to < 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'R': settings.resume = true; break;
+		case 'a': settings.append = true; break;
+		case 'S': settings.sort = true; break;
+		case 'x':
+			settings.sort_run_bytes = atoll(optarg) * 1024 * 1024;
+			if (settings.sort_run_bytes <= 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set sorting memory to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'd': settings.temp_directory = std::string(optarg); break;
 		case 's':
 			SILENT = 1;
 			break;
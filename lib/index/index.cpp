@@ -159,6 +159,47 @@ yon_index_t& yon_index_t::operator+=(const entry_type& entry) {
 	return(*this);
 }
 
+bool yon_index_t::Append(const self_type& other, const uint32_t block_offset, const int64_t byte_offset_delta) {
+	if (this->mImpl->index_.size() != other.mImpl->index_.size()) {
+		std::cerr << utility::timestamp("ERROR", "INDEX") << "Cannot append an index with a different number of contigs (" << other.mImpl->index_.size() << " != " << this->mImpl->index_.size() << ")..." << std::endl;
+		return false;
+	}
+
+	// Check that the appended entries keep this archive sorted.
+	if (other.mImpl->linear_.size()) {
+		const entry_type& first = other.mImpl->linear_.front();
+		if (this->mImpl->linear_.size() && this->mImpl->linear_.back().contig_id == first.contig_id) {
+			if (first.min_position < this->mImpl->linear_.back().min_position) {
+				std::cerr << utility::timestamp("ERROR", "INDEX") << "Appended blocks are unsorted: position " << first.min_position << " < " << this->mImpl->linear_.back().min_position << "..." << std::endl;
+				return false;
+			}
+		} else if (this->is_sorted_ && this->mImpl->index_meta_[first.contig_id].n_blocks != 0) {
+			std::cerr << utility::timestamp("ERROR", "INDEX") << "Appended blocks map to contig " << first.contig_id << " that is not at the end of the archive..." << std::endl;
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < other.mImpl->linear_.size(); ++i) {
+		entry_type entry = other.mImpl->linear_[i];
+		entry.block_id        = block_offset + i;
+		entry.byte_offset     = entry.byte_offset + byte_offset_delta;
+		entry.byte_offset_end = entry.byte_offset_end + byte_offset_delta;
+		*this += entry;
+	}
+
+	// Remap the quad-tree bins to the new block identifiers and merge.
+	IndexImpl::variant_quad_tree_type shifted(other.mImpl->index_);
+	for (uint32_t i = 0; i < shifted.size(); ++i) {
+		for (uint32_t j = 0; j < shifted[i].size(); ++j) {
+			for (uint32_t k = 0; k < shifted[i][j].size(); ++k)
+				shifted[i][j][k] += block_offset;
+		}
+	}
+	this->mImpl->index_ += shifted;
+
+	return true;
+}
+
 yon1_idx_rec& yon_index_t::operator[](const uint32_t block_id) { return(this->mImpl->linear_.at(block_id)); }
 const yon1_idx_rec& yon_index_t::operator[](const uint32_t block_id) const { return(this->mImpl->linear_.at(block_id)); }
 
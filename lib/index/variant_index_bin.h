@@ -83,7 +83,7 @@ public:
 					temp[new_size++] = this->blocks_[i];
 				}
 			}
-			memcpy(temp, this->blocks_, new_size*sizeof(value_type));
+			memcpy(this->blocks_, temp, new_size*sizeof(value_type));
 			delete [] temp;
 			this->n_blocks_ = new_size;
     	}
@@ -0,0 +1,128 @@
+#include <cstdio>
+#include <cstring>
+
+#include "import_checkpoint.h"
+#include "utility.h"
+
+namespace tachyon {
+
+yon_import_ckpt::yon_import_ckpt() :
+	n_samples(0),
+	n_contigs(0),
+	input_offset(-1),
+	n_blocks_written(0),
+	n_variants_written(0),
+	byte_offset_end(0)
+{}
+
+bool yon_import_ckpt::Write(const std::string& path) const {
+	const std::string temp_path = path + ".tmp";
+	std::ofstream stream(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.good()) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Could not open: " << temp_path << "!" << std::endl;
+		return false;
+	}
+
+	stream << *this;
+	stream.flush();
+	if (!stream.good()) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Failed to write checkpoint: " << temp_path << "!" << std::endl;
+		return false;
+	}
+	stream.close();
+
+	if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Failed to rename " << temp_path << " to " << path << "!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool yon_import_ckpt::Read(const std::string& path) {
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream.good()) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Could not open: " << path << "!" << std::endl;
+		return false;
+	}
+
+	char magic_string[8];
+	stream.read(&magic_string[0], TACHYON_CHECKPOINT_MAGIC.size());
+	if (!stream.good() || strncmp(&magic_string[0], &TACHYON_CHECKPOINT_MAGIC[0], TACHYON_CHECKPOINT_MAGIC.size()) != 0) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Illegal checkpoint magic string in " << path << "!" << std::endl;
+		return false;
+	}
+
+	stream >> *this;
+	if (stream.fail()) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Truncated or corrupted checkpoint: " << path << "!" << std::endl;
+		return false;
+	}
+
+	if (this->index_entries.size() != this->n_blocks_written) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Checkpoint index has " << this->index_entries.size() << " entries but " << this->n_blocks_written << " blocks were written!" << std::endl;
+		return false;
+	}
+
+	if (this->input_offset < 0) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Checkpoint has no valid input position!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool yon_import_ckpt::IsCompatible(const std::string& input_file, const uint32_t n_samples, const uint32_t n_contigs) const {
+	if (this->input_file != input_file) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Checkpoint was written for input " << this->input_file << " and not " << input_file << "!" << std::endl;
+		return false;
+	}
+
+	if (this->n_samples != n_samples || this->n_contigs != n_contigs) {
+		std::cerr << utility::timestamp("ERROR", "CHECKPOINT") << "Input header does not match the checkpoint (" << n_samples << "/" << this->n_samples << " samples, " << n_contigs << "/" << this->n_contigs << " contigs)!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+std::ostream& operator<<(std::ostream& stream, const yon_import_ckpt& ckpt) {
+	stream.write(&TACHYON_CHECKPOINT_MAGIC[0], TACHYON_CHECKPOINT_MAGIC.size());
+	utility::SerializeString(ckpt.input_file, stream);
+	utility::SerializePrimitive(ckpt.n_samples, stream);
+	utility::SerializePrimitive(ckpt.n_contigs, stream);
+	utility::SerializePrimitive(ckpt.input_offset, stream);
+	utility::SerializePrimitive(ckpt.n_blocks_written, stream);
+	utility::SerializePrimitive(ckpt.n_variants_written, stream);
+	utility::SerializePrimitive(ckpt.byte_offset_end, stream);
+
+	const uint64_t n_entries = ckpt.index_entries.size();
+	utility::SerializePrimitive(n_entries, stream);
+	for (uint64_t i = 0; i < n_entries; ++i)
+		stream << ckpt.index_entries[i];
+
+	utility::SerializeString(ckpt.digest_state, stream);
+	return(stream);
+}
+
+std::istream& operator>>(std::istream& stream, yon_import_ckpt& ckpt) {
+	// The magic string is consumed by the caller.
+	utility::DeserializeString(ckpt.input_file, stream);
+	utility::DeserializePrimitive(ckpt.n_samples, stream);
+	utility::DeserializePrimitive(ckpt.n_contigs, stream);
+	utility::DeserializePrimitive(ckpt.input_offset, stream);
+	utility::DeserializePrimitive(ckpt.n_blocks_written, stream);
+	utility::DeserializePrimitive(ckpt.n_variants_written, stream);
+	utility::DeserializePrimitive(ckpt.byte_offset_end, stream);
+
+	uint64_t n_entries = 0;
+	utility::DeserializePrimitive(n_entries, stream);
+	if (!stream.good()) return(stream);
+	ckpt.index_entries.resize(n_entries);
+	for (uint64_t i = 0; i < n_entries; ++i)
+		stream >> ckpt.index_entries[i];
+
+	utility::DeserializeString(ckpt.digest_state, stream);
+	return(stream);
+}
+
+}
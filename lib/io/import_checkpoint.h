@@ -0,0 +1,77 @@
+#ifndef IO_IMPORT_CHECKPOINT_H_
+#define IO_IMPORT_CHECKPOINT_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "index_record.h"
+
+namespace tachyon {
+
+const std::string TACHYON_CHECKPOINT_SUFFIX = "ckpt";
+const std::string TACHYON_CHECKPOINT_MAGIC  = "YONCKPT\1";
+
+/**<
+ * Sidecar checkpoint describing the last consistent state of a partially
+ * written Tachyon archive during import. It records the last block that was
+ * completely written, the byte offset at which it ends, the index entries and
+ * running digest state for all written blocks, and the position in the input
+ * stream (a htslib virtual offset for Bgzf-compressed input) of the first
+ * record that was not yet written. This is sufficient to truncate the archive
+ * to the last consistent block and continue importing from that record.
+ */
+struct yon_import_ckpt {
+public:
+	typedef yon_import_ckpt self_type;
+
+public:
+	yon_import_ckpt();
+	~yon_import_ckpt() = default;
+
+	/**<
+	 * Write the checkpoint to disk. The data is first written to a temporary
+	 * file that is then renamed over the target path so that a crash during
+	 * checkpointing never leaves a truncated checkpoint behind.
+	 * @param path Dst file path.
+	 * @return     Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Write(const std::string& path) const;
+
+	/**<
+	 * Read a checkpoint previously written with Write().
+	 * @param path Src file path.
+	 * @return     Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Read(const std::string& path);
+
+	/**<
+	 * Checks that this checkpoint was produced from the same input data as
+	 * described by the provided input file name and header properties.
+	 * @param input_file Input file name.
+	 * @param n_samples  Number of samples in the input header.
+	 * @param n_contigs  Number of contigs in the input header.
+	 * @return           Returns TRUE if compatible or FALSE otherwise.
+	 */
+	bool IsCompatible(const std::string& input_file, const uint32_t n_samples, const uint32_t n_contigs) const;
+
+	friend std::ostream& operator<<(std::ostream& stream, const self_type& ckpt);
+	friend std::istream& operator>>(std::istream& stream, self_type& ckpt);
+
+public:
+	std::string input_file; // input file name
+	uint32_t n_samples; // number of samples in the input
+	uint32_t n_contigs; // number of contigs in the input header
+	int64_t  input_offset; // input stream offset of the first record not written
+	uint64_t n_blocks_written; // number of completely written blocks
+	uint64_t n_variants_written; // number of variants in those blocks
+	uint64_t byte_offset_end; // byte offset in the archive at the end of the last block
+	std::vector<yon1_idx_rec> index_entries; // linear index entries of written blocks
+	std::string digest_state; // serialized running digest state
+};
+
+}
+
+#endif /* IO_IMPORT_CHECKPOINT_H_ */
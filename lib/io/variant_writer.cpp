@@ -1,9 +1,16 @@
 #include <strings.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <fstream>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
 
 #include <openssl/evp.h>
 
@@ -17,17 +24,141 @@ namespace tachyon {
 
 class VariantWriterInterface::VariantWriterInterfaceImpl {
 public:
-	VariantWriterInterfaceImpl() = default;
-	~VariantWriterInterfaceImpl() = default;
+	VariantWriterInterfaceImpl() :
+		current(new yon1_vc_t),
+		budget_ready(false),
+		n_capacity(0), n_samples(0), compression_level(0),
+		n_submitted(0), n_written(0), alive(false)
+	{
+		// The initial container is owned by the pool as it is submitted
+		// and recycled like any other.
+		this->pool.push_back(this->current);
+	}
+
+	~VariantWriterInterfaceImpl() {
+		this->Stop();
+		for (uint32_t i = 0; i < this->pool.size(); ++i) delete this->pool[i];
+	}
+
+	/**<
+	 * Start the compression workers. Each worker permutes, encodes, and
+	 * compresses the variant containers queued with Submit(). A bounded
+	 * number of containers are kept in circulation such that memory usage
+	 * is proportional to the number of workers.
+	 * @param n_threads         Number of worker threads.
+	 * @param n_samples         Number of samples in the file.
+	 * @param compression_level Dst compression level of data blocks.
+	 */
+	void Start(const uint32_t n_threads, const uint32_t n_samples, const uint32_t compression_level) {
+		this->n_capacity        = 2*n_threads + 1;
+		this->n_samples         = n_samples;
+		this->compression_level = compression_level;
+		this->alive = true;
+		for (uint32_t i = 0; i < n_threads; ++i)
+			this->workers.push_back(std::thread(&VariantWriterInterfaceImpl::Work, this));
+	}
+
+	void Stop(void) {
+		{
+			std::unique_lock<std::mutex> lock(this->mtx);
+			this->alive = false;
+		}
+		this->cv_queued.notify_all();
+		for (uint32_t i = 0; i < this->workers.size(); ++i) this->workers[i].join();
+		this->workers.clear();
+	}
+
+	void Work(void) {
+		while (true) {
+			std::unique_lock<std::mutex> lock(this->mtx);
+			this->cv_queued.wait(lock, [this]{ return(this->queued.size() || this->alive == false); });
+			if (this->queued.size() == 0) return;
+
+			std::pair<uint64_t, yon1_vc_t*> job = this->queued.front();
+			this->queued.pop_front();
+			lock.unlock();
+
+			job.second->PrepareWritableBlock(this->n_samples, this->compression_level);
+
+			lock.lock();
+			this->finished[job.first] = job.second;
+			lock.unlock();
+			this->cv_finished.notify_one();
+		}
+	}
+
+	void Submit(yon1_vc_t* vc) {
+		{
+			std::unique_lock<std::mutex> lock(this->mtx);
+			this->queued.push_back(std::make_pair(this->n_submitted++, vc));
+		}
+		this->cv_queued.notify_one();
+	}
+
+	/**<
+	 * Retrieve the next finished container in submission order.
+	 * @param wait Block until the next container is finished.
+	 * @return     Returns a pointer to the container or a nullptr if none is available.
+	 */
+	yon1_vc_t* NextFinished(const bool wait) {
+		std::unique_lock<std::mutex> lock(this->mtx);
+		if (this->n_written == this->n_submitted) return nullptr;
+		if (wait) this->cv_finished.wait(lock, [this]{ return(this->finished.count(this->n_written) != 0); });
+
+		std::unordered_map<uint64_t, yon1_vc_t*>::iterator it = this->finished.find(this->n_written);
+		if (it == this->finished.end()) return nullptr;
+
+		yon1_vc_t* vc = it->second;
+		this->finished.erase(it);
+		++this->n_written;
+		return(vc);
+	}
+
+	// Containers are only recycled and handed out from the writing thread.
+	yon1_vc_t* Acquire(void) {
+		if (this->available.size()) {
+			yon1_vc_t* vc = this->available.back();
+			this->available.pop_back();
+			return(vc);
+		}
+		if (this->pool.size() < this->n_capacity) {
+			this->pool.push_back(new yon1_vc_t);
+			return(this->pool.back());
+		}
+		return nullptr;
+	}
+
+	inline void Release(yon1_vc_t* vc) { this->available.push_back(vc); }
 
 public:
 	algorithm::VariantDigestManager digest;
+
+	yon1_vc_t* current; // container currently being added to
+	yon_vb_budget budget; // block size policy
+	bool budget_ready; // budget has been set up from the settings
+	std::vector<yon1_vc_t*> pool; // all containers including the current one
+	std::vector<yon1_vc_t*> available; // cleared containers ready for reuse
+
+	uint32_t n_capacity; // max number of containers in circulation
+	uint32_t n_samples;
+	uint32_t compression_level;
+	uint64_t n_submitted; // number of containers queued for compression
+	uint64_t n_written; // number of containers retrieved in order
+	bool alive;
+	std::deque< std::pair<uint64_t, yon1_vc_t*> > queued;
+	std::unordered_map<uint64_t, yon1_vc_t*> finished;
+	std::vector<std::thread> workers;
+	std::mutex mtx;
+	std::condition_variable cv_queued;
+	std::condition_variable cv_finished;
 };
 
 VariantWriterInterface::VariantWriterInterface() :
 	n_blocks_written(0),
 	n_variants_written(0),
 	stream(nullptr),
+	append_contig_id(-1),
+	append_position(-1),
 	n_s(0),
 	mImpl(new VariantWriterInterfaceImpl)
 {}
@@ -100,6 +231,24 @@ yon_vnt_hdr_t& VariantWriterInterface::UpdateHeaderView(yon_vnt_hdr_t& header, c
 }
 
 
+yon_vnt_hdr_t& VariantWriterInterface::UpdateHeaderConcat(yon_vnt_hdr_t& header) {
+	VcfExtra e;
+	e.key = "tachyon_concatVersion";
+	e.value = tachyon::TACHYON_PROGRAM_NAME + "-" + VERSION + ";";
+	e.value += "libraries=" +  tachyon::TACHYON_PROGRAM_NAME + '-' + tachyon::TACHYON_LIB_VERSION + ","
+			+   SSLeay_version(SSLEAY_VERSION) + ","
+			+  "ZSTD-" + ZSTD_versionString()
+			+  "; timestamp=" + tachyon::utility::datetime();
+	header.literals_ += "##" + e.key + "=" + e.value + '\n';
+	header.extra_fields_.push_back(e);
+	e.key = "tachyon_concatCommand";
+	e.value = tachyon::LITERAL_COMMAND_LINE;
+	header.literals_ += "##" + e.key + "=" + e.value + '\n';
+	header.extra_fields_.push_back(e);
+
+	return(header);
+}
+
 bool VariantWriterInterface::Write(yon1_vb_t& container, yon1_idx_rec& index_entry)
 {
 	this->WriteBlock(container, index_entry); // write block
@@ -132,6 +281,61 @@ bool VariantWriterInterface::WriteBlock(yon1_vb_t& block, yon1_idx_rec& index_en
 	return(this->stream->good());
 }
 
+bool VariantWriterInterface::WriteBlocksRaw(std::istream& stream, const uint64_t l_data, const yon_index_t& index, const uint64_t n_variants) {
+	if (this->stream == nullptr) return false;
+
+	const int64_t byte_offset_delta = (int64_t)this->stream->tellp() - (int64_t)stream.tellg();
+	if (!this->index.Append(index, this->n_blocks_written, byte_offset_delta))
+		return false;
+
+	if (this->CopyBytes(stream, l_data) == false)
+		return false;
+
+	this->n_blocks_written   += index.GetLinearSize();
+	this->n_variants_written += n_variants;
+
+	return(this->stream->good());
+}
+
+bool VariantWriterInterface::WriteBlockRaw(std::istream& stream, const yon1_idx_rec& index_entry) {
+	if (this->stream == nullptr) return false;
+
+	// Write out pending records before the copied block.
+	if (this->FlushContainer() == false) return false;
+	if (this->WriteFinishedContainers(true) == false) return false;
+
+	stream.seekg(index_entry.byte_offset);
+	if (stream.good() == false) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to seek to block offset " << index_entry.byte_offset << "..." << std::endl;
+		return false;
+	}
+
+	yon1_idx_rec entry = index_entry;
+	entry.byte_offset  = this->stream->tellp();
+	if (this->CopyBytes(stream, index_entry.byte_offset_end - index_entry.byte_offset) == false)
+		return false;
+
+	this->index.AddSorted(entry.contig_id, entry.min_position, entry.max_position, this->n_blocks_written);
+	return(this->UpdateIndex(entry));
+}
+
+bool VariantWriterInterface::CopyBytes(std::istream& stream, const uint64_t l_data) {
+	const uint64_t l_chunk = 1 << 22; // 4 MB
+	std::vector<char> buffer(std::min(l_data, l_chunk));
+	uint64_t l_remaining = l_data;
+	while (l_remaining) {
+		const uint64_t l_read = std::min(l_remaining, l_chunk);
+		stream.read(buffer.data(), l_read);
+		if ((uint64_t)stream.gcount() != l_read) {
+			std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to read block data: source archive is truncated..." << std::endl;
+			return false;
+		}
+		this->stream->write(buffer.data(), l_read);
+		l_remaining -= l_read;
+	}
+	return(this->stream->good());
+}
+
 bool VariantWriterInterface::close() {
 	if (this->stream == nullptr) return false;
 	if (this->stream->good() == false) return false;
@@ -143,13 +347,10 @@ bool VariantWriterInterface::close() {
 }
 
 bool VariantWriterInterface::WriteFinal() {
-	// Write last if any.
-	if (variant_container.size()) {
-		this->variant_container.PrepareWritableBlock(this->n_s, this->settings.compression_level);
-		this->index.IndexContainer(this->variant_container, this->n_blocks_written);
-		this->Write(variant_container.block_, this->index.GetCurrent());
-		this->variant_container.clear();
-	}
+	// Write last if any and wait for all queued blocks to be written.
+	this->FlushContainer();
+	this->WriteFinishedContainers(true);
+	this->mImpl->Stop();
 
 	// Done importing
 	this->stream->flush();
@@ -176,6 +377,14 @@ bool VariantWriterInterface::WriteFinal() {
 	return(this->stream->good());
 }
 
+bool VariantWriterInterface::SerializeDigestState(std::ostream& stream) const {
+	return(this->mImpl->digest.SerializeState(stream));
+}
+
+bool VariantWriterInterface::DeserializeDigestState(std::istream& stream) {
+	return(this->mImpl->digest.DeserializeState(stream));
+}
+
 void VariantWriterInterface::WriteIndex(void) {
 	*this->stream << this->index;
 	this->stream->flush();
@@ -197,41 +406,97 @@ bool VariantWriterInterface::WriteEndOfBlock(void) {
 	return(this->stream->good());
 }
 
+bool VariantWriterInterface::FlushContainer(void) {
+	if (this->mImpl->current->size() == 0) return true;
+
+	if (this->settings.n_threads <= 1) {
+		this->mImpl->current->PrepareWritableBlock(this->n_s, this->settings.compression_level);
+		return(this->WriteContainer(*this->mImpl->current));
+	}
+
+	// Workers are started lazily as the settings are assigned after
+	// construction and writers that only copy pre-encoded blocks never
+	// need them.
+	if (this->mImpl->workers.size() == 0)
+		this->mImpl->Start(this->settings.n_threads, this->n_s, this->settings.compression_level);
+
+	this->mImpl->Submit(this->mImpl->current);
+	this->mImpl->current = nullptr;
+
+	if (this->WriteFinishedContainers(false) == false)
+		return false;
+
+	// If all containers are in flight then wait for the oldest one
+	// to finish and reuse it.
+	this->mImpl->current = this->mImpl->Acquire();
+	if (this->mImpl->current == nullptr) {
+		yon1_vc_t* vc = this->mImpl->NextFinished(true);
+		assert(vc != nullptr);
+		this->mImpl->current = vc;
+		return(this->WriteContainer(*vc));
+	}
+
+	return true;
+}
+
+bool VariantWriterInterface::WriteContainer(yon1_vc_t& vc) {
+	this->mImpl->budget.Update(vc.block_.GetUncompressedSize(), vc.block_.GetCompressedSize(), vc.size());
+	this->index.IndexContainer(vc, this->n_blocks_written);
+	this->Write(vc.block_, this->index.GetCurrent());
+	vc.clear();
+	return(this->stream->good());
+}
+
+bool VariantWriterInterface::WriteFinishedContainers(const bool wait) {
+	while (true) {
+		yon1_vc_t* vc = this->mImpl->NextFinished(wait);
+		if (vc == nullptr) break;
+
+		const bool ok = this->WriteContainer(*vc);
+		this->mImpl->Release(vc);
+		if (ok == false) return false;
+	}
+	return(this->stream->good());
+}
+
 void VariantWriterInterface::operator+=(const yon1_vnt_t& rec) {
-	// Make sure we have enough space.
-	if (variant_container.capacity() < settings.checkpoint_n_snps + 10)
-		variant_container.reserve(settings.checkpoint_n_snps + 10);
-
-	if (variant_container.size() == settings.checkpoint_n_snps) {
-		// write
-		this->variant_container.PrepareWritableBlock(this->n_s, this->settings.compression_level);
-		this->index.IndexContainer(this->variant_container, this->n_blocks_written);
-		this->Write(variant_container.block_, this->index.GetCurrent());
-		this->variant_container.clear();
-	}
-
-	if (variant_container.size()) {
-		if (rec.rid != variant_container.front().rid) {
-			//std::cerr << "different rid: write" << std::endl;
-			// write
-			this->variant_container.PrepareWritableBlock(this->n_s, this->settings.compression_level);
-			this->index.IndexContainer(this->variant_container, this->n_blocks_written);
-			this->Write(this->variant_container.block_, this->index.GetCurrent());
-			this->variant_container.clear();
-		} else if (rec.pos < this->variant_container.front().pos) {
-			std::cerr << "unsorted file: " << rec.pos << " < " << variant_container.front().pos << std::endl;
+	// The settings are assigned after construction: set up the block
+	// size policy when the first record is added.
+	if (this->mImpl->budget_ready == false) {
+		this->mImpl->budget.Setup(std::max(settings.checkpoint_bytes, (int64_t)0),
+		                          settings.checkpoint_compressed,
+		                          settings.checkpoint_n_snps,
+		                          settings.checkpoint_min_snps,
+		                          settings.checkpoint_max_snps);
+		this->mImpl->budget_ready = true;
+	}
+
+	yon1_vc_t* vc = this->mImpl->current;
+	const uint32_t n_limit = this->mImpl->budget.GetRecordLimit();
+
+	if (vc->size() >= n_limit) {
+		this->FlushContainer();
+		vc = this->mImpl->current;
+	}
+
+	if (vc->size()) {
+		if (rec.rid != vc->front().rid) {
+			this->FlushContainer();
+			vc = this->mImpl->current;
+		} else if (rec.pos < vc->front().pos) {
+			std::cerr << "unsorted file: " << rec.pos << " < " << vc->front().pos << std::endl;
 			exit(1);
-		} else if (variant_container.back().pos - variant_container.front().pos > settings.checkpoint_bases) {
-			//std::cerr << "length cutoff=" << (variant_container.back().pos - variant_container.front().pos) << "/" << settings.checkpoint_bases << std::endl;
-			// write
-			this->variant_container.PrepareWritableBlock(this->n_s, this->settings.compression_level);
-			this->index.IndexContainer(this->variant_container, this->n_blocks_written);
-			this->Write(variant_container.block_, this->index.GetCurrent());
-			this->variant_container.clear();
+		} else if (vc->back().pos - vc->front().pos > settings.checkpoint_bases) {
+			this->FlushContainer();
+			vc = this->mImpl->current;
 		}
 	}
 
-	variant_container += rec;
+	// Make sure we have enough space.
+	if (vc->capacity() < n_limit + 10)
+		vc->reserve(n_limit + 10);
+
+	*vc += rec;
 }
 
 bool VariantWriterFile::open(const std::string output) {
@@ -258,6 +523,171 @@ bool VariantWriterFile::open(const std::string output) {
 	return true;
 }
 
+bool VariantWriterFile::open(const std::string output, const uint64_t byte_offset) {
+	if (output.size() == 0) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "No output file/file prefix provided!" << std::endl;
+		return false;
+	}
+
+	this->filename = output;
+	this->CheckOutputNames(output);
+	const std::string file_name = this->GetFileName();
+
+	// Make sure the target archive exists, is at least as long as the
+	// requested offset, and begins with a valid Tachyon magic string.
+	std::ifstream check(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!check.good()) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Could not open: " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	const uint64_t l_file = check.tellg();
+	if (l_file < byte_offset || byte_offset < TACHYON_MAGIC_HEADER_LENGTH) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Archive " << file_name << " is shorter than the requested resume offset (" << l_file << " < " << byte_offset << ")!" << std::endl;
+		return false;
+	}
+
+	char magic_string[TACHYON_MAGIC_HEADER_LENGTH];
+	check.seekg(0);
+	check.read(&magic_string[0], TACHYON_MAGIC_HEADER_LENGTH);
+	check.close();
+	if (strncmp(&magic_string[0], &TACHYON_MAGIC_HEADER[0], TACHYON_MAGIC_HEADER_LENGTH) != 0) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Illegal Tachyon magic string in " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	// Drop any partially written data past the offset.
+	if (truncate(file_name.c_str(), byte_offset) != 0) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to truncate " << file_name << " to " << byte_offset << " bytes!" << std::endl;
+		return false;
+	}
+
+	// Open without truncating and append from the end of the retained data.
+	std::ofstream* ostream = reinterpret_cast<std::ofstream*>(this->stream);
+	ostream->open(file_name, std::ios::in | std::ios::out | std::ios::binary);
+	ostream->seekp(byte_offset);
+
+	if (!this->stream->good()) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Could not open: " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	if (!SILENT) {
+		std::cerr << utility::timestamp("LOG", "WRITER") << "Reopening: " << file_name << " at offset " << byte_offset << "..." << std::endl;
+	}
+
+	return true;
+}
+
+bool VariantWriterFile::OpenAppend(const std::string output, const yon_vnt_hdr_t& header) {
+	if (output.size() == 0) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "No output file/file prefix provided!" << std::endl;
+		return false;
+	}
+
+	this->filename = output;
+	this->CheckOutputNames(output);
+	const std::string file_name = this->GetFileName();
+
+	std::ifstream check(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!check.good()) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Could not open: " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	const uint64_t l_file = check.tellg();
+	if (l_file <= YON_FOOTER_LENGTH) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Archive " << file_name << " is corrupted!" << std::endl;
+		return false;
+	}
+
+	// Read and validate the global footer.
+	yon_ftr_t footer;
+	check.seekg(l_file - YON_FOOTER_LENGTH);
+	check >> footer;
+	if (!check.good() || footer.Validate() == false) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to validate footer of " << file_name << ": the archive is not finalized!" << std::endl;
+		return false;
+	}
+
+	// Read the stored header and check that it is compatible with the
+	// data to be appended.
+	check.seekg(0);
+	char magic_string[TACHYON_MAGIC_HEADER_LENGTH];
+	check.read(&magic_string[0], TACHYON_MAGIC_HEADER_LENGTH);
+	if (strncmp(&magic_string[0], &TACHYON_MAGIC_HEADER[0], TACHYON_MAGIC_HEADER_LENGTH) != 0) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Illegal Tachyon magic string in " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	uint32_t l_data   = 0;
+	uint32_t l_c_data = 0;
+	utility::DeserializePrimitive(l_data,   check);
+	utility::DeserializePrimitive(l_c_data, check);
+
+	yon_buffer_t header_uncompressed(l_data + 1024);
+	yon_buffer_t header_compressed(l_c_data + 1024); header_compressed.n_chars_ = l_c_data;
+	check.read(header_compressed.data(), l_c_data);
+
+	algorithm::CompressionManager manager;
+	if (!check.good() || !manager.zstd_codec.Decompress(header_compressed, header_uncompressed)) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to decompress header of " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	yon_vnt_hdr_t stored_header;
+	header_uncompressed >> stored_header;
+	if (!stored_header.IsCompatible(header)) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Cannot append to " << file_name << ": incompatible headers!" << std::endl;
+		return false;
+	}
+
+	// Load the index describing the existing blocks. New blocks are
+	// added to it and the merged index is written when closing.
+	check.seekg(footer.offset_end_of_data);
+	check >> this->index;
+	if (!check.good()) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to read index of " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	// Appended records have to sort after the last record in the archive
+	// given by the contig of the last block and the start position of its
+	// last record stored in the block header.
+	if (footer.n_blocks) {
+		yon_vb_hdr last_header;
+		check.seekg(this->index[footer.n_blocks - 1].byte_offset);
+		check >> last_header;
+		if (!check.good()) {
+			std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to read the last block of " << file_name << "!" << std::endl;
+			return false;
+		}
+		this->append_contig_id = this->index[footer.n_blocks - 1].contig_id;
+		this->append_position  = last_header.max_position;
+	}
+	check.close();
+
+	this->n_blocks_written   = footer.n_blocks;
+	this->n_variants_written = footer.n_variants;
+
+	// The trailer is kept until it is overwritten by the first block such
+	// that a failure before any data is written leaves the archive intact.
+	std::ofstream* ostream = reinterpret_cast<std::ofstream*>(this->stream);
+	ostream->open(file_name, std::ios::in | std::ios::out | std::ios::binary);
+	ostream->seekp(footer.offset_end_of_data);
+
+	if (!this->stream->good()) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Could not open: " << file_name << "!" << std::endl;
+		return false;
+	}
+
+	if (!SILENT) {
+		std::cerr << utility::timestamp("LOG", "WRITER") << "Appending to: " << file_name << " (" << footer.n_blocks << " blocks, " << utility::ToPrettyString(footer.n_variants) << " variants)..." << std::endl;
+	}
+
+	return true;
+}
+
 void VariantWriterFile::CheckOutputNames(const std::string& input) {
 	std::vector<std::string> paths = utility::FilePathBaseExtension(input);
 	this->basePath = paths[0];
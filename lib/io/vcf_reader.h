@@ -1,7 +1,11 @@
 #ifndef IO_VCF_READER_H_
 #define IO_VCF_READER_H_
 
+#include "htslib/bgzf.h"
+#include "htslib/hfile.h"
+
 #include "vcf_utils.h"
+#include "vcf_sorter.h"
 
 namespace tachyon{
 namespace io{
@@ -39,6 +43,10 @@ public:
 	}
 
 	bool next(const int unpack_level = BCF_UN_ALL) {
+		if (this->sorter_ != nullptr)
+			return(this->sorter_->next(this->bcf1_, unpack_level));
+
+		this->last_record_offset_ = this->Tell();
 		if (bcf_read(this->fp_, this->header_, this->bcf1_) < 0) {
 			if (bcf1_->errcode) {
 				std::cerr << utility::timestamp("ERROR") << "Failed to parse VCF record: " << bcf1_->errcode << std::endl;
@@ -53,6 +61,10 @@ public:
 	}
 
 	bool next(bcf1_t* bcf_entry, const int unpack_level = BCF_UN_ALL) {
+		if (this->sorter_ != nullptr)
+			return(this->sorter_->next(bcf_entry, unpack_level));
+
+		this->last_record_offset_ = this->Tell();
 		if (bcf_read(this->fp_, this->header_, bcf_entry) < 0) {
 			if (bcf_entry->errcode) {
 				std::cerr << utility::timestamp("ERROR") << "Failed to parse VCF record: " << bcf1_->errcode << std::endl;
@@ -67,6 +79,70 @@ public:
 		return true;
 	}
 
+	/**<
+	 * Returns the current position in the input stream. For Bgzf-compressed
+	 * input (Vcf.gz and Bcf) this is the htslib virtual file offset
+	 * (compressed block offset << 16 | offset into the uncompressed block)
+	 * and for uncompressed Vcf it is the plain byte offset.
+	 * @return Returns the current stream position or -1 if unavailable.
+	 */
+	int64_t Tell(void) const {
+		if (this->sorter_ != nullptr) return(-1);
+		if (this->fp_->format.compression == no_compression)
+			return(htell(this->fp_->fp.hfile));
+		if (this->fp_->format.compression == bgzf)
+			return(bgzf_tell(this->fp_->fp.bgzf));
+		return(-1);
+	}
+
+	/**<
+	 * Seek the input stream to a position previously returned by Tell(). Plain
+	 * gzip-compressed input and streams (stdin) cannot be repositioned.
+	 * @param offset Src virtual or byte offset.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Seek(const int64_t offset) {
+		if (offset < 0 || this->sorter_ != nullptr) return false;
+		if (this->fp_->format.compression == no_compression)
+			return(hseek(this->fp_->fp.hfile, offset, SEEK_SET) >= 0);
+		if (this->fp_->format.compression == bgzf)
+			return(bgzf_seek(this->fp_->fp.bgzf, offset, SEEK_SET) >= 0);
+		return false;
+	}
+
+	/**<
+	 * Consume the remainder of the input and sort it by contig and position
+	 * using an external-memory sort. Subsequent calls to next() return the
+	 * records in sorted order. Sorted input cannot be repositioned with
+	 * Seek() and Tell() is unavailable.
+	 * @param temp_directory Directory for temporary run files.
+	 * @param run_bytes      Max number of bytes of records held in memory per run.
+	 * @param n_threads      Number of threads used to sort each run.
+	 * @return               Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Sort(const std::string& temp_directory, const uint64_t run_bytes, const uint32_t n_threads) {
+		this->sorter_ = std::unique_ptr<VcfSorter>(new VcfSorter(temp_directory, run_bytes, n_threads));
+		if (this->sorter_->Build(this->fp_, this->header_) == false) {
+			this->sorter_.reset();
+			return false;
+		}
+		return true;
+	}
+
+	/**<
+	 * Returns the stream position at which the most recently read
+	 * record started. Used to restart reading from a record that has
+	 * already been consumed from the stream (such as a carry-over record).
+	 * @return Returns the offset of the last read record.
+	 */
+	inline int64_t GetLastRecordOffset(void) const { return(this->last_record_offset_); }
+
+	/**<
+	 * Returns TRUE if records served by the external-memory sorter are
+	 * incomplete because a temporary file could not be read.
+	 */
+	inline bool SortFailed(void) const { return(this->sorter_ != nullptr && this->sorter_->Failed()); }
+
 	/**<
 	 * Utility function that writes the VcfHeader literals string into
 	 * a target output stream. The literals string does NOT contain
@@ -99,7 +175,9 @@ private:
 			  bcf_hdr_t* header) :
     fp_(fp),
     header_(header),
-    bcf1_(bcf_init())
+    bcf1_(bcf_init()),
+    last_record_offset_(-1),
+    sorter_(nullptr)
 {
     if (this->header_->nhrec < 1) {
         std::cerr << utility::timestamp("ERROR") << "Empty header, not a valid VCF." << std::endl;
@@ -191,6 +269,12 @@ public:
 
 	// htslib representation of a parsed vcf line.
 	bcf1_t* bcf1_;
+
+	// Stream position of the start of the most recently read record.
+	int64_t last_record_offset_;
+
+	// External-memory sorter serving records if the input is unsorted.
+	std::unique_ptr<VcfSorter> sorter_;
 };
 
 }
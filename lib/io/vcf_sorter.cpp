@@ -0,0 +1,318 @@
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#include "vcf_sorter.h"
+#include "tachyon.h"
+
+namespace tachyon{
+namespace io{
+
+VcfSorter::VcfSorter(const std::string& temp_directory, const uint64_t run_bytes, const uint32_t n_threads) :
+	temp_directory_(temp_directory.size() ? temp_directory : "."),
+	run_bytes_(run_bytes ? run_bytes : YON_SORT_RUN_BYTES),
+	n_threads_(std::max(n_threads, (uint32_t)1)),
+	n_records_(0),
+	n_runs_(0),
+	b_buffer_(0),
+	n_returned_(0),
+	failed_(false),
+	heap_(yon_sort_run_cmp(&this->runs_))
+{}
+
+VcfSorter::~VcfSorter() {
+	this->ClearBuffer();
+	for (uint32_t i = 0; i < this->runs_.size(); ++i)
+		this->CloseRun(this->runs_[i], true);
+}
+
+bool VcfSorter::Build(htsFile* fp, bcf_hdr_t* header) {
+	while (true) {
+		bcf1_t* rec = bcf_init();
+		if (bcf_read(fp, header, rec) < 0) {
+			const int errcode = rec->errcode;
+			bcf_destroy(rec);
+			if (errcode) {
+				std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to parse VCF record: " << errcode << std::endl;
+				return false;
+			}
+			break;
+		}
+
+		this->buffer_.push_back(yon_sort_rec(rec, this->n_records_));
+		this->b_buffer_ += sizeof(bcf1_t) + rec->shared.l + rec->indiv.l;
+		++this->n_records_;
+
+		if (this->b_buffer_ >= this->run_bytes_) {
+			this->SortRun();
+			if (this->SpillRun(header) == false)
+				return false;
+		}
+	}
+
+	this->SortRun();
+
+	// If everything fits in a single run then records are served
+	// directly from memory.
+	if (this->runs_.size() == 0)
+		return true;
+
+	if (this->buffer_.size()) {
+		if (this->SpillRun(header) == false)
+			return false;
+	}
+
+	if (this->ReduceRuns(header) == false)
+		return false;
+
+	uint32_t first = 0;
+	while (first < this->runs_.size() && this->runs_[first].path.size() == 0) ++first;
+	return(this->OpenRuns(first, this->runs_.size(), this->heap_));
+}
+
+bool VcfSorter::next(bcf1_t* bcf_entry, const int unpack_level) {
+	if (this->runs_.size() == 0) {
+		if (this->n_returned_ == this->buffer_.size())
+			return false;
+
+		bcf_copy(bcf_entry, this->buffer_[this->n_returned_].rec);
+		bcf_destroy(this->buffer_[this->n_returned_].rec);
+		this->buffer_[this->n_returned_].rec = nullptr;
+		++this->n_returned_;
+	} else {
+		uint64_t seq = 0;
+		const int ret = this->PopRun(this->heap_, bcf_entry, seq);
+		if (ret <= 0) {
+			if (ret < 0) this->failed_ = true;
+			return false;
+		}
+	}
+
+	bcf_unpack(bcf_entry, unpack_level);
+	return true;
+}
+
+void VcfSorter::SortRun(void) {
+	if (this->buffer_.size() < 2) return;
+
+	const uint32_t n_slices = std::min((uint64_t)this->n_threads_, (uint64_t)this->buffer_.size());
+	std::vector<size_t> bounds(n_slices + 1);
+	for (uint32_t i = 0; i <= n_slices; ++i)
+		bounds[i] = (this->buffer_.size() * i) / n_slices;
+
+	std::vector<yon_sort_rec>::iterator begin = this->buffer_.begin();
+
+	// Sort slices concurrently.
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < n_slices; ++i) {
+		threads.push_back(std::thread([begin, &bounds, i]() {
+			std::sort(begin + bounds[i], begin + bounds[i+1]);
+		}));
+	}
+	for (uint32_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+	// Merge adjacent sorted slices pairwise. Merges within
+	// a round touch disjoint ranges and run concurrently.
+	for (uint32_t width = 1; width < n_slices; width *= 2) {
+		threads.clear();
+		for (uint32_t i = 0; i + width < n_slices; i += 2*width) {
+			const size_t from = bounds[i];
+			const size_t mid  = bounds[i + width];
+			const size_t to   = bounds[std::min(i + 2*width, n_slices)];
+			threads.push_back(std::thread([begin, from, mid, to]() {
+				std::inplace_merge(begin + from, begin + mid, begin + to);
+			}));
+		}
+		for (uint32_t i = 0; i < threads.size(); ++i) threads[i].join();
+	}
+}
+
+bool VcfSorter::SpillRun(bcf_hdr_t* header) {
+	yon_sort_run run;
+	if (this->CreateRun(header, run) == false)
+		return false;
+
+	for (uint32_t i = 0; i < this->buffer_.size(); ++i) {
+		if (bcf_write(run.fp, header, this->buffer_[i].rec) < 0 ||
+		    fwrite(&this->buffer_[i].seq, sizeof(uint64_t), 1, run.seq_fp) != 1)
+		{
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to write to temporary file: " << run.path << std::endl;
+			this->CloseRun(run, true);
+			return false;
+		}
+	}
+
+	hts_close(run.fp);
+	fclose(run.seq_fp);
+	run.fp     = nullptr;
+	run.seq_fp = nullptr;
+	this->runs_.push_back(run);
+
+	if (!SILENT) {
+		std::cerr << utility::timestamp("LOG", "SORT") << "Spilled run " << this->runs_.size() << " (" << utility::ToPrettyString(this->buffer_.size()) << " records, " << utility::ToPrettyDiskString(this->b_buffer_) << ")..." << std::endl;
+	}
+
+	this->ClearBuffer();
+	return true;
+}
+
+bool VcfSorter::CreateRun(bcf_hdr_t* header, yon_sort_run& run) {
+	std::string path = this->temp_directory_ + "/yon_sort_XXXXXX";
+	const int fd = mkstemp(&path[0]);
+	if (fd < 0) {
+		std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to create temporary file in: " << this->temp_directory_ << std::endl;
+		return false;
+	}
+	close(fd);
+
+	run.path   = path;
+	run.fp     = hts_open(path.c_str(), "wbu");
+	run.seq_fp = fopen((path + ".seq").c_str(), "wb");
+	if (run.fp == nullptr || run.seq_fp == nullptr || bcf_hdr_write(run.fp, header) < 0) {
+		std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to open temporary file: " << path << std::endl;
+		this->CloseRun(run, true);
+		return false;
+	}
+
+	++this->n_runs_;
+	return true;
+}
+
+bool VcfSorter::OpenRuns(const uint32_t from, const uint32_t to, heap_type& heap) {
+	for (uint32_t i = from; i < to; ++i) {
+		yon_sort_run& run = this->runs_[i];
+		run.fp = hts_open(run.path.c_str(), "r");
+		if (run.fp == nullptr) {
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to open temporary file: " << run.path << std::endl;
+			return false;
+		}
+
+		run.seq_fp = fopen((run.path + ".seq").c_str(), "rb");
+		if (run.seq_fp == nullptr) {
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to open temporary file: " << run.path << ".seq" << std::endl;
+			return false;
+		}
+
+		run.hdr = bcf_hdr_read(run.fp);
+		if (run.hdr == nullptr) {
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to read header of temporary file: " << run.path << std::endl;
+			return false;
+		}
+
+		run.rec = bcf_init();
+		if (this->ReadRun(run) <= 0) {
+			// Empty runs are never written.
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to read temporary file: " << run.path << std::endl;
+			return false;
+		}
+		heap.push(i);
+	}
+	return true;
+}
+
+int VcfSorter::ReadRun(yon_sort_run& run) {
+	if (bcf_read(run.fp, run.hdr, run.rec) < 0)
+		return(run.rec->errcode ? -1 : 0);
+
+	if (fread(&run.seq, sizeof(uint64_t), 1, run.seq_fp) != 1)
+		return(-1);
+
+	return(1);
+}
+
+int VcfSorter::PopRun(heap_type& heap, bcf1_t* bcf_entry, uint64_t& seq) {
+	if (heap.empty()) return(0);
+
+	const uint32_t top = heap.top();
+	heap.pop();
+
+	yon_sort_run& run = this->runs_[top];
+	bcf_copy(bcf_entry, run.rec);
+	seq = run.seq;
+
+	const int ret = this->ReadRun(run);
+	if (ret > 0) {
+		heap.push(top);
+	} else {
+		if (ret < 0) {
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to read temporary file: " << run.path << std::endl;
+			return(-1);
+		}
+		// Run is exhausted: its file is no longer needed.
+		this->CloseRun(run, true);
+	}
+	return(1);
+}
+
+void VcfSorter::CloseRun(yon_sort_run& run, const bool remove_file) {
+	if (run.rec != nullptr) bcf_destroy(run.rec);
+	if (run.hdr != nullptr) bcf_hdr_destroy(run.hdr);
+	if (run.fp  != nullptr) hts_close(run.fp);
+	if (run.seq_fp != nullptr) fclose(run.seq_fp);
+	run.rec    = nullptr;
+	run.hdr    = nullptr;
+	run.fp     = nullptr;
+	run.seq_fp = nullptr;
+
+	if (remove_file && run.path.size()) {
+		std::remove(run.path.c_str());
+		std::remove((run.path + ".seq").c_str());
+		run.path.clear();
+	}
+}
+
+bool VcfSorter::ReduceRuns(bcf_hdr_t* header) {
+	uint32_t first = 0;
+	while (this->runs_.size() - first > YON_SORT_MAX_FANIN) {
+		const uint32_t to = first + YON_SORT_MAX_FANIN;
+
+		heap_type heap(yon_sort_run_cmp(&this->runs_));
+		if (this->OpenRuns(first, to, heap) == false)
+			return false;
+
+		yon_sort_run merged;
+		if (this->CreateRun(header, merged) == false)
+			return false;
+
+		bcf1_t* rec = bcf_init();
+		uint64_t seq = 0;
+		int ret = 0;
+		while ((ret = this->PopRun(heap, rec, seq)) > 0) {
+			if (bcf_write(merged.fp, header, rec) < 0 ||
+			    fwrite(&seq, sizeof(uint64_t), 1, merged.seq_fp) != 1)
+			{
+				std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to write to temporary file: " << merged.path << std::endl;
+				bcf_destroy(rec);
+				this->CloseRun(merged, true);
+				return false;
+			}
+		}
+		bcf_destroy(rec);
+
+		if (ret < 0) {
+			this->CloseRun(merged, true);
+			return false;
+		}
+
+		hts_close(merged.fp);
+		fclose(merged.seq_fp);
+		merged.fp     = nullptr;
+		merged.seq_fp = nullptr;
+		this->runs_.push_back(merged);
+		first = to;
+	}
+	return true;
+}
+
+void VcfSorter::ClearBuffer(void) {
+	for (uint32_t i = 0; i < this->buffer_.size(); ++i) {
+		if (this->buffer_[i].rec != nullptr) bcf_destroy(this->buffer_[i].rec);
+	}
+	this->buffer_.clear();
+	this->b_buffer_ = 0;
+}
+
+}
+}
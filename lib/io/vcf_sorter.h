@@ -0,0 +1,185 @@
+#ifndef IO_VCF_SORTER_H_
+#define IO_VCF_SORTER_H_
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <cstdio>
+#include <cstdint>
+
+#include "vcf_utils.h"
+
+namespace tachyon{
+namespace io{
+
+// Default number of bytes of records held in memory per sorting run.
+const uint64_t YON_SORT_RUN_BYTES = 1024*1024*1024; // 1 GB
+// Maximum number of runs that are merged at once.
+const uint32_t YON_SORT_MAX_FANIN = 128;
+
+/**<
+ * External-memory sorter for htslib bcf1_t records. Records are read from
+ * an open htsFile into runs bounded by the number of bytes they occupy.
+ * Each run is sorted by (contig, position) using multiple threads and, if
+ * the input does not fit into a single run, spilled to a temporary
+ * uncompressed Bcf file together with a sidecar file of the input order
+ * of its records. Sorted records are subsequently retrieved in
+ * order with next() by k-way merging the spilled runs. Records with equal
+ * keys are returned in input order.
+ */
+class VcfSorter {
+public:
+	typedef VcfSorter self_type;
+
+private:
+	// In-memory record and its position in the input.
+	struct yon_sort_rec {
+		yon_sort_rec() : rec(nullptr), seq(0) {}
+		yon_sort_rec(bcf1_t* rec, const uint64_t seq) : rec(rec), seq(seq) {}
+
+		// Ordering by contig, position, and input order.
+		inline bool operator<(const yon_sort_rec& other) const {
+			if (this->rec->rid != other.rec->rid) return(this->rec->rid < other.rec->rid);
+			if (this->rec->pos != other.rec->pos) return(this->rec->pos < other.rec->pos);
+			return(this->seq < other.seq);
+		}
+
+		bcf1_t*  rec;
+		uint64_t seq;
+	};
+
+	// Spilled run being merged.
+	struct yon_sort_run {
+		yon_sort_run() : fp(nullptr), seq_fp(nullptr), hdr(nullptr), rec(nullptr), seq(0) {}
+
+		std::string path;
+		htsFile*    fp;
+		FILE*       seq_fp; // input order of the records
+		bcf_hdr_t*  hdr;
+		bcf1_t*     rec; // current head of the run
+		uint64_t    seq; // input order of the current head
+	};
+
+	// Min-heap ordering of run heads. Ties are broken by input order
+	// such that the merge is stable.
+	struct yon_sort_run_cmp {
+		yon_sort_run_cmp(const std::vector<yon_sort_run>* runs) : runs(runs) {}
+		bool operator()(const uint32_t a, const uint32_t b) const {
+			const yon_sort_run& ra = (*runs)[a];
+			const yon_sort_run& rb = (*runs)[b];
+			if (ra.rec->rid != rb.rec->rid) return(ra.rec->rid > rb.rec->rid);
+			if (ra.rec->pos != rb.rec->pos) return(ra.rec->pos > rb.rec->pos);
+			return(ra.seq > rb.seq);
+		}
+		const std::vector<yon_sort_run>* runs;
+	};
+
+	typedef std::priority_queue<uint32_t, std::vector<uint32_t>, yon_sort_run_cmp> heap_type;
+
+public:
+	VcfSorter(const std::string& temp_directory, const uint64_t run_bytes, const uint32_t n_threads);
+	~VcfSorter();
+	VcfSorter(const self_type& other) = delete;
+	VcfSorter& operator=(const self_type& other) = delete;
+
+	/**<
+	 * Consume all remaining records from the provided file handle and
+	 * prepare them for sorted retrieval.
+	 * @param fp     Src htslib file handle positioned at the first record.
+	 * @param header Src htslib header describing the records.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool Build(htsFile* fp, bcf_hdr_t* header);
+
+	/**<
+	 * Retrieve the next record in sorted order.
+	 * @param bcf_entry    Dst record that is overwritten.
+	 * @param unpack_level Level of unpacking passed to bcf_unpack.
+	 * @return             Returns TRUE upon success or FALSE if no more records are available
+	 *                     or a temporary file could not be read (see Failed()).
+	 */
+	bool next(bcf1_t* bcf_entry, const int unpack_level);
+
+	// Returns TRUE if reading the spilled runs failed such that the
+	// records returned by next() are incomplete.
+	inline bool Failed(void) const { return(this->failed_); }
+
+	inline uint64_t GetNumberRecords(void) const { return(this->n_records_); }
+	inline uint32_t GetNumberRuns(void) const { return(this->n_runs_); }
+
+private:
+	/**<
+	 * Sort the in-memory run by (contig, position). The run is partitioned
+	 * into one slice per thread that are sorted concurrently and then merged
+	 * pairwise in rounds that are also run concurrently.
+	 */
+	void SortRun(void);
+
+	/**<
+	 * Write the sorted in-memory run to a new temporary file and release
+	 * the records.
+	 * @param header Src htslib header describing the records.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool SpillRun(bcf_hdr_t* header);
+
+	/**<
+	 * Open a temporary run file for writing.
+	 * @param header Src htslib header describing the records.
+	 * @param run    Dst run that will be written to.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool CreateRun(bcf_hdr_t* header, yon_sort_run& run);
+
+	/**<
+	 * Open the spilled runs [from, to) and prime the merge heap with
+	 * their first records.
+	 */
+	bool OpenRuns(const uint32_t from, const uint32_t to, heap_type& heap);
+
+	/**<
+	 * Pop the smallest record from the merge heap and refill the heap
+	 * from the run it came from.
+	 * @param heap      Src merge heap.
+	 * @param bcf_entry Dst record that is overwritten.
+	 * @param seq       Dst input order of the record.
+	 * @return          Returns 1 if a record was popped, 0 if the heap is empty, or -1 upon error.
+	 */
+	int PopRun(heap_type& heap, bcf1_t* bcf_entry, uint64_t& seq);
+	void CloseRun(yon_sort_run& run, const bool remove_file);
+
+	/**<
+	 * Read the next record of a spilled run and its input order.
+	 * @param run Src run.
+	 * @return    Returns 1 if a record was read, 0 if the run is exhausted, or -1 upon error.
+	 */
+	int ReadRun(yon_sort_run& run);
+
+	/**<
+	 * Reduce the number of spilled runs to at most YON_SORT_MAX_FANIN by
+	 * repeatedly merging groups of runs into new runs.
+	 * @param header Src htslib header describing the records.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool ReduceRuns(bcf_hdr_t* header);
+
+	void ClearBuffer(void);
+
+private:
+	std::string temp_directory_;
+	uint64_t run_bytes_; // max bytes of records per run
+	uint32_t n_threads_;
+	uint64_t n_records_; // total number of records
+	uint32_t n_runs_; // total number of runs written
+	uint64_t b_buffer_; // bytes in the in-memory run
+	uint64_t n_returned_; // records returned from the in-memory run
+	bool failed_; // reading a spilled run failed
+	std::vector<yon_sort_rec> buffer_; // in-memory run
+	std::vector<yon_sort_run> runs_; // spilled runs
+	heap_type heap_;
+};
+
+}
+}
+
+#endif /* IO_VCF_SORTER_H_ */
@@ -0,0 +1,249 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef LD_H_
+#define LD_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <getopt.h>
+
+#include "program_utils.h"
+#include "variant_reader.h"
+#include "linkage_disequilibrium.h"
+
+// Maximum number of records in a dense matrix.
+const uint32_t YON_LD_DENSE_MAX = 25000;
+
+void ld_usage(void) {
+	programMessage(true);
+	std::cerr <<
+	"About:  Compute pairwise linkage disequilibrium between records within a\n"
+	"        window. Sparse output lists every pair with an r-squared of at least\n"
+	"        the threshold; dense output is a square matrix of r-squared values\n"
+	"        for all records in the file.\n"
+	"Usage:  " << tachyon::TACHYON_PROGRAM_NAME << " ld [options] -i <in.yon>\n\n"
+	"Options:\n"
+	"  -i FILE   input YON file (required)\n"
+	"  -o FILE   output file (- for stdout) [-]\n"
+	"  -r FLOAT  minimum r-squared of reported pairs (sparse only) [0.2]\n"
+	"  -w INT    maximum distance in bp between pairs (0 for unlimited) [1000000]\n"
+	"  -W INT    maximum number of records between pairs (0 for unlimited) [0]\n"
+	"  -g        use the correlation of genotype dosages rather than haplotypes\n"
+	"  -d        output a dense matrix for all pairs (ignores -r, -w, and -W)\n"
+	"  -t INT    number of threads [all]\n"
+	"  -k FILE   keychain file with encryption keys (required if the file is encrypted)\n"
+	"  -s        hide all program messages [null]\n" << std::endl;
+}
+
+int ld(int argc, char** argv) {
+	if (argc <= 2) {
+		ld_usage();
+		return(1);
+	}
+
+	int c;
+	int option_index = 0;
+	static struct option long_options[] = {
+		{"input",    required_argument, 0, 'i' },
+		{"output",   required_argument, 0, 'o' },
+		{"r2",       required_argument, 0, 'r' },
+		{"window",   required_argument, 0, 'w' },
+		{"window-records", required_argument, 0, 'W' },
+		{"genotype", no_argument,       0, 'g' },
+		{"dense",    no_argument,       0, 'd' },
+		{"threads",  required_argument, 0, 't' },
+		{"keychain", required_argument, 0, 'k' },
+		{"silent",   no_argument,       0, 's' },
+		{0,0,0,0}
+	};
+
+	SILENT = 0;
+	tachyon::VariantReaderSettings settings;
+	tachyon::yon_ld_settings ld_settings;
+	ld_settings.n_threads = std::thread::hardware_concurrency();
+	bool dense = false;
+
+	while ((c = getopt_long(argc, argv, "i:o:r:w:W:gdt:k:s?", long_options, &option_index)) != -1) {
+		switch (c) {
+		case 0:
+			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
+			break;
+		case 'i':
+			settings.input = std::string(optarg);
+			break;
+		case 'o':
+			settings.output = std::string(optarg);
+			break;
+		case 'r':
+			ld_settings.min_r2 = atof(optarg);
+			break;
+		case 'w':
+			ld_settings.window_bp = atoll(optarg);
+			if (ld_settings.window_bp < 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Window cannot be negative..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'W':
+			ld_settings.window_records = atoi(optarg);
+			break;
+		case 'g':
+			ld_settings.mode = tachyon::YON_LD_GENOTYPE;
+			break;
+		case 'd':
+			dense = true;
+			break;
+		case 't':
+			ld_settings.n_threads = atoi(optarg);
+			break;
+		case 'k':
+			settings.keychain_file = std::string(optarg);
+			break;
+		case 's':
+			SILENT = 1;
+			break;
+		default:
+			ld_usage();
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Unrecognized option: " << (char)c << std::endl;
+			return(1);
+		}
+	}
+
+	if (settings.input.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No input value specified..." << std::endl;
+		return(1);
+	}
+
+	if (dense) {
+		ld_settings.min_r2 = 0;
+		ld_settings.window_bp = 0;
+		ld_settings.window_records = 0;
+	}
+
+	if (!SILENT) {
+		programMessage();
+		std::cerr << tachyon::utility::timestamp("LOG") << "Calling ld..." << std::endl;
+	}
+
+	tachyon::VariantReader reader;
+	reader.GetSettings() = settings;
+	if (!reader.open(settings.input)) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open file: " << settings.input << "..." << std::endl;
+		return(1);
+	}
+	reader.GetBlockSettings().LoadMinimumVcf(true).LoadGenotypes(true);
+
+	const tachyon::yon_vnt_hdr_t& header = reader.GetHeader();
+	tachyon::LinkageDisequilibrium engine;
+	if (engine.Open(header.GetNumberSamples(), ld_settings) == false)
+		return(1);
+
+	std::ofstream out_file;
+	if (settings.output.size() && settings.output != "-") {
+		out_file.open(settings.output);
+		if (!out_file.good()) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open: " << settings.output << std::endl;
+			return(1);
+		}
+	}
+	std::ostream& out = out_file.is_open() ? out_file : std::cout;
+
+	// Dense output keeps the lower triangle of every record added.
+	std::vector<tachyon::yon_ld_record> records;
+	std::vector< std::vector<float> > matrix;
+
+	if (dense == false)
+		out << "CHROM_A\tPOS_A\tCHROM_B\tPOS_B\tN\tR2\tDPRIME\n";
+
+	uint64_t n_pairs = 0;
+	while (reader.NextBlock()) {
+		tachyon::yon1_vc_t vc(reader.GetCurrentContainer(), header);
+		if (engine.Add(vc) == false) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to compute linkage disequilibrium..." << std::endl;
+			return(1);
+		}
+
+		const std::vector<tachyon::yon_ld_pair>& pairs = engine.GetPairs();
+		n_pairs += pairs.size();
+
+		if (dense == false) {
+			for (uint32_t i = 0; i < pairs.size(); ++i) {
+				const tachyon::yon_ld_pair& p = pairs[i];
+				out << header.contigs_[p.rid_a].name << '\t' << p.pos_a + 1 << '\t'
+				    << header.contigs_[p.rid_b].name << '\t' << p.pos_b + 1 << '\t'
+				    << p.n << '\t' << p.r2 << '\t' << p.d_prime << '\n';
+			}
+			continue;
+		}
+
+		const std::vector<tachyon::yon_ld_record>& added = engine.GetRecords();
+		if (records.size() + added.size() > YON_LD_DENSE_MAX) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Dense output is limited to " << YON_LD_DENSE_MAX << " records..." << std::endl;
+			return(1);
+		}
+
+		// Pairs are ordered by b and every record is paired with all
+		// preceding records.
+		const uint32_t n_prev = records.size();
+		for (uint32_t i = 0; i < added.size(); ++i) {
+			records.push_back(added[i]);
+			matrix.push_back(std::vector<float>(records.size() - 1, std::numeric_limits<float>::quiet_NaN()));
+		}
+		uint32_t b = n_prev, a = 0;
+		for (uint32_t i = 0; i < pairs.size(); ++i) {
+			while (records[b].id != pairs[i].b) { ++b; a = 0; }
+			while (records[a].id != pairs[i].a) ++a;
+			matrix[b][a] = pairs[i].r2;
+		}
+	}
+
+	if (dense) {
+		for (uint32_t i = 0; i < records.size(); ++i)
+			out << (i ? "\t" : "") << header.contigs_[records[i].rid].name << ':' << records[i].pos + 1;
+		out << '\n';
+
+		for (uint32_t i = 0; i < records.size(); ++i) {
+			for (uint32_t j = 0; j < records.size(); ++j) {
+				if (j) out << '\t';
+				if (i == j) out << 1;
+				else out << (j < i ? matrix[i][j] : matrix[j][i]);
+			}
+			out << '\n';
+		}
+	}
+	out.flush();
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Computed " << tachyon::utility::ToPrettyString(n_pairs) << " pairs over "
+		          << tachyon::utility::ToPrettyString(engine.GetNumberRecords() - engine.GetNumberSkipped()) << " records ("
+		          << tachyon::utility::ToPrettyString(engine.GetNumberSkipped()) << " skipped)..." << std::endl;
+	}
+
+	return 0;
+}
+
+#endif /* LD_H_ */
@@ -23,7 +23,12 @@ DEALINGS IN THE SOFTWARE.
 #include <iostream>
 #include <getopt.h>
 
+#include "assoc.h"
+#include "concat.h"
+#include "grm.h"
 #include "import.h"
+#include "ld.h"
+#include "matrix.h"
 #include "stats.h"
 #include "program_utils.h"
 #include "view.h"
@@ -50,6 +55,16 @@ int main(int argc, char** argv) {
 		return(import(argc, argv));
 	} else if (strncmp(subroutine.data(), "view", 4) == 0 && subroutine.size() == 4) {
 		return(view(argc, argv));
+	} else if (strncmp(subroutine.data(), "concat", 6) == 0 && subroutine.size() == 6) {
+		return(concat(argc, argv));
+	} else if (strncmp(subroutine.data(), "assoc", 5) == 0 && subroutine.size() == 5) {
+		return(assoc(argc, argv));
+	} else if (strncmp(subroutine.data(), "grm", 3) == 0 && subroutine.size() == 3) {
+		return(grm(argc, argv));
+	} else if (strncmp(subroutine.data(), "ld", 2) == 0 && subroutine.size() == 2) {
+		return(ld(argc, argv));
+	} else if (strncmp(subroutine.data(), "matrix", 6) == 0 && subroutine.size() == 6) {
+		return(matrix(argc, argv));
 	} else if (strncmp(subroutine.data(), "stats", 5) == 0 && subroutine.size() == 5) {
 		return(stats(argc, argv));
 		return(0);
@@ -0,0 +1,217 @@
+/*
+Copyright (C) 2017-current Genome Research Ltd.
+Author: Marcus D. R. Klarqvist <mk819@cam.ac.uk>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+#ifndef MATRIX_H_
+#define MATRIX_H_
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <getopt.h>
+
+#include "program_utils.h"
+#include "variant_reader.h"
+#include "genotype_matrix.h"
+
+void matrix_usage(void) {
+	programMessage(true);
+	std::cerr <<
+	"About:  Export genotypes as a dense int8 matrix in NumPy .npy format with one\n"
+	"        row per variant (or one row per column if transposed). The contig and\n"
+	"        position of every variant are written to <out.npy>.variants.\n"
+	"Usage:  " << tachyon::TACHYON_PROGRAM_NAME << " matrix [options] -i <in.yon> -o <out.npy>\n\n"
+	"Options:\n"
+	"  -i FILE   input YON file (required)\n"
+	"  -o FILE   output .npy file (required)\n"
+	"  -l STRING layout: dosage, haplotype, or missing [dosage]\n"
+	"  -S FILE   file with one sample name per line to subset and order columns\n"
+	"  -p INT    alleles per sample in the haplotype layout [2]\n"
+	"  -T        transpose output to columns x variants\n"
+	"  -t INT    number of threads [all]\n"
+	"  -k FILE   keychain file with encryption keys (required if the file is encrypted)\n"
+	"  -s        hide all program messages [null]\n" << std::endl;
+}
+
+int matrix(int argc, char** argv) {
+	if (argc <= 2) {
+		matrix_usage();
+		return(1);
+	}
+
+	int c;
+	int option_index = 0;
+	static struct option long_options[] = {
+		{"input",    required_argument, 0, 'i' },
+		{"output",   required_argument, 0, 'o' },
+		{"layout",   required_argument, 0, 'l' },
+		{"samples",  required_argument, 0, 'S' },
+		{"ploidy",   required_argument, 0, 'p' },
+		{"transpose",no_argument,       0, 'T' },
+		{"threads",  required_argument, 0, 't' },
+		{"keychain", required_argument, 0, 'k' },
+		{"silent",   no_argument,       0, 's' },
+		{0,0,0,0}
+	};
+
+	SILENT = 0;
+	tachyon::VariantReaderSettings settings;
+	tachyon::yon_gt_matrix_settings matrix_settings;
+	std::string samples_file;
+	uint32_t n_threads = std::thread::hardware_concurrency();
+
+	while ((c = getopt_long(argc, argv, "i:o:l:S:p:Tt:k:s?", long_options, &option_index)) != -1) {
+		switch (c) {
+		case 0:
+			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
+			break;
+		case 'i':
+			settings.input = std::string(optarg);
+			break;
+		case 'o':
+			settings.output = std::string(optarg);
+			break;
+		case 'l':
+		{
+			const std::string layout(optarg);
+			if (layout == "dosage") matrix_settings.layout = tachyon::YON_GT_MATRIX_DOSAGE;
+			else if (layout == "haplotype") matrix_settings.layout = tachyon::YON_GT_MATRIX_HAPLOTYPE;
+			else if (layout == "missing") matrix_settings.layout = tachyon::YON_GT_MATRIX_MISSING_MASK;
+			else {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Unknown layout: " << layout << std::endl;
+				return(1);
+			}
+			break;
+		}
+		case 'S':
+			samples_file = std::string(optarg);
+			break;
+		case 'p':
+			matrix_settings.ploidy = atoi(optarg);
+			if (matrix_settings.ploidy == 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Ploidy must be positive..." << std::endl;
+				return(1);
+			}
+			break;
+		case 'T':
+			matrix_settings.transpose = true;
+			break;
+		case 't':
+			n_threads = atoi(optarg);
+			break;
+		case 'k':
+			settings.keychain_file = std::string(optarg);
+			break;
+		case 's':
+			SILENT = 1;
+			break;
+		default:
+			matrix_usage();
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Unrecognized option: " << (char)c << std::endl;
+			return(1);
+		}
+	}
+
+	if (settings.input.length() == 0) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "No input value specified..." << std::endl;
+		return(1);
+	}
+
+	if (settings.output.length() == 0 || settings.output == "-") {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Matrix requires an output file..." << std::endl;
+		return(1);
+	}
+
+	if (!SILENT) {
+		programMessage();
+		std::cerr << tachyon::utility::timestamp("LOG") << "Calling matrix..." << std::endl;
+	}
+
+	tachyon::VariantReader reader;
+	reader.GetSettings() = settings;
+	if (!reader.open(settings.input)) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to open file: " << settings.input << "..." << std::endl;
+		return(1);
+	}
+
+	if (samples_file.size()) {
+		std::ifstream samples(samples_file);
+		if (!samples.good()) {
+			std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open sample file: " << samples_file << std::endl;
+			return(1);
+		}
+		std::string line;
+		while (std::getline(samples, line)) {
+			if (line.size() == 0) continue;
+			const int32_t id = reader.GetHeader().GetSampleId(line);
+			if (id < 0) {
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Sample does not exist: " << line << std::endl;
+				return(1);
+			}
+			matrix_settings.samples.push_back(id);
+		}
+	}
+
+	reader.GetBlockSettings().LoadMinimumVcf(true).LoadGenotypes(true);
+
+	// Matrices are always filled with one row per variant. Transposed
+	// output is instead stored in Fortran order by the writer.
+	const bool transpose = matrix_settings.transpose;
+	matrix_settings.transpose = false;
+
+	tachyon::yon_npy_writer writer;
+	if (!writer.open(settings.output, matrix_settings.GetNumberColumns(reader.GetHeader().GetNumberSamples()), transpose))
+		return(1);
+
+	const std::string variants_file = settings.output + ".variants";
+	std::ofstream variants(variants_file);
+	if (!variants.good()) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Could not open: " << variants_file << std::endl;
+		return(1);
+	}
+
+	const tachyon::yon_vnt_hdr_t& header = reader.GetHeader();
+	// The callback stops iteration if a matrix cannot be written.
+	bool written = true;
+	const bool ret = reader.GetGenotypeMatrices(matrix_settings, [&writer, &variants, &header, &written](const tachyon::yon_gt_matrix& m) {
+		for (uint32_t i = 0; i < m.n_rows; ++i)
+			variants << header.contigs_[m.rid[i]].name << '\t' << m.pos[i] + 1 << '\n';
+		written = writer.Add(m);
+		return(written);
+	}, n_threads);
+
+	if (ret == false || written == false) {
+		std::cerr << tachyon::utility::timestamp("ERROR") << "Failed to export genotypes..." << std::endl;
+		return(1);
+	}
+
+	if (!writer.close()) return(1);
+
+	if (!SILENT) {
+		std::cerr << tachyon::utility::timestamp("LOG") << "Wrote " << tachyon::utility::ToPrettyString(writer.n_rows) << " variants x " << writer.n_cols << " columns to " << settings.output << std::endl;
+	}
+
+	return 0;
+}
+
+#endif /* MATRIX_H_ */
@@ -60,6 +60,11 @@ void programHelp(void) {
     "Commands:\n"
 	"import  import VCF/VCF.gz/BCF to YON\n"
     "view    convert YON->VCF/BCF/YON; provides subsetting and slicing functionality\n"
+	"concat  concatenate YON archives with compatible headers\n"
+	"ld      compute pairwise linkage disequilibrium\n"
+	"assoc   test variants for association with a phenotype\n"
+	"grm     compute the genomic relationship matrix or kinship of all samples\n"
+	"matrix  export genotypes as a dense matrix in NumPy .npy format\n"
 	"stats   calculate comprehensive per-sample statistics\n" << std::endl;
 }
 
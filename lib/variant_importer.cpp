@@ -1,5 +1,7 @@
+#include <cstdio>
 #include <fstream>
 #include <regex>
+#include <sstream>
 #include <thread>
 
 #include <openssl/evp.h>
@@ -8,6 +10,7 @@
 #include "variant_importer.h"
 #include "containers/checksum_container.h"
 #include "algorithm/parallel/vcf_slaves.h"
+#include "io/import_checkpoint.h"
 #include "vcf_importer_slave.h"
 #include "algorithm/timer.h"
 
@@ -16,16 +19,30 @@ namespace tachyon {
 VariantImporterSettings::VariantImporterSettings() :
 	verbose(true),
 	permute_genotypes(true),
+	haplotype_pbwt(false),
+	sparse_genotypes(false),
 	encrypt_data(false),
+	resume(false),
+	append(false),
+	sort(false),
 	checkpoint_n_snps(1000),
 	checkpoint_bases(10e6),
+	checkpoint_compressed(false),
+	checkpoint_bytes(0),
+	checkpoint_min_snps(100),
+	checkpoint_max_snps(100000),
 	n_threads(std::thread::hardware_concurrency()),
 	compression_level(6),
 	htslib_extra_threads(std::thread::hardware_concurrency() - 1 >= 0
 	                     ? std::thread::hardware_concurrency() - 1
 	                     : 0),
+	permute_threads(1),
+	permute_carry_interval(0),
+	checkpoint_interval(100),
 	info_end_key(-1),
-	info_svlen_key(-1)
+	info_svlen_key(-1),
+	sort_run_bytes(io::YON_SORT_RUN_BYTES),
+	temp_directory(".")
 {
 }
 
@@ -34,7 +51,12 @@ std::string VariantImporterSettings::GetInterpretedString(void) const {
 	   "\",\"output_prefix\":\"" + this->output_prefix +
 	   "\",\"checkpoint_snps\":" + std::to_string(this->checkpoint_n_snps) +
 	   ",\"checkpoint_bases\":" + std::to_string(this->checkpoint_bases) +
+	   ",\"checkpoint_bytes\":" + std::to_string(this->checkpoint_bytes) +
+	   ",\"checkpoint_compressed\":" + (this->checkpoint_compressed ? "true" : "false") +
 	   ",\"compression_level\":" + std::to_string(this->compression_level) +
+	   ",\"permute_carry_interval\":" + std::to_string(this->permute_carry_interval) +
+	   ",\"haplotype_pbwt\":" + (this->haplotype_pbwt ? "true" : "false") +
+	   ",\"sparse_genotypes\":" + (this->sparse_genotypes ? "true" : "false") +
 	   "}"
 	));
 }
@@ -82,6 +104,18 @@ private:
 	 */
 	bool WriteYonHeader(writer_interface_type* writer);
 
+	/**<
+	 * Restore the state of a previously interrupted import from its sidecar
+	 * checkpoint: the archive is truncated to the end of the last block
+	 * described by the checkpoint, the index entries, block and variant counts,
+	 * and digest states are restored into the writer, and the input stream is
+	 * positioned at the first record that was not written.
+	 * @param writer Destination writer.
+	 * @param ckpt   Dst checkpoint read from disk.
+	 * @return       Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool ResumeFromCheckpoint(writer_interface_type* writer, yon_import_ckpt& ckpt);
+
 	/**<
 	 * Adds Extra fields to the global tachyon header describing when and how
 	 * the target file was imported in the tachyon archive.
@@ -151,8 +185,41 @@ bool VariantImporter::Build() {
 	}
 	else this->mImpl->writer = new VariantImporterImpl::writer_file_type;
 
-	// Open a file handle or standard out for writing.
-	if (!this->mImpl->writer->open(this->settings_.output_prefix)) {
+	if ((this->settings_.resume || this->settings_.append) &&
+	   (this->settings_.output_prefix.size() == 0 || this->settings_.output_prefix == "-"))
+	{
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Cannot resume or append to an archive that is written to standard out..." << std::endl;
+		return false;
+	}
+
+	// Keys are generated per block and only written to the keychain when
+	// the import completes: the keys of blocks written before an
+	// interruption are lost and those blocks could never be decrypted.
+	if (this->settings_.resume && this->settings_.encrypt_data) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Cannot resume an encrypted import..." << std::endl;
+		return false;
+	}
+
+	// The keychain of the existing archive would be overwritten by the keys
+	// of the appended blocks.
+	if (this->settings_.append && this->settings_.encrypt_data) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Cannot append encrypted data to an existing archive..." << std::endl;
+		return false;
+	}
+
+	// Sorted imports are not checkpointed: an interrupted append could not
+	// be recovered once the trailer of the archive has been overwritten.
+	if (this->settings_.append && this->settings_.sort) {
+		std::cerr << utility::timestamp("ERROR", "WRITER") << "Cannot sort input that is appended to an existing archive..." << std::endl;
+		return false;
+	}
+
+	// Open a file handle or standard out for writing. When resuming or
+	// appending, the existing archive is reopened after the input header
+	// has been read and validated against it.
+	if (!this->settings_.resume && !this->settings_.append &&
+	    !this->mImpl->writer->open(this->settings_.output_prefix))
+	{
 		std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to open writer..." << std::endl;
 		return false;
 	}
@@ -175,6 +242,22 @@ bool VariantImporter::VariantImporterImpl::Build(writer_interface_type* writer,
 	if (this->vcf_reader_ == nullptr)
 		return false;
 
+	// Unsorted input is sorted into temporary runs that are merged
+	// on the fly while importing.
+	if (this->settings->sort) {
+		if (this->settings->resume) {
+			std::cerr << utility::timestamp("ERROR", "IMPORT") << "Cannot resume an import of sorted input..." << std::endl;
+			return false;
+		}
+
+		if (!SILENT)
+			std::cerr << utility::timestamp("LOG", "SORT") << "Sorting input records..." << std::endl;
+
+		if (!this->vcf_reader_->Sort(this->settings->temp_directory, this->settings->sort_run_bytes, this->settings->n_threads)) {
+			std::cerr << utility::timestamp("ERROR", "SORT") << "Failed to sort input: " << this->settings->input_file << std::endl;
+			return false;
+		}
+	}
 
 	for (uint32_t i = 0; i < this->vcf_reader_->vcf_header_.contigs_.size(); ++i) {
 		if (this->vcf_reader_->vcf_header_.contigs_[i].n_bases == 0) {
@@ -217,16 +300,76 @@ bool VariantImporter::VariantImporterImpl::Build(writer_interface_type* writer,
 	// for the data lengths.
 	writer->index.Setup(this->vcf_reader_->vcf_header_.contigs_);
 
-	// Write out a fresh Tachyon header with the data from the Vcf header. As
-	// this data will not be modified during the import stage it is safe to
-	// write out now.
-	this->WriteYonHeader(writer);
+	// Checkpoints are only written for file output as resuming requires
+	// truncating and reopening the archive. Sorted input has no input
+	// position to resume from and encrypted imports cannot be resumed.
+	const bool file_output     = (this->settings->output_prefix.size() && this->settings->output_prefix != "-");
+	const bool use_checkpoints = (file_output && this->settings->sort == false && this->settings->encrypt_data == false);
+	std::string checkpoint_path;
+	yon_import_ckpt ckpt;
+	if (file_output) {
+		writer_file_type* wfile = reinterpret_cast<writer_file_type*>(writer);
+		wfile->CheckOutputNames(this->settings->output_prefix);
+		checkpoint_path = wfile->GetFileName() + '.' + TACHYON_CHECKPOINT_SUFFIX;
+	}
+
+	if (this->settings->resume) {
+		if (!ckpt.Read(checkpoint_path))
+			return false;
+
+		if (!this->ResumeFromCheckpoint(writer, ckpt))
+			return false;
+	} else {
+		// Drop any stale checkpoint from a previous run as it no longer
+		// describes the archive that is about to be written.
+		if (file_output) std::remove(checkpoint_path.c_str());
+
+		if (this->settings->append) {
+			// Reopen an existing archive: its header is kept and has to be
+			// compatible with the input data.
+			this->yon_header_ = this->ConvertVcfHeader(this->vcf_reader_->vcf_header_);
+			if (!reinterpret_cast<writer_file_type*>(writer)->OpenAppend(this->settings->output_prefix, this->yon_header_))
+				return false;
+		} else {
+			// Write out a fresh Tachyon header with the data from the Vcf header. As
+			// this data will not be modified during the import stage it is safe to
+			// write out now.
+			this->WriteYonHeader(writer);
+		}
+
+		ckpt.input_file = this->settings->input_file;
+		ckpt.n_samples  = this->vcf_reader_->vcf_header_.GetNumberSamples();
+		ckpt.n_contigs  = this->vcf_reader_->vcf_header_.contigs_.size();
+	}
 
 	yon_producer_vcfc  producer(*this->settings, this->vcf_reader_, this->settings->n_threads);
 	yon_consumer_vcfc* consumers = new yon_consumer_vcfc[this->settings->n_threads];
 	yon_writer_sync    write;
 	write.writer = writer;
 
+	// Adaptive block sizing: blocks are closed after a number of records
+	// estimated from the sizes of the blocks written so far.
+	yon_vb_budget budget;
+	if (this->settings->checkpoint_bytes > 0) {
+		budget.Setup(this->settings->checkpoint_bytes,
+		             this->settings->checkpoint_compressed,
+		             this->settings->checkpoint_n_snps,
+		             this->settings->checkpoint_min_snps,
+		             this->settings->checkpoint_max_snps);
+		producer.budget = &budget;
+		write.budget    = &budget;
+	}
+
+	// Continue block numbering from the last checkpointed block if resuming.
+	producer.n_blocks   = writer->n_blocks_written;
+	write.next_block_id  = writer->n_blocks_written;
+	write.first_block_id = writer->n_blocks_written;
+	if (use_checkpoints && this->settings->checkpoint_interval > 0) {
+		write.checkpoint_interval = this->settings->checkpoint_interval;
+		write.checkpoint_path     = checkpoint_path;
+		write.checkpoint          = ckpt;
+	}
+
 	write.stats_basic.Allocate(YON_BLK_N_STATIC);
 	write.stats_info.Allocate(this->vcf_reader_->vcf_header_.info_fields_.size());
 	write.stats_format.Allocate(this->vcf_reader_->vcf_header_.format_fields_.size());
@@ -245,6 +388,18 @@ bool VariantImporter::VariantImporterImpl::Build(writer_interface_type* writer,
 	std::shared_ptr<yon_writer_sync> s_writer(&write);
 	std::shared_ptr<Keychain> s_keychain(&this->keychain);
 
+	// Carry the genotype permutation from each block to the next. The
+	// chain starts empty such that the first block written by this run
+	// stores a full permutation, also when resuming or appending.
+	// Permutations of encrypted blocks cannot be resolved without a
+	// keychain and are therefore never carried.
+	std::shared_ptr<yon_ppa_chain> s_ppa_chain;
+	if (this->settings->permute_carry_interval > 0 && this->settings->permute_genotypes && GT_available) {
+		if (this->settings->encrypt_data) {
+			std::cerr << utility::timestamp("NOTICE") << "Permutations are not carried across encrypted blocks..." << std::endl;
+		} else s_ppa_chain = std::make_shared<yon_ppa_chain>(writer->n_blocks_written);
+	}
+
 	// Setup and start slaves.
 	for (uint32_t i = 0; i < this->settings->n_threads; ++i) {
 		consumers[i].thread_id = i;
@@ -255,6 +410,8 @@ bool VariantImporter::VariantImporterImpl::Build(writer_interface_type* writer,
 		consumers[i].importer.GT_available_       = GT_available;
 		consumers[i].importer.SetVcfHeader(s_vcf_hdr);
 		consumers[i].importer.settings_           = s_settings;
+		consumers[i].importer.permutator.SetThreads(this->settings->permute_threads);
+		consumers[i].importer.ppa_chain = s_ppa_chain;
 		consumers[i].importer.keychain            = s_keychain;
 		consumers[i].importer.info_reorder_map_   = this->info_reorder_map_;
 		consumers[i].importer.format_reorder_map_ = this->format_reorder_map_;
@@ -286,10 +443,26 @@ bool VariantImporter::VariantImporterImpl::Build(writer_interface_type* writer,
 	writer->index += consumers[0].importer.index;
 	//this->writer->index.Print(std::cerr);
 
+	// Do not finalize a failed import: an archive opened for appending is
+	// left untouched if no block was written and can otherwise be
+	// recovered from the checkpoint.
+	if (write.failed) {
+		std::cerr << utility::timestamp("ERROR", "IMPORT") << "Failed to write blocks..." << std::endl;
+		return false;
+	}
+
+	if (this->vcf_reader_->SortFailed()) {
+		std::cerr << utility::timestamp("ERROR", "IMPORT") << "Failed to read sorted records..." << std::endl;
+		return false;
+	}
+
 	// Finalize writing procedure.
 	writer->close();
 	this->WriteKeychain(writer);
 
+	// The archive is complete: the checkpoint is no longer needed.
+	if (use_checkpoints) std::remove(checkpoint_path.c_str());
+
 	uint64_t b_uncompressed = 0;
 	if (settings.output_prefix != "-") {
 		std::cout << "Field\tType\tCompressed\tUncompressed\tStrideCompressed\tStrideUncompressed\tFold\tBinaryVcf\tFold-Bcf-Yon" << std::endl;
@@ -343,6 +516,57 @@ bool VariantImporter::VariantImporterImpl::WriteKeychain(writer_interface_type*
 	return true;
 }
 
+bool VariantImporter::VariantImporterImpl::ResumeFromCheckpoint(writer_interface_type* writer, yon_import_ckpt& ckpt) {
+	if (writer == nullptr)
+		return false;
+
+	if (!ckpt.IsCompatible(this->settings->input_file,
+	                       this->vcf_reader_->vcf_header_.GetNumberSamples(),
+	                       this->vcf_reader_->vcf_header_.contigs_.size()))
+	{
+		return false;
+	}
+
+	// Truncate the archive to the last consistent block and reopen it.
+	writer_file_type* wfile = reinterpret_cast<writer_file_type*>(writer);
+	if (!wfile->open(this->settings->output_prefix, ckpt.byte_offset_end))
+		return false;
+
+	// Restore the index. The quad-tree bins are rebuilt from the block
+	// intervals stored in the linear index: this is coarser than indexing
+	// every record but remains correct as overlap queries are resolved
+	// against the linear index.
+	for (uint32_t i = 0; i < ckpt.index_entries.size(); ++i) {
+		const yon1_idx_rec& entry = ckpt.index_entries[i];
+		writer->index += entry;
+		writer->index.AddSorted(entry.contig_id, entry.min_position, entry.max_position, entry.block_id);
+	}
+	writer->n_blocks_written   = ckpt.n_blocks_written;
+	writer->n_variants_written = ckpt.n_variants_written;
+
+	std::istringstream digest_state(ckpt.digest_state);
+	if (!writer->DeserializeDigestState(digest_state)) {
+		std::cerr << utility::timestamp("ERROR", "IMPORT") << "Failed to restore digest state from checkpoint..." << std::endl;
+		return false;
+	}
+
+	// Position the input stream at the first record that was not written.
+	if (!this->vcf_reader_->Seek(ckpt.input_offset)) {
+		std::cerr << utility::timestamp("ERROR", "IMPORT") << "Failed to seek input to offset " << ckpt.input_offset << ". Resuming requires uncompressed or bgzipped input..." << std::endl;
+		return false;
+	}
+
+	// The archive header has already been written: only reconstruct the
+	// in-memory representation.
+	this->yon_header_ = this->ConvertVcfHeader(this->vcf_reader_->vcf_header_);
+
+	if (!SILENT) {
+		std::cerr << utility::timestamp("LOG", "IMPORT") << "Resuming import after block " << ckpt.n_blocks_written << " (" << utility::ToPrettyString(ckpt.n_variants_written) << " variants)..." << std::endl;
+	}
+
+	return true;
+}
+
 bool VariantImporter::VariantImporterImpl::WriteYonHeader(writer_interface_type* writer) {
 	if (writer == nullptr)
 		return false;
@@ -16,6 +16,7 @@
 #include "algorithm/parallel/vcf_slaves.h"
 #include "algorithm/parallel/variant_slaves.h"
 #include "algorithm/parallel/variant_base_slave.h"
+#include "algorithm/parallel/fork_join.h"
 
 namespace tachyon {
 
@@ -25,6 +26,8 @@ VariantReaderSettings::VariantReaderSettings() :
 	output("-"), output_type('v'),
 	permute_genotypes(true), encrypt_data(true),
 	checkpoint_n_snps(500), checkpoint_bases(5000000),
+	checkpoint_compressed(false), checkpoint_bytes(0),
+	checkpoint_min_snps(100), checkpoint_max_snps(100000),
 	n_threads(std::thread::hardware_concurrency()), compression_level(6)
 {}
 
@@ -49,8 +52,8 @@ public:
 	typedef io::BasicReader                        basic_reader_type;
 
 public:
-	VariantReaderImpl() = default;
-	VariantReaderImpl(const std::string& filename) : basic_reader(filename) {}
+	VariantReaderImpl() : ppa_deltas(false), ppa_last_block(-1) {}
+	VariantReaderImpl(const std::string& filename) : basic_reader(filename), ppa_deltas(false), ppa_last_block(-1) {}
 
 	/**<
 	* Converts this header object into a hts_vcf_header object from the
@@ -66,19 +69,23 @@ public:
 	checksum_type           checksums;
 	codec_manager_type      codec_manager;
 	interval_container_type interval_container;
-
+	bool       ppa_deltas; // a permutation array stored as a delta has been seen
+	int64_t    ppa_last_block; // block identifier of ppa_last or -1
+	yon_gt_ppa ppa_last; // resolved permutation array of the most recent block
 };
 
 VariantReader::VariantReader() :
 	mImpl(new VariantReader::VariantReaderImpl),
 	b_data_start(0),
-	gt_exp(nullptr)
+	gt_exp(nullptr),
+	gt_tile_from(0)
 {}
 
 VariantReader::VariantReader(const std::string& filename) :
 	mImpl(new VariantReader::VariantReaderImpl(filename)),
 	b_data_start(0),
-	gt_exp(nullptr)
+	gt_exp(nullptr),
+	gt_tile_from(0)
 {
 
 }
@@ -190,6 +197,7 @@ bool VariantReader::NextBlock() {
 
 	// Reset and re-use
 	this->variant_container.clear();
+	const uint64_t block_offset = this->mImpl->basic_reader.stream_.tellg();
 
 	// Read packed header and footer bytes from the byte-stream.
 	if (!this->variant_container.ReadHeaderFooter(this->mImpl->basic_reader.stream_))
@@ -231,6 +239,12 @@ bool VariantReader::NextBlock() {
 		return false;
 	}
 
+	if ((this->block_settings.load_static & YON_BLK_BV_PPA) &&
+	    !this->ResolvePermutation(this->variant_container, block_offset))
+	{
+		return false;
+	}
+
 	// Checks need to made to ascertain that any data actually exists
 	// and that if data was encrypted that any data was successfully
 	// decrypted.
@@ -244,6 +258,7 @@ bool VariantReader::NextBlockRaw(void) {
 
 	// Reset and re-use
 	this->variant_container.clear();
+	const uint64_t block_offset = this->mImpl->basic_reader.stream_.tellg();
 
 	if (!this->variant_container.ReadHeaderFooter(this->mImpl->basic_reader.stream_))
 		return false;
@@ -258,6 +273,32 @@ bool VariantReader::NextBlockRaw(void) {
 	if (!this->variant_container.read(this->mImpl->basic_reader.stream_, this->block_settings, this->global_header))
 		return false;
 
+	// Permutation arrays stored relative to the preceding block are
+	// resolved in order here. Once such a block has been seen all
+	// subsequent permutation arrays are resolved here to keep the
+	// cached permutation current. The resolved array is not
+	// decompressed again. Blocks encoded as a haplotype PBWT store the
+	// haplotype order in the same container: it is decompressed into
+	// gt_hppa when the block is unpacked as in NextBlock().
+	yon1_vb_t& block = this->variant_container;
+	this->mImpl->ppa_deltas |= (bool)block.header.controller.has_ppa_delta;
+	if (this->mImpl->ppa_deltas && (this->block_settings.load_static & YON_BLK_BV_PPA) &&
+	    block.header.controller.has_gt_permuted &&
+	    block.header.controller.has_gt_haplotypes == false &&
+	    block.gt_ppa != nullptr &&
+	    block.base_containers[YON_BLK_PPA].GetSizeCompressed() &&
+	    block.base_containers[YON_BLK_PPA].IsEncrypted() == false)
+	{
+		if (!this->mImpl->codec_manager.Decompress(block.base_containers[YON_BLK_PPA], *block.gt_ppa)) {
+			std::cerr << utility::timestamp("ERROR", "COMPRESSION") << "Failed to decompress GT permutation information!" << std::endl;
+			return false;
+		}
+		block.base_containers[YON_BLK_PPA].data.reset();
+
+		if (!this->ResolvePermutation(block, block_offset))
+			return false;
+	}
+
 	// All passed
 	return true;
 }
@@ -277,45 +318,263 @@ bool VariantReader::CheckNextValid(void) {
 	return true;
 }
 
-yon1_vb_t VariantReader::ReturnBlock(void) {
-	block_entry_type c;
-
+bool VariantReader::ReturnBlock(block_entry_type& c) {
+	c.clear();
 	if (this->CheckNextValid() == false)
-		return c;
+		return false;
 
+	const uint64_t block_offset = this->mImpl->basic_reader.stream_.tellg();
 	if (!c.ReadHeaderFooter(this->mImpl->basic_reader.stream_))
-		return(c);
+		return false;
 
 	if (!this->mImpl->codec_manager.zstd_codec.Decompress(c.footer_support)) {
 		std::cerr << utility::timestamp("ERROR", "COMPRESSION") << "Failed decompression of footer!" << std::endl;
+		return false;
 	}
 	c.footer_support.data_uncompressed >> c.footer;
 
 	// Attempts to read a YON block with the settings provided
 	if (!c.read(this->mImpl->basic_reader.stream_, this->block_settings, this->global_header))
-		return(c);
+		return false;
 
 	// encryption manager ascertainment
 	if (c.header.controller.any_encrypted) {
 		if (this->keychain.size() == 0) {
 			std::cerr << utility::timestamp("ERROR", "DECRYPTION") << "Data is encrypted but no keychain was provided!" << std::endl;
-			return(c);
+			return false;
 		}
 
 		encryption_manager_type encryption_manager;
 		if (!encryption_manager.Decrypt(c, this->keychain)) {
 			std::cerr << utility::timestamp("ERROR", "DECRYPTION") << "Failed decryption!" << std::endl;
-			return(c);
+			return false;
 		}
 	}
 
 	// Internally decompress available data
 	if (!this->mImpl->codec_manager.Decompress(c)) {
 		std::cerr << utility::timestamp("ERROR", "COMPRESSION") << "Failed decompression!" << std::endl;
-		return(c);
+		return false;
+	}
+
+	if ((this->block_settings.load_static & YON_BLK_BV_PPA) &&
+	    this->ResolvePermutation(c, block_offset) == false)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Decrypt and decompress a raw block. This function is invoked
+// concurrently for distinct blocks.
+static bool UnpackRawBlock(yon1_vb_t& block,
+                           Keychain& keychain,
+                           algorithm::CompressionManager& codec_manager)
+{
+	if (block.header.controller.any_encrypted) {
+		if (keychain.size() == 0) {
+			std::cerr << utility::timestamp("ERROR", "DECRYPTION") << "Data is encrypted but no keychain was provided!" << std::endl;
+			return false;
+		}
+
+		EncryptionDecorator encryption_manager;
+		if (!encryption_manager.Decrypt(block, keychain)) {
+			std::cerr << utility::timestamp("ERROR", "DECRYPTION") << "Failed decryption!" << std::endl;
+			return false;
+		}
+	}
+
+	if (!codec_manager.Decompress(block)) {
+		std::cerr << utility::timestamp("ERROR", "COMPRESSION") << "Failed decompression!" << std::endl;
+		return false;
 	}
 
-	return(c);
+	return true;
+}
+
+// Decrypt and decompress a raw block and convert its genotypes into a
+// dense matrix. This function is invoked concurrently for distinct blocks.
+static bool ConvertGenotypeMatrix(yon1_vb_t& block,
+                                  const yon_vnt_hdr_t& header,
+                                  Keychain& keychain,
+                                  algorithm::CompressionManager& codec_manager,
+                                  yon_gt_tiled_exp& tiles,
+                                  yon_gt_matrix& matrix,
+                                  const yon_gt_matrix_settings& settings)
+{
+	if (UnpackRawBlock(block, keychain, codec_manager) == false)
+		return false;
+
+	yon1_vc_t vc(block, header);
+	return(matrix.Fill(vc, settings, tiles));
+}
+
+// Decrypt and decompress a raw block and test all of its records for
+// association. This function is invoked concurrently for distinct blocks.
+static bool TestAssociations(yon1_vb_t& block,
+                             const yon_vnt_hdr_t& header,
+                             Keychain& keychain,
+                             algorithm::CompressionManager& codec_manager,
+                             const Association& engine,
+                             yon_assoc_workspace& ws)
+{
+	if (UnpackRawBlock(block, keychain, codec_manager) == false)
+		return false;
+
+	yon1_vc_t vc(block, header);
+	return(engine.Evaluate(vc, ws));
+}
+
+bool VariantReader::NextGenotypeMatrix(yon_gt_matrix& matrix, const yon_gt_matrix_settings& settings) {
+	if (this->NextBlock() == false)
+		return false;
+
+	if (this->gt_tiles.n_s != this->global_header.GetNumberSamples())
+		this->gt_tiles.Allocate(this->global_header.GetNumberSamples());
+
+	yon1_vc_t vc(this->variant_container, this->global_header);
+	return(matrix.Fill(vc, settings, this->gt_tiles));
+}
+
+bool VariantReader::GetGenotypeMatrices(const yon_gt_matrix_settings& settings,
+                                        const matrix_callback_type& callback,
+                                        const uint32_t n_threads)
+{
+	const uint32_t n_workers = std::max(n_threads, (uint32_t)1);
+
+	// Every worker owns its block, codecs, and matrix.
+	block_entry_type* blocks = new block_entry_type[n_workers];
+	algorithm::CompressionManager* codecs = new algorithm::CompressionManager[n_workers];
+	yon_gt_tiled_exp* tiles  = new yon_gt_tiled_exp[n_workers];
+	yon_gt_matrix* matrices  = new yon_gt_matrix[n_workers];
+	std::vector<uint8_t> success(n_workers, 0);
+	for (uint32_t i = 0; i < n_workers; ++i)
+		tiles[i].Allocate(this->global_header.GetNumberSamples());
+
+	algorithm::ForkJoinPool pool;
+	pool.Start(n_workers);
+
+	// Stopping at the request of the callback is not an error.
+	bool ret = true, stop = false;
+	uint32_t block_id = 0;
+	while (ret && stop == false) {
+		// Blocks are read in order as permutation arrays may be stored
+		// relative to the preceding block.
+		uint32_t n_blocks = 0;
+		for (; n_blocks < n_workers; ++n_blocks) {
+			if (this->NextBlockRaw() == false) break;
+			blocks[n_blocks] = std::move(this->variant_container);
+			this->variant_container = block_entry_type();
+		}
+		if (n_blocks == 0) break;
+
+		pool.Run([&](const uint32_t w) {
+			if (w >= n_blocks) return;
+			success[w] = ConvertGenotypeMatrix(blocks[w], this->global_header, this->keychain, codecs[w], tiles[w], matrices[w], settings);
+		});
+
+		for (uint32_t i = 0; i < n_blocks; ++i) {
+			if (success[i] == false) { ret = false; break; }
+			matrices[i].block_id = block_id++;
+			if (callback(matrices[i]) == false) { stop = true; break; }
+		}
+	}
+
+	pool.Stop();
+	delete [] blocks;
+	delete [] codecs;
+	delete [] tiles;
+	delete [] matrices;
+	return(ret);
+}
+
+bool VariantReader::GetAssociations(const Association& engine,
+                                    const assoc_callback_type& callback,
+                                    const uint32_t n_threads)
+{
+	const uint32_t n_workers = std::max(n_threads, (uint32_t)1);
+
+	// Every worker owns its block, codecs, and workspace such that null
+	// model rows are only permuted again if the permutation changes.
+	block_entry_type* blocks = new block_entry_type[n_workers];
+	algorithm::CompressionManager* codecs = new algorithm::CompressionManager[n_workers];
+	yon_assoc_workspace* workspaces = new yon_assoc_workspace[n_workers];
+	std::vector<uint8_t> success(n_workers, 0);
+
+	algorithm::ForkJoinPool pool;
+	pool.Start(n_workers);
+
+	// Stopping at the request of the callback is not an error.
+	bool ret = true, stop = false;
+	while (ret && stop == false) {
+		// Blocks are read in order as permutation arrays may be stored
+		// relative to the preceding block.
+		uint32_t n_blocks = 0;
+		for (; n_blocks < n_workers; ++n_blocks) {
+			if (this->NextBlockRaw() == false) break;
+			blocks[n_blocks] = std::move(this->variant_container);
+			this->variant_container = block_entry_type();
+		}
+		if (n_blocks == 0) break;
+
+		pool.Run([&](const uint32_t w) {
+			if (w >= n_blocks) return;
+			success[w] = TestAssociations(blocks[w], this->global_header, this->keychain, codecs[w], engine, workspaces[w]);
+		});
+
+		for (uint32_t i = 0; i < n_blocks; ++i) {
+			if (success[i] == false) { ret = false; break; }
+			if (callback(workspaces[i]) == false) { stop = true; break; }
+		}
+	}
+
+	pool.Stop();
+	delete [] blocks;
+	delete [] codecs;
+	delete [] workspaces;
+	return(ret);
+}
+
+bool VariantReader::GetFilteredBlocks(const block_callback_type& callback, const uint64_t first_block) {
+	this->mImpl->interval_container.Build(this->global_header);
+	const bool use_intervals = this->mImpl->interval_container.size();
+	std::vector<uint8_t> pass;
+
+	// Records are filtered in place such that genotype summaries required
+	// by the filters are evaluated at most once per record.
+	auto process = [&](void) -> bool {
+		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
+		pass.assign(vc.size(), 0);
+		for (uint32_t i = 0; i < vc.size(); ++i) {
+			if (use_intervals && this->FilterIntervals(vc[i]) == false)
+				continue;
+
+			pass[i] = this->variant_filters.Filter(vc[i], i);
+		}
+		return(callback(vc, pass));
+	};
+
+	if (use_intervals) {
+		for (uint64_t i = first_block; i < this->mImpl->interval_container.GetBlockList().size(); ++i) {
+			if (this->GetBlock(this->mImpl->interval_container.GetBlockList()[i]) == false)
+				return false;
+
+			if (process() == false) return false;
+		}
+		return true;
+	}
+
+	if (first_block) {
+		if (first_block >= this->GetIndex().GetLinearSize()) return true;
+		if (this->SeekBlock(first_block) == false) return false;
+	}
+
+	while (this->NextBlock()) {
+		if (process() == false) return false;
+	}
+
+	return true;
 }
 
 bool VariantReader::GetBlock(const index_entry_type& index_entry) {
@@ -336,6 +595,105 @@ bool VariantReader::GetBlock(const index_entry_type& index_entry) {
 	return(this->NextBlock());
 }
 
+bool VariantReader::ResolvePermutation(block_entry_type& block, const uint64_t block_offset) {
+	if (block.gt_ppa == nullptr || block.gt_ppa->ordering == nullptr)
+		return true;
+
+	// A block that is not sample-permuted may still hold the permutation
+	// array of a previously loaded block.
+	if (block.header.controller.has_gt_permuted == false || block.header.controller.has_gt_haplotypes)
+		return true;
+
+	// Locate the block in the linear index. Blocks are stored in the
+	// order of the index.
+	int64_t block_id = -1;
+	uint64_t from = 0, to = this->index.GetLinearSize();
+	while (from < to) {
+		const uint64_t mid = from + (to - from) / 2;
+		if (this->index[mid].byte_offset < block_offset) from = mid + 1;
+		else to = mid;
+	}
+	if (from < this->index.GetLinearSize() && this->index[from].byte_offset == block_offset)
+		block_id = from;
+
+	if (block.header.controller.has_ppa_delta) {
+		this->mImpl->ppa_deltas = true;
+		if (block_id <= 0) {
+			std::cerr << utility::timestamp("ERROR", "PERMUTE") << "Permutation array is stored relative to a block that does not exist!" << std::endl;
+			return false;
+		}
+
+		if (this->mImpl->ppa_last_block != block_id - 1) {
+			if (this->LoadPermutation(block_id - 1) == false)
+				return false;
+		}
+
+		if (block.gt_ppa->ApplyDelta(this->mImpl->ppa_last) == false) {
+			std::cerr << utility::timestamp("ERROR", "PERMUTE") << "Corrupted permutation array in block " << block_id << "!" << std::endl;
+			return false;
+		}
+		block.header.controller.has_ppa_delta = false;
+	}
+
+	this->mImpl->ppa_last = *block.gt_ppa;
+	this->mImpl->ppa_last_block = block_id;
+	return true;
+}
+
+bool VariantReader::LoadPermutation(const uint32_t block_id) {
+	std::ifstream& stream = this->mImpl->basic_reader.stream_;
+	const uint64_t restore_offset = stream.tellg();
+
+	// Walk back to the closest block storing a full permutation or
+	// to the block whose permutation is cached.
+	int64_t first = block_id;
+	while (first != this->mImpl->ppa_last_block) {
+		yon_vb_hdr header;
+		stream.seekg(this->index[first].byte_offset);
+		stream >> header;
+		if (stream.good() == false || !(header.controller.has_gt && header.controller.has_gt_permuted)) {
+			std::cerr << utility::timestamp("ERROR", "PERMUTE") << "Block " << first << " has no permutation array to resolve block " << block_id + 1 << " from!" << std::endl;
+			return false;
+		}
+		if (header.controller.has_ppa_delta == false) break;
+		if (first == 0) {
+			std::cerr << utility::timestamp("ERROR", "PERMUTE") << "No block with a full permutation array precedes block " << block_id + 1 << "!" << std::endl;
+			return false;
+		}
+		--first;
+	}
+	if (first == this->mImpl->ppa_last_block) ++first;
+
+	// Resolve forward from that block loading only the permutation
+	// arrays.
+	block_settings_type settings;
+	settings.load_static = YON_BLK_BV_PPA;
+	for (uint32_t i = first; i <= block_id; ++i) {
+		block_entry_type block;
+		stream.seekg(this->index[i].byte_offset);
+		if (!block.ReadHeaderFooter(stream))
+			return false;
+
+		if (!this->mImpl->codec_manager.zstd_codec.Decompress(block.footer_support)) {
+			std::cerr << utility::timestamp("ERROR", "COMPRESSION") << "Failed decompression of footer!" << std::endl;
+			return false;
+		}
+		block.footer_support.data_uncompressed >> block.footer;
+
+		if (!block.read(stream, settings, this->global_header))
+			return false;
+
+		if (!this->mImpl->codec_manager.Decompress(block))
+			return false;
+
+		if (this->ResolvePermutation(block, this->index[i].byte_offset) == false)
+			return false;
+	}
+
+	stream.seekg(restore_offset);
+	return true;
+}
+
 bool VariantReader::SeekBlock(const uint32_t& block_id) {
 	const uint64_t offset = this->GetIndex()[block_id].byte_offset;
 	this->mImpl->basic_reader.stream_.seekg(offset);
@@ -361,30 +719,83 @@ bool VariantReader::LoadKeychainFile(void) {
 	return true;
 }
 
+yon_gt_rcd* VariantReader::ExpandGenotypes(yon1_vc_t& vc, const uint32_t i) {
+	if (this->gt_tiles.n_s != this->global_header.GetNumberSamples())
+		this->gt_tiles.Allocate(this->global_header.GetNumberSamples());
+
+	if (i < this->gt_tile_from || i >= this->gt_tile_from + this->gt_tiles.size()) {
+		const uint32_t n_records = std::min((uint32_t)vc.size() - i, this->gt_tiles.capacity());
+		std::vector<yon_gt*> gts(n_records, nullptr);
+		for (uint32_t j = 0; j < n_records; ++j) {
+			if (vc[i+j].is_loaded_gt && vc[i+j].controller.gt_available)
+				gts[j] = vc[i+j].gt;
+		}
+
+		this->gt_tile_from = i;
+		if (this->gt_tiles.Expand(gts.data(), n_records) == false)
+			return nullptr;
+	}
+
+	return(this->gt_tiles.GetRecords(i - this->gt_tile_from));
+}
+
+void VariantReader::ResetGenotypeTiles(void) {
+	this->gt_tiles.ResetPermutation();
+	this->gt_tiles.n_r = 0;
+	this->gt_tile_from = 0;
+}
+
+void VariantReader::AnnotateBlock(yon1_vc_t& vc) {
+	if (this->settings.group_file.size() == 0)
+		return;
+
+	this->occ_table.BuildTable(this->variant_container.gt_ppa);
+	if (this->popgen.Evaluate(vc, this->occ_table))
+		this->popgen.ComputeStrandBias();
+}
+
+void VariantReader::AnnotateRecord(yon1_vc_t& vc, const uint32_t i) {
+	if (this->settings.group_file.size()) {
+		// Hypothesis tests over groupings were computed in batch for the
+		// block by AnnotateBlock().
+		vc[i].EvaluateOcc(this->occ_table);
+		vc[i].EvaluateOccSummary(true, false);
+	}
+
+	vc[i].EvaluateSummary(true);
+	vc[i].AddGenotypeStatistics(this->global_header);
+	if (this->settings.group_file.size())
+		vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names, this->popgen, i);
+}
+
 uint64_t VariantReader::OutputVcfLinear(void) {
 	if (this->gt_exp == nullptr)
 		this->gt_exp = new yon_gt_rcd[this->global_header.GetNumberSamples()];
 
+	// Genotypes are expanded in tiles of records if every record is
+	// output.
+	const bool tiled = this->variant_filters.size() == 0 && (this->GetBlockSettings().display_static & YON_BLK_BV_GT);
+
 	yon_buffer_t buf(100000);
 	while (this->NextBlock()) {
 		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
+		this->ResetGenotypeTiles();
 
-		if (this->GetBlockSettings().annotate_extra && this->settings.group_file.size())
-			this->occ_table.BuildTable(this->variant_container.gt_ppa);
+		if (this->GetBlockSettings().annotate_extra)
+			this->AnnotateBlock(vc);
 
 		for (uint32_t i = 0; i < vc.size(); ++i) {
 			if (this->variant_filters.Filter(vc[i], i) == false)
 				continue;
 
-			if (this->GetBlockSettings().annotate_extra) {
-				vc[i].EvaluateOcc(this->occ_table);
-				vc[i].EvaluateOccSummary(true);
+			if (this->GetBlockSettings().annotate_extra)
+				this->AnnotateRecord(vc, i);
+			yon_gt_rcd* exp = nullptr;
+			if (tiled && vc[i].is_loaded_gt && vc[i].controller.gt_available)
+				exp = this->ExpandGenotypes(vc, i);
 
-				vc[i].EvaluateSummary(true);
-				vc[i].AddGenotypeStatistics(this->global_header);
-				vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names);
-			}
-			vc[i].ToVcfString(this->global_header, buf, this->GetBlockSettings().display_static, this->gt_exp);
+			if (exp != nullptr) vc[i].ToVcfString(this->global_header, buf, this->GetBlockSettings().display_static, exp, true);
+			else vc[i].ToVcfString(this->global_header, buf, this->GetBlockSettings().display_static, this->gt_exp);
 			std::cout.write(buf.data(), buf.size());
 			buf.reset();
 		}
@@ -406,8 +817,8 @@ uint64_t VariantReader::OutputVcfSearch(void) {
 
 		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
 
-		if (this->GetBlockSettings().annotate_extra && this->settings.group_file.size())
-			this->occ_table.BuildTable(this->variant_container.gt_ppa);
+		if (this->GetBlockSettings().annotate_extra)
+			this->AnnotateBlock(vc);
 
 		for (uint32_t i = 0; i < vc.size(); ++i) {
 			if ((this->*filter_intervals)(vc[i]) == false)
@@ -416,14 +827,8 @@ uint64_t VariantReader::OutputVcfSearch(void) {
 			if (this->variant_filters.Filter(vc[i], i) == false)
 				continue;
 
-			if (this->GetBlockSettings().annotate_extra) {
-				vc[i].EvaluateOcc(this->occ_table);
-				vc[i].EvaluateOccSummary(true);
-
-				vc[i].EvaluateSummary(true);
-				vc[i].AddGenotypeStatistics(this->global_header);
-				vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names);
-			}
+			if (this->GetBlockSettings().annotate_extra)
+				this->AnnotateRecord(vc, i);
 
 			vc[i].ToVcfString(this->global_header, buf, this->GetBlockSettings().display_static, this->gt_exp);
 			std::cout.write(buf.data(), buf.size());
@@ -459,21 +864,15 @@ uint64_t VariantReader::OutputYonLinear(void) {
 	while (this->NextBlock()) {
 		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
 
-		if (this->GetBlockSettings().annotate_extra && this->settings.group_file.size())
-			this->occ_table.BuildTable(this->variant_container.gt_ppa);
+		if (this->GetBlockSettings().annotate_extra)
+			this->AnnotateBlock(vc);
 
 		for (uint32_t i = 0; i < vc.size(); ++i) {
 			if (this->variant_filters.Filter(vc[i], i) == false)
 				continue;
 
-			if (this->GetBlockSettings().annotate_extra) {
-				vc[i].EvaluateOcc(this->occ_table);
-				vc[i].EvaluateOccSummary(true);
-
-				vc[i].EvaluateSummary(true);
-				vc[i].AddGenotypeStatistics(this->global_header);
-				vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names);
-			}
+			if (this->GetBlockSettings().annotate_extra)
+				this->AnnotateRecord(vc, i);
 			if (vc[i].gt != nullptr) vc[i].gt->Expand();
 			*writer += vc[i];
 		}
@@ -509,13 +908,54 @@ uint64_t VariantReader::OutputYonSearch(void) {
 	// Filter functionality
 	filter_intervals_function filter_intervals = &self_type::FilterIntervals;
 
+	// Blocks lying entirely within the target intervals can be copied
+	// verbatim if records are neither filtered nor modified and all
+	// fields are retained. Only the boundary blocks are re-encoded.
+	const yon_vb_settings& block_settings = this->GetBlockSettings();
+	const bool passthrough = this->variant_filters.size() == 0
+	                      && block_settings.annotate_extra == false
+	                      && block_settings.load_static    == std::numeric_limits<uint32_t>::max()
+	                      && block_settings.display_static == std::numeric_limits<uint32_t>::max()
+	                      && block_settings.info_list.size()   == 0
+	                      && block_settings.format_list.size() == 0
+	                      && this->settings.keychain_file.size() == 0
+	                      && this->settings.group_file.size()    == 0;
+	uint32_t n_copied = 0;
+	int64_t last_copied = -1; // block copied immediately before or -1
+
 	for (uint32_t i = 0; i < this->mImpl->interval_container.GetBlockList().size(); ++i) {
-		this->GetBlock(this->mImpl->interval_container.GetBlockList()[i]);
+		const index_entry_type& entry = this->mImpl->interval_container.GetBlockList()[i];
+		if (passthrough && this->mImpl->interval_container.IsCovered(entry.contig_id, entry.min_position, entry.max_position)) {
+			// A block storing its permutation array relative to the
+			// preceding block can only be copied directly after that
+			// block.
+			bool ppa_delta = false;
+			if (last_copied < 0 || last_copied + 1 != (int64_t)entry.block_id) {
+				yon_vb_hdr header;
+				this->mImpl->basic_reader.stream_.seekg(entry.byte_offset);
+				this->mImpl->basic_reader.stream_ >> header;
+				ppa_delta = header.controller.has_ppa_delta;
+			}
+
+			if (ppa_delta == false) {
+				if (writer->WriteBlockRaw(this->mImpl->basic_reader.stream_, entry) == false) {
+					std::cerr << utility::timestamp("ERROR", "WRITER") << "Failed to copy block " << entry.block_id << "..." << std::endl;
+					delete writer;
+					return false;
+				}
+				last_copied = entry.block_id;
+				++n_copied;
+				continue;
+			}
+		}
+		last_copied = -1;
+
+		this->GetBlock(entry);
 
 		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
 
-		if (this->GetBlockSettings().annotate_extra && this->settings.group_file.size())
-			this->occ_table.BuildTable(this->variant_container.gt_ppa);
+		if (this->GetBlockSettings().annotate_extra)
+			this->AnnotateBlock(vc);
 
 		for (uint32_t i = 0; i < vc.size(); ++i) {
 			if ((this->*filter_intervals)(vc[i]) == false)
@@ -524,14 +964,8 @@ uint64_t VariantReader::OutputYonSearch(void) {
 			if (this->variant_filters.Filter(vc[i], i) == false)
 				continue;
 
-			if (this->GetBlockSettings().annotate_extra) {
-				vc[i].EvaluateOcc(this->occ_table);
-				vc[i].EvaluateOccSummary(true);
-
-				vc[i].EvaluateSummary(true);
-				vc[i].AddGenotypeStatistics(this->global_header);
-				vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names);
-			}
+			if (this->GetBlockSettings().annotate_extra)
+				this->AnnotateRecord(vc, i);
 
 			if (vc[i].gt != nullptr) vc[i].gt->Expand();
 			*writer += vc[i];
@@ -541,6 +975,10 @@ uint64_t VariantReader::OutputYonSearch(void) {
 	writer->close();
 	delete writer;
 
+	if (!SILENT) {
+		std::cerr << utility::timestamp("LOG") << "Copied " << n_copied << "/" << this->mImpl->interval_container.GetBlockList().size() << " blocks verbatim..." << std::endl;
+	}
+
 	return 0;
 }
 
@@ -617,30 +1055,34 @@ uint64_t VariantReader::OutputHtslibVcfLinear(void) {
 	// reusing as we iterate over available yon records.
 	bcf1_t *rec = bcf_init1();
 
+	// Genotypes are expanded in tiles of records if every record is
+	// output.
+	const bool tiled = this->variant_filters.size() == 0 && (this->GetBlockSettings().display_static & YON_BLK_BV_GT);
+
 	// Iterate over available blocks.
 	while (this->NextBlock()) {
 		yon1_vc_t vc(this->GetCurrentContainer(), this->global_header);
+		this->ResetGenotypeTiles();
 
 		if (this->GetBlockSettings().annotate_extra)
-			this->occ_table.BuildTable(this->variant_container.gt_ppa);
+			this->AnnotateBlock(vc);
 
 		// Iterate over available records in this block.
 		for (uint32_t i = 0; i < vc.size(); ++i) {
 			if (this->variant_filters.Filter(vc[i], i) == false)
 				continue;
 
-			if (this->GetBlockSettings().annotate_extra) {
-				vc[i].EvaluateOcc(this->occ_table);
-				vc[i].EvaluateOccSummary(true);
-
-				vc[i].EvaluateSummary(true);
-				vc[i].AddGenotypeStatistics(this->global_header);
-				vc[i].AddGenotypeStatisticsOcc(this->global_header, this->occ_table.row_names);
-			}
+			if (this->GetBlockSettings().annotate_extra)
+				this->AnnotateRecord(vc, i);
 
 			vc[i].UpdateHtslibVcfRecord(rec, hdr);
 			vc[i].OutputHtslibVcfInfo(rec, hdr);
-			vc[i].OutputHtslibVcfFormat(rec, hdr, this->GetBlockSettings().display_static & YON_BLK_BV_GT, this->gt_exp);
+			yon_gt_rcd* exp = nullptr;
+			if (tiled && vc[i].is_loaded_gt && vc[i].controller.gt_available)
+				exp = this->ExpandGenotypes(vc, i);
+
+			if (exp != nullptr) vc[i].OutputHtslibVcfFormat(rec, hdr, true, exp, true);
+			else vc[i].OutputHtslibVcfFormat(rec, hdr, this->GetBlockSettings().display_static & YON_BLK_BV_GT, this->gt_exp);
 			vc[i].OutputHtslibVcfFilter(rec, hdr);
 
 
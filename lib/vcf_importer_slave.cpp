@@ -6,14 +6,16 @@ VcfImporterSlave::VcfImporterSlave() :
 		n_blocks_processed(0),
 		block_id(0),
 		vcf_header_(nullptr),
-		GT_available_(false)
+		GT_available_(false),
+		ppa_is_delta(false)
 {}
 
 VcfImporterSlave::VcfImporterSlave(const settings_type& settings) :
 	n_blocks_processed(0),
 	block_id(0),
 	vcf_header_(nullptr),
-	GT_available_(false)
+	GT_available_(false),
+	ppa_is_delta(false)
 {}
 
 VcfImporterSlave::~VcfImporterSlave() {
@@ -32,6 +34,7 @@ VcfImporterSlave& VcfImporterSlave::operator+=(const VcfImporterSlave& other) {
 bool VcfImporterSlave::Add(vcf_container_type& container, const uint32_t block_id) {
 	// Clear current data.
 	this->block.clear();
+	this->arena.reset();
 	this->index.GetCurrent().reset();
 
 	// Assign new block id. This is provided by the producer.
@@ -55,12 +58,26 @@ bool VcfImporterSlave::Add(vcf_container_type& container, const uint32_t block_i
 	// during import stages. Do not destroy the target block
 	// before finishing with this.
 	this->block.gt_ppa = &this->permutator.permutation_array;
+	this->ppa_is_delta = false;
 
-	if (this->GT_available_ && this->settings_->permute_genotypes) {
+	if (this->GT_available_ && this->settings_->haplotype_pbwt &&
+	    this->vcf_header_->GetNumberSamples() > 1 && this->IsPhasedBlock(container))
+	{
+		// Fully phased blocks permute haplotypes rather than samples. A
+		// block permuted after this one starts from the identity.
+		if (this->ppa_chain != nullptr) {
+			this->ppa_chain->Wait(block_id);
+			this->ppa_chain->Publish(block_id, nullptr);
+		}
+		this->block.header.controller.has_gt_haplotypes = true;
+	} else if (this->GT_available_ && this->settings_->permute_genotypes) {
 		// Only store the permutation array if the number of samples
 		// are greater then one (1).
 		if (this->vcf_header_->GetNumberSamples() > 1) {
-			if (this->permutator.Build(container, *this->vcf_header_) == false)
+			if (this->ppa_chain != nullptr) {
+				if (this->PermuteCarry(container, block_id) == false)
+					return false;
+			} else if (this->permutator.Build(container, *this->vcf_header_) == false)
 				return false;
 
 			this->block.header.controller.has_gt_permuted = true;
@@ -73,11 +90,31 @@ bool VcfImporterSlave::Add(vcf_container_type& container, const uint32_t block_i
 	this->block.header.n_variants        = container.sizeWithoutCarryOver();
 	this->block.UpdateContainers(this->vcf_header_->GetNumberSamples());
 
+	// Genotypes are encoded with the final permutation but the
+	// permutation itself is stored relative to the preceding block
+	// unless that is not smaller.
+	if (this->ppa_is_delta) {
+		if (this->permutator.permutation_array.ToDelta(this->ppa_reference, this->ppa_delta) == false) {
+			std::cerr << utility::timestamp("ERROR","PERMUTE") << "Failed to encode permutation relative to the preceding block..." << std::endl;
+			return false;
+		}
+		if (this->ppa_delta.n_s < this->permutator.permutation_array.n_s) {
+			this->block.gt_ppa = &this->ppa_delta;
+			this->block.header.controller.has_ppa_delta = true;
+		}
+	}
+
+	// The haplotype order is borrowed from the encoder.
+	if (this->block.header.controller.has_gt_haplotypes)
+		this->block.gt_hppa = &this->encoder.GetHaplotypeOrder();
+
 	// Perform compression using standard parameters.
 	if (!this->compression_manager.Compress(this->block, this->settings_->compression_level, this->vcf_header_->GetNumberSamples())) {
 		std::cerr << utility::timestamp("ERROR","COMPRESSION") << "Failed to compress..." << std::endl;
 		return false;
 	}
+	this->block.gt_ppa  = &this->permutator.permutation_array;
+	this->block.gt_hppa = nullptr;
 
 	// Encrypt the variant block if desired.
 	if (this->settings_->encrypt_data) {
@@ -101,15 +138,51 @@ bool VcfImporterSlave::Add(vcf_container_type& container, const uint32_t block_i
 	return true;
 }
 
+bool VcfImporterSlave::PermuteCarry(const vcf_container_type& container, const uint32_t block_id) {
+	this->ppa_chain->Wait(block_id);
+
+	// A full permutation is stored in the first block and then once
+	// every permute_carry_interval blocks such that a reader never
+	// has to resolve more than that number of blocks.
+	const bool seeded = this->ppa_chain->valid;
+	this->ppa_is_delta = seeded && (block_id % this->settings_->permute_carry_interval) != 0;
+	if (seeded) this->permutator.Seed(this->ppa_chain->ppa);
+	if (this->ppa_is_delta) this->ppa_reference = this->ppa_chain->ppa;
+
+	const bool ret = this->permutator.Build(container, *this->vcf_header_);
+	this->ppa_chain->Publish(block_id, ret ? &this->permutator.permutation_array : nullptr);
+	if (ret == false) this->ppa_is_delta = false;
+	return(ret);
+}
+
+bool VcfImporterSlave::IsPhasedBlock(const vcf_container_type& container) const {
+	uint32_t n_gt = 0;
+	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) {
+		const bcf1_t* rec = container.at(i);
+		if (rec->n_fmt == 0 || this->vcf_header_->GetFormat(rec->d.fmt[0].id)->id != "GT")
+			continue;
+
+		if (gt_encoder_type::IsPhasedBiallelic(rec, this->vcf_header_->GetNumberSamples()) == false)
+			return false;
+		++n_gt;
+	}
+	return(n_gt != 0);
+}
+
 bool VcfImporterSlave::AddRecords(const vcf_container_type& container) {
-	// Allocate memory for the entries.
-	yon1_vnt_t* variants = new yon1_vnt_t[container.sizeWithoutCarryOver()];
+	// Allocate memory for the entries. Records and their allele strings
+	// are served from the block-local arena and are released collectively
+	// when the next block is started.
+	const uint32_t n_variants = container.sizeWithoutCarryOver();
+	yon1_vnt_t* variants = this->arena.Allocate<yon1_vnt_t>(n_variants);
+	for (uint32_t i = 0; i < n_variants; ++i)
+		new( &variants[i] ) yon1_vnt_t( &this->arena );
 
 	// Iterate over the Vcf container and invoke the meta entry
 	// ctor with the target htslib bcf1_t entry provided. Internally
 	// converts the bcf1_t data members into the allelic structure
 	// that tachyon uses.
-	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) {
+	for (uint32_t i = 0; i < n_variants; ++i) {
 		// Transmute a bcf record into a yon1_vnt_t structure.
 		variants[i].UpdateBase(container[i]);
 
@@ -120,13 +193,16 @@ bool VcfImporterSlave::AddRecords(const vcf_container_type& container) {
 	}
 
 	// Add FORMAT:GT field data.
+	this->encoder.SetSparse(this->settings_->sparse_genotypes);
 	this->encoder.Encode(container, variants, this->block, this->permutator.permutation_array);
 
 	// Interleave meta records out to the destination block byte
 	// streams.
-	for (uint32_t i = 0; i < container.sizeWithoutCarryOver(); ++i) this->block += variants[i];
+	for (uint32_t i = 0; i < n_variants; ++i) this->block += variants[i];
 
-	delete [] variants;
+	// Invoke dtors only: memory is owned by the arena.
+	for (uint32_t i = 0; i < n_variants; ++i)
+		((variants + i)->~yon1_vnt_t)();
 
 	return true;
 }
@@ -1,6 +1,9 @@
 #ifndef VCF_IMPORTER_SLAVE_H_
 #define VCF_IMPORTER_SLAVE_H_
 
+#include <mutex>
+#include <condition_variable>
+
 #include "utility.h"
 #include "algorithm/compression/compression_manager.h"
 #include "algorithm/compression/genotype_encoder.h"
@@ -18,6 +21,47 @@
 
 namespace tachyon{
 
+/**<
+ * Hands the final genotype permutation of each block to the slave that
+ * permutes the next block when permutations are carried across blocks.
+ * Blocks are permuted in order of their block identifiers whereas all
+ * other work on blocks remains concurrent.
+ */
+struct yon_ppa_chain {
+public:
+	yon_ppa_chain(const uint32_t first_block_id) : next_block_id(first_block_id), valid(false) {}
+	~yon_ppa_chain() = default;
+
+	// Wait until all blocks preceding the given block have been permuted.
+	void Wait(const uint32_t block_id) {
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->cv.wait(lock, [this, block_id]{ return(this->next_block_id == block_id); });
+	}
+
+	/**<
+	 * Publish the final permutation of a block and wake the slave waiting
+	 * for the next block.
+	 * @param block_id Src block identifier.
+	 * @param ppa      Src permutation or nullptr if the block was not permuted.
+	 */
+	void Publish(const uint32_t block_id, const yon_gt_ppa* ppa) {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			if (ppa != nullptr) this->ppa = *ppa;
+			this->valid = (ppa != nullptr);
+			this->next_block_id = block_id + 1;
+		}
+		this->cv.notify_all();
+	}
+
+public:
+	uint32_t next_block_id; // next block to be permuted
+	bool valid; // ppa holds the permutation of the preceding block
+	yon_gt_ppa ppa;
+	std::mutex mutex;
+	std::condition_variable cv;
+};
+
 /**<
  * Slave worker instantiation of VariantImporter. Used exclusively during htslib
  * Vcf importing. Data has to be provided through the cyclic queue generated by the
@@ -68,6 +112,26 @@ public:
 	 */
 	bool AddRecords(const vcf_container_type& container);
 
+	/**<
+	 * Permute the genotypes of the provided container seeded with the final
+	 * permutation of the preceding block. Waits until the preceding block
+	 * has been permuted. The preceding permutation is retained as reference
+	 * if this block stores its permutation as a delta.
+	 * @param container Source container.
+	 * @param block_id  Source block number.
+	 * @return          Returns TRUE upon success or FALSE otherwise.
+	 */
+	bool PermuteCarry(const vcf_container_type& container, const uint32_t block_id);
+
+	/**<
+	 * Predicate for whether every record with FORMAT:GT data in the provided
+	 * container is diploid, biallelic, fully phased, and has no missing
+	 * alleles such that the block can be encoded as a haplotype PBWT.
+	 * @param container Source container.
+	 * @return          Returns TRUE if the block is eligible or FALSE otherwise.
+	 */
+	bool IsPhasedBlock(const vcf_container_type& container) const;
+
 	/**<
 	 * Wrapper function for adding a single variant site from the source
 	 * container.
@@ -126,10 +190,15 @@ public:
 	bool GT_available_; // genotypes available
 	//index_entry_type  index_entry; // streaming index entry
 	radix_sorter_type permutator;  // GT permuter
+	std::shared_ptr<yon_ppa_chain> ppa_chain; // shared permutation chain or nullptr
+	bool       ppa_is_delta; // store the permutation relative to ppa_reference
+	yon_gt_ppa ppa_reference; // final permutation of the preceding block
+	yon_gt_ppa ppa_delta; // permutation encoded relative to ppa_reference
 	gt_encoder_type   encoder;     // RLE packer
 	compression_manager_type compression_manager; // General compression manager
 	EncryptionDecorator encryption_decorator;
 	block_type block; // Local data container
+	yon_arena  arena; // Block-local memory arena for records
 	// Maps from htslib vcf header to yon header.
 	reorder_map_type filter_reorder_map_;
 	reorder_map_type info_reorder_map_;
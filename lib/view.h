@@ -41,6 +41,7 @@ void view_usage(void){
 	"                 z: compressed VCF,  v: uncompressed VCF [v]\n"
 	"  -c INT    import checkpoint size in number of variants (default: 1000)\n"
 	"  -C FLOAT  import checkpoint size in bases (default: 5 Mb)\n"
+	"  -B INT    target compressed block size in bytes: adapts -c to the data (default: off)\n"
 	"  -L INT    compression level 1-20 (default: 6)\n"
 	"  -t INT    number of compression threads (default: all available)\n"
 	"  -p/-P     permute/do not permute diploid genotypes\n"
@@ -98,6 +99,7 @@ int view(int argc, char** argv){
 		{"filter",            optional_argument, 0,  'f' },
 		{"output-type",       optional_argument, 0,  'O' },
 		{"checkpoint-variants", optional_argument, 0, 'c' },
+		{"block-bytes-compressed", optional_argument, 0, 'B' },
 		{"checkpoint-bases",    optional_argument, 0, 'C' },
 		{"compression-level",   optional_argument, 0, 'L' },
 		{"permute",             no_argument,       0, 'p' },
@@ -145,7 +147,7 @@ int view(int argc, char** argv){
 	tachyon::VariantReader reader;
 	tachyon::VariantReaderFilters& filters = reader.GetFilterSettings();
 
-	while ((c = getopt_long(argc, argv, "i:o:k:f:O:r:GshHX?l:L:m:M:pPuUc:C:jJzZa:A:n:wWeEq:Q:b:", long_options, &option_index)) != -1){
+	while ((c = getopt_long(argc, argv, "i:o:k:f:O:r:GshHX?l:L:m:M:pPuUc:C:jJzZa:A:n:wWeEq:Q:b:t:B:", long_options, &option_index)) != -1){
 		switch (c){
 		case 0:
 			std::cerr << "Case 0: " << option_index << '\t' << long_options[option_index].name << std::endl;
@@ -170,6 +172,14 @@ int view(int argc, char** argv){
 				return(1);
 			}
 			break;
+		case 'B':
+			settings.checkpoint_bytes      = atoll(optarg);
+			settings.checkpoint_compressed = true;
+			if(settings.checkpoint_bytes <= 0){
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set block size to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
 		case 'L':
 			settings.compression_level = atoi(optarg);
 			if(settings.compression_level <= 0){
@@ -177,6 +187,13 @@ int view(int argc, char** argv){
 				return(1);
 			}
 			break;
+		case 't':
+			settings.n_threads = atoi(optarg);
+			if(settings.n_threads <= 0){
+				std::cerr << tachyon::utility::timestamp("ERROR") << "Cannot set number of threads to <= 0..." << std::endl;
+				return(1);
+			}
+			break;
 		case 'p': settings.permute_genotypes = true;  break;
 		case 'P': settings.permute_genotypes = false; break;
 		case 'b':